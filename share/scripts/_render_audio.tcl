@@ -0,0 +1,164 @@
+namespace eval render_audio {
+
+set_help_text render_audio \
+{Renders the sound of the running machine to WAV file(s), as fast as possible.
+
+Usage:
+    render_audio [-prefix <name>] [-channels] [-keepvideo] [-command <script>] <seconds>
+    render_audio stop
+    render_audio status
+
+This records the given number of (emulated) seconds of audio, starting now.
+Meanwhile the emulation runs unthrottled, with sound output muted and (unless
+-keepvideo is given) with the renderer set to 'none'. When done, the original
+settings are restored.
+
+Options:
+    -prefix <name>     prefix for the file names (default: the title of the
+                       running software), files are written to the soundlogs
+                       directory
+    -channels          also record each channel of each sound device to a
+                       separate file (see record_channels)
+    -keepvideo         don't switch off the video output
+    -command <script>  execute this Tcl script when rendering has finished,
+                       e.g. 'exit' or a proc that starts the next track
+
+The mixed and the per-channel files start and end at exactly the same sample.
+The files are written from background threads, so a slow disk doesn't slow
+down the emulation.
+
+Example (e.g. in a script passed via -script when batch rendering):
+    render_audio -channels -prefix mysong -command exit 180
+}
+
+variable rendering false
+variable saved_settings [list]
+variable channels false
+variable command ""
+variable after_id ""
+variable files [list]
+
+set_tabcompletion_proc render_audio [namespace code tab_render_audio]
+proc tab_render_audio {args} {
+	if {[llength $args] == 2} {
+		return [list "stop" "status" "-prefix" "-channels" "-keepvideo" "-command"]
+	}
+	return [list "-prefix" "-channels" "-keepvideo" "-command"]
+}
+
+proc render_audio {args} {
+	variable rendering
+	variable saved_settings
+	variable channels
+	variable command
+	variable after_id
+	variable files
+
+	switch -- [lindex $args 0] {
+		"stop" {
+			if {!$rendering} {
+				error "Not rendering."
+			}
+			after cancel $after_id
+			return [finish]
+		}
+		"status" {
+			return [expr {$rendering ? "rendering" : "idle"}]
+		}
+	}
+
+	set prefix ""
+	set keep_video false
+	set channels false
+	set command ""
+	while {[string match "-*" [lindex $args 0]]} {
+		switch -- [lindex $args 0] {
+			"-prefix" {
+				set prefix [lindex $args 1]
+				set args [lrange $args 2 end]
+			}
+			"-channels" {
+				set channels true
+				set args [lrange $args 1 end]
+			}
+			"-keepvideo" {
+				set keep_video true
+				set args [lrange $args 1 end]
+			}
+			"-command" {
+				set command [lindex $args 1]
+				set args [lrange $args 2 end]
+			}
+			default {
+				error "Unknown option: [lindex $args 0]"
+			}
+		}
+	}
+	if {[llength $args] != 1} {
+		error "Expected exactly one argument: the number of seconds to render."
+	}
+	set seconds [lindex $args 0]
+	if {![string is double -strict $seconds] || $seconds <= 0} {
+		error "Not a valid duration: $seconds"
+	}
+	if {$rendering} {
+		error "Already rendering."
+	}
+	if {[dict get [record status] status] ne "idle"} {
+		error "Already recording, stop that first."
+	}
+	if {$prefix eq ""} {
+		set prefix [utils::filename_clean [guess_title]]
+		if {$prefix eq ""} {set prefix "render"}
+	}
+
+	# Start recording before changing any settings, so nothing needs to
+	# be restored when this fails.
+	set files [list [record start -audioonly -prefix "${prefix}_"]]
+	if {$channels} {
+		lappend files [string trim [record_channels start all -prefix $prefix]]
+	}
+
+	set saved_settings [list throttle $::throttle mute $::mute]
+	set ::throttle off
+	set ::mute on
+	if {!$keep_video} {
+		lappend saved_settings renderer $::renderer
+		set ::renderer none
+	}
+
+	set rendering true
+	set after_id [after time $seconds [namespace code finish]]
+	return [join $files "\n"]
+}
+
+proc finish {} {
+	variable rendering
+	variable saved_settings
+	variable channels
+	variable command
+	variable files
+
+	# Both stop at the current emulated time, so the files have exactly the
+	# same length.
+	record stop
+	if {$channels} {
+		record_channels stop
+	}
+	foreach {setting value} $saved_settings {
+		set ::$setting $value
+	}
+	set rendering false
+
+	set result "Finished rendering:\n[join $files "\n"]"
+	if {$command ne ""} {
+		after realtime 0 $command
+	}
+	return $result
+}
+
+namespace export render_audio
+
+} ;# namespace render_audio
+
+namespace import render_audio::*
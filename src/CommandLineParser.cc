@@ -18,6 +18,8 @@
 #include "GLUtil.hh"
 #include "Reactor.hh"
 #include "RomInfo.hh"
+#include "TclObject.hh"
+#include "CommandException.hh"
 #include "hash_map.hh"
 #include "one_of.hh"
 #include "outer.hh"
@@ -71,6 +73,7 @@ CommandLineParser::CommandLineParser(Reactor& reactor_)
 	registerOption("-script",     scriptOption,  PHASE_BEFORE_SETTINGS, 1); // correct phase?
 	registerOption("-command",    commandOption, PHASE_BEFORE_SETTINGS, 1); // same phase as -script
 	registerOption("-testconfig", testConfigOption, PHASE_BEFORE_SETTINGS, 1);
+	registerOption("-diskmanipulator", diskManipulatorOption, PHASE_BEFORE_SETTINGS, 1);
 
 	registerOption("-machine",    machineOption, PHASE_LOAD_MACHINE);
 
@@ -575,6 +578,36 @@ string_view CommandLineParser::TestConfigOption::optionHelp() const
 	return "Test if the specified config works and exit";
 }
 
+// class DiskManipulatorOption
+
+void CommandLineParser::DiskManipulatorOption::parseOption(
+	const string& /*option*/, span<string>& cmdLine)
+{
+	// Run a single diskmanipulator command and exit, without loading
+	// settings nor an MSX machine.
+	auto& parser = OUTER(CommandLineParser, diskManipulatorOption);
+	TclObject command = makeTclList("diskmanipulator");
+	command.addListElements(cmdLine);
+	cmdLine = cmdLine.subspan(0, 0); // eat all remaining parameters
+
+	try {
+		auto result = command.executeCommand(parser.getInterpreter());
+		if (!result.getString().empty()) {
+			cout << result.getString();
+			if (!StringOp::endsWith(result.getString(), '\n')) cout << '\n';
+		}
+	} catch (CommandException& e) {
+		std::cerr << e.getMessage() << '\n';
+		exitCode = 1;
+	}
+	parser.parseStatus = CommandLineParser::EXIT;
+}
+
+string_view CommandLineParser::DiskManipulatorOption::optionHelp() const
+{
+	return "Run a diskmanipulator command (e.g. batch) and exit";
+}
+
 // class BashOption
 
 void CommandLineParser::BashOption::parseOption(
@@ -141,6 +141,11 @@ private:
 		std::string_view optionHelp() const override;
 	} bashOption;
 
+	struct DiskManipulatorOption final : CLIOption {
+		void parseOption(const std::string& option, span<std::string>& cmdLine) override;
+		std::string_view optionHelp() const override;
+	} diskManipulatorOption;
+
 	struct FileTypeCategoryInfoTopic final : InfoTopic {
 		FileTypeCategoryInfoTopic(InfoCommand& openMSXInfoCommand, const CommandLineParser& parser);
 		void execute(span<const TclObject> tokens, TclObject& result) const override;
@@ -207,6 +207,9 @@ private:
 	static Tcl_Obj* newObj(unsigned u) {
 		return Tcl_NewIntObj(u);
 	}
+	static Tcl_Obj* newObj(uint64_t u) {
+		return Tcl_NewWideIntObj(Tcl_WideInt(u));
+	}
 	static Tcl_Obj* newObj(float f) {
 		return Tcl_NewDoubleObj(double(f));
 	}
@@ -364,6 +364,13 @@ void MSXCPU::disasmCommand(
 
 void MSXCPU::setPaused(bool paused)
 {
+	if (paused) {
+		++pauseCount;
+	} else {
+		assert(pauseCount);
+		--pauseCount;
+	}
+	paused = pauseCount != 0;
 	if (z80Active) {
 		z80 ->setExtHALT(paused);
 		z80 ->exitCPULoopSync();
@@ -558,6 +565,16 @@ void MSXCPU::serialize(Archive& ar, unsigned version)
 	if (ar.isLoader()) {
 		invalidateMemCacheSlot();
 		invalidateAllSlotsRWCache(0x0000, 0x10000);
+
+		// The devices (restored before the CPU) have re-established their
+		// pauses (e.g. turbor hw pause). A pause that's not part of the
+		// savestate (register log playback) must not remain active.
+		bool paused = pauseCount != 0;
+		if (z80Active) {
+			z80 ->setExtHALT(paused);
+		} else {
+			r800->setExtHALT(paused);
+		}
 	}
 }
 INSTANTIATE_SERIALIZE_METHODS(MSXCPU);
@@ -133,7 +133,9 @@ public:
 	                   TclObject& result) const;
 
 	/** (un)pause CPU. During pause the CPU executes NOP instructions
-	  * continuously (just like during HALT). Used by turbor hw pause. */
+	  * continuously (just like during HALT). Used by turbor hw pause and
+	  * by register log playback. Calls nest: the CPU only continues after
+	  * as many unpause as pause calls. */
 	void setPaused(bool paused);
 
 	void setNextSyncPoint(EmuTime::param time);
@@ -208,6 +210,7 @@ private:
 	EmuTime reference;
 	bool z80Active;
 	bool newZ80Active;
+	unsigned pauseCount = 0;
 
 	MSXCPUInterface* interface = nullptr; // only used for debug
 };
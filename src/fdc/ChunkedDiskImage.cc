@@ -0,0 +1,38 @@
+#include "ChunkedDiskImage.hh"
+
+namespace openmsx {
+
+ChunkedDiskImage::ChunkedDiskImage(const Filename& fileName)
+	: SectorBasedDisk(fileName)
+	, image(fileName.getResolved())
+{
+	setNbSectors(image.getSize() / sizeof(SectorBuffer));
+	enableSectorCache();
+}
+
+void ChunkedDiskImage::readSectorImpl(size_t sector, SectorBuffer& buf)
+{
+	image.read(sector * sizeof(buf), buf.raw, sizeof(buf));
+}
+
+void ChunkedDiskImage::writeSectorImpl(size_t sector, const SectorBuffer& buf)
+{
+	image.write(sector * sizeof(buf), buf.raw, sizeof(buf));
+}
+
+void ChunkedDiskImage::readSectorsImpl(size_t sector, size_t num, SectorBuffer* bufs)
+{
+	image.read(sector * sizeof(SectorBuffer), bufs[0].raw, num * sizeof(SectorBuffer));
+}
+
+void ChunkedDiskImage::writeSectorsImpl(size_t sector, size_t num, const SectorBuffer* bufs)
+{
+	image.write(sector * sizeof(SectorBuffer), bufs[0].raw, num * sizeof(SectorBuffer));
+}
+
+bool ChunkedDiskImage::isWriteProtectedImpl() const
+{
+	return image.isReadOnly();
+}
+
+} // namespace openmsx
@@ -0,0 +1,29 @@
+#ifndef CHUNKEDDISKIMAGE_HH
+#define CHUNKEDDISKIMAGE_HH
+
+#include "SectorBasedDisk.hh"
+#include "ChunkedImage.hh"
+
+namespace openmsx {
+
+/** Disk image in the chunked (compressed + overlay) format, see ChunkedImage.
+  */
+class ChunkedDiskImage final : public SectorBasedDisk
+{
+public:
+	explicit ChunkedDiskImage(const Filename& filename);
+
+private:
+	// SectorBasedDisk
+	void readSectorImpl (size_t sector,       SectorBuffer& buf) override;
+	void writeSectorImpl(size_t sector, const SectorBuffer& buf) override;
+	void readSectorsImpl (size_t sector, size_t num,       SectorBuffer* bufs) override;
+	void writeSectorsImpl(size_t sector, size_t num, const SectorBuffer* bufs) override;
+	bool isWriteProtectedImpl() const override;
+
+	ChunkedImage image;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,397 @@
+#include "ChunkedImage.hh"
+#include "FileOperations.hh"
+#include "MSXException.hh"
+#include "endian.hh"
+#include "lz4.hh"
+#include "xxhash.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace openmsx {
+
+// Layout of a base image (all values little endian):
+//   header: magic[8], version(32), chunkSize(32), imageSize(64), numChunks(32), reserved(32)
+//   per chunk: offset(64), compressedSize(32), checksum(32), tiger-tree-hash[24]
+//   followed by the compressed chunk data
+// Layout of an overlay:
+//   header: magic[8], version(32), chunkSize(32), imageSize(64), numChunks(32),
+//           checksum of the base chunk table(32), length(32) + name of the base image
+//   per chunk: offset(64), 0 if that chunk is not (yet) present in the overlay
+//   followed by the (uncompressed) modified chunks
+constexpr char BASE_MAGIC[8]    = {'o', 'M', 'S', 'X', 'c', 'h', 'n', 'k'};
+constexpr char OVERLAY_MAGIC[8] = {'o', 'M', 'S', 'X', 'o', 'v', 'l', 'y'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t HEADER_SIZE = 32;
+constexpr size_t BASE_ENTRY_SIZE = 40;
+constexpr size_t TT_BLOCK_SIZE = 1024; // see TigerTree
+
+static uint32_t read32(const uint8_t* p) { return Endian::read_UA_L32(p); }
+static uint64_t read64(const uint8_t* p) { return Endian::read_UA_L64(p); }
+static void write32(std::vector<uint8_t>& v, uint32_t x)
+{
+	uint8_t b[4]; Endian::write_UA_L32(b, x); v.insert(v.end(), b, b + 4);
+}
+static void write64(std::vector<uint8_t>& v, uint64_t x)
+{
+	uint8_t b[8]; Endian::write_UA_L64(b, x); v.insert(v.end(), b, b + 8);
+}
+
+static bool isValidChunkSize(size_t size)
+{
+	// must be a power-of-2 number of tiger-tree blocks (so that a chunk is
+	// a complete subtree), and small enough for the LZ4 routines
+	return (size >= TT_BLOCK_SIZE) && (size <= 16 * 1024 * 1024) &&
+	       ((size & (size - 1)) == 0);
+}
+
+// Tiger-tree-hash of a chunk, the same value as TigerTree calculates for the
+// corresponding subtree. Requires that data[-1] can be temporarily modified.
+static void calcChunkHash(uint8_t* data, size_t size, TigerHash& result)
+{
+	if (size == TT_BLOCK_SIZE) {
+		tiger_leaf(data, result);
+	} else {
+		TigerHash h0, h1;
+		calcChunkHash(data,            size / 2, h0);
+		calcChunkHash(data + size / 2, size / 2, h1);
+		tiger_int(h0, h1, result);
+	}
+}
+
+static void readExact(File& file, size_t pos, void* buffer, size_t num)
+{
+	if ((pos + num) > file.getSize()) {
+		throw MSXException("Chunked image is truncated: ", file.getURL());
+	}
+	file.seek(pos);
+	file.read(buffer, num);
+}
+
+bool ChunkedImage::isChunkedImage(File& file)
+{
+	char magic[8];
+	if (file.getSize() < sizeof(magic)) return false;
+	file.seek(0);
+	file.read(magic, sizeof(magic));
+	return (memcmp(magic, BASE_MAGIC,    sizeof(magic)) == 0) ||
+	       (memcmp(magic, OVERLAY_MAGIC, sizeof(magic)) == 0);
+}
+
+ChunkedImage::ChunkedImage(const std::string& filename)
+{
+	File file(filename);
+	uint8_t magic[8];
+	readExact(file, 0, magic, sizeof(magic));
+	if (memcmp(magic, OVERLAY_MAGIC, sizeof(magic)) == 0) {
+		overlay = std::move(file);
+		openOverlay(filename);
+	} else {
+		base = std::move(file);
+		openBase(filename);
+	}
+	compressBuf.resize(chunkSize);
+}
+
+void ChunkedImage::openBase(const std::string& filename)
+{
+	uint8_t header[HEADER_SIZE];
+	readExact(base, 0, header, sizeof(header));
+	if (memcmp(header, BASE_MAGIC, sizeof(BASE_MAGIC)) != 0) {
+		throw MSXException("Not a chunked image: ", filename);
+	}
+	if (read32(header + 8) != VERSION) {
+		throw MSXException("Unsupported chunked image version: ", filename);
+	}
+	chunkSize = read32(header + 12);
+	imageSize = read64(header + 16);
+	size_t numChunks = read32(header + 24);
+	if (!isValidChunkSize(chunkSize) ||
+	    (numChunks != ((imageSize + chunkSize - 1) / chunkSize))) {
+		throw MSXException("Corrupt chunked image: ", filename);
+	}
+
+	std::vector<uint8_t> table(numChunks * BASE_ENTRY_SIZE);
+	readExact(base, HEADER_SIZE, table.data(), table.size());
+	auto fileSize = base.getSize();
+	chunks.resize(numChunks);
+	for (auto i : xrange(numChunks)) {
+		const uint8_t* p = &table[i * BASE_ENTRY_SIZE];
+		auto& c = chunks[i];
+		c.offset = read64(p + 0);
+		c.compressedSize = read32(p + 8);
+		c.checksum = read32(p + 12);
+		memcpy(c.hash.h8, p + 16, sizeof(c.hash.h8));
+		if ((c.compressedSize > chunkSize) ||
+		    ((c.offset + c.compressedSize) > fileSize)) {
+			throw MSXException("Corrupt chunked image: ", filename);
+		}
+	}
+}
+
+void ChunkedImage::openOverlay(const std::string& filename)
+{
+	uint8_t header[HEADER_SIZE];
+	readExact(overlay, 0, header, sizeof(header));
+	if (read32(header + 8) != VERSION) {
+		throw MSXException("Unsupported overlay version: ", filename);
+	}
+	auto ovlChunkSize = read32(header + 12);
+	auto ovlImageSize = read64(header + 16);
+	size_t numChunks = read32(header + 24);
+	auto tableChecksum = read32(header + 28);
+
+	uint8_t lenBuf[4];
+	readExact(overlay, HEADER_SIZE, lenBuf, sizeof(lenBuf));
+	auto nameLen = read32(lenBuf);
+	if (nameLen > 4096) {
+		throw MSXException("Corrupt overlay: ", filename);
+	}
+	std::string baseName(nameLen, '\0');
+	readExact(overlay, HEADER_SIZE + 4, baseName.data(), nameLen);
+	if (!FileOperations::isAbsolutePath(baseName)) {
+		baseName = FileOperations::join(
+			FileOperations::getDirName(filename), baseName);
+	}
+
+	base = File(baseName);
+	openBase(baseName);
+	std::vector<uint8_t> table(chunks.size() * BASE_ENTRY_SIZE);
+	readExact(base, HEADER_SIZE, table.data(), table.size());
+	if ((ovlChunkSize != chunkSize) || (ovlImageSize != imageSize) ||
+	    (numChunks != chunks.size()) ||
+	    (tableChecksum != xxhash_impl<false>(table.data(), table.size()))) {
+		throw MSXException("Overlay ", filename,
+		                   " doesn't match its base image ", baseName);
+	}
+
+	overlayTableOffset = HEADER_SIZE + 4 + nameLen;
+	std::vector<uint8_t> offsets(numChunks * 8);
+	readExact(overlay, overlayTableOffset, offsets.data(), offsets.size());
+	auto fileSize = overlay.getSize();
+	overlayOffsets.resize(numChunks);
+	for (auto i : xrange(numChunks)) {
+		auto offset = read64(&offsets[i * 8]);
+		if (offset && ((offset + chunkSize) > fileSize)) {
+			throw MSXException("Corrupt overlay: ", filename);
+		}
+		overlayOffsets[i] = offset;
+	}
+}
+
+void ChunkedImage::create(File& rawImage, const std::string& filename,
+                          size_t chunkSize_)
+{
+	if (!isValidChunkSize(chunkSize_)) {
+		throw MSXException("Invalid chunk size: ", chunkSize_);
+	}
+	size_t size = rawImage.getSize();
+	size_t numChunks = (size + chunkSize_ - 1) / chunkSize_;
+
+	File file(filename, File::TRUNCATE);
+	std::vector<uint8_t> table;
+	table.reserve(HEADER_SIZE + numChunks * BASE_ENTRY_SIZE);
+	table.insert(table.end(), std::begin(BASE_MAGIC), std::end(BASE_MAGIC));
+	write32(table, VERSION);
+	write32(table, uint32_t(chunkSize_));
+	write64(table, size);
+	write32(table, uint32_t(numChunks));
+	write32(table, 0);
+	table.resize(HEADER_SIZE + numChunks * BASE_ENTRY_SIZE);
+	file.write(table.data(), table.size()); // placeholder, rewritten below
+
+	// one extra byte in front for calcChunkHash()
+	MemBuffer<uint8_t> buf(chunkSize_ + 1);
+	uint8_t* data = buf.data() + 1;
+	MemBuffer<uint8_t> compressed(LZ4::compressBound(int(chunkSize_)));
+	uint64_t offset = table.size();
+	for (auto i : xrange(numChunks)) {
+		auto num = std::min(chunkSize_, size - i * chunkSize_);
+		rawImage.seek(i * chunkSize_);
+		rawImage.read(data, num);
+		memset(data + num, 0, chunkSize_ - num); // partial last chunk
+
+		TigerHash hash;
+		if (num == chunkSize_) {
+			calcChunkHash(data, chunkSize_, hash);
+		} else {
+			memset(hash.h8, 0, sizeof(hash.h8)); // never used
+		}
+
+		uint32_t compressedSize = 0;
+		uint32_t checksum = 0;
+		if (std::any_of(data, data + chunkSize_, [](uint8_t b) { return b != 0; })) {
+			auto len = size_t(LZ4::compress(data, compressed.data(), int(chunkSize_)));
+			const uint8_t* src = compressed.data();
+			if (len >= chunkSize_) {
+				// incompressible, store as-is
+				len = chunkSize_;
+				src = data;
+			}
+			file.write(src, len);
+			compressedSize = uint32_t(len);
+			checksum = xxhash_impl<false>(src, len);
+		}
+
+		uint8_t* p = &table[HEADER_SIZE + i * BASE_ENTRY_SIZE];
+		Endian::write_UA_L64(p + 0, compressedSize ? offset : 0);
+		Endian::write_UA_L32(p + 8, compressedSize);
+		Endian::write_UA_L32(p + 12, checksum);
+		memcpy(p + 16, hash.h8, sizeof(hash.h8));
+		offset += compressedSize;
+	}
+	file.seek(0);
+	file.write(table.data(), table.size());
+}
+
+void ChunkedImage::createOverlay(const std::string& baseFilename,
+                                 const std::string& overlayFilename)
+{
+	auto baseName = baseFilename;
+	if (!FileOperations::isAbsolutePath(baseName)) {
+		baseName = FileOperations::join(
+			FileOperations::getDirName(overlayFilename), baseName);
+	}
+	ChunkedImage image(baseName); // also checks it's a valid base image
+	if (image.overlay.is_open()) {
+		throw MSXException("Can't create an overlay on top of an overlay: ",
+		                   baseFilename);
+	}
+	std::vector<uint8_t> table(image.chunks.size() * BASE_ENTRY_SIZE);
+	readExact(image.base, HEADER_SIZE, table.data(), table.size());
+
+	std::vector<uint8_t> data;
+	data.insert(data.end(), std::begin(OVERLAY_MAGIC), std::end(OVERLAY_MAGIC));
+	write32(data, VERSION);
+	write32(data, uint32_t(image.chunkSize));
+	write64(data, image.imageSize);
+	write32(data, uint32_t(image.chunks.size()));
+	write32(data, xxhash_impl<false>(table.data(), table.size()));
+	write32(data, uint32_t(baseFilename.size()));
+	data.insert(data.end(), baseFilename.begin(), baseFilename.end());
+	data.resize(data.size() + image.chunks.size() * 8); // all not present
+
+	File file(overlayFilename, File::TRUNCATE);
+	file.write(data.data(), data.size());
+}
+
+bool ChunkedImage::isReadOnly() const
+{
+	return !overlay.is_open() || overlay.isReadOnly();
+}
+
+time_t ChunkedImage::getModificationDate()
+{
+	return overlay.is_open() ? overlay.getModificationDate()
+	                         : base.getModificationDate();
+}
+
+void ChunkedImage::loadChunk(size_t index, uint8_t* buffer)
+{
+	if (!overlayOffsets.empty() && overlayOffsets[index]) {
+		overlay.seek(overlayOffsets[index]);
+		overlay.read(buffer, chunkSize);
+		return;
+	}
+	const auto& c = chunks[index];
+	if (c.compressedSize == 0) {
+		memset(buffer, 0, chunkSize);
+		return;
+	}
+	uint8_t* dst = (c.compressedSize == chunkSize) ? buffer : compressBuf.data();
+	base.seek(c.offset);
+	base.read(dst, c.compressedSize);
+	// The checksum only detects accidental corruption, the image file
+	// itself can't be trusted, so also decompress with all checks enabled.
+	if (xxhash_impl<false>(dst, c.compressedSize) != c.checksum) {
+		throw MSXException("Corrupt chunk in image ", base.getURL());
+	}
+	if (dst != buffer) {
+		auto len = LZ4::decompressSafe(dst, buffer, int(c.compressedSize), int(chunkSize));
+		if ((len < 0) || (size_t(len) != chunkSize)) {
+			throw MSXException("Corrupt chunk in image ", base.getURL());
+		}
+	}
+}
+
+uint8_t* ChunkedImage::getChunk(size_t index)
+{
+	++useCounter;
+	for (auto& c : cache) {
+		if (c.index == index) {
+			c.lastUse = useCounter;
+			return c.data.data();
+		}
+	}
+	// replace the least recently used chunk
+	auto& c = *std::min_element(std::begin(cache), std::end(cache),
+		[](const CachedChunk& x, const CachedChunk& y) { return x.lastUse < y.lastUse; });
+	c.index = size_t(-1); // in case of an exception below
+	c.data.resize(chunkSize);
+	loadChunk(index, c.data.data());
+	c.index = index;
+	c.lastUse = useCounter;
+	return c.data.data();
+}
+
+void ChunkedImage::read(size_t offset, uint8_t* buffer, size_t num)
+{
+	assert((offset + num) <= imageSize);
+	while (num) {
+		auto index = offset / chunkSize;
+		auto inChunk = offset % chunkSize;
+		auto n = std::min(num, chunkSize - inChunk);
+		memcpy(buffer, getChunk(index) + inChunk, n);
+		buffer += n;
+		offset += n;
+		num -= n;
+	}
+}
+
+void ChunkedImage::write(size_t offset, const uint8_t* buffer, size_t num)
+{
+	assert((offset + num) <= imageSize);
+	assert(!isReadOnly());
+	while (num) {
+		auto index = offset / chunkSize;
+		auto inChunk = offset % chunkSize;
+		auto n = std::min(num, chunkSize - inChunk);
+		uint8_t* chunk = getChunk(index);
+		memcpy(chunk + inChunk, buffer, n);
+		if (overlayOffsets[index]) {
+			overlay.seek(overlayOffsets[index] + inChunk);
+			overlay.write(buffer, n);
+		} else {
+			// first write to this chunk: copy it to the overlay, only
+			// then update the table (an interrupted write leaves the
+			// overlay in a consistent state)
+			uint64_t pos = overlay.getSize();
+			overlay.seek(pos);
+			overlay.write(chunk, chunkSize);
+			uint8_t b[8];
+			Endian::write_UA_L64(b, pos);
+			overlay.seek(overlayTableOffset + index * 8);
+			overlay.write(b, sizeof(b));
+			overlayOffsets[index] = pos;
+		}
+		buffer += n;
+		offset += n;
+		num -= n;
+	}
+}
+
+const TigerHash* ChunkedImage::getHash(size_t offset, size_t size) const
+{
+	if ((size != chunkSize) || (offset % chunkSize) ||
+	    ((offset + size) > imageSize)) {
+		return nullptr;
+	}
+	auto index = offset / chunkSize;
+	if (!overlayOffsets.empty() && overlayOffsets[index]) {
+		return nullptr; // modified, must be recalculated
+	}
+	return &chunks[index].hash;
+}
+
+} // namespace openmsx
@@ -0,0 +1,102 @@
+#ifndef CHUNKEDIMAGE_HH
+#define CHUNKEDIMAGE_HH
+
+#include "File.hh"
+#include "MemBuffer.hh"
+#include "tiger.hh"
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+/** A (harddisk or floppy) image split in fixed size chunks that are each
+  * compressed (with LZ4) separately, so that any sector can be read without
+  * decompressing the whole image. All-zero chunks take no space at all.
+  *
+  * Such a base image is never modified. Instead writes go to an overlay
+  * file: that file refers to the base image and only contains the
+  * (uncompressed) chunks that were modified. This allows many machines to
+  * share the same (read-only) base image, each with their own overlay.
+  *
+  * For each chunk of the base image its tiger-tree-hash is stored. That
+  * makes calculating the tiger-tree-hash of the whole image (see HD) cheap:
+  * only the chunks that were modified in the overlay must be hashed.
+  */
+class ChunkedImage
+{
+public:
+	static constexpr size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+	/** Is the given file a chunked image (either a base or an overlay)? */
+	[[nodiscard]] static bool isChunkedImage(File& file);
+
+	/** Open a base image (read-only) or an overlay (writable, unless the
+	  * overlay file itself is read-only).
+	  * @throws MSXException when it's not a (valid) chunked image, or when
+	  *         the base image of an overlay doesn't match.
+	  */
+	explicit ChunkedImage(const std::string& filename);
+
+	/** Convert a raw image to a chunked image. */
+	static void create(File& rawImage, const std::string& filename,
+	                   size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+	/** Create an (empty) overlay for the given base image. The name of
+	  * the base image is stored as given. When it's a relative path, it
+	  * is interpreted relative to the directory of the overlay.
+	  */
+	static void createOverlay(const std::string& baseFilename,
+	                          const std::string& overlayFilename);
+
+	[[nodiscard]] size_t getSize() const { return imageSize; }
+	[[nodiscard]] bool isReadOnly() const;
+	/** The modification time of the overlay, or of the base image when
+	  * there's no overlay. */
+	[[nodiscard]] time_t getModificationDate();
+
+	/** @pre offset + num <= getSize() */
+	void read(size_t offset, uint8_t* buffer, size_t num);
+	/** @pre offset + num <= getSize() and !isReadOnly() */
+	void write(size_t offset, const uint8_t* buffer, size_t num);
+
+	/** If [offset, offset + size) is exactly one (unmodified) chunk, then
+	  * return the tiger-tree-hash of it, otherwise nullptr. */
+	[[nodiscard]] const TigerHash* getHash(size_t offset, size_t size) const;
+
+private:
+	struct ChunkInfo {
+		uint64_t offset; // in base image
+		uint32_t compressedSize; // 0 -> all zeros, chunkSize -> not compressed
+		uint32_t checksum; // xxhash of the compressed data
+		TigerHash hash; // of the uncompressed data
+	};
+	struct CachedChunk {
+		size_t index = size_t(-1);
+		MemBuffer<uint8_t> data;
+		uint64_t lastUse = 0;
+	};
+
+	void openBase(const std::string& filename);
+	void openOverlay(const std::string& filename);
+	uint8_t* getChunk(size_t index);
+	void loadChunk(size_t index, uint8_t* buffer);
+
+	File base;
+	File overlay; // not open if there's no overlay
+	std::vector<ChunkInfo> chunks;
+	std::vector<uint64_t> overlayOffsets; // 0 -> not in overlay
+	size_t overlayTableOffset = 0;
+	size_t chunkSize = 0;
+	size_t imageSize = 0;
+
+	static constexpr size_t NUM_CACHED = 8;
+	CachedChunk cache[NUM_CACHED];
+	uint64_t useCounter = 0;
+	MemBuffer<uint8_t> compressBuf;
+};
+
+} // namespace openmsx
+
+#endif
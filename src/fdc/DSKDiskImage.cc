@@ -9,6 +9,7 @@ DSKDiskImage::DSKDiskImage(const Filename& fileName)
 	, file(std::make_shared<File>(fileName, File::PRE_CACHE))
 {
 	setNbSectors(file->getSize() / sizeof(SectorBuffer));
+	enableSectorCache();
 }
 
 DSKDiskImage::DSKDiskImage(const Filename& fileName,
@@ -17,6 +18,7 @@ DSKDiskImage::DSKDiskImage(const Filename& fileName,
 	, file(std::move(file_))
 {
 	setNbSectors(file->getSize() / sizeof(SectorBuffer));
+	enableSectorCache();
 }
 
 void DSKDiskImage::readSectorImpl(size_t sector, SectorBuffer& buf)
@@ -25,6 +27,18 @@ void DSKDiskImage::readSectorImpl(size_t sector, SectorBuffer& buf)
 	file->read(&buf, sizeof(buf));
 }
 
+void DSKDiskImage::readSectorsImpl(size_t sector, size_t num, SectorBuffer* bufs)
+{
+	file->seek(sector * sizeof(SectorBuffer));
+	file->read(bufs, num * sizeof(SectorBuffer));
+}
+
+void DSKDiskImage::writeSectorsImpl(size_t sector, size_t num, const SectorBuffer* bufs)
+{
+	file->seek(sector * sizeof(SectorBuffer));
+	file->write(bufs, num * sizeof(SectorBuffer));
+}
+
 void DSKDiskImage::writeSectorImpl(size_t sector, const SectorBuffer& buf)
 {
 	file->seek(sector * sizeof(buf));
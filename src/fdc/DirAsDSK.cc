@@ -265,6 +265,7 @@ DirAsDSK::DirAsDSK(DiskChanger& diskChanger_, CliComm& cliComm_,
 	, hostDir(FileOperations::expandTilde(hostDir_.getResolved() + '/'))
 	, syncMode(syncMode_)
 	, lastAccess(EmuTime::zero())
+	, watcher(hostDir)
 	, nofSectors((diskChanger_.isDoubleSidedDrive() ? 2 : 1) * SECTORS_PER_TRACK * NUM_TRACKS)
 	, nofSectorsPerFat((((3 * nofSectors) / (2 * SECTORS_PER_CLUSTER)) + SECTOR_SIZE - 1) / SECTOR_SIZE)
 	, firstSector2ndFAT(FIRST_FAT_SECTOR + nofSectorsPerFat)
@@ -341,7 +342,9 @@ void DirAsDSK::checkCaches()
 		// Happens when dirasdisk is used in virtual_drive.
 		needSync = true;
 	}
-	if (needSync) {
+	// Without host changes the disk content (and so e.g. its sha1sum)
+	// stays the same.
+	if (needSync && watcher.hasChanges()) {
 		flushCaches();
 	}
 }
@@ -365,8 +368,7 @@ void DirAsDSK::readSectorImpl(size_t sector, SectorBuffer& buf)
 			// Happens when dirasdisk is used in virtual_drive.
 			needSync = true;
 		}
-		if (needSync) {
-			syncWithHost();
+		if (needSync && syncChangesWithHost()) {
 			flushCaches(); // e.g. sha1sum
 			// Let the diskdrive report the disk has been ejected.
 			// E.g. a turbor machine uses this to flush its
@@ -379,6 +381,34 @@ void DirAsDSK::readSectorImpl(size_t sector, SectorBuffer& buf)
 	memcpy(&buf, &sectors[sector], sizeof(buf));
 }
 
+// Returns true when something (may) have changed.
+bool DirAsDSK::syncChangesWithHost()
+{
+	auto changes = watcher.getChanges();
+	if (changes.all) {
+		// Not watching the host directory, or some changes were lost.
+		syncWithHost();
+		return true;
+	}
+	bool retry = unmappedHostFiles;
+	bool changed = false;
+	if (!changes.dirs.empty()) {
+		syncWithHost(changes.dirs);
+		changed = true;
+	}
+	if (retry) {
+		// Some host files/directories could not be added before (e.g.
+		// because the virtual disk was full). That may have changed
+		// without any host change (e.g. the MSX deleted a file), so
+		// retry all of them.
+		auto oldSize = mapDirs.size();
+		unmappedHostFiles = false;
+		addNewHostFiles({}, firstDirSector);
+		changed |= mapDirs.size() != oldSize;
+	}
+	return changed;
+}
+
 void DirAsDSK::syncWithHost()
 {
 	// Check for removed host files. This frees up space in the virtual
@@ -393,10 +423,62 @@ void DirAsDSK::syncWithHost()
 	checkModifiedHostFiles();
 
 	// Last add new host files (this can only consume virtual disk space).
+	unmappedHostFiles = false;
 	addNewHostFiles({}, firstDirSector);
 }
 
-void DirAsDSK::checkDeletedHostFiles()
+// Like above, but only look at the given host directories (see
+// DirectoryWatcher), everything else is known to be unchanged.
+void DirAsDSK::syncWithHost(const vector<string>& changedDirs)
+{
+	checkDeletedHostFiles(&changedDirs);
+	checkModifiedHostFiles(&changedDirs);
+	// Parent directories come before their subdirectories, so new host
+	// directories are already added (recursively) when we get to them.
+	for (const auto& hostSubDir : changedDirs) {
+		unsigned msxDirSector = getMsxDirSector(hostSubDir);
+		if (msxDirSector == unsigned(-1)) {
+			// Not (yet) mapped on the msx side, e.g. because it
+			// didn't fit. It will be retried on the next sync.
+			unmappedHostFiles = true;
+			continue;
+		}
+		// Existing subdirectories are handled by their own entry in
+		// 'changedDirs' (if they changed).
+		addNewHostFiles(hostSubDir, msxDirSector, false);
+	}
+}
+
+// Is the host file located in one of the given directories (or is the list
+// of directories not given)?
+static bool inChangedDir(const string& hostName, const vector<string>* changedDirs)
+{
+	if (!changedDirs) return true;
+	auto dir = std::string_view(hostName).substr(0, hostName.find_last_of('/') + 1);
+	return ranges::binary_search(*changedDirs, dir);
+}
+
+// Returns the first sector of the msx directory that corresponds to the given
+// host directory. Or -1 if that host directory is not mapped.
+unsigned DirAsDSK::getMsxDirSector(const string& hostSubDir)
+{
+	if (hostSubDir.empty()) return firstDirSector;
+	assert(StringOp::endsWith(hostSubDir, '/'));
+	DirIndex dirIndex = findHostFileInDSK(
+		hostSubDir.substr(0, hostSubDir.size() - 1));
+	if (dirIndex.sector == unsigned(-1)) return unsigned(-1);
+	if (!(msxDir(dirIndex).attrib & MSXDirEntry::ATT_DIRECTORY)) {
+		return unsigned(-1);
+	}
+	unsigned cluster = msxDir(dirIndex).startCluster;
+	if ((cluster < FIRST_CLUSTER) || (cluster >= maxCluster)) {
+		// Sanity check on cluster range.
+		return unsigned(-1);
+	}
+	return clusterToSector(cluster);
+}
+
+void DirAsDSK::checkDeletedHostFiles(const vector<string>* changedDirs)
 {
 	// This handles both host files and directories.
 	auto copy = mapDirs;
@@ -412,6 +494,7 @@ void DirAsDSK::checkDeletedHostFiles()
 			// mapDirs. Ignore it.
 			continue;
 		}
+		if (!inChangedDir(mapDir.hostName, changedDirs)) continue;
 		string fullHostName = hostDir + mapDir.hostName;
 		bool isMSXDirectory = (msxDir(dirIdx).attrib &
 		                       MSXDirEntry::ATT_DIRECTORY) != 0;
@@ -492,7 +575,7 @@ void DirAsDSK::freeFATChain(unsigned cluster)
 	}
 }
 
-void DirAsDSK::checkModifiedHostFiles()
+void DirAsDSK::checkModifiedHostFiles(const vector<string>* changedDirs)
 {
 	auto copy = mapDirs;
 	for (const auto& [dirIdx, mapDir] : copy) {
@@ -500,6 +583,7 @@ void DirAsDSK::checkModifiedHostFiles()
 			// See comment in checkDeletedHostFiles().
 			continue;
 		}
+		if (!inChangedDir(mapDir.hostName, changedDirs)) continue;
 		string fullHostName = hostDir + mapDir.hostName;
 		bool isMSXDirectory = (msxDir(dirIdx).attrib &
 		                       MSXDirEntry::ATT_DIRECTORY) != 0;
@@ -683,7 +767,8 @@ static size_t weight(const string& hostName)
 	return result;
 }
 
-void DirAsDSK::addNewHostFiles(const string& hostSubDir, unsigned msxDirSector)
+void DirAsDSK::addNewHostFiles(const string& hostSubDir, unsigned msxDirSector,
+                               bool recurseExisting)
 {
 	assert(!StringOp::startsWith(hostSubDir, '/'));
 	assert(hostSubDir.empty() || StringOp::endsWith(hostSubDir, '/'));
@@ -711,20 +796,24 @@ void DirAsDSK::addNewHostFiles(const string& hostSubDir, unsigned msxDirSector)
 				throw MSXException("Error accessing ", fullHostName);
 			}
 			if (FileOperations::isDirectory(fst)) {
-				addNewDirectory(hostSubDir, hostName, msxDirSector, fst);
+				addNewDirectory(hostSubDir, hostName, msxDirSector, fst,
+				                recurseExisting);
 			} else if (FileOperations::isRegularFile(fst)) {
 				addNewHostFile(hostSubDir, hostName, msxDirSector, fst);
 			} else {
-				throw MSXException("Not a regular file: ", fullHostName);
+				// Will never be mapped, so don't retry it.
+				cliComm.printWarning("Not a regular file: ", fullHostName);
 			}
 		} catch (MSXException& e) {
 			cliComm.printWarning(e.getMessage());
+			unmappedHostFiles = true;
 		}
 	}
 }
 
 void DirAsDSK::addNewDirectory(const string& hostSubDir, const string& hostName,
-                               unsigned msxDirSector, FileOperations::Stat& fst)
+                               unsigned msxDirSector, FileOperations::Stat& fst,
+                               bool recurseExisting)
 {
 	string hostPath = hostSubDir + hostName;
 	DirIndex dirIndex = findHostFileInDSK(hostPath);
@@ -766,12 +855,17 @@ void DirAsDSK::addNewDirectory(const string& hostSubDir, const string& hostName,
 		msxDir(idx1).startCluster = msxDirSector == firstDirSector
 		                          ? 0 : sectorToCluster(msxDirSector);
 	} else {
+		if (!recurseExisting) {
+			// Only the content of new directories is needed.
+			return;
+		}
 		if (!(msxDir(dirIndex).attrib & MSXDirEntry::ATT_DIRECTORY)) {
 			// Should rarely happen because checkDeletedHostFiles()
 			// recently checked this. (It could happen when a host
 			// directory is *just*recently* created with the same
 			// name as an existing msx file). Ignore, it will be
 			// corrected in the next sync.
+			unmappedHostFiles = true;
 			return;
 		}
 		unsigned cluster = msxDir(dirIndex).startCluster;
@@ -783,7 +877,8 @@ void DirAsDSK::addNewDirectory(const string& hostSubDir, const string& hostName,
 	}
 
 	// Recursively process this directory.
-	addNewHostFiles(strCat(hostSubDir, hostName, '/'), newMsxDirSector);
+	addNewHostFiles(strCat(hostSubDir, hostName, '/'), newMsxDirSector,
+	                recurseExisting);
 }
 
 void DirAsDSK::addNewHostFile(const string& hostSubDir, const string& hostName,
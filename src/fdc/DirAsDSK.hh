@@ -3,6 +3,7 @@
 
 #include "SectorBasedDisk.hh"
 #include "DiskImageUtils.hh"
+#include "DirectoryWatcher.hh"
 #include "FileOperations.hh"
 #include "EmuTime.hh"
 #include "hash_map.hh"
@@ -68,14 +69,18 @@ private:
 	void writeDataSector(unsigned sector, const SectorBuffer& buf);
 	void writeDIREntry(DirIndex dirIndex, DirIndex dirDirIndex,
 	                   const MSXDirEntry& newEntry);
+	bool syncChangesWithHost();
 	void syncWithHost();
-	void checkDeletedHostFiles();
+	void syncWithHost(const std::vector<std::string>& changedDirs);
+	void checkDeletedHostFiles(const std::vector<std::string>* changedDirs = nullptr);
 	void deleteMSXFile(DirIndex dirIndex);
 	void deleteMSXFilesInDir(unsigned msxDirSector);
 	void freeFATChain(unsigned cluster);
-	void addNewHostFiles(const std::string& hostSubDir, unsigned msxDirSector);
+	void addNewHostFiles(const std::string& hostSubDir, unsigned msxDirSector,
+	                     bool recurseExisting = true);
 	void addNewDirectory(const std::string& hostSubDir, const std::string& hostName,
-	                     unsigned msxDirSector, FileOperations::Stat& fst);
+	                     unsigned msxDirSector, FileOperations::Stat& fst,
+	                     bool recurseExisting);
 	void addNewHostFile(const std::string& hostSubDir, const std::string& hostName,
 	                    unsigned msxDirSector, FileOperations::Stat& fst);
 	DirIndex fillMSXDirEntry(
@@ -87,7 +92,8 @@ private:
 	unsigned nextMsxDirSector(unsigned sector);
 	bool checkMSXFileExists(const std::string& msxfilename,
 	                        unsigned msxDirSector);
-	void checkModifiedHostFiles();
+	void checkModifiedHostFiles(const std::vector<std::string>* changedDirs = nullptr);
+	unsigned getMsxDirSector(const std::string& hostSubDir);
 	void setMSXTimeStamp(DirIndex dirIndex, FileOperations::Stat& fst);
 	void importHostFile(DirIndex dirIndex, FileOperations::Stat& fst);
 	void exportToHost(DirIndex dirIndex, DirIndex dirDirIndex);
@@ -128,6 +134,15 @@ private:
 
 	EmuTime lastAccess; // last time there was a sector read/write
 
+	// Reports which host directories changed, so that we don't have to
+	// rescan the whole host directory tree on each sync.
+	DirectoryWatcher watcher;
+
+	// Some host files/directories could not be mapped in the last sync
+	// (e.g. disk full). As long as this is set, all host directories are
+	// checked for new files on each sync, not only the changed ones.
+	bool unmappedHostFiles = false;
+
 	// For each directory entry that has a mapped host file/directory we
 	// store the name, last modification time and size of the corresponding
 	// host file/dir.
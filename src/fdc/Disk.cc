@@ -17,6 +17,7 @@ void Disk::writeTrack(byte track, byte side, const RawTrack& input)
 		throw WriteProtectedException();
 	}
 	writeTrackImpl(track, side, input);
+	flushSectorCache();
 	flushCaches();
 }
 
@@ -100,6 +100,11 @@ bool DummyDrive::isDummyDrive() const
 	return true;
 }
 
+bool DummyDrive::isInstant() const
+{
+	return false;
+}
+
 void DummyDrive::applyWd2793ReadTrackQuirk()
 {
 	// nothing
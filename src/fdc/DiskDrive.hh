@@ -18,6 +18,8 @@ public:
 
 public:
 	static constexpr unsigned ROTATIONS_PER_SECOND = 5; // 300rpm
+	/** In instant mode, the mechanics of the drive are this much faster. */
+	static constexpr unsigned INSTANT_SPEEDUP = 32;
 
 	virtual ~DiskDrive() = default;
 
@@ -96,6 +98,21 @@ public:
 	/** See RawTrack::applyWd2793ReadTrackQuirk() */
 	virtual void applyWd2793ReadTrackQuirk() = 0;
 	virtual void invalidateWd2793ReadTrackQuirk() = 0;
+
+	/** Is the drive in 'instant' mode? In this mode the disk rotates
+	 * (INSTANT_SPEEDUP times) faster and the FDC also shortens its
+	 * mechanical delays (head stepping, head loading) by that factor.
+	 * Data transfers are no longer limited by the rotation speed, only by
+	 * how fast the CPU reads/writes the data. The sequence of status
+	 * flags and interrupts remains the same. Only software that measures
+	 * disk timing (e.g. some copy protections) notices the difference.
+	 */
+	virtual bool isInstant() const = 0;
+
+	/** Shorten a mechanical delay in instant mode. */
+	EmuDuration mechanicalDelay(EmuDuration::param delay) const {
+		return isInstant() ? delay / INSTANT_SPEEDUP : delay;
+	}
 };
 
 
@@ -126,6 +143,7 @@ public:
 	bool isDummyDrive() const override;
 	void applyWd2793ReadTrackQuirk() override;
 	void invalidateWd2793ReadTrackQuirk() override;
+	bool isInstant() const override;
 };
 
 } // namespace openmsx
@@ -3,6 +3,8 @@
 #include "File.hh"
 #include "FileContext.hh"
 #include "DSKDiskImage.hh"
+#include "ChunkedDiskImage.hh"
+#include "ChunkedImage.hh"
 #include "XSADiskImage.hh"
 #include "DMKDiskImage.hh"
 #include "RamDSKDiskImage.hh"
@@ -55,6 +57,9 @@ std::unique_ptr<Disk> DiskFactory::createDisk(
 	}
 	try {
 		auto file = std::make_shared<File>(filename, File::PRE_CACHE);
+		if (ChunkedImage::isChunkedImage(*file)) {
+			return std::make_unique<ChunkedDiskImage>(filename);
+		}
 		try {
 			// first try XSA
 			return std::make_unique<XSADiskImage>(filename, *file);
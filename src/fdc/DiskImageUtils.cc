@@ -179,7 +179,7 @@ static void setBootSector(MSXBootSector& boot, size_t nbSectors,
 	firstDataSector = rootDirStart + nbRootDirSectors;
 }
 
-void format(SectorAccessibleDisk& disk, bool dos1)
+void format(SectorAccessibleDisk& disk, bool dos1, bool fillData)
 {
 	// first create a bootsector for given partition size
 	size_t nbSectors = disk.getNbSectors();
@@ -202,6 +202,8 @@ void format(SectorAccessibleDisk& disk, bool dos1)
 	buf.raw[2] = 0xFF;
 	disk.writeSector(1, buf);
 
+	if (!fillData) return;
+
 	// write 'empty' data sectors
 	memset(&buf, 0xE5, sizeof(buf));
 	for (size_t i = firstDataSector; i < nbSectors; ++i) {
@@ -222,7 +224,8 @@ static void logicalToCHS(unsigned logical, unsigned& cylinder,
 	cylinder = tmp / 16;
 }
 
-void partition(SectorAccessibleDisk& disk, const std::vector<unsigned>& sizes)
+void partition(SectorAccessibleDisk& disk, const std::vector<unsigned>& sizes,
+               bool fillData)
 {
 	assert(sizes.size() <= 31);
 
@@ -252,7 +255,7 @@ void partition(SectorAccessibleDisk& disk, const std::vector<unsigned>& sizes)
 		p.start = partitionOffset;
 		p.size = sizes[i];
 		DiskPartition diskPartition(disk, partitionOffset, partitionNbSectors);
-		format(diskPartition);
+		format(diskPartition, false, fillData);
 		partitionOffset += partitionNbSectors;
 	}
 	disk.writeSector(0, buf);
@@ -120,15 +120,20 @@ namespace DiskImageUtils {
 	 * The formatting depends on the size of the image.
 	 * @param disk the disk/partition image to be formatted
 	 * @param dos1 set to true if you want to force dos1 formatting (boot sector)
+	 * @param fillData set to false to leave the data sectors untouched
+	 *        (instead of filling them with 0xE5), e.g. to keep a newly
+	 *        created (sparse) image file small
 	 */
-	void format(SectorAccessibleDisk& disk, bool dos1 = false);
+	void format(SectorAccessibleDisk& disk, bool dos1 = false,
+	            bool fillData = true);
 
 	/** Write a partition table to the given disk and format each partition
 	 * @param disk The disk to partition.
 	 * @param sizes The number of sectors for each partition.
+	 * @param fillData see format()
 	 */
 	void partition(SectorAccessibleDisk& disk,
-	               const std::vector<unsigned>& sizes);
+	               const std::vector<unsigned>& sizes, bool fillData = true);
 };
 
 } // namespace openmsx
@@ -1,4 +1,5 @@
 #include "DiskManipulator.hh"
+#include "ChunkedImage.hh"
 #include "DiskContainer.hh"
 #include "MSXtar.hh"
 #include "DiskImageUtils.hh"
@@ -14,7 +15,9 @@
 #include "SectorBasedDisk.hh"
 #include "StringOp.hh"
 #include "TclObject.hh"
+#include "ThreadPool.hh"
 #include "one_of.hh"
+#include "outer.hh"
 #include "ranges.hh"
 #include "stl.hh"
 #include "strCat.hh"
@@ -35,6 +38,7 @@ DiskManipulator::DiskManipulator(CommandController& commandController_,
                                  Reactor& reactor_)
 	: Command(commandController_, "diskmanipulator")
 	, reactor(reactor_)
+	, cacheStatisticsInfo(reactor.getOpenMSXInfoCommand())
 {
 }
 
@@ -141,10 +145,11 @@ void DiskManipulator::execute(span<const TclObject> tokens, TclObject& result)
 	}
 
 	string_view subcmd = tokens[1].getString();
-	if (((tokens.size() != 4)                     && (subcmd == one_of("savedsk", "mkdir"))) ||
+	if (((tokens.size() != 4)                     && (subcmd == one_of("savedsk", "mkdir", "compress", "overlay"))) ||
 	    ((tokens.size() != 3)                     && (subcmd ==        "dir"             ))  ||
 	    ((tokens.size() < 3 || tokens.size() > 4) && (subcmd == one_of("format", "chdir")))  ||
-	    ((tokens.size() < 4)                      && (subcmd == one_of("export", "import", "create")))) {
+	    ((tokens.size() < 4)                      && (subcmd == one_of("export", "import", "create"))) ||
+	    ((tokens.size() < 3)                      && (subcmd ==        "batch"           ))) {
 		throw CommandException("Incorrect number of parameters");
 	}
 
@@ -183,6 +188,12 @@ void DiskManipulator::execute(span<const TclObject> tokens, TclObject& result)
 	} else if (subcmd == "create") {
 		create(tokens);
 
+	} else if (subcmd == "compress") {
+		compress(tokens[2].getString(), tokens[3].getString());
+
+	} else if (subcmd == "overlay") {
+		overlay(tokens[2].getString(), tokens[3].getString());
+
 	} else if (subcmd == "format") {
 		bool dos1 = false;
 		string_view drive = tokens[2].getString();
@@ -201,6 +212,9 @@ void DiskManipulator::execute(span<const TclObject> tokens, TclObject& result)
 		auto& settings = getDriveSettings(tokens[2].getString());
 		result = dir(settings);
 
+	} else if (subcmd == "batch") {
+		result = batch(span<const TclObject>(std::begin(tokens) + 2, std::end(tokens)));
+
 	} else {
 		throw CommandException("Unknown subcommand: ", subcmd);
 	}
@@ -246,6 +260,18 @@ string DiskManipulator::help(const vector<string>& tokens) const
 	    "postfix M for megabyte.\n"
 	    "When using the -dos1 option, the boot sector of the created image will be MSX-DOS1\n"
 	    "compatible.\n";
+	  } else if (tokens[1] == "compress") {
+	  helptext=
+	    "diskmanipulator compress <image> <chunked image>\n"
+	    "Convert a (disk or harddisk) image to the chunked image format. In that format each\n"
+	    "64kB chunk is compressed separately, so the image can still be accessed quickly. A\n"
+	    "chunked image itself is never modified, to write to it first create an overlay.\n";
+	  } else if (tokens[1] == "overlay") {
+	  helptext=
+	    "diskmanipulator overlay <chunked image> <overlay>\n"
+	    "Create an overlay file for a chunked image. Use the overlay as (harddisk) image: all\n"
+	    "writes go to the overlay, the chunked image remains unmodified and can be shared by\n"
+	    "many overlays (e.g. by many emulated machines).\n";
 	  } else if (tokens[1] == "format") {
 	  helptext=
 	    "diskmanipulator format <disk name>\n"
@@ -255,6 +281,19 @@ string DiskManipulator::help(const vector<string>& tokens) const
 	  helptext=
 	    "diskmanipulator dir <disk name>\n"
 	    "Shows the content of the current directory on <disk name>\n";
+	  } else if (tokens[1] == "batch") {
+	  helptext=
+	    "diskmanipulator batch <job> [<job>...]\n"
+	    "Import in or export from many disk image files at once, the images don't need to be\n"
+	    "inserted in a drive. Each job is a list of one of these forms:\n"
+	    "  import [-partition <nr>] <dskfilename> <host directory|host file> [...]\n"
+	    "  export [-partition <nr>] <dskfilename> <host directory>\n"
+	    "Import works on the root directory of the image (or partition), export extracts all\n"
+	    "files and subdirs. Different images are processed in parallel, jobs on the same image\n"
+	    "run in the given order. Use e.g.\n"
+	    "  openmsx -diskmanipulator batch 'import a.dsk files' 'export b.dsk out'\n"
+	    "to run this from a shell, without starting an MSX machine (quote each job, so that it\n"
+	    "is passed as a single argument).\n";
 	  } else {
 	  helptext = "Unknown diskmanipulator subcommand: " + tokens[1];
 	  }
@@ -270,6 +309,9 @@ string DiskManipulator::help(const vector<string>& tokens) const
 	    "                                               directory on <disk name>\n"
 	    "diskmanipulator import <disk> <dir/file> ... : import files and subdirs from <dir/file>\n"
 	    "diskmanipulator export <disk> <host dir>     : export all files on <disk> to <host dir>\n"
+	    "diskmanipulator compress <fn> <chunked fn>   : convert image <fn> to a chunked image\n"
+	    "diskmanipulator overlay <chunked fn> <fn>    : create an overlay <fn> for a chunked image\n"
+	    "diskmanipulator batch <job> [<job> ...]      : import/export for many dsk files at once\n"
 	    "For more info use 'help diskmanipulator <subcommand>'.\n";
 	}
 	return helptext;
@@ -280,10 +322,17 @@ void DiskManipulator::tabCompletion(vector<string>& tokens) const
 	if (tokens.size() == 2) {
 		static constexpr const char* const cmds[] = {
 			"import", "export", "savedsk", "dir", "create",
-			"format", "chdir", "mkdir",
+			"format", "chdir", "mkdir", "compress", "overlay",
+			"batch",
 		};
 		completeString(tokens, cmds);
 
+	} else if ((tokens.size() <= 4) && (tokens[1] == one_of("compress", "overlay"))) {
+		completeFileName(tokens, userFileContext());
+
+	} else if (tokens[1] == "batch") {
+		// nothing, the arguments are lists
+
 	} else if ((tokens.size() == 3) && (tokens[1] == "create")) {
 		completeFileName(tokens, userFileContext());
 
@@ -341,6 +390,26 @@ void DiskManipulator::savedsk(const DriveSettings& driveData,
 	}
 }
 
+void DiskManipulator::compress(string_view imageName, string_view chunkedName)
+{
+	try {
+		File image(userFileContext().resolve(imageName));
+		ChunkedImage::create(image, FileOperations::expandTilde(chunkedName));
+	} catch (MSXException& e) {
+		throw CommandException("Couldn't create chunked image: ", e.getMessage());
+	}
+}
+
+void DiskManipulator::overlay(string_view chunkedName, string_view overlayName)
+{
+	try {
+		ChunkedImage::createOverlay(userFileContext().resolve(chunkedName),
+		                            FileOperations::expandTilde(overlayName));
+	} catch (MSXException& e) {
+		throw CommandException("Couldn't create overlay: ", e.getMessage());
+	}
+}
+
 void DiskManipulator::create(span<const TclObject> tokens)
 {
 	vector<unsigned> sizes;
@@ -409,19 +478,23 @@ void DiskManipulator::create(span<const TclObject> tokens)
 	// create file with correct size
 	Filename filename(string(tokens[2].getString()));
 	try {
-		File file(filename, File::CREATE);
+		File file(filename, File::TRUNCATE);
 		file.truncate(totalSectors * SectorBasedDisk::SECTOR_SIZE);
 	} catch (FileException& e) {
 		throw CommandException("Couldn't create image: ", e.getMessage());
 	}
 
 	// initialize (create partition tables and format partitions)
+	// The new file only contains zeros (a hole, on filesystems that
+	// support sparse files), so don't write the data sectors: a
+	// multi-GB image then only takes disk space for the data that's
+	// actually used.
 	DSKDiskImage image(filename);
 	if (sizes.size() > 1) {
-		DiskImageUtils::partition(image, sizes);
+		DiskImageUtils::partition(image, sizes, false);
 	} else {
 		// only one partition specified, don't create partition table
-		DiskImageUtils::format(image, dos1);
+		DiskImageUtils::format(image, dos1, false);
 	}
 }
 
@@ -542,4 +615,265 @@ void DiskManipulator::exprt(DriveSettings& driveData, string_view dirname,
 	}
 }
 
+// Identifies the image file, also when it's named differently (relative
+// path, symlink, ...) in different jobs.
+static string getImageKey(const string& filename)
+{
+#ifndef _WIN32
+	FileOperations::Stat st;
+	if (FileOperations::getStat(filename, st)) {
+		return strCat(st.st_dev, ':', st.st_ino);
+	}
+#endif
+	return FileOperations::getAbsolutePath(filename);
+}
+
+string DiskManipulator::batch(span<const TclObject> jobs)
+{
+	// The jobs on the same image file run in the given order (each with
+	// its own MSXtar), the different images are processed in parallel.
+	// Nothing is shared between the images. Only opening the images
+	// (e.g. the cache of decompressed files) is not thread-safe, that's
+	// done upfront. Per group of images, so that we don't need a file
+	// descriptor for each image at the same time.
+	struct Job {
+		bool exprt = false;
+		unsigned partition = 0;
+		string imageName;
+		vector<string> hostNames;
+		unique_ptr<DiskPartition> disk;
+		string messages;
+		bool failed = false;
+	};
+	struct Image {
+		string key;
+		vector<Job*> jobs;
+		unique_ptr<DSKDiskImage> image;
+	};
+
+	auto& interp = getInterpreter();
+	vector<Job> todo;
+	todo.reserve(jobs.size()); // the Images point into this vector
+	for (auto& j : jobs) {
+		auto& job = todo.emplace_back();
+		auto num = j.getListLength(interp);
+		unsigned i = 0;
+		auto next = [&]() -> string_view {
+			if (i == num) {
+				throw CommandException("Incomplete batch job: ", j.getString());
+			}
+			return j.getListIndex(interp, i++).getString();
+		};
+		auto action = next();
+		if (action == one_of("import", "export")) {
+			job.exprt = action == "export";
+		} else {
+			throw CommandException("Unknown batch action: ", action);
+		}
+		job.imageName = string(next());
+		if (job.imageName == "-partition") {
+			try {
+				job.partition = StringOp::fast_stou(next());
+			} catch (std::invalid_argument&) {
+				throw CommandException("Invalid partition number");
+			}
+			job.imageName = string(next());
+		}
+		do {
+			job.hostNames.push_back(FileOperations::expandTilde(next()));
+		} while (i < num);
+		if (job.exprt) {
+			if (job.hostNames.size() != 1) {
+				throw CommandException("Export needs exactly one host directory: ", j.getString());
+			}
+			if (!FileOperations::isDirectory(job.hostNames.front())) {
+				throw CommandException(job.hostNames.front(), " is not a directory");
+			}
+		}
+	}
+
+	vector<Image> images;
+	for (auto& job : todo) {
+		auto key = getImageKey(FileOperations::expandTilde(job.imageName));
+		auto it = ranges::find_if(images, [&](auto& im) { return im.key == key; });
+		if (it == images.end()) {
+			it = images.insert(images.end(), Image{std::move(key), {}, {}});
+		}
+		it->jobs.push_back(&job);
+	}
+
+	auto process = [&](Job& job) {
+		MSXtar workhorse(*job.disk);
+		if (job.exprt) {
+			workhorse.getDir(job.hostNames.front());
+			return;
+		}
+		for (auto& s : job.hostNames) {
+			FileOperations::Stat st;
+			if (!FileOperations::getStat(s, st)) {
+				throw MSXException("Non-existing file ", s);
+			}
+			if (FileOperations::isDirectory(st)) {
+				job.messages += workhorse.addDir(s);
+			} else if (FileOperations::isRegularFile(st)) {
+				job.messages += workhorse.addFile(s);
+			} else {
+				// ignore other stuff (sockets, device nodes, ..)
+				strAppend(job.messages, "Ignoring ", s, '\n');
+			}
+		}
+	};
+
+	constexpr size_t GROUP_SIZE = 64;
+	for (size_t first = 0; first < images.size(); first += GROUP_SIZE) {
+		auto num = std::min(GROUP_SIZE, images.size() - first);
+		auto group = span<Image>(images).subspan(first, num);
+		for (auto& im : group) {
+			try {
+				Filename filename(im.jobs.front()->imageName);
+				im.image = std::make_unique<DSKDiskImage>(
+					filename, std::make_shared<File>(filename));
+			} catch (MSXException& e) {
+				for (auto* job : im.jobs) {
+					job->messages = e.getMessage();
+					job->failed = true;
+				}
+				continue;
+			}
+			for (auto* job : im.jobs) {
+				try {
+					if (job->partition != 0) {
+						DiskImageUtils::checkFAT12Partition(*im.image, job->partition);
+					} else if (DiskImageUtils::hasPartitionTable(*im.image)) {
+						throw MSXException("Please select partition number.");
+					}
+					job->disk = std::make_unique<DiskPartition>(*im.image, job->partition);
+				} catch (MSXException& e) {
+					job->messages = std::move(e).getMessage();
+					job->failed = true;
+				}
+			}
+		}
+		getThreadPool().parallelFor(unsigned(num), [&](unsigned k) {
+			for (auto* job : group[k].jobs) {
+				if (job->failed) continue;
+				try {
+					process(*job);
+				} catch (MSXException& e) {
+					strAppend(job->messages, e.getMessage(), '\n');
+					job->failed = true;
+				}
+			}
+		});
+		for (auto& im : group) {
+			for (auto* job : im.jobs) job->disk.reset();
+			im.image.reset(); // closes the image
+		}
+	}
+
+	string result;
+	string errors;
+	for (auto& job : todo) {
+		auto& out = job.failed ? errors : result;
+		if (!job.messages.empty()) {
+			strAppend(out, job.imageName, ": ", job.messages);
+			if (!StringOp::endsWith(out, '\n')) out += '\n';
+		}
+	}
+	if (!errors.empty()) {
+		throw CommandException(result, errors);
+	}
+	return result;
+}
+
+ThreadPool& DiskManipulator::getThreadPool()
+{
+	if (!threadPool) {
+		threadPool = std::make_unique<ThreadPool>();
+	}
+	return *threadPool;
+}
+
+
+// class CacheStatisticsInfoTopic
+
+DiskManipulator::CacheStatisticsInfoTopic::CacheStatisticsInfoTopic(
+		InfoCommand& openMSXInfoCommand)
+	: InfoTopic(openMSXInfoCommand, "disk_cache_statistics")
+{
+}
+
+void DiskManipulator::CacheStatisticsInfoTopic::execute(
+	span<const TclObject> tokens, TclObject& result) const
+{
+	auto& manipulator = OUTER(DiskManipulator, cacheStatisticsInfo);
+	auto getStats = [](const SectorAccessibleDisk& disk) {
+		const auto& stats = disk.getCacheStatistics();
+		TclObject dict;
+		dict.addDictKeyValues(
+			"sector_cache", disk.hasSectorCache(),
+			"sector_reads", stats.sectorReads,
+			"sector_hits",  stats.sectorHits,
+			"read_ahead",   stats.readAhead,
+			"image_reads",  stats.imageReads,
+			"image_writes", stats.imageWrites,
+			"track_reads",  stats.trackReads,
+			"track_hits",   stats.trackHits);
+		return dict;
+	};
+	switch (tokens.size()) {
+	case 2:
+		for (auto& d : manipulator.drives) {
+			if (auto* disk = d.drive->getSectorAccessibleDisk()) {
+				result.addDictKeyValue(d.driveName, getStats(*disk));
+			}
+		}
+		break;
+	case 3: {
+		auto name = tokens[2].getString();
+		auto it = manipulator.findDriveSettings(name);
+		if (it == end(manipulator.drives)) {
+			it = manipulator.findDriveSettings(
+				strCat(manipulator.getMachinePrefix(), name));
+		}
+		if (it == end(manipulator.drives)) {
+			throw CommandException("Unknown drive: ", name);
+		}
+		auto* disk = it->drive->getSectorAccessibleDisk();
+		if (!disk) {
+			throw CommandException("Unsupported disk type.");
+		}
+		result = getStats(*disk);
+		break;
+	}
+	default:
+		throw CommandException("Too many parameters");
+	}
+}
+
+string DiskManipulator::CacheStatisticsInfoTopic::help(const vector<string>& /*tokens*/) const
+{
+	return "Shows statistics about the caching of disk and harddisk "
+	       "images: how many (unpatched) sectors were read and how many "
+	       "of those came from the sector cache, how many sectors were "
+	       "read ahead, the number of read and write requests to the "
+	       "underlying image, and for floppy images how often a track "
+	       "was read and found in the track cache. All values are totals "
+	       "since the image was inserted (for harddisks: since the "
+	       "harddisk was created). Without argument the "
+	       "statistics of all drives are returned (as a dict).\n";
+}
+
+void DiskManipulator::CacheStatisticsInfoTopic::tabCompletion(vector<string>& tokens) const
+{
+	if (tokens.size() == 3) {
+		auto& manipulator = OUTER(DiskManipulator, cacheStatisticsInfo);
+		vector<string> names;
+		for (auto& d : manipulator.drives) {
+			append(names, {d.driveName, d.drive->getContainerName()});
+		}
+		completeString(tokens, names);
+	}
+}
+
 } // namespace openmsx
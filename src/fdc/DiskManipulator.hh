@@ -2,6 +2,7 @@
 #define FILEMANIPULATOR_HH
 
 #include "Command.hh"
+#include "InfoTopic.hh"
 #include <string_view>
 #include <vector>
 #include <memory>
@@ -14,6 +15,7 @@ class SectorAccessibleDisk;
 class DiskPartition;
 class MSXtar;
 class Reactor;
+class ThreadPool;
 
 class DiskManipulator final : public Command
 {
@@ -53,6 +55,8 @@ private:
 	                                  DriveSettings& driveData);
 
 	void create(span<const TclObject> tokens);
+	void compress(std::string_view imageName, std::string_view chunkedName);
+	void overlay(std::string_view chunkedName, std::string_view overlayName);
 	void savedsk(const DriveSettings& driveData,
 	             std::string_view filename);
 	void format(DriveSettings& driveData, bool dos1);
@@ -63,8 +67,19 @@ private:
 	                   span<const TclObject> lists);
 	void exprt(DriveSettings& driveData, std::string_view dirname,
 	           span<const TclObject> lists);
+	std::string batch(span<const TclObject> jobs);
+	ThreadPool& getThreadPool();
 
 	Reactor& reactor;
+	std::unique_ptr<ThreadPool> threadPool; // created on first use
+
+	struct CacheStatisticsInfoTopic final : InfoTopic {
+		explicit CacheStatisticsInfoTopic(InfoCommand& openMSXInfoCommand);
+		void execute(span<const TclObject> tokens,
+			     TclObject& result) const override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} cacheStatisticsInfo;
 };
 
 } // namespace openmsx
@@ -58,6 +58,18 @@ void DiskPartition::writeSectorImpl(size_t sector, const SectorBuffer& buf)
 	parent.writeSector(start + sector, buf);
 }
 
+void DiskPartition::readSectorsImpl(
+	size_t sector, size_t num, SectorBuffer* bufs)
+{
+	parent.readSectorRange(start + sector, num, bufs);
+}
+
+void DiskPartition::writeSectorsImpl(
+	size_t sector, size_t num, const SectorBuffer* bufs)
+{
+	parent.writeSectorRange(start + sector, num, bufs);
+}
+
 bool DiskPartition::isWriteProtectedImpl() const
 {
 	return parent.isWriteProtected();
@@ -27,6 +27,8 @@ public:
 private:
 	void readSectorImpl (size_t sector,       SectorBuffer& buf) override;
 	void writeSectorImpl(size_t sector, const SectorBuffer& buf) override;
+	void readSectorsImpl (size_t sector, size_t num,       SectorBuffer* bufs) override;
+	void writeSectorsImpl(size_t sector, size_t num, const SectorBuffer* bufs) override;
 	bool isWriteProtectedImpl() const override;
 
 	SectorAccessibleDisk& parent;
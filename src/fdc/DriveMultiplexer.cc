@@ -137,6 +137,11 @@ bool DriveMultiplexer::isDummyDrive() const
 	return drive[selected]->isDummyDrive();
 }
 
+bool DriveMultiplexer::isInstant() const
+{
+	return drive[selected]->isInstant();
+}
+
 void DriveMultiplexer::applyWd2793ReadTrackQuirk()
 {
 	drive[selected]->applyWd2793ReadTrackQuirk();
@@ -48,6 +48,7 @@ public:
 	bool isDummyDrive() const override;
 	void applyWd2793ReadTrackQuirk() override;
 	void invalidateWd2793ReadTrackQuirk() override;
+	bool isInstant() const override;
 
 	bool isDiskInserted(DriveNum num) const;
 	bool diskChanged(DriveNum num);
@@ -16,9 +16,11 @@
 #include "File.hh"
 #include "one_of.hh"
 #include "stl.hh"
+#include <algorithm>
 #include <cstring>
 #include <cassert>
 #include <cctype>
+#include <vector>
 #include <sys/stat.h>
 
 using std::string;
@@ -29,6 +31,9 @@ namespace openmsx {
 constexpr unsigned BAD_FAT = 0xFF7;
 constexpr unsigned EOF_FAT = 0xFFF; // actually 0xFF8-0xFFF, signals EOF in FAT12
 constexpr unsigned SECTOR_SIZE = SectorAccessibleDisk::SECTOR_SIZE;
+// File content is transferred in runs of consecutive clusters of (at most)
+// this many sectors, with a single disk access per run.
+constexpr unsigned MAX_RUN_SECTORS = 128;
 
 constexpr byte T_MSX_REG  = 0x00; // Normal file
 constexpr byte T_MSX_READ = 0x01; // Read-Only file
@@ -147,6 +152,7 @@ MSXtar::MSXtar(SectorAccessibleDisk& sectordisk)
 
 	// cache complete FAT
 	fatCacheDirty = false;
+	freeClusterHint = 2;
 	fatBuffer.resize(sectorsPerFat);
 	for (unsigned i = 0; i < sectorsPerFat; ++i) {
 		disk.readSector(i + 1, fatBuffer[i]);
@@ -200,17 +206,22 @@ void MSXtar::writeFAT(unsigned clnr, unsigned val)
 		p[1] = (p[1] & 0xF0) + ((val >> 8) & 0x0F);
 	}
 	fatCacheDirty = true;
+	if (val == 0) freeClusterHint = std::min(freeClusterHint, clnr);
 }
 
 // Find the next clusternumber marked as free in the FAT
 // @throws When no more free clusters
 unsigned MSXtar::findFirstFreeCluster()
 {
-	for (unsigned cluster = 2; cluster < maxCluster; ++cluster) {
+	// There are no free clusters below 'freeClusterHint', so adding many
+	// (or large) files doesn't rescan the whole FAT for each cluster.
+	for (unsigned cluster = freeClusterHint; cluster < maxCluster; ++cluster) {
 		if (readFAT(cluster) == 0) {
+			freeClusterHint = cluster;
 			return cluster;
 		}
 	}
+	freeClusterHint = maxCluster;
 	throw MSXException("Disk full.");
 }
 
@@ -421,7 +432,13 @@ unsigned MSXtar::addSubdir(
 
 static void getTimeDate(time_t& totalSeconds, unsigned& time, unsigned& date)
 {
-	tm* mtim = localtime(&totalSeconds);
+	// localtime() is not thread-safe, see DiskManipulator's batch mode
+	tm mtimBuf;
+#ifdef _WIN32
+	tm* mtim = localtime_s(&mtimBuf, &totalSeconds) ? nullptr : &mtimBuf;
+#else
+	tm* mtim = localtime_r(&totalSeconds, &mtimBuf);
+#endif
 	if (!mtim) {
 		time = 0;
 		date = 0;
@@ -477,10 +494,14 @@ void MSXtar::alterFileInDSK(MSXDirEntry& msxDirEntry, const string& hostName)
 	// open host file for reading
 	File file(FileOperations::expandTilde(hostName), "rb");
 
-	// copy host file to image
+	// First build the FAT chain for the new content (reuse the existing
+	// chain, extend it with free clusters), then copy the data.
+	unsigned clusterSize = sectorsPerCluster * SECTOR_SIZE;
+	size_t neededClusters = (hostSize + clusterSize - 1) / clusterSize;
+	std::vector<unsigned> chain;
 	unsigned prevCl = 0;
 	unsigned curCl = getStartCluster(msxDirEntry);
-	while (remaining) {
+	while (chain.size() < neededClusters) {
 		// allocate new cluster if needed
 		try {
 			if (curCl == one_of(0u, EOF_FAT)) {
@@ -497,23 +518,32 @@ void MSXtar::alterFileInDSK(MSXDirEntry& msxDirEntry, const string& hostName)
 			// no more free clusters
 			break;
 		}
-
-		// fill cluster
-		unsigned logicalSector = clusterToSector(curCl);
-		for (unsigned j = 0; (j < sectorsPerCluster) && remaining; ++j) {
-			SectorBuffer buf;
-			memset(&buf, 0, sizeof(buf));
-			unsigned chunkSize = std::min(SECTOR_SIZE, remaining);
-			file.read(&buf, chunkSize);
-			writeLogicalSector(logicalSector + j, buf);
-			remaining -= chunkSize;
-		}
+		chain.push_back(curCl);
 
 		// advance to next cluster
 		prevCl = curCl;
 		curCl = readFAT(curCl);
 	}
 
+	// copy host file to image, a run of consecutive clusters at a time
+	MemBuffer<SectorBuffer> buf;
+	for (size_t i = 0; (i < chain.size()) && remaining; /**/) {
+		size_t n = 1;
+		while (((i + n) < chain.size()) && (chain[i + n] == (chain[i] + n)) &&
+		       (((n + 1) * sectorsPerCluster) <= MAX_RUN_SECTORS)) {
+			++n;
+		}
+		unsigned runSize = std::min(remaining, unsigned(n) * clusterSize);
+		unsigned numSectors = (runSize + SECTOR_SIZE - 1) / SECTOR_SIZE;
+		buf.resize(numSectors);
+		file.read(buf.data(), runSize);
+		memset(reinterpret_cast<uint8_t*>(buf.data()) + runSize, 0,
+		       numSectors * SECTOR_SIZE - runSize);
+		disk.writeSectorRange(clusterToSector(chain[i]), numSectors, buf.data());
+		remaining -= runSize;
+		i += n;
+	}
+
 	// terminate FAT chain
 	if (prevCl == 0) {
 		msxDirEntry.startCluster = 0;
@@ -757,16 +787,27 @@ void MSXtar::chroot(string_view newRootDir, bool createDir)
 void MSXtar::fileExtract(const string& resultFile, const MSXDirEntry& dirEntry)
 {
 	unsigned size = dirEntry.size;
-	unsigned sector = clusterToSector(getStartCluster(dirEntry));
+	unsigned cluster = getStartCluster(dirEntry);
+	unsigned clusterSize = sectorsPerCluster * SECTOR_SIZE;
 
 	File file(FileOperations::expandTilde(resultFile), "wb");
-	while (size && sector) {
-		SectorBuffer buf;
-		readLogicalSector(sector, buf);
-		unsigned savesize = std::min(size, SECTOR_SIZE);
-		file.write(&buf, savesize);
-		size -= savesize;
-		sector = getNextSector(sector);
+	MemBuffer<SectorBuffer> buf;
+	while (size && (2 <= cluster) && (cluster < maxCluster)) {
+		// a run of consecutive clusters
+		unsigned n = 1;
+		unsigned next = readFAT(cluster);
+		while ((next == (cluster + n)) &&
+		       (((n + 1) * sectorsPerCluster) <= MAX_RUN_SECTORS)) {
+			++n;
+			next = readFAT(next);
+		}
+		unsigned runSize = std::min(size, n * clusterSize);
+		unsigned numSectors = (runSize + SECTOR_SIZE - 1) / SECTOR_SIZE;
+		buf.resize(numSectors);
+		disk.readSectorRange(clusterToSector(cluster), numSectors, buf.data());
+		file.write(buf.data(), runSize);
+		size -= runSize;
+		cluster = next;
 	}
 	// now change the access time
 	changeTime(resultFile, dirEntry);
@@ -76,6 +76,7 @@ private:
 	unsigned rootDirStart; // first sector from the root directory
 	unsigned rootDirLast;  // last  sector from the root directory
 	unsigned chrootSector;
+	unsigned freeClusterHint; // no free clusters below this one
 
 	bool fatCacheDirty;
 };
@@ -12,6 +12,7 @@
 #include <cstdarg>
 #include <ctime>
 #include <fstream>
+#include <iterator>
 #include <memory>
 
 using std::string;
@@ -445,9 +446,7 @@ void NowindHost::transferSectors(unsigned transferAddress, unsigned amount)
 	send16(amount);
 
 	auto* bufferPointer = buffer[0].raw + transfered;
-	for (unsigned i = 0; i < amount; ++i) {
-		send(bufferPointer[i]);
-	}
+	hostToMsxFifo.push_back(bufferPointer, bufferPointer + amount);
 	send(0xAF);
 	send(0x07); // used for validation
 }
@@ -461,9 +460,8 @@ void NowindHost::transferSectorsBackwards(unsigned transferAddress, unsigned amo
 	send(amount / 64);
 
 	auto* bufferPointer = buffer[0].raw + transfered;
-	for (int i = amount - 1; i >= 0; --i) {
-		send(bufferPointer[i]);
-	}
+	hostToMsxFifo.push_back(std::make_reverse_iterator(bufferPointer + amount),
+	                        std::make_reverse_iterator(bufferPointer));
 	send(0xAF);
 	send(0x07); // used for validation
 }
@@ -715,19 +713,14 @@ void NowindHost::deviceRead()
 unsigned NowindHost::readHelper1(unsigned dev, char* buf)
 {
 	assert(dev < MAX_DEVICES);
-	unsigned len = 0;
-	for (/**/; len < 256; ++len) {
-		devices[dev].fs->read(&buf[len], 1);
-		if (devices[dev].fs->eof()) break;
-	}
-	return len;
+	auto& fs = *devices[dev].fs;
+	fs.read(buf, 256);
+	return unsigned(fs.gcount()); // less than 256 -> end-of-file
 }
 
 void NowindHost::readHelper2(unsigned len, const char* buf)
 {
-	for (unsigned i = 0; i < len; ++i) {
-		send(buf[i]);
-	}
+	hostToMsxFifo.push_back(buf, buf + len);
 	if (len < 256) {
 		send(0x1A); // end-of-file
 	}
@@ -26,6 +26,7 @@ RealDrive::RealDrive(MSXMotherBoard& motherBoard_, EmuDuration::param motorTimeo
 		motherBoard.getReactor().getGlobalSettings().getThrottleManager())
 	, motorTimeout(motorTimeout_)
 	, motorTimer(getCurrentTime())
+	, speedFactor(1)
 	, headPos(0), side(0), startAngle(0)
 	, motorStatus(false)
 	, doubleSizedDrive(doubleSided)
@@ -50,10 +51,19 @@ RealDrive::RealDrive(MSXMotherBoard& motherBoard_, EmuDuration::param motorTimeo
 	motherBoard.getMSXCliComm().update(CliComm::HARDWARE, driveName, "add");
 	changer = std::make_unique<DiskChanger>(motherBoard, driveName, true, doubleSizedDrive,
 	                                        [this]() { invalidateTrack(); });
+
+	instantSetting = std::make_unique<BooleanSetting>(
+		motherBoard.getCommandController(), driveName + "_instant",
+		"speed up disk access in this drive by skipping most of the "
+		"mechanical delays (disk rotation, head movement), this may "
+		"break software that depends on exact disk timing",
+		false, Setting::DONT_SAVE);
+	instantSetting->attach(*this);
 }
 
 RealDrive::~RealDrive()
 {
+	instantSetting->detach(*this);
 	try {
 		flushTrack();
 	} catch (MSXException&) {
@@ -268,7 +278,7 @@ unsigned RealDrive::getCurrentAngle(EmuTime::param time) const
 {
 	if (motorStatus) {
 		// rotating, take passed time into account
-		auto deltaAngle = motorTimer.getTicksTillUp(time);
+		auto deltaAngle = motorTimer.getTicksTillUp(time) * speedFactor;
 		return (startAngle + deltaAngle) % TICKS_PER_ROTATION;
 	} else {
 		// not rotating, angle didn't change
@@ -304,6 +314,21 @@ void RealDrive::setLoading(EmuTime::param time)
 	syncLoadingTimeout.setSyncPoint(time + EmuDuration::sec(1));
 }
 
+void RealDrive::update(const Setting& setting)
+{
+	assert(&setting == instantSetting.get()); (void)setting;
+	// Continue rotating from the current angle, but at the new speed.
+	auto time = getCurrentTime();
+	startAngle = getCurrentAngle(time);
+	motorTimer.advance(time);
+	speedFactor = instantSetting->getBoolean() ? INSTANT_SPEEDUP : 1;
+}
+
+bool RealDrive::isInstant() const
+{
+	return speedFactor != 1;
+}
+
 void RealDrive::execLoadingTimeout()
 {
 	loadingIndicator.update(false);
@@ -333,7 +358,7 @@ EmuTime RealDrive::getTimeTillIndexPulse(EmuTime::param time, int count)
 	unsigned delta = TICKS_PER_ROTATION - getCurrentAngle(time);
 	auto dur1 = MotorClock::duration(delta);
 	auto dur2 = MotorClock::duration(TICKS_PER_ROTATION) * (count - 1);
-	return time + dur1 + dur2;
+	return time + (dur1 + dur2).divRoundUp(speedFactor);
 }
 
 void RealDrive::invalidateTrack()
@@ -414,7 +439,7 @@ EmuTime RealDrive::getNextSector(EmuTime::param time, RawTrack::Sector& sector)
 	if (delta < 4) delta += TICKS_PER_ROTATION;
 	assert(4 <= delta); assert(unsigned(delta) < (TICKS_PER_ROTATION + 4));
 
-	return time + MotorClock::duration(delta);
+	return time + MotorClock::duration(delta).divRoundUp(speedFactor);
 }
 
 void RealDrive::flushTrack()
@@ -2,7 +2,9 @@
 #define REALDRIVE_HH
 
 #include "DiskDrive.hh"
+#include "BooleanSetting.hh"
 #include "Clock.hh"
+#include "Observer.hh"
 #include "Schedulable.hh"
 #include "ThrottleManager.hh"
 #include "outer.hh"
@@ -18,7 +20,7 @@ class DiskChanger;
 
 /** This class implements a real drive, single or double sided.
  */
-class RealDrive final : public DiskDrive
+class RealDrive final : public DiskDrive, private Observer<Setting>
 {
 public:
 	RealDrive(MSXMotherBoard& motherBoard, EmuDuration::param motorTimeout,
@@ -50,6 +52,7 @@ public:
 
 	void applyWd2793ReadTrackQuirk() override;
 	void invalidateWd2793ReadTrackQuirk() override;
+	bool isInstant() const override;
 
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
@@ -73,6 +76,9 @@ private:
 		}
 	} syncMotorTimeout;
 
+	// Observer<Setting>
+	void update(const Setting& setting) override;
+
 	void execLoadingTimeout();
 	void execMotorTimeout(EmuTime::param time);
 	EmuTime::param getCurrentTime() const { return syncLoadingTimeout.getCurrentTime(); }
@@ -97,6 +103,8 @@ private:
 	using MotorClock = Clock<TICKS_PER_ROTATION * ROTATIONS_PER_SECOND>;
 	MotorClock motorTimer;
 	std::unique_ptr<DiskChanger> changer;
+	std::unique_ptr<BooleanSetting> instantSetting;
+	unsigned speedFactor; // 1 or INSTANT_SPEEDUP
 	unsigned headPos;
 	unsigned side;
 	unsigned startAngle;
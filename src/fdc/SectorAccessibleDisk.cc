@@ -4,10 +4,31 @@
 #include "DiskExceptions.hh"
 #include "sha1.hh"
 #include "xrange.hh"
+#include <algorithm>
 #include <memory>
 
 namespace openmsx {
 
+struct SectorAccessibleDisk::SectorCache
+{
+	static constexpr size_t NUM_ENTRIES = 256; // direct mapped, 128kB
+	static constexpr size_t READ_AHEAD = 16;
+
+	SectorCache() { flush(); }
+	void flush() { std::fill(std::begin(tags), std::end(tags), size_t(-1)); }
+
+	void store(size_t sector, const SectorBuffer& buf) {
+		auto idx = sector % NUM_ENTRIES;
+		tags[idx] = sector;
+		data[idx] = buf;
+	}
+
+	size_t tags[NUM_ENTRIES]; // sector number or -1
+	SectorBuffer data[NUM_ENTRIES];
+	SectorBuffer readBuf[READ_AHEAD];
+	size_t lastSector = size_t(-2);
+};
+
 SectorAccessibleDisk::SectorAccessibleDisk()
 	: patch(std::make_unique<EmptyDiskPatch>(*this))
 {
@@ -33,22 +54,134 @@ void SectorAccessibleDisk::readSector(size_t sector, SectorBuffer& buf)
 	}
 }
 
-void SectorAccessibleDisk::writeSector(size_t sector, const SectorBuffer& buf)
+void SectorAccessibleDisk::readSectorCached(size_t sector, SectorBuffer& buf)
+{
+	++cacheStats.sectorReads;
+	if (!sectorCache) {
+		++cacheStats.imageReads;
+		readSectorImpl(sector, buf);
+		return;
+	}
+
+	auto& cache = *sectorCache;
+	bool sequential = sector == (cache.lastSector + 1);
+	cache.lastSector = sector;
+	auto idx = sector % SectorCache::NUM_ENTRIES;
+	if (cache.tags[idx] == sector) {
+		++cacheStats.sectorHits;
+		buf = cache.data[idx];
+		return;
+	}
+
+	// Read ahead on sequential access. But not for the first sectors,
+	// getNbSectors() may need to read those (see readSector()).
+	size_t num = 1;
+	if (sequential && (sector > 1)) {
+		auto nbSectors = getNbSectors();
+		if (sector < nbSectors) {
+			num = std::min(SectorCache::READ_AHEAD, nbSectors - sector);
+		}
+	}
+	++cacheStats.imageReads;
+	if (num == 1) {
+		readSectorImpl(sector, buf);
+		cache.store(sector, buf);
+		return;
+	}
+	try {
+		readSectorsImpl(sector, num, cache.readBuf);
+	} catch (MSXException&) {
+		// maybe only the read-ahead part failed
+		readSectorImpl(sector, buf);
+		cache.store(sector, buf);
+		return;
+	}
+	for (auto i : xrange(num)) {
+		cache.store(sector + i, cache.readBuf[i]);
+	}
+	cacheStats.readAhead += num - 1;
+	buf = cache.readBuf[0];
+}
+
+void SectorAccessibleDisk::checkWrite(size_t sector, size_t num)
 {
 	if (isWriteProtected()) {
 		throw WriteProtectedException();
 	}
-	if (!isDummyDisk() && (getNbSectors() <= sector)) {
+	if (!isDummyDisk() && (getNbSectors() < (sector + num))) {
 		throw NoSuchSectorException("No such sector");
 	}
+}
+
+void SectorAccessibleDisk::writeSector(size_t sector, const SectorBuffer& buf)
+{
+	checkWrite(sector, 1);
 	try {
+		++cacheStats.imageWrites;
 		writeSectorImpl(sector, buf);
 	} catch (MSXException& e) {
+		if (sectorCache) sectorCache->flush(); // unknown state
 		throw DiskIOErrorException("Disk I/O error: ", e.getMessage());
 	}
+	if (sectorCache) sectorCache->store(sector, buf);
 	flushCaches();
 }
 
+void SectorAccessibleDisk::readSectorRange(
+	size_t sector, size_t num, SectorBuffer* bufs)
+{
+	// Sector by sector, so that patches are applied. The sector cache
+	// reads ahead for this (sequential) access pattern.
+	for (auto i : xrange(num)) {
+		readSector(sector + i, bufs[i]);
+	}
+}
+
+void SectorAccessibleDisk::writeSectorRange(
+	size_t sector, size_t num, const SectorBuffer* bufs)
+{
+	checkWrite(sector, num);
+	try {
+		++cacheStats.imageWrites;
+		writeSectorsImpl(sector, num, bufs);
+	} catch (MSXException& e) {
+		flushSectorCache(); // unknown state
+		throw DiskIOErrorException("Disk I/O error: ", e.getMessage());
+	}
+	if (sectorCache) {
+		for (auto i : xrange(num)) {
+			sectorCache->store(sector + i, bufs[i]);
+		}
+	}
+	flushCaches();
+}
+
+void SectorAccessibleDisk::readSectorsImpl(
+	size_t sector, size_t num, SectorBuffer* bufs)
+{
+	for (auto i : xrange(num)) {
+		readSectorImpl(sector + i, bufs[i]);
+	}
+}
+
+void SectorAccessibleDisk::writeSectorsImpl(
+	size_t sector, size_t num, const SectorBuffer* bufs)
+{
+	for (auto i : xrange(num)) {
+		writeSectorImpl(sector + i, bufs[i]);
+	}
+}
+
+void SectorAccessibleDisk::enableSectorCache()
+{
+	sectorCache = std::make_unique<SectorCache>();
+}
+
+void SectorAccessibleDisk::flushSectorCache()
+{
+	if (sectorCache) sectorCache->flush();
+}
+
 size_t SectorAccessibleDisk::getNbSectors() const
 {
 	return getNbSectorsImpl();
@@ -100,9 +233,7 @@ int SectorAccessibleDisk::readSectors (
 	SectorBuffer* buffers, size_t startSector, size_t nbSectors)
 {
 	try {
-		for (auto i : xrange(nbSectors)) {
-			readSector(startSector + i, buffers[i]);
-		}
+		readSectorRange(startSector, nbSectors, buffers);
 		return 0;
 	} catch (MSXException&) {
 		return -1;
@@ -113,9 +244,7 @@ int SectorAccessibleDisk::writeSectors(
 	const SectorBuffer* buffers, size_t startSector, size_t nbSectors)
 {
 	try {
-		for (auto i : xrange(nbSectors)) {
-			writeSector(startSector + i, buffers[i]);
-		}
+		writeSectorRange(startSector, nbSectors, buffers);
 		return 0;
 	} catch (MSXException&) {
 		return -1;
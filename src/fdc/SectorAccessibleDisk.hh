@@ -20,6 +20,10 @@ public:
 	// sector stuff
 	void readSector (size_t sector,       SectorBuffer& buf);
 	void writeSector(size_t sector, const SectorBuffer& buf);
+	/** Like readSector()/writeSector(), but for 'num' consecutive
+	  * sectors. Writing passes the whole range to the image at once. */
+	void readSectorRange (size_t sector, size_t num,       SectorBuffer* bufs);
+	void writeSectorRange(size_t sector, size_t num, const SectorBuffer* bufs);
 	size_t getNbSectors() const;
 
 	// write protected stuff
@@ -47,7 +51,20 @@ public:
 	int writeSectors(const SectorBuffer* buffers, size_t startSector,
 	                 size_t nbSectors);
 
+	struct CacheStatistics {
+		uint64_t sectorReads = 0; // (unpatched) sector reads
+		uint64_t sectorHits = 0;  // ... that were found in the cache
+		uint64_t readAhead = 0;   // sectors read before they were requested
+		uint64_t imageReads = 0;  // read requests to the underlying image
+		uint64_t imageWrites = 0; // write requests to the underlying image
+		uint64_t trackReads = 0;  // only for SectorBasedDisk
+		uint64_t trackHits = 0;
+	};
+	[[nodiscard]] bool hasSectorCache() const { return sectorCache != nullptr; }
+	[[nodiscard]] const CacheStatistics& getCacheStatistics() const { return cacheStats; }
+
 	// should only be called by EmptyDiskPatch
+	void readSectorCached(size_t sector, SectorBuffer& buf);
 	virtual void readSectorImpl (size_t sector, SectorBuffer& buf) = 0;
 
 protected:
@@ -64,12 +81,35 @@ protected:
 	virtual void flushCaches();
 	virtual Sha1Sum getSha1SumImpl(FilePool& filepool);
 
+	/** Keep recently read sectors in memory, and read ahead when
+	  * sectors are accessed sequentially. Only for disks where reading
+	  * has no side effects, and whose content only changes via
+	  * writeSector(), or via writeTrack() (which calls
+	  * flushSectorCache()). So e.g. not for DirAsDSK.
+	  */
+	void enableSectorCache();
+	void flushSectorCache();
+	CacheStatistics& getCacheStatisticsRW() { return cacheStats; }
+
+	/** Read/write a range of consecutive sectors. The default
+	  * implementation handles the sectors one by one. Override when the
+	  * underlying image can do this more efficiently (e.g. a single file
+	  * access).
+	  */
+	virtual void readSectorsImpl (size_t sector, size_t num,       SectorBuffer* bufs);
+	virtual void writeSectorsImpl(size_t sector, size_t num, const SectorBuffer* bufs);
+
 private:
 	virtual void writeSectorImpl(size_t sector, const SectorBuffer& buf) = 0;
 	virtual size_t getNbSectorsImpl() const = 0;
 	virtual bool isWriteProtectedImpl() const = 0;
 
+	void checkWrite(size_t sector, size_t num);
+
+	struct SectorCache;
 	std::unique_ptr<const PatchInterface> patch;
+	std::unique_ptr<SectorCache> sectorCache;
+	CacheStatistics cacheStats;
 	Sha1Sum sha1cache;
 	bool forcedWriteProtect = false;
 	bool peekMode = false;
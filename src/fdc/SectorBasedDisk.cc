@@ -40,8 +40,11 @@ void SectorBasedDisk::readTrack(byte track, byte side, RawTrack& output)
 	// Typically the software will also read several sectors from the same
 	// track before moving to the next.
 	checkCaches();
+	auto& stats = getCacheStatisticsRW();
+	++stats.trackReads;
 	int num = track | (side << 8);
 	if (num == cachedTrackNum) {
+		++stats.trackHits;
 		output = cachedTrackData;
 		return;
 	}
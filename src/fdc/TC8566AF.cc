@@ -209,8 +209,13 @@ byte TC8566AF::executionPhaseRead(EmuTime::param time)
 		byte result = drv->readTrackByte(dataCurrent++);
 		crc.update(result);
 		--dataAvailable;
-		delayTime += 1; // time when next byte will be available
 		mainStatus &= ~STM_RQM;
+		if (drv->isInstant()) {
+			// next byte is available right away, no lost data
+			delayTime.reset(time);
+		} else {
+			delayTime += 1; // time when next byte will be available
+		}
 		if (delayTime.before(time)) {
 			// lost data
 			status0 |= ST0_IC0;
@@ -492,7 +497,7 @@ void TC8566AF::commandPhaseWrite(byte value, EmuTime::param time)
 			// load drive head, if not already loaded
 			EmuTime ready = time;
 			if (!isHeadLoaded(time)) {
-				ready += getHeadLoadDelay();
+				ready += drive[driveSelect]->mechanicalDelay(getHeadLoadDelay());
 				// set 'head is loaded'
 				headUnloadTime = EmuTime::infinity();
 			}
@@ -687,7 +692,7 @@ void TC8566AF::doSeek(EmuTime::param time)
 
 	currentDrive.step(direction, time);
 
-	setSyncPoint(time + getSeekDelay());
+	setSyncPoint(time + currentDrive.mechanicalDelay(getSeekDelay()));
 }
 
 void TC8566AF::executeUntil(EmuTime::param time)
@@ -715,8 +720,13 @@ void TC8566AF::executionPhaseWrite(byte value, EmuTime::param time)
 		drv->writeTrackByte(dataCurrent++, value);
 		crc.update(value);
 		--dataAvailable;
-		delayTime += 1; // time when next byte can be written
 		mainStatus &= ~STM_RQM;
+		if (drv->isInstant()) {
+			// next byte can be written right away
+			delayTime.reset(time);
+		} else {
+			delayTime += 1; // time when next byte can be written
+		}
 		if (delayTime.before(time)) {
 			// lost data
 			status0 |= ST0_IC0;
@@ -3,6 +3,7 @@
 #include "CliComm.hh"
 #include "Clock.hh"
 #include "MSXException.hh"
+#include "one_of.hh"
 #include "serialize.hh"
 #include "unreachable.hh"
 #include <iostream>
@@ -254,6 +255,15 @@ void WD2793::setDataReg(byte value, EmuTime::param time)
 	    ((commandReg & 0xF0) == 0xF0)) { // write track
 		dataRegWritten = true;
 		drqTime.reset(EmuTime::infinity()); // DRQ = false
+
+		if (drive.isInstant() && pendingSyncPoint() &&
+		    (fsmState == one_of(FSM_WRITE_SECTOR, FSM_WRITE_TRACK))) {
+			// In instant mode, don't wait till the previous byte
+			// is written to disk, write it right now (and accept
+			// the next byte).
+			removeSyncPoint();
+			executeUntil(time);
+		}
 	}
 }
 
@@ -268,15 +278,21 @@ byte WD2793::getDataReg(EmuTime::param time)
 		dataReg = drive.readTrackByte(dataCurrent++);
 		crc.update(dataReg);
 		dataAvailable--;
-		drqTime += 1; // time when the next byte will be available
-		while (dataAvailable && unlikely(getDTRQ(time))) {
-			statusReg |= LOST_DATA;
-			dataReg = drive.readTrackByte(dataCurrent++);
-			crc.update(dataReg);
-			dataAvailable--;
-			drqTime += 1;
+		if (drive.isInstant()) {
+			// In instant mode the next byte is available right
+			// away, the CPU can't be too slow.
+			drqTime.reset(time);
+		} else {
+			drqTime += 1; // time when the next byte will be available
+			while (dataAvailable && unlikely(getDTRQ(time))) {
+				statusReg |= LOST_DATA;
+				dataReg = drive.readTrackByte(dataCurrent++);
+				crc.update(dataReg);
+				dataAvailable--;
+				drqTime += 1;
+			}
+			assert(!dataAvailable || !getDTRQ(time));
 		}
-		assert(!dataAvailable || !getDTRQ(time));
 		if (dataAvailable == 0) {
 			if ((commandReg & 0xE0) == 0x80) {
 				// read sector
@@ -505,7 +521,7 @@ void WD2793::step(EmuTime::param time)
 		endType1Cmd(time);
 	} else {
 		drive.step(directionIn, time);
-		schedule(FSM_SEEK, time + timePerStep[commandReg & STEP_SPEED]);
+		schedule(FSM_SEEK, time + drive.mechanicalDelay(timePerStep[commandReg & STEP_SPEED]));
 	}
 }
 
@@ -544,7 +560,7 @@ void WD2793::startType2Cmd(EmuTime::param time)
 
 		if (commandReg & E_FLAG) {
 			schedule(FSM_TYPE2_LOADED,
-			         time + EmuDuration::msec(30)); // when 1MHz clock
+			         time + drive.mechanicalDelay(EmuDuration::msec(30))); // when 1MHz clock
 		} else {
 			type2Loaded(time);
 		}
@@ -837,7 +853,7 @@ void WD2793::startType3Cmd(EmuTime::param time)
 
 		if (commandReg & E_FLAG) {
 			schedule(FSM_TYPE3_LOADED,
-			         time + EmuDuration::msec(30)); // when 1MHz clock
+			         time + drive.mechanicalDelay(EmuDuration::msec(30))); // when 1MHz clock
 		} else {
 			type3Loaded(time);
 		}
@@ -1,8 +1,14 @@
 #include "CompressedFileAdapter.hh"
 #include "FileException.hh"
+#include "FileOperations.hh"
+#include "SeekableInflate.hh"
+#include "ZlibInflate.hh"
 #include "hash_set.hh"
+#include "sha1.hh"
+#include "strCat.hh"
 #include "xxhash.hh"
 #include <cstring>
+#include <mutex>
 
 using std::string;
 
@@ -15,6 +21,21 @@ struct GetURLFromDecompressed {
 };
 static hash_set<std::shared_ptr<CompressedFileAdapter::Decompressed>,
                 GetURLFromDecompressed, XXHasher> decompressCache;
+// Files may be opened from multiple threads (e.g. FilePool scanning).
+static std::mutex decompressCacheMutex;
+
+// Files with at least this much compressed data are decompressed piece by
+// piece (when possible, see decompress()).
+constexpr size_t SEEKABLE_THRESHOLD = 4 * 1024 * 1024;
+
+// The checkpoints for SeekableInflate are stored in the user data directory
+// (e.g. the directory of the file itself may be read-only).
+static string getIndexFilename(std::string_view url)
+{
+	auto sum = SHA1::calc(reinterpret_cast<const uint8_t*>(url.data()), url.size());
+	return strCat(FileOperations::getUserDataDir(), "/decompress_index/",
+	              sum.toString(), ".idx");
+}
 
 
 CompressedFileAdapter::CompressedFileAdapter(std::unique_ptr<FileBase> file_)
@@ -24,6 +45,7 @@ CompressedFileAdapter::CompressedFileAdapter(std::unique_ptr<FileBase> file_)
 
 CompressedFileAdapter::~CompressedFileAdapter()
 {
+	std::lock_guard<std::mutex> lock(decompressCacheMutex);
 	auto it = decompressCache.find(getURL());
 	decompressed.reset();
 	if (it != end(decompressCache) && it->unique()) {
@@ -32,29 +54,70 @@ CompressedFileAdapter::~CompressedFileAdapter()
 	}
 }
 
-void CompressedFileAdapter::decompress()
+// Make the decompressed data available, either completely in memory
+// ('decompressed') or, if 'randomAccess' is enough (IOW the caller doesn't
+// need mmap()), for big files via 'seekable'.
+void CompressedFileAdapter::decompress(bool randomAccess)
 {
 	if (decompressed) return;
+	if (seekable && randomAccess) return;
 
 	string url = getURL();
-	auto it = decompressCache.find(url);
-	if (it != end(decompressCache)) {
-		decompressed = *it;
-	} else {
-		decompressed = std::make_shared<Decompressed>();
-		decompress(*file, *decompressed);
-		decompressed->cachedModificationDate = getModificationDate();
-		decompressed->cachedURL = std::move(url);
-		decompressCache.insert_noDuplicateCheck(decompressed);
+	{
+		std::lock_guard<std::mutex> lock(decompressCacheMutex);
+		auto it = decompressCache.find(url);
+		if (it != end(decompressCache)) {
+			decompressed = *it;
+		}
+	}
+	if (!decompressed) {
+		// decompress without holding the lock
+		ZlibInflate zlib(file->mmap());
+		string originalName;
+		size_t sizeHint = parseHeader(zlib, originalName);
+		auto input = zlib.getRemainingInput();
+		if (randomAccess && (input.size() >= SEEKABLE_THRESHOLD)) {
+			auto key = strCat(url, ' ', file->getSize(), ' ',
+			                  file->getModificationDate());
+			seekable = std::make_unique<SeekableInflate>(
+				input, getIndexFilename(url), key);
+			seekableOriginalName = std::move(originalName);
+			return; // 'seekable' reads from the (mmap'ed) original file
+		}
+		auto d = std::make_shared<Decompressed>();
+		d->originalName = std::move(originalName);
+		d->size = sizeHint ? zlib.inflate(d->buf, sizeHint)
+		                   : zlib.inflate(d->buf);
+		d->cachedModificationDate = getModificationDate();
+		d->cachedURL = std::move(url);
+
+		std::lock_guard<std::mutex> lock(decompressCacheMutex);
+		auto it = decompressCache.find(d->cachedURL);
+		if (it != end(decompressCache)) {
+			// another thread was faster
+			decompressed = *it;
+		} else {
+			decompressed = std::move(d);
+			decompressCache.insert_noDuplicateCheck(decompressed);
+		}
 	}
 
 	// close original file after succesful decompress
+	seekable.reset();
 	file.reset();
 }
 
 void CompressedFileAdapter::read(void* buffer, size_t num)
 {
-	decompress();
+	decompress(true);
+	if (seekable) {
+		if (seekable->getSize() < (pos + num)) {
+			throw FileException("Read beyond end of file");
+		}
+		seekable->read(pos, static_cast<uint8_t*>(buffer), num);
+		pos += num;
+		return;
+	}
 	if (decompressed->size < (pos + num)) {
 		throw FileException("Read beyond end of file");
 	}
@@ -81,8 +144,8 @@ void CompressedFileAdapter::munmap()
 
 size_t CompressedFileAdapter::getSize()
 {
-	decompress();
-	return decompressed->size;
+	decompress(true);
+	return seekable ? seekable->getSize() : decompressed->size;
 }
 
 void CompressedFileAdapter::seek(size_t newpos)
@@ -112,8 +175,8 @@ string CompressedFileAdapter::getURL() const
 
 string CompressedFileAdapter::getOriginalName()
 {
-	decompress();
-	return decompressed->originalName;
+	decompress(true);
+	return seekable ? seekableOriginalName : decompressed->originalName;
 }
 
 bool CompressedFileAdapter::isReadOnly() const
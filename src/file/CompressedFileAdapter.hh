@@ -7,6 +7,16 @@
 
 namespace openmsx {
 
+class SeekableInflate;
+class ZlibInflate;
+
+/** Base class for reading compressed (gzip or zip) files.
+  *
+  * Normally the whole file is decompressed in memory on first access (and
+  * shared with other File objects for the same file). But big files that
+  * are only accessed via read()/seek() (e.g. hard disk images) are instead
+  * decompressed piece by piece on demand, see SeekableInflate.
+  */
 class CompressedFileAdapter : public FileBase
 {
 public:
@@ -35,13 +45,23 @@ public:
 protected:
 	explicit CompressedFileAdapter(std::unique_ptr<FileBase> file);
 	~CompressedFileAdapter() override;
-	virtual void decompress(FileBase& file, Decompressed& decompressed) = 0;
+
+	/** Parse the header that precedes the (raw) deflate stream.
+	  * @param zlib Input positioned at the start of the file, on return
+	  *             it must be positioned at the start of the deflate stream.
+	  * @param originalName Output, the name of the uncompressed file.
+	  * @result An estimate for the uncompressed size (0 if unknown).
+	  * @throws FileException when the header is invalid.
+	  */
+	virtual size_t parseHeader(ZlibInflate& zlib, std::string& originalName) = 0;
 
 private:
-	void decompress();
+	void decompress(bool randomAccess = false);
 
 	std::unique_ptr<FileBase> file;
 	std::shared_ptr<Decompressed> decompressed;
+	std::unique_ptr<SeekableInflate> seekable; // alternative for 'decompressed'
+	std::string seekableOriginalName;
 	size_t pos;
 };
 
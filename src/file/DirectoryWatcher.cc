@@ -0,0 +1,171 @@
+#include "DirectoryWatcher.hh"
+#include "foreach_file.hh"
+#include "ranges.hh"
+#include "StringOp.hh"
+#include "strCat.hh"
+#include "systemfuncs.hh"
+#include "unistdp.hh"
+#include <cassert>
+#include <cerrno>
+#include <utility>
+#if HAVE_INOTIFY_INIT1
+#include <sys/inotify.h>
+#endif
+
+namespace openmsx {
+
+#if HAVE_INOTIFY_INIT1
+// Everything that can change the name, type, size or modification time of a
+// directory entry. (Plain accesses are not interesting.)
+constexpr uint32_t WATCH_MASK =
+	IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB |
+	IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF |
+	IN_ONLYDIR;
+#endif
+
+DirectoryWatcher::DirectoryWatcher(std::string directory, bool watchHidden_)
+	: root(std::move(directory))
+	, watchHidden(watchHidden_)
+{
+	assert(StringOp::endsWith(root, '/'));
+	start();
+}
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+	deactivate();
+}
+
+void DirectoryWatcher::start()
+{
+#if HAVE_INOTIFY_INIT1
+	fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd == -1) return;
+	addWatch({});
+	// The initial state is not a change.
+	pending = Changes();
+#endif
+}
+
+void DirectoryWatcher::deactivate()
+{
+	if (fd != -1) {
+		close(fd); // this also removes all watches
+		fd = -1;
+	}
+	watches.clear();
+	pending = Changes();
+}
+
+void DirectoryWatcher::addWatch(const std::string& relDir)
+{
+#if HAVE_INOTIFY_INIT1
+	std::string path = root + relDir;
+	path.pop_back(); // remove trailing '/'
+	int wd = inotify_add_watch(fd, path.c_str(), WATCH_MASK);
+	if (wd == -1) {
+		if (!relDir.empty() && ((errno == ENOENT) || (errno == ENOTDIR))) {
+			// Already removed again. Not a problem, that's also
+			// reported as a change in the parent directory.
+			return;
+		}
+		// E.g. the maximum number of watches is reached. We can't
+		// reliably report changes anymore.
+		deactivate();
+		return;
+	}
+	// When a watched directory is renamed, it gets the same watch
+	// descriptor again (it's the same inode), so update the name.
+	watches.insert_or_assign(wd, relDir);
+	// Things may have been created in this directory before the watch was
+	// added.
+	pending.dirs.push_back(relDir);
+
+	foreach_file_and_directory(
+		std::move(path),
+		[](const std::string& /*path*/) { /*nothing*/ },
+		[&](const std::string& /*path*/, std::string_view name) {
+			if (!watchHidden && StringOp::startsWith(name, '.')) return true;
+			addWatch(strCat(relDir, name, '/'));
+			return isActive();
+		});
+#else
+	(void)relDir;
+#endif
+}
+
+void DirectoryWatcher::poll()
+{
+#if HAVE_INOTIFY_INIT1
+	alignas(inotify_event) char buf[16 * 1024];
+	while (isActive()) {
+		auto len = read(fd, buf, sizeof(buf));
+		if (len <= 0) return; // EAGAIN: no more events
+
+		for (auto* p = buf; p < (buf + len); /**/) {
+			auto* event = reinterpret_cast<const inotify_event*>(p);
+			p += sizeof(inotify_event) + event->len;
+
+			if (event->mask & IN_Q_OVERFLOW) {
+				// Events were lost.
+				pending.all = true;
+				continue;
+			}
+			auto* dir = lookup(watches, event->wd);
+			if (!dir) continue; // already removed watch
+			auto relDir = *dir; // copy, addWatch() may invalidate 'dir'
+
+			if (event->mask & IN_IGNORED) {
+				// Watched directory was removed (the parent
+				// directory also reports this).
+				watches.erase(event->wd);
+				if (relDir.empty()) pending.all = true;
+				continue;
+			}
+			if ((event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) &&
+			    relDir.empty()) {
+				// The watched directory itself is gone.
+				pending.all = true;
+			}
+			if ((event->mask & IN_ISDIR) &&
+			    (event->mask & (IN_CREATE | IN_MOVED_TO)) &&
+			    (event->len != 0) && (watchHidden || (event->name[0] != '.'))) {
+				addWatch(strCat(relDir, event->name, '/'));
+				if (!isActive()) return;
+			}
+			pending.dirs.push_back(std::move(relDir));
+		}
+	}
+#endif
+}
+
+bool DirectoryWatcher::hasChanges()
+{
+	poll();
+	return !isActive() || pending.all || !pending.dirs.empty();
+}
+
+DirectoryWatcher::Changes DirectoryWatcher::getChanges()
+{
+	poll();
+	if (!isActive()) {
+		Changes result;
+		result.all = true;
+		return result;
+	}
+	if (pending.all) {
+		// Also the set of watched directories may be incomplete now,
+		// so start over.
+		deactivate();
+		start();
+		Changes result;
+		result.all = true;
+		return result;
+	}
+	auto result = std::exchange(pending, Changes());
+	ranges::sort(result.dirs);
+	result.dirs.erase(ranges::unique(result.dirs), end(result.dirs));
+	return result;
+}
+
+} // namespace openmsx
@@ -0,0 +1,71 @@
+#ifndef DIRECTORYWATCHER_HH
+#define DIRECTORYWATCHER_HH
+
+#include "hash_map.hh"
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+/** Get notified about changes in a host directory tree, so that a user of
+  * that tree (e.g. DirAsDSK) doesn't have to periodically rescan all of it.
+  *
+  * On Linux this uses inotify: there's a watch on the given directory and
+  * (recursively) on all its subdirectories. Subdirectories that are created
+  * later on are watched as well. Hidden subdirectories (name starts with a
+  * '.') are only watched on request.
+  *
+  * On other platforms (or when inotify fails, e.g. because the limit on the
+  * number of watches is reached) the watcher is not active. Then the user
+  * must assume that anything may have changed at any time.
+  */
+class DirectoryWatcher
+{
+public:
+	struct Changes {
+		/** Anything may have changed (e.g. because events were lost). */
+		bool all = false;
+		/** The directories in which something was created, deleted,
+		  * modified or renamed. Relative to the watched directory,
+		  * either empty (the watched directory itself) or ending in
+		  * '/'. Sorted, so a directory comes before its subdirectories.
+		  */
+		std::vector<std::string> dirs;
+	};
+
+	/** Start watching.
+	  * @param directory The directory to watch, must end in '/'.
+	  * @param watchHidden Also watch hidden subdirectories?
+	  */
+	explicit DirectoryWatcher(std::string directory, bool watchHidden = false);
+	~DirectoryWatcher();
+
+	DirectoryWatcher(const DirectoryWatcher&) = delete;
+	DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+	/** Is change notification available? If not, getChanges() always
+	  * reports that everything may have changed. */
+	[[nodiscard]] bool isActive() const { return fd != -1; }
+
+	/** Were there any changes since the last call to getChanges()? */
+	[[nodiscard]] bool hasChanges();
+
+	/** Get (and forget) the changes since the previous call. */
+	[[nodiscard]] Changes getChanges();
+
+private:
+	void start();
+	void poll();
+	void addWatch(const std::string& relDir);
+	void deactivate();
+
+	const std::string root;
+	const bool watchHidden;
+	hash_map<int, std::string> watches; // watch descriptor -> relative dir
+	Changes pending;
+	int fd = -1;
+};
+
+} // namespace openmsx
+
+#endif
@@ -120,6 +120,11 @@ void File::truncate(size_t size)
 	return file->truncate(size);
 }
 
+std::vector<std::pair<size_t, size_t>> File::getDataRegions()
+{
+	return file->getDataRegions();
+}
+
 void File::flush()
 {
 	file->flush();
@@ -6,6 +6,8 @@
 #include <ctime>
 #include <memory>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 namespace openmsx {
 
@@ -113,6 +115,14 @@ public:
 	 */
 	void truncate(size_t size);
 
+	/** Get the regions of this file that (may) contain data, as sorted
+	 *  (offset, size) pairs. The ranges in between are holes in a sparse
+	 *  file, they read as zeros. Without support for sparse files (from
+	 *  the platform or the filesystem) this is the whole file.
+	 * @throws FileException
+	 */
+	std::vector<std::pair<size_t, size_t>> getDataRegions();
+
 	/** Force a write of all buffered data to disk. There is no need to
 	 *  call this function before destroying a File object.
 	 */
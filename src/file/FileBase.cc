@@ -48,6 +48,14 @@ void FileBase::truncate(size_t newSize)
 	}
 }
 
+std::vector<std::pair<size_t, size_t>> FileBase::getDataRegions()
+{
+	// default implementation, no holes
+	std::vector<std::pair<size_t, size_t>> result;
+	if (auto size = getSize()) result.emplace_back(0, size);
+	return result;
+}
+
 string FileBase::getLocalReference()
 {
 	// default implementation, file is not backed (uncompressed) on
@@ -5,6 +5,8 @@
 #include "span.hh"
 #include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace openmsx {
 
@@ -25,6 +27,7 @@ public:
 	virtual void seek(size_t pos) = 0;
 	virtual size_t getPos() = 0;
 	virtual void truncate(size_t size);
+	virtual std::vector<std::pair<size_t, size_t>> getDataRegions();
 	virtual void flush() = 0;
 
 	virtual std::string getURL() const = 0;
@@ -1,14 +1,21 @@
 #include "FilePoolCore.hh"
+#include "DirectoryWatcher.hh"
 #include "File.hh"
 #include "FileException.hh"
 #include "foreach_file.hh"
 #include "Date.hh"
+#include "MSXException.hh"
+#include "ThreadPool.hh"
 #include "Timer.hh"
 #include "one_of.hh"
 #include "ranges.hh"
-#include <fstream>
+#include "stl.hh"
+#include "strCat.hh"
+#include <algorithm>
+#include <cstring>
 #include <optional>
 #include <tuple>
+#include <type_traits>
 
 using std::string;
 
@@ -36,7 +43,12 @@ FilePoolCore::FilePoolCore(string filecache_,
 	, reportProgress(reportProgress_)
 {
 	try {
-		readSha1sums();
+		indexFile = File(filecache);
+		if (!readIndex(indexFile.mmap())) {
+			// not a binary index, maybe the old text format
+			indexFile.close();
+			readSha1sums();
+		}
 	} catch (MSXException&) {
 		// ignore, probably .filecache doesn't exist yet
 	}
@@ -59,6 +71,19 @@ void FilePoolCore::insert(const Sha1Sum& sum, time_t time, const string& filenam
 	needWrite = true;
 }
 
+// Like insert(), but appends to 'sha1Index'. Inserting many entries one by
+// one is quadratic, instead insert a whole batch and then call
+// sortSha1Index().
+void FilePoolCore::insertUnsorted(
+	const Sha1Sum& sum, time_t time, const string& filename)
+{
+	stringBuffer.push_back(filename);
+	auto idx = pool.emplace(sum, time, stringBuffer.back()).idx;
+	sha1Index.push_back(idx);
+	filenameIndex.insert(idx);
+	needWrite = true;
+}
+
 FilePoolCore::Sha1Index::iterator FilePoolCore::getSha1Iterator(Index idx, Entry& entry)
 {
 	// There can be multiple entries for the same sha1, look for the specific one.
@@ -67,6 +92,7 @@ FilePoolCore::Sha1Index::iterator FilePoolCore::getSha1Iterator(Index idx, Entry
 		if (*b == idx) {
 			return b;
 		}
+		++b;
 	}
 	assert(false); return sha1Index.end();
 }
@@ -137,6 +163,70 @@ void FilePoolCore::Entry::setTime(time_t t)
 	timeStr = nullptr;
 }
 
+// Layout of the binary '.filecache' file. It's only a cache, so simply use
+// the native byte order (a file from a different host is rejected):
+//   IndexHeader
+//   IndexEntry[numEntries]   sorted on sha1sum
+//   char[stringsSize]        filenames
+namespace {
+	constexpr char INDEX_MAGIC[8] = {'o', 'M', 'S', 'X', 'p', 'o', 'o', 'l'};
+	constexpr uint32_t INDEX_VERSION = 1;
+	constexpr uint32_t INDEX_BYTE_ORDER = 0x01020304;
+
+	struct IndexHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t byteOrder;
+		uint32_t numEntries;
+		uint32_t stringsSize;
+		uint32_t reserved[2];
+	};
+	struct IndexEntry {
+		int64_t time;
+		Sha1Sum sum;
+		uint32_t nameOffset;
+		uint32_t nameLength;
+	};
+	static_assert(std::is_trivially_copyable_v<IndexEntry>);
+	static_assert(sizeof(IndexHeader) == 32);
+	static_assert(sizeof(IndexEntry) == 40);
+}
+
+// Returns false if 'data' is not a (valid) binary index.
+bool FilePoolCore::readIndex(span<const uint8_t> data)
+{
+	assert(sha1Index.empty());
+
+	IndexHeader header;
+	if (data.size() < sizeof(header)) return false;
+	memcpy(&header, data.data(), sizeof(header));
+	if ((memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) ||
+	    (header.version != INDEX_VERSION) ||
+	    (header.byteOrder != INDEX_BYTE_ORDER)) {
+		return false;
+	}
+	auto entriesOffset = sizeof(IndexHeader);
+	auto stringsOffset = entriesOffset + uint64_t(header.numEntries) * sizeof(IndexEntry);
+	if (data.size() != (stringsOffset + header.stringsSize)) return false;
+	auto strings = reinterpret_cast<const char*>(data.data() + stringsOffset);
+	auto getString = [&](uint32_t offset, uint32_t length) -> std::optional<std::string_view> {
+		if ((uint64_t(offset) + length) > header.stringsSize) return {};
+		return std::string_view(strings + offset, length);
+	};
+
+	// Filenames point directly into the mmap'ed file.
+	sha1Index.reserve(header.numEntries);
+	for (uint32_t i = 0; i < header.numEntries; ++i) {
+		IndexEntry e;
+		memcpy(&e, data.data() + entriesOffset + i * sizeof(IndexEntry), sizeof(e));
+		auto filename = getString(e.nameOffset, e.nameLength);
+		if (!filename || (time_t(e.time) == time_t(-1))) continue;
+		sha1Index.push_back(pool.emplace(e.sum, time_t(e.time), *filename).idx);
+	}
+	buildIndices();
+	return true;
+}
+
 // returns: <sha1, time-string, filename>
 static std::optional<std::tuple<Sha1Sum, const char*, std::string_view>> parse(
 	char* line, char* line_end)
@@ -201,7 +291,13 @@ void FilePoolCore::readSha1sums()
 			return c != one_of('\n', '\r');
 		});
 	}
+	buildIndices();
+	needWrite = true; // convert to the binary format
+}
 
+// Called after loading all entries in 'pool' and 'sha1Index'.
+void FilePoolCore::buildIndices()
+{
 	if (!ranges::is_sorted(sha1Index, CompareSha1(pool))) {
 		// This should _rarely_ happen. In fact it should only happen
 		// when .filecache was manually edited. Though because it's
@@ -225,23 +321,54 @@ void FilePoolCore::readSha1sums()
 	}
 }
 
+// Restore the order of 'sha1Index' after entries were appended to it with
+// insertUnsorted(). The first 'sortedSize' elements are still sorted.
+void FilePoolCore::sortSha1Index(size_t sortedSize)
+{
+	auto middle = begin(sha1Index) + sortedSize;
+	std::sort(middle, end(sha1Index), CompareSha1(pool));
+	std::inplace_merge(begin(sha1Index), middle, end(sha1Index), CompareSha1(pool));
+}
+
 void FilePoolCore::writeSha1sums()
 {
-	std::ofstream file;
-	FileOperations::openofstream(file, filecache);
-	if (!file.is_open()) {
-		return;
-	}
+	// Build the new content in memory: the filenames may still point into
+	// the (mmap'ed) old file, which is about to be overwritten.
+	std::vector<IndexEntry> entries;
+	string strings;
+	auto addString = [&](std::string_view s) {
+		auto offset = uint32_t(strings.size());
+		strings += s;
+		return offset;
+	};
+	entries.reserve(sha1Index.size());
 	for (auto idx : sha1Index) {
-		const auto& entry = pool[idx];
-		file << entry.sum.toString() << "  ";
-		if (entry.timeStr) {
-			file << entry.timeStr;
-		} else {
-			assert(entry.time != time_t(-1));
-			file << Date::toString(entry.time);
-		}
-		file << "  " << entry.filename << '\n';
+		auto& entry = pool[idx];
+		auto time = entry.getTime();
+		if (time == time_t(-1)) continue; // invalid date/time in old text format
+		IndexEntry e;
+		e.time = int64_t(time);
+		e.sum = entry.sum;
+		e.nameLength = uint32_t(entry.filename.size());
+		e.nameOffset = addString(entry.filename);
+		entries.push_back(e);
+	}
+
+	IndexHeader header = {};
+	memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	header.version = INDEX_VERSION;
+	header.byteOrder = INDEX_BYTE_ORDER;
+	header.numEntries = uint32_t(entries.size());
+	header.stringsSize = uint32_t(strings.size());
+
+	indexFile.close();
+	try {
+		File file(filecache, File::TRUNCATE);
+		file.write(&header, sizeof(header));
+		file.write(entries.data(), entries.size() * sizeof(IndexEntry));
+		file.write(strings.data(), strings.size());
+	} catch (MSXException&) {
+		// ignore, it's only a cache
 	}
 }
 
@@ -308,6 +435,19 @@ Sha1Sum FilePoolCore::calcSha1sum(File& file)
 	return sha1.digest();
 }
 
+// Like calcSha1sum() but without progress reporting, so it can be called from
+// any thread. Returns std::nullopt on error.
+static std::optional<Sha1Sum> calcSha1sumNoProgress(const string& filename)
+{
+	try {
+		File file(filename);
+		auto data = file.mmap();
+		return SHA1::calc(data.data(), data.size());
+	} catch (MSXException&) {
+		return {};
+	}
+}
+
 File FilePoolCore::getFromPool(const Sha1Sum& sha1sum)
 {
 	auto [b, e] = ranges::equal_range(sha1Index, sha1sum, CompareSha1(pool));
@@ -360,31 +500,178 @@ File FilePoolCore::getFromPool(const Sha1Sum& sha1sum)
 	return File(); // not found
 }
 
+FilePoolCore::WatchedDir& FilePoolCore::getWatchedDir(const string& directory)
+{
+	auto it = ranges::find_if(watchedDirs, [&](auto& w) {
+		return w.directory == directory;
+	});
+	if (it != end(watchedDirs)) return *it;
+	// The scan below also enters hidden subdirectories, so watch those too.
+	auto& result = watchedDirs.emplace_back();
+	result.directory = directory;
+	result.watcher = std::make_unique<DirectoryWatcher>(directory + '/', true);
+	return result;
+}
+
 File FilePoolCore::scanDirectory(
 	const Sha1Sum& sha1sum, const string& directory, const string& poolPath,
 	ScanProgress& progress)
 {
-	File result;
-	auto fileAction = [&](const std::string& path, const FileOperations::Stat& st) {
+	auto& watched = getWatchedDir(directory);
+	if (watched.complete) {
+		auto changes = watched.watcher->getChanges();
+		if (!changes.all) {
+			append(watched.changedDirs, std::move(changes.dirs));
+			return scanChangedDirs(sha1sum, watched, poolPath, progress);
+		}
+		// (Possibly) missed some changes, scan everything again.
+		watched.complete = false;
+	}
+	// Changes from now on are picked up by the next scan.
+	watched.changedDirs.clear();
+	(void)watched.watcher->getChanges();
+
+	// Depth-first traversal, but all files in one directory are handled
+	// together, so that they can be hashed in parallel.
+	std::vector<string> todo = {directory};
+	std::vector<FileAndTime> files;
+	while (!todo.empty()) {
 		if (stop) {
 			// Scanning can take a long time. Allow to exit
 			// openmsx when it takes too long. Stop scanning
 			// by pretending we didn't find the file.
-			assert(!result.is_open());
-			return false; // abort foreach_file_recursive
+			return File();
 		}
-		result = scanFile(sha1sum, path, st, poolPath, progress);
-		return !result.is_open(); // abort traversal when found
-	};
-	foreach_file_recursive(directory, fileAction);
-	return result;
+		string dir = std::move(todo.back());
+		todo.pop_back();
+
+		// Note: a file can be modified in place without changing the
+		// modification time of its directory, so always look at (the
+		// modification time of) all files.
+		files.clear();
+		foreach_file_and_directory(
+			dir,
+			[&](const string& path, const FileOperations::Stat& fst) {
+				files.emplace_back(path, FileOperations::getModificationDate(fst));
+			},
+			[&](const string& path) { todo.push_back(path); });
+		File result = scanFiles(sha1sum, files, poolPath, progress);
+		if (result.is_open()) return result; // (remaining files not scanned)
+	}
+	watched.complete = watched.watcher->isActive();
+	return File(); // not found
 }
 
-File FilePoolCore::scanFile(const Sha1Sum& sha1sum, const string& filename,
-                            const FileOperations::Stat& st, const string& poolPath,
-                            ScanProgress& progress)
+File FilePoolCore::scanChangedDirs(
+	const Sha1Sum& sha1sum, WatchedDir& watched, const string& poolPath,
+	ScanProgress& progress)
+{
+	// Only the files directly in the changed directories need to be looked
+	// at: a new subdirectory is reported as a change on its own.
+	auto& todo = watched.changedDirs;
+	std::vector<FileAndTime> files;
+	while (!todo.empty()) {
+		if (stop) return File();
+		const auto& rel = todo.back();
+		// same paths as in the full scan
+		string dir = watched.directory;
+		if (!rel.empty()) {
+			strAppend(dir, '/', std::string_view(rel).substr(0, rel.size() - 1));
+		}
+		files.clear();
+		foreach_file(
+			dir,
+			[&](const string& path, const FileOperations::Stat& fst) {
+				files.emplace_back(path, FileOperations::getModificationDate(fst));
+			});
+		File result = scanFiles(sha1sum, files, poolPath, progress);
+		// When found (or stopped), this directory may not be completely
+		// scanned yet, so keep it in the list.
+		if (result.is_open() || stop) return result;
+		todo.pop_back();
+	}
+	return File(); // not found
+}
+
+File FilePoolCore::scanFiles(const Sha1Sum& sha1sum, span<const FileAndTime> files,
+                             const string& poolPath, ScanProgress& progress)
+{
+	// Collect the files that are not (or not correctly) in the database.
+	std::vector<const FileAndTime*> toHash;
+	for (const auto& f : files) {
+		auto [idx, entry] = findInDatabase(f.first);
+		if ((idx == Index(-1)) || (entry->getTime() != f.second)) {
+			toHash.push_back(&f);
+		} else if (entry->sum == sha1sum) {
+			// db is still up to date (normally already found by
+			// getFromPool())
+			try {
+				return File(f.first);
+			} catch (FileException&) {
+				// error reading file, remove from db
+				remove(idx, *entry);
+			}
+		}
+	}
+	progress.amountScanned += unsigned(files.size() - toHash.size());
+
+	// Calculating the sha1sums is by far the most expensive part of the
+	// scan: do it in parallel, in batches so that we can still show
+	// progress, abort the scan and stop as soon as the file is found.
+	constexpr size_t BATCH_SIZE = 128;
+	std::vector<std::optional<Sha1Sum>> sums;
+	for (size_t i = 0; i < toHash.size(); i += BATCH_SIZE) {
+		if (stop) break;
+		auto num = std::min(BATCH_SIZE, toHash.size() - i);
+		reportScanProgress(sha1sum, toHash[i]->first, poolPath, progress);
+		progress.amountScanned += unsigned(num);
+
+		sums.assign(num, std::nullopt);
+		getThreadPool().parallelFor(unsigned(num), [&](unsigned j) {
+			sums[j] = calcSha1sumNoProgress(toHash[i + j]->first);
+		});
+
+		// First update the existing entries ('sha1Index' must remain
+		// sorted for that), then add the new ones in one go.
+		File result;
+		auto checkFound = [&](const string& filename, const Sha1Sum& sum) {
+			if (result.is_open() || (sum != sha1sum)) return;
+			try {
+				result = File(filename);
+			} catch (FileException&) {
+				// ignore
+			}
+		};
+		for (size_t j = 0; j < num; ++j) {
+			const auto& [filename, time] = *toHash[i + j];
+			auto [idx, entry] = findInDatabase(filename);
+			if (idx == Index(-1)) continue;
+			if (!sums[j]) {
+				// error reading file, remove from db
+				remove(idx, *entry);
+				continue;
+			}
+			entry->setTime(time);
+			adjustSha1(idx, *entry, *sums[j]);
+			checkFound(filename, *sums[j]);
+		}
+		auto sortedSize = sha1Index.size();
+		for (size_t j = 0; j < num; ++j) {
+			const auto& [filename, time] = *toHash[i + j];
+			if (!sums[j] || filenameIndex.find(filename)) continue;
+			insertUnsorted(*sums[j], time, filename);
+			checkFound(filename, *sums[j]);
+		}
+		sortSha1Index(sortedSize);
+		if (result.is_open()) return result;
+	}
+	return File(); // not found
+}
+
+void FilePoolCore::reportScanProgress(
+	const Sha1Sum& sha1sum, std::string_view filename, const string& poolPath,
+	ScanProgress& progress)
 {
-	++progress.amountScanned;
 	// Periodically send a progress message with the current filename
 	auto now = Timer::getTime();
 	if (now > (progress.lastTime + 250'000)) { // 4Hz
@@ -393,48 +680,16 @@ File FilePoolCore::scanFile(const Sha1Sum& sha1sum, const string& filename,
 		        "Searching for file with sha1sum ", sha1sum.toString(),
 		        "...\nIndexing filepool ", poolPath, ": [",
 		        progress.amountScanned, "]: ",
-		        std::string_view(filename).substr(poolPath.size())));
+		        filename.substr(std::min(poolPath.size(), filename.size()))));
 	}
+}
 
-	auto time = FileOperations::getModificationDate(st);
-	auto [idx, entry] = findInDatabase(filename);
-	if (idx == Index(-1)) {
-		// not in pool
-		try {
-			File file(filename);
-			auto sum = calcSha1sum(file);
-			insert(sum, time, filename);
-			if (sum == sha1sum) {
-				return file;
-			}
-		} catch (FileException&) {
-			// ignore
-		}
-	} else {
-		// already in pool
-		assert(filename == entry->filename);
-		try {
-			if (entry->getTime() == time) {
-				// db is still up to date
-				if (entry->sum == sha1sum) {
-					return File(filename);
-				}
-			} else {
-				// db outdated
-				File file(filename);
-				auto sum = calcSha1sum(file);
-				entry->setTime(time);
-				adjustSha1(idx, *entry, sum);
-				if (sum == sha1sum) {
-					return file;
-				}
-			}
-		} catch (FileException&) {
-			// error reading file, remove from db
-			remove(idx, *entry);
-		}
+ThreadPool& FilePoolCore::getThreadPool()
+{
+	if (!threadPool) {
+		threadPool = std::make_unique<ThreadPool>();
 	}
-	return File(); // not found
+	return *threadPool;
 }
 
 std::pair<FilePoolCore::Index, FilePoolCore::Entry*> FilePoolCore::findInDatabase(std::string_view filename)
@@ -1,23 +1,29 @@
 #ifndef FILEPOOLCORE_HH
 #define FILEPOOLCORE_HH
 
+#include "File.hh"
 #include "FileOperations.hh"
 #include "ObjectPool.hh"
 #include "MemBuffer.hh"
 #include "SimpleHashSet.hh"
 #include "sha1.hh"
+#include "span.hh"
 #include "xxhash.hh"
 #include <cassert>
 #include <cstdint>
 #include <ctime>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 namespace openmsx {
 
-class File;
+class DirectoryWatcher;
+class ThreadPool;
 
 enum class FileType {
 	NONE = 0,
@@ -34,6 +40,17 @@ inline FileType& operator|=(FileType& x, FileType y) {
 	return x;
 }
 
+/** Database of (sha1sum, modification time, filename) for all files in the
+  * file pool directories, used to locate e.g. ROM images by sha1sum.
+  *
+  * The database is stored in a binary '.filecache' file, which is mmap'ed
+  * when loaded (the older text format can still be read). When a sha1sum
+  * is not found in the database, the pool directories are scanned: files
+  * that are new or changed are hashed in parallel. Once a pool directory
+  * has been scanned completely, later scans only look at the (sub)directories
+  * in which a DirectoryWatcher noticed changes (when that's not supported,
+  * the whole directory is scanned again).
+  */
 class FilePoolCore
 {
 public:
@@ -72,6 +89,7 @@ private:
 		uint64_t lastTime;
 		unsigned amountScanned;
 	};
+	using FileAndTime = std::pair<std::string, time_t>;
 
 	struct Entry {
 		Entry(const Sha1Sum& s, time_t t, std::string_view f)
@@ -126,6 +144,7 @@ private:
 
 private:
 	void insert(const Sha1Sum& sum, time_t time, const std::string& filename);
+	void insertUnsorted(const Sha1Sum& sum, time_t time, const std::string& filename);
 	Sha1Index::iterator getSha1Iterator(Index idx, Entry& entry);
 	void remove(Sha1Index::iterator it);
 	void remove(Index idx);
@@ -133,19 +152,32 @@ private:
 	bool adjustSha1(Sha1Index::iterator it, Entry& entry, const Sha1Sum& newSum);
 	bool adjustSha1(Index idx,              Entry& entry, const Sha1Sum& newSum);
 
+	bool readIndex(span<const uint8_t> data);
 	void readSha1sums();
 	void writeSha1sums();
+	void buildIndices();
+	void sortSha1Index(size_t sortedSize);
 
 	File getFromPool(const Sha1Sum& sha1sum);
 	File scanDirectory(const Sha1Sum& sha1sum,
 	                   const std::string& directory,
 	                   const std::string& poolPath,
 	                   ScanProgress& progress);
-	File scanFile(const Sha1Sum& sha1sum,
-	              const std::string& filename,
-	              const FileOperations::Stat& st,
-	              const std::string& poolPath,
-	              ScanProgress& progress);
+	struct WatchedDir;
+	WatchedDir& getWatchedDir(const std::string& directory);
+	File scanChangedDirs(const Sha1Sum& sha1sum,
+	                     WatchedDir& watched,
+	                     const std::string& poolPath,
+	                     ScanProgress& progress);
+	File scanFiles(const Sha1Sum& sha1sum,
+	               span<const FileAndTime> files,
+	               const std::string& poolPath,
+	               ScanProgress& progress);
+	void reportScanProgress(const Sha1Sum& sha1sum,
+	                        std::string_view filename,
+	                        const std::string& poolPath,
+	                        ScanProgress& progress);
+	ThreadPool& getThreadPool();
 	Sha1Sum calcSha1sum(File& file);
 	std::pair<Index, Entry*> findInDatabase(std::string_view filename);
 
@@ -154,13 +186,27 @@ private:
 	std::function<Directories()> getDirectories;
 	std::function<void(const std::string&)> reportProgress;
 
-	MemBuffer<char> fileMem; // content of initial .filecache
-	std::vector<std::string> stringBuffer; // owns strings that are not in 'fileMem'
+	File indexFile; // mmap'ed initial (binary) .filecache
+	MemBuffer<char> fileMem; // content of initial (text) .filecache
+	std::deque<std::string> stringBuffer; // owns strings that are not in 'indexFile' or 'fileMem'
 
 	Pool pool; // the actual entries
 	Sha1Index sha1Index; // entries accessible via sha1, sorted on 'CompareSha1'
 	FilenameIndex filenameIndex{FilenameIndexHash(pool), FilenameIndexEqual(pool)}; // accessible via filename
 
+	std::unique_ptr<ThreadPool> threadPool; // created on first use
+
+	struct WatchedDir {
+		std::string directory;
+		std::unique_ptr<DirectoryWatcher> watcher;
+		// All files in this directory (tree) are in the database, except
+		// for the (sub)directories listed in 'changedDirs' or reported by
+		// 'watcher'.
+		bool complete = false;
+		std::vector<std::string> changedDirs; // relative, empty or ending in '/'
+	};
+	std::vector<WatchedDir> watchedDirs;
+
 	bool stop = false; // abort long search (set via reportProgress callback)
 	bool needWrite = false; // dirty '.filecache'? write on exit
 
@@ -53,13 +53,12 @@ static bool skipHeader(ZlibInflate& zlib, std::string& originalName)
 	return true;
 }
 
-void GZFileAdapter::decompress(FileBase& f, Decompressed& d)
+size_t GZFileAdapter::parseHeader(ZlibInflate& zlib, std::string& originalName)
 {
-	ZlibInflate zlib(f.mmap());
-	if (!skipHeader(zlib, d.originalName)) {
+	if (!skipHeader(zlib, originalName)) {
 		throw FileException("Not a gzip header");
 	}
-	d.size = zlib.inflate(d.buf);
+	return 0; // unknown size
 }
 
 } // namespace openmsx
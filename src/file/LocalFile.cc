@@ -264,6 +264,36 @@ void LocalFile::truncate(size_t size)
 }
 #endif
 
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+std::vector<std::pair<size_t, size_t>> LocalFile::getDataRegions()
+{
+	auto size = getSize();
+	auto pos = getPos();
+	fflush(file.get()); // buffered writes must be in the file
+	int fd = fileno(file.get());
+
+	std::vector<std::pair<size_t, size_t>> result;
+	off_t end = 0;
+	while (size_t(end) < size) {
+		off_t start = lseek(fd, end, SEEK_DATA);
+		if (start == -1) {
+			if (errno != ENXIO) {
+				// e.g. not supported by the filesystem
+				result.assign(1, {0, size});
+			}
+			// else only a hole till the end of the file
+			break;
+		}
+		end = lseek(fd, start, SEEK_HOLE);
+		if (end == -1) end = size;
+		result.emplace_back(start, end - start);
+	}
+	// lseek() bypassed the stdio buffering, resync
+	seek(pos);
+	return result;
+}
+#endif
+
 void LocalFile::flush()
 {
 	fflush(file.get());
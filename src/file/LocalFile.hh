@@ -32,6 +32,9 @@ public:
 	size_t getPos() override;
 #if HAVE_FTRUNCATE
 	void truncate(size_t size) override;
+#endif
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+	std::vector<std::pair<size_t, size_t>> getDataRegions() override;
 #endif
 	void flush() override;
 	std::string getURL() const override;
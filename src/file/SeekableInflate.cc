@@ -0,0 +1,274 @@
+#include "SeekableInflate.hh"
+#include "File.hh"
+#include "FileException.hh"
+#include "FileOperations.hh"
+#include "MSXException.hh"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <zlib.h>
+
+namespace openmsx {
+
+constexpr size_t WINDOW_SIZE = 32768; // max distance of a deflate back-reference
+
+namespace {
+	// raw inflate stream, cleaned up on destruction
+	struct RawInflate {
+		RawInflate() {
+			s.zalloc = nullptr;
+			s.zfree  = nullptr;
+			s.opaque = nullptr;
+			s.next_in  = nullptr;
+			s.avail_in = 0;
+			int err = inflateInit2(&s, -MAX_WBITS);
+			if (err != Z_OK) {
+				throw FileException(
+					"Error initializing inflate struct: ", zError(err));
+			}
+		}
+		~RawInflate() {
+			inflateEnd(&s);
+		}
+
+		// 'avail_in' is only 32-bit: pass the input in pieces
+		void feed(span<const uint8_t> input, size_t& inPos) {
+			if ((s.avail_in != 0) || (inPos == input.size())) return;
+			auto num = std::min<size_t>(input.size() - inPos, 1 << 30);
+			s.next_in = const_cast<uint8_t*>(input.data() + inPos);
+			s.avail_in = uInt(num);
+			inPos += num;
+		}
+
+		z_stream s;
+	};
+}
+
+SeekableInflate::SeekableInflate(
+		span<const uint8_t> input_, const std::string& indexFilename,
+		const std::string& key, size_t spacing)
+	: input(input_)
+{
+	if (!indexFilename.empty() && loadIndex(indexFilename, key)) {
+		loaded = true;
+		return;
+	}
+	buildIndex(spacing);
+	if (!indexFilename.empty()) {
+		saveIndex(indexFilename, key);
+	}
+}
+
+void SeekableInflate::buildIndex(size_t spacing)
+{
+	checkpoints.clear();
+	checkpoints.push_back({0, 0, 0, {}});
+
+	RawInflate z;
+	MemBuffer<uint8_t> window(WINDOW_SIZE); // circular output buffer
+	size_t inPos = 0;
+	uint64_t totalOut = 0;
+	uint64_t last = 0;
+	while (true) {
+		z.s.next_out = window.data();
+		z.s.avail_out = WINDOW_SIZE;
+		while (z.s.avail_out != 0) {
+			z.feed(input, inPos);
+			auto before = z.s.avail_out;
+			// Z_BLOCK: also return at each deflate block boundary
+			int err = ::inflate(&z.s, Z_BLOCK);
+			totalOut += before - z.s.avail_out;
+			if (err == Z_STREAM_END) {
+				size = totalOut;
+				return;
+			}
+			if (err != Z_OK) {
+				throw FileException("Error decompressing: ", zError(err));
+			}
+			bool blockBoundary = (z.s.data_type & 128) && !(z.s.data_type & 64);
+			if (blockBoundary && ((totalOut - last) >= spacing)) {
+				Checkpoint cp;
+				cp.out = totalOut;
+				cp.in = inPos - z.s.avail_in;
+				cp.bits = z.s.data_type & 7;
+				// the last 'n' output bytes, they end at 'writePos'
+				auto n = size_t(std::min<uint64_t>(totalOut, WINDOW_SIZE));
+				size_t writePos = WINDOW_SIZE - z.s.avail_out;
+				cp.window.resize(n);
+				if (n <= writePos) {
+					memcpy(cp.window.data(), window.data() + writePos - n, n);
+				} else {
+					size_t wrap = n - writePos;
+					memcpy(cp.window.data(), window.data() + WINDOW_SIZE - wrap, wrap);
+					memcpy(cp.window.data() + wrap, window.data(), writePos);
+				}
+				checkpoints.push_back(std::move(cp));
+				last = totalOut;
+			}
+		}
+	}
+}
+
+const SeekableInflate::Chunk& SeekableInflate::getChunk(size_t index)
+{
+	++useCounter;
+	for (auto& c : chunks) {
+		if (c.index == index) {
+			c.lastUse = useCounter;
+			return c;
+		}
+	}
+
+	// replace the least recently used chunk
+	auto& chunk = *std::min_element(std::begin(chunks), std::end(chunks),
+		[](const Chunk& x, const Chunk& y) { return x.lastUse < y.lastUse; });
+	chunk.index = size_t(-1); // in case of an exception below
+
+	const auto& cp = checkpoints[index];
+	auto end = (index + 1 < checkpoints.size()) ? checkpoints[index + 1].out : size;
+	chunk.size = size_t(end - cp.out);
+	chunk.data.resize(chunk.size);
+
+	RawInflate z;
+	size_t inPos = size_t(cp.in);
+	if (cp.bits) {
+		inflatePrime(&z.s, cp.bits, input[inPos - 1] >> (8 - cp.bits));
+	}
+	if (!cp.window.empty()) {
+		inflateSetDictionary(&z.s, cp.window.data(), uInt(cp.window.size()));
+	}
+	z.s.next_out = chunk.data.data();
+	z.s.avail_out = uInt(chunk.size);
+	while (z.s.avail_out != 0) {
+		z.feed(input, inPos);
+		int err = ::inflate(&z.s, Z_NO_FLUSH);
+		if (err == Z_STREAM_END) break;
+		if (err != Z_OK) {
+			throw FileException("Error decompressing: ", zError(err));
+		}
+	}
+	if (z.s.avail_out != 0) {
+		throw FileException("Error decompressing: unexpected end of stream");
+	}
+
+	chunk.index = index;
+	chunk.lastUse = useCounter;
+	return chunk;
+}
+
+void SeekableInflate::read(size_t pos, uint8_t* buffer, size_t num)
+{
+	assert((pos + num) <= size);
+	while (num) {
+		// last checkpoint at or before 'pos'
+		auto it = std::upper_bound(begin(checkpoints), end(checkpoints), pos,
+			[](uint64_t p, const Checkpoint& c) { return p < c.out; });
+		size_t index = (it - begin(checkpoints)) - 1;
+		const auto& chunk = getChunk(index);
+		size_t offset = pos - size_t(checkpoints[index].out);
+		size_t n = std::min(num, chunk.size - offset);
+		memcpy(buffer, chunk.data.data() + offset, n);
+		buffer += n;
+		pos += n;
+		num -= n;
+	}
+}
+
+// Layout of the index file (native byte order, it's only a cache):
+//   magic, version, key length, key, uncompressed size, number of checkpoints,
+//   per checkpoint: out, in, bits, window size, window
+constexpr char INDEX_MAGIC[8] = {'o', 'M', 'S', 'X', 'z', 'i', 'd', 'x'};
+constexpr uint32_t INDEX_VERSION = 1;
+
+bool SeekableInflate::loadIndex(const std::string& filename, const std::string& key)
+{
+	try {
+		File file(filename);
+		auto data = file.mmap();
+		size_t pos = 0;
+		auto get = [&](void* dst, size_t num) {
+			if ((data.size() - pos) < num) return false;
+			memcpy(dst, data.data() + pos, num);
+			pos += num;
+			return true;
+		};
+
+		char magic[sizeof(INDEX_MAGIC)];
+		uint32_t version, keyLength;
+		if (!get(magic, sizeof(magic)) ||
+		    (memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0) ||
+		    !get(&version, sizeof(version)) || (version != INDEX_VERSION) ||
+		    !get(&keyLength, sizeof(keyLength)) || (keyLength != key.size())) {
+			return false;
+		}
+		std::string fileKey(keyLength, '\0');
+		if (!get(fileKey.data(), keyLength) || (fileKey != key)) return false;
+
+		uint64_t fileSize;
+		uint32_t num;
+		if (!get(&fileSize, sizeof(fileSize)) || !get(&num, sizeof(num)) || (num == 0)) {
+			return false;
+		}
+		std::vector<Checkpoint> cps(num);
+		for (auto& cp : cps) {
+			uint32_t bits, windowSize;
+			if (!get(&cp.out, sizeof(cp.out)) || !get(&cp.in, sizeof(cp.in)) ||
+			    !get(&bits, sizeof(bits)) || !get(&windowSize, sizeof(windowSize)) ||
+			    (bits > 7) || (windowSize > WINDOW_SIZE) ||
+			    (cp.in > input.size()) || (bits && (cp.in == 0)) ||
+			    (cp.out > fileSize)) {
+				return false;
+			}
+			cp.bits = bits;
+			cp.window.resize(windowSize);
+			if (!get(cp.window.data(), windowSize)) return false;
+		}
+		if ((cps[0].out != 0) ||
+		    !std::is_sorted(begin(cps), end(cps),
+		                    [](const Checkpoint& x, const Checkpoint& y) { return x.out < y.out; })) {
+			return false;
+		}
+		checkpoints = std::move(cps);
+		size = size_t(fileSize);
+		return true;
+	} catch (MSXException&) {
+		return false; // e.g. index file doesn't exist (yet)
+	}
+}
+
+void SeekableInflate::saveIndex(const std::string& filename, const std::string& key) const
+{
+	std::vector<uint8_t> data;
+	auto put = [&](const void* src, size_t num) {
+		auto* p = static_cast<const uint8_t*>(src);
+		data.insert(data.end(), p, p + num);
+	};
+	auto keyLength = uint32_t(key.size());
+	uint64_t fileSize = size;
+	auto num = uint32_t(checkpoints.size());
+	put(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	put(&INDEX_VERSION, sizeof(INDEX_VERSION));
+	put(&keyLength, sizeof(keyLength));
+	put(key.data(), key.size());
+	put(&fileSize, sizeof(fileSize));
+	put(&num, sizeof(num));
+	for (const auto& cp : checkpoints) {
+		uint32_t bits = cp.bits;
+		auto windowSize = uint32_t(cp.window.size());
+		put(&cp.out, sizeof(cp.out));
+		put(&cp.in, sizeof(cp.in));
+		put(&bits, sizeof(bits));
+		put(&windowSize, sizeof(windowSize));
+		put(cp.window.data(), cp.window.size());
+	}
+
+	try {
+		FileOperations::mkdirp(FileOperations::getDirName(filename));
+		File file(filename, File::TRUNCATE);
+		file.write(data.data(), data.size());
+	} catch (MSXException&) {
+		// ignore, it's only a cache
+	}
+}
+
+} // namespace openmsx
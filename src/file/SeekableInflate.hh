@@ -0,0 +1,88 @@
+#ifndef SEEKABLEINFLATE_HH
+#define SEEKABLEINFLATE_HH
+
+#include "MemBuffer.hh"
+#include "span.hh"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+/** Random access into a (raw) deflate stream, without decompressing all of
+  * it in memory.
+  *
+  * A first sequential pass over the stream records a checkpoint every
+  * 'spacing' bytes of output: the position in the compressed stream (at a
+  * deflate block boundary) and the last 32kB of output before it (the
+  * dictionary needed to continue from there). Afterwards any part of the
+  * output can be reached by inflating from the nearest checkpoint. The most
+  * recently used parts are kept in a small cache.
+  *
+  * Because that first pass still has to go over the whole stream, the
+  * checkpoints can be stored in an index file, so that a next time the
+  * stream can be accessed immediately.
+  */
+class SeekableInflate
+{
+public:
+	static constexpr size_t DEFAULT_SPACING = 1024 * 1024;
+
+	/** @param input The raw deflate stream, must remain valid during the
+	  *              lifetime of this object.
+	  * @param indexFilename Load the checkpoints from this file, or when
+	  *              that's not possible, store them in there after
+	  *              building them. Empty for no index file.
+	  * @param key   Identifies the compressed stream (e.g. its filename,
+	  *              size and modification time). An index file with a
+	  *              different key is ignored.
+	  * @param spacing Distance between checkpoints (in uncompressed bytes).
+	  * @throws FileException when the stream is corrupt.
+	  */
+	SeekableInflate(span<const uint8_t> input, const std::string& indexFilename,
+	                const std::string& key, size_t spacing = DEFAULT_SPACING);
+
+	/** Size of the uncompressed data. */
+	[[nodiscard]] size_t getSize() const { return size; }
+
+	/** Copy part of the uncompressed data.
+	  * @pre pos + num <= getSize()
+	  * @throws FileException when the stream is corrupt.
+	  */
+	void read(size_t pos, uint8_t* buffer, size_t num);
+
+	/** Was the index loaded from the index file? (for testing) */
+	[[nodiscard]] bool loadedIndex() const { return loaded; }
+
+private:
+	struct Checkpoint {
+		uint64_t out; // position in uncompressed data
+		uint64_t in;  // position in compressed data (byte after the block boundary)
+		unsigned bits; // number of bits of input[in - 1] that belong to the next block
+		std::vector<uint8_t> window; // the (at most 32kB) output just before 'out'
+	};
+	struct Chunk {
+		size_t index = size_t(-1); // checkpoint index
+		MemBuffer<uint8_t> data;
+		size_t size = 0;
+		uint64_t lastUse = 0;
+	};
+
+	void buildIndex(size_t spacing);
+	bool loadIndex(const std::string& filename, const std::string& key);
+	void saveIndex(const std::string& filename, const std::string& key) const;
+	const Chunk& getChunk(size_t index);
+
+	span<const uint8_t> input;
+	std::vector<Checkpoint> checkpoints;
+	size_t size = 0;
+
+	static constexpr size_t NUM_CHUNKS = 4;
+	Chunk chunks[NUM_CHUNKS];
+	uint64_t useCounter = 0;
+	bool loaded = false;
+};
+
+} // namespace openmsx
+
+#endif
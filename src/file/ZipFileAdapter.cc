@@ -9,10 +9,8 @@ ZipFileAdapter::ZipFileAdapter(std::unique_ptr<FileBase> file_)
 {
 }
 
-void ZipFileAdapter::decompress(FileBase& f, Decompressed& d)
+size_t ZipFileAdapter::parseHeader(ZlibInflate& zlib, std::string& originalName)
 {
-	ZlibInflate zlib(f.mmap());
-
 	if (zlib.get32LE() != 0x04034B50) {
 		throw FileException("Invalid ZIP file");
 	}
@@ -32,10 +30,10 @@ void ZipFileAdapter::decompress(FileBase& f, Decompressed& d)
 	unsigned origSize = zlib.get32LE(); // uncompressed size
 	unsigned filenameLen = zlib.get16LE(); // filename length
 	unsigned extraFieldLen = zlib.get16LE(); // extra field length
-	d.originalName = zlib.getString(filenameLen); // original filename
+	originalName = zlib.getString(filenameLen); // original filename
 	zlib.skip(extraFieldLen); // skip "extra field"
 
-	d.size = zlib.inflate(d.buf, origSize);
+	return origSize;
 }
 
 } // namespace openmsx
@@ -11,7 +11,7 @@ public:
 	explicit ZipFileAdapter(std::unique_ptr<FileBase> file);
 
 private:
-	void decompress(FileBase& file, Decompressed& decompressed) override;
+	size_t parseHeader(ZlibInflate& zlib, std::string& originalName) override;
 };
 
 } // namespace openmsx
@@ -22,6 +22,12 @@ public:
 	std::string getString(size_t len);
 	std::string getCString();
 
+	/** The part of the input that's not consumed yet (e.g. the compressed
+	  * data after the header). */
+	[[nodiscard]] span<uint8_t> getRemainingInput() const {
+		return {s.next_in, s.avail_in};
+	}
+
 	size_t inflate(MemBuffer<uint8_t>& output, size_t sizeHint = 65536);
 
 private:
@@ -1,4 +1,5 @@
 #include "HD.hh"
+#include "ChunkedImage.hh"
 #include "FileContext.hh"
 #include "FilePool.hh"
 #include "DeviceConfig.hh"
@@ -14,6 +15,7 @@
 #include "serialize.hh"
 #include "tiger.hh"
 #include "xrange.hh"
+#include <algorithm>
 #include <cassert>
 #include <memory>
 
@@ -52,7 +54,8 @@ HD::HD(const DeviceConfig& config)
 	}
 
 	file = File(filename, mode);
-	filesize = file.getSize();
+	openChunkedImage();
+	enableSectorCache();
 	if (mode == File::CREATE && filesize == 0) {
 		// OK, the file was just newly created. Now make sure the file
 		// is of the right (default) size
@@ -86,13 +89,22 @@ void HD::switchImage(const Filename& newFilename)
 {
 	file = File(newFilename);
 	filename = newFilename;
-	filesize = file.getSize();
+	openChunkedImage();
+	flushSectorCache();
 	tigerTree = std::make_unique<TigerTree>(*this, filesize,
 			filename.getResolved());
 	motherBoard.getMSXCliComm().update(CliComm::MEDIA, getName(),
 	                                   filename.getResolved());
 }
 
+void HD::openChunkedImage()
+{
+	chunked = ChunkedImage::isChunkedImage(file)
+	        ? std::make_unique<ChunkedImage>(filename.getResolved())
+	        : nullptr;
+	filesize = chunked ? chunked->getSize() : file.getSize();
+}
+
 size_t HD::getNbSectorsImpl() const
 {
 	return filesize / sizeof(SectorBuffer);
@@ -100,26 +112,50 @@ size_t HD::getNbSectorsImpl() const
 
 void HD::readSectorImpl(size_t sector, SectorBuffer& buf)
 {
-	file.seek(sector * sizeof(buf));
-	file.read(&buf, sizeof(buf));
+	readSectorsImpl(sector, 1, &buf);
 }
 
 void HD::writeSectorImpl(size_t sector, const SectorBuffer& buf)
 {
-	file.seek(sector * sizeof(buf));
-	file.write(&buf, sizeof(buf));
-	tigerTree->notifyChange(sector * sizeof(buf), sizeof(buf),
-	                        file.getModificationDate());
+	writeSectorsImpl(sector, 1, &buf);
+}
+
+void HD::readSectorsImpl(size_t sector, size_t num, SectorBuffer* bufs)
+{
+	auto offset = sector * sizeof(SectorBuffer);
+	auto size = num * sizeof(SectorBuffer);
+	if (chunked) {
+		chunked->read(offset, bufs[0].raw, size);
+		return;
+	}
+	file.seek(offset);
+	file.read(bufs, size);
+}
+
+void HD::writeSectorsImpl(size_t sector, size_t num, const SectorBuffer* bufs)
+{
+	auto offset = sector * sizeof(SectorBuffer);
+	auto size = num * sizeof(SectorBuffer);
+	if (chunked) {
+		chunked->write(offset, bufs[0].raw, size);
+		tigerTree->notifyChange(offset, size, chunked->getModificationDate());
+		return;
+	}
+	file.seek(offset);
+	file.write(bufs, size);
+	dataRegionsValid = false; // may have filled a hole
+	tigerTree->notifyChange(offset, size, file.getModificationDate());
 }
 
 bool HD::isWriteProtectedImpl() const
 {
-	return file.isReadOnly();
+	return chunked ? chunked->isReadOnly() : file.isReadOnly();
 }
 
 Sha1Sum HD::getSha1SumImpl(FilePool& filePool)
 {
-	if (hasPatches()) {
+	if (hasPatches() || chunked) {
+		// hash the (patched or decompressed) content, not the file
 		return SectorAccessibleDisk::getSha1SumImpl(filePool);
 	}
 	return filePool.getSha1Sum(file);
@@ -148,6 +184,7 @@ std::string HD::getTigerTreeHash()
 {
 	lastProgressTime = Timer::getTime();
 	everDidProgress = false;
+	dataRegionsValid = false; // file may have been modified externally
 	auto callback = [this](size_t p, size_t t) { showProgress(p, t); };
 	return tigerTree->calcHash(callback).toString(); // calls HD::getData()
 }
@@ -175,12 +212,35 @@ uint8_t* HD::getData(size_t offset, size_t size)
 
 bool HD::isCacheStillValid(time_t& cacheTime)
 {
-	time_t fileTime = file.getModificationDate();
+	time_t fileTime = chunked ? chunked->getModificationDate()
+	                          : file.getModificationDate();
 	bool result = fileTime == cacheTime;
 	cacheTime = fileTime;
 	return result;
 }
 
+const TigerHash* HD::getHash(size_t offset, size_t size)
+{
+	// IPS patches are applied in getData(), they're not in the stored hashes
+	if (!chunked || hasPatches()) return nullptr;
+	return chunked->getHash(offset, size);
+}
+
+bool HD::isZero(size_t offset, size_t size)
+{
+	// Holes in a sparse image file read as zeros, so they don't need to
+	// be read (nor hashed).
+	if (chunked || hasPatches()) return false;
+	if (!dataRegionsValid) {
+		dataRegions = file.getDataRegions();
+		dataRegionsValid = true;
+	}
+	// first region that ends after 'offset'
+	auto it = std::upper_bound(begin(dataRegions), end(dataRegions), offset,
+		[](size_t o, const auto& r) { return o < (r.first + r.second); });
+	return (it == end(dataRegions)) || (it->first >= (offset + size));
+}
+
 SectorAccessibleDisk* HD::getSectorAccessibleDisk()
 {
 	return this;
@@ -10,10 +10,13 @@
 #include <bitset>
 #include <string>
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace openmsx {
 
 class MSXMotherBoard;
+class ChunkedImage;
 class HDCommand;
 class DeviceConfig;
 
@@ -39,6 +42,8 @@ private:
 	// SectorAccessibleDisk:
 	void readSectorImpl (size_t sector,       SectorBuffer& buf) override;
 	void writeSectorImpl(size_t sector, const SectorBuffer& buf) override;
+	void readSectorsImpl (size_t sector, size_t num,       SectorBuffer* bufs) override;
+	void writeSectorsImpl(size_t sector, size_t num, const SectorBuffer* bufs) override;
 	size_t getNbSectorsImpl() const override;
 	bool isWriteProtectedImpl() const override;
 	Sha1Sum getSha1SumImpl(FilePool& filePool) override;
@@ -52,6 +57,10 @@ private:
 	// TTData
 	uint8_t* getData(size_t offset, size_t size) override;
 	bool isCacheStillValid(time_t& time) override;
+	const TigerHash* getHash(size_t offset, size_t size) override;
+	bool isZero(size_t offset, size_t size) override;
+
+	void openChunkedImage();
 
 	void showProgress(size_t position, size_t maxPosition);
 
@@ -61,8 +70,12 @@ private:
 	std::unique_ptr<TigerTree> tigerTree;
 
 	File file;
+	std::unique_ptr<ChunkedImage> chunked; // only for chunked images
 	Filename filename;
 	size_t filesize;
+	// Cached result of File::getDataRegions(), see isZero().
+	std::vector<std::pair<size_t, size_t>> dataRegions;
+	bool dataRegionsValid = false;
 
 	static constexpr unsigned MAX_HD = 26;
 	using HDInUse = std::bitset<MAX_HD>;
@@ -587,9 +587,12 @@ byte AY8910::peekRegister(unsigned reg, EmuTime::param time) const
 void AY8910::writeRegister(unsigned reg, byte value, EmuTime::param time)
 {
 	if (reg >= 16) return;
-	if ((reg < AY_PORTA) && (reg == AY_ESHAPE || regs[reg] != value)) {
-		// Update the output buffer before changing the register.
-		updateStream(time);
+	if (reg < AY_PORTA) {
+		if (reg == AY_ESHAPE || regs[reg] != value) {
+			// Update the output buffer before changing the register.
+			updateStream(time);
+		}
+		logRegisterWrite(0, reg, value, time);
 	}
 	wrtReg(reg, value, time);
 }
@@ -701,6 +704,11 @@ void AY8910::generateChannels(float** bufs, unsigned num)
 	if ((chanEnable & 0x38) == 0x38) {
 		noise.advance(num);
 	}
+	if (!bufs[0] && !bufs[1] && !bufs[2]) {
+		// All channels remain muted until the next register write,
+		// advanceIdle() does the same as the rest of this method.
+		setIdle();
+	}
 
 	// Calculate samples.
 	// The 8910 has three outputs, each output is the mix of one of the
@@ -972,6 +980,30 @@ float AY8910::getAmplificationFactorImpl() const
 	return 1.0f;
 }
 
+void AY8910::advanceIdle(unsigned num)
+{
+	// see generateChannels(), all channels muted
+	for (auto& t : tone) t.advance(num);
+	noise.advance(num);
+	if (envelope.isChanging()) {
+		envelope.advance(num);
+	}
+}
+
+std::optional<RegisterLogger::Chip> AY8910::getRegisterLogChip() const
+{
+	return RegisterLogger::Chip::AY8910;
+}
+
+void AY8910::replayRegisterWrite(uint8_t port, uint8_t reg, uint8_t value,
+                                 EmuTime::param time)
+{
+	// the I/O ports are not logged
+	if ((port == 0) && (reg < AY_PORTA)) {
+		writeRegister(reg, value, time);
+	}
+}
+
 void AY8910::update(const Setting& setting)
 {
 	if (&setting == one_of(&vibratoPercent, &detunePercent)) {
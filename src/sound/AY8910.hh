@@ -159,7 +159,11 @@ private:
 
 	// SoundDevice
 	void generateChannels(float** bufs, unsigned num) override;
+	void advanceIdle(unsigned num) override;
 	float getAmplificationFactorImpl() const override;
+	std::optional<RegisterLogger::Chip> getRegisterLogChip() const override;
+	void replayRegisterWrite(uint8_t port, uint8_t reg, uint8_t value,
+	                         EmuTime::param time) override;
 
 	// Observer<Setting>
 	void update(const Setting& setting) override;
@@ -0,0 +1,131 @@
+#include "AsyncWavWriter.hh"
+#include "WavWriter.hh"
+#include "MSXException.hh"
+#include "Math.hh"
+#include "one_of.hh"
+#include <cassert>
+#include <cmath>
+
+namespace openmsx {
+
+// Number of 16-bit values per chunk (a bit less than 0.4s of 44.1kHz stereo).
+static constexpr unsigned CHUNK_SIZE = 32 * 1024;
+static constexpr unsigned MAX_PENDING_CHUNKS = 16;
+
+AsyncWavWriter::AsyncWavWriter(const Filename& filename, unsigned channels_,
+                               unsigned frequency)
+	: channels(channels_)
+	, writer(std::make_unique<Wav16Writer>(filename, channels, frequency))
+	, worker(MAX_PENDING_CHUNKS)
+{
+	chunk.reserve(CHUNK_SIZE);
+}
+
+AsyncWavWriter::~AsyncWavWriter()
+{
+	try {
+		close();
+	} catch (MSXException&) {
+		// ignore, can't throw from destructor
+	}
+}
+
+static int16_t float2int16(float f)
+{
+	return Math::clipIntToShort(lrintf(32768.0f * f));
+}
+
+void AsyncWavWriter::write(const int16_t* buffer, unsigned stereo, unsigned samples)
+{
+	assert(!closed);
+	assert(stereo == one_of(1u, 2u));
+	assert(stereo == channels); (void)stereo;
+	unsigned num = stereo * samples;
+	while (num) {
+		unsigned n = std::min<unsigned>(num, CHUNK_SIZE - unsigned(chunk.size()));
+		chunk.insert(chunk.end(), buffer, buffer + n);
+		buffer += n;
+		num -= n;
+		if (chunk.size() == CHUNK_SIZE) submitChunk();
+	}
+}
+
+void AsyncWavWriter::write(const float* buffer, unsigned stereo, unsigned samples,
+                           float ampLeft, float ampRight)
+{
+	assert(!closed);
+	assert(stereo == one_of(1u, 2u));
+	assert(stereo == channels);
+	if (stereo == 1) {
+		assert(ampLeft == ampRight);
+		for (unsigned i = 0; i < samples; ++i) {
+			chunk.push_back(float2int16(buffer[i] * ampLeft));
+			if (chunk.size() == CHUNK_SIZE) submitChunk();
+		}
+	} else {
+		// CHUNK_SIZE is even, so a stereo pair never gets split
+		for (unsigned i = 0; i < samples; ++i) {
+			chunk.push_back(float2int16(buffer[2 * i + 0] * ampLeft));
+			chunk.push_back(float2int16(buffer[2 * i + 1] * ampRight));
+			if (chunk.size() == CHUNK_SIZE) submitChunk();
+		}
+	}
+}
+
+void AsyncWavWriter::writeSilence(unsigned stereo, unsigned samples)
+{
+	assert(!closed);
+	assert(stereo == one_of(1u, 2u));
+	assert(stereo == channels);
+	unsigned num = stereo * samples;
+	while (num) {
+		unsigned n = std::min<unsigned>(num, CHUNK_SIZE - unsigned(chunk.size()));
+		chunk.insert(chunk.end(), n, 0);
+		num -= n;
+		if (chunk.size() == CHUNK_SIZE) submitChunk();
+	}
+}
+
+void AsyncWavWriter::submitChunk()
+{
+	std::vector<int16_t> data;
+	data.reserve(CHUNK_SIZE);
+	std::swap(data, chunk);
+	worker.pushMoveOnly([this, data = std::move(data)] {
+		if (!writer) return; // stopped after an error
+		try {
+			writer->write(data.data(), channels, unsigned(data.size() / channels));
+		} catch (MSXException& e) {
+			setError(e.getMessage());
+			writer.reset();
+		}
+	});
+}
+
+void AsyncWavWriter::close()
+{
+	if (closed) return;
+	closed = true;
+	if (!chunk.empty()) submitChunk();
+	worker.push([this] {
+		if (!writer) return;
+		try {
+			writer->flush(); // updates the header
+		} catch (MSXException& e) {
+			setError(e.getMessage());
+		}
+		writer.reset();
+	});
+	worker.flush();
+
+	std::lock_guard<std::mutex> lock(errorMutex);
+	if (!error.empty()) throw MSXException(error);
+}
+
+void AsyncWavWriter::setError(std::string message)
+{
+	std::lock_guard<std::mutex> lock(errorMutex);
+	if (error.empty()) error = std::move(message);
+}
+
+} // namespace openmsx
@@ -0,0 +1,67 @@
+#ifndef ASYNCWAVWRITER_HH
+#define ASYNCWAVWRITER_HH
+
+#include "WorkerThread.hh"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class Filename;
+class Wav16Writer;
+
+/** Writes a 16-bit WAV file from a background thread.
+  *
+  * The samples are converted and collected in large chunks on the calling
+  * (emulation) thread, only full chunks are handed over to the writer
+  * thread. So the emulation thread never waits for disk I/O, unless the
+  * disk can't keep up at all (then WorkerThread blocks).
+  *
+  * The file itself is created in the constructor, so an invalid filename
+  * is still reported immediately. Errors while writing are reported by
+  * close().
+  */
+class AsyncWavWriter
+{
+public:
+	AsyncWavWriter(const Filename& filename, unsigned channels, unsigned frequency);
+
+	/** Calls close(), but ignores errors. */
+	~AsyncWavWriter();
+
+	AsyncWavWriter(const AsyncWavWriter&) = delete;
+	AsyncWavWriter& operator=(const AsyncWavWriter&) = delete;
+
+	void write(const int16_t* buffer, unsigned stereo, unsigned samples);
+	void write(const float* buffer, unsigned stereo, unsigned samples,
+	           float ampLeft, float ampRight);
+	void writeSilence(unsigned stereo, unsigned samples);
+
+	/** Write all pending samples, update the WAV header and wait till
+	  * that's done. Afterwards no more samples may be written.
+	  * @throws MSXException when something went wrong while writing.
+	  */
+	void close();
+
+private:
+	void submitChunk();
+	void setError(std::string message);
+
+	std::vector<int16_t> chunk; // not yet submitted
+	const unsigned channels;
+	bool closed = false;
+
+	std::unique_ptr<Wav16Writer> writer; // only used by 'worker'
+	std::string error; // first error on the worker thread
+	std::mutex errorMutex;
+
+	// Must come last, so that it's stopped first.
+	WorkerThread worker;
+};
+
+} // namespace openmsx
+
+#endif
@@ -156,6 +156,11 @@ static bool isSilent(float x)
 	return std::abs(x) < threshold;
 }
 
+bool BlipBuffer::isDrained() const
+{
+	return (availSamp <= 0) && isSilent(accum);
+}
+
 template <unsigned PITCH>
 bool BlipBuffer::readSamples(float* __restrict out, unsigned samples)
 {
@@ -30,6 +30,9 @@ public:
 	template <unsigned PITCH>
 	bool readSamples(float* out, unsigned samples);
 
+	// Will readSamples() return 'false' (muted) until the next addDelta()?
+	bool isDrained() const;
+
 private:
 	template <unsigned PITCH>
 	void readSamplesHelper(float* out, unsigned samples) __restrict;
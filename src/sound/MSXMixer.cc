@@ -11,8 +11,10 @@
 #include "BooleanSetting.hh"
 #include "CommandException.hh"
 #include "AviRecorder.hh"
+#include "RegisterLogCommand.hh"
 #include "Filename.hh"
 #include "CliComm.hh"
+#include "ThreadPool.hh"
 #include "stl.hh"
 #include "aligned.hh"
 #include "one_of.hh"
@@ -21,6 +23,7 @@
 #include "unreachable.hh"
 #include "view.hh"
 #include "vla.hh"
+#include "xrange.hh"
 #include <cassert>
 #include <cmath>
 #include <cstring>
@@ -47,6 +50,8 @@ MSXMixer::MSXMixer(Mixer& mixer_, MSXMotherBoard& motherBoard_,
 	, throttleManager(globalSettings.getThrottleManager())
 	, prevTime(getCurrentTime(), 44100)
 	, soundDeviceInfo(commandController.getMachineInfoCommand())
+	, soundStatisticsInfo(commandController.getMachineInfoCommand())
+	, registerLogCommand(std::make_unique<RegisterLogCommand>(motherBoard, *this))
 	, recorder(nullptr)
 	, synchronousCounter(0)
 {
@@ -123,6 +128,8 @@ void MSXMixer::registerSound(SoundDevice& device, float volume,
 
 void MSXMixer::unregisterSound(SoundDevice& device)
 {
+	registerLogCommand->unregisterSound(device);
+
 	auto it = rfind_if_unguarded(infos,
 		[&](const SoundDeviceInfo& i) { return i.device == &device; });
 	it->volumeSetting->detach(*this);
@@ -435,33 +442,69 @@ void MSXMixer::generate(float* output, EmuTime::param time, unsigned samples)
 	constexpr unsigned HAS_STEREO_FLAG = 2;
 	unsigned usedBuffers = 0;
 
+	// Optionally let all devices generate their output in parallel first,
+	// each in its own buffer. The results are still mixed (below) one
+	// after the other in the fixed order of 'infos', so the output is
+	// exactly the same as when the devices are generated serially.
+	auto* pool = mixer.getSynthesisThreadPool();
+	bool parallel = pool && (infos.size() > 1);
+	unsigned pitch = (2 * samples + 3 + 3) & ~3; // keep SSE alignment
+	VLA(bool, generated, infos.size());
+	if (parallel) {
+		if (deviceBufSize < pitch * infos.size()) {
+			deviceBufSize = pitch * unsigned(infos.size());
+			deviceBuf.resize(deviceBufSize);
+		}
+		pool->parallelFor(unsigned(infos.size()), [&](unsigned i) {
+			generated[i] = infos[i].device->timedUpdateBuffer(
+				samples, &deviceBuf[pitch * i], time);
+		});
+	}
+	// Returns the output of the i-th device (possibly generated in 'buf'),
+	// or nullptr if that output is silent.
+	auto getOutput = [&](unsigned i, float* buf) -> const float* {
+		if (parallel) {
+			return generated[i] ? &deviceBuf[pitch * i] : nullptr;
+		}
+		return infos[i].device->timedUpdateBuffer(samples, buf, time) ? buf : nullptr;
+	};
+	// Like getOutput(), but the result is always placed in 'buf'.
+	auto getOutputIn = [&](unsigned i, float* buf, unsigned num) {
+		auto* out = getOutput(i, buf);
+		if (out && (out != buf)) {
+			memcpy(buf, out, num * sizeof(float));
+		}
+		return out != nullptr;
+	};
+
 	// FIXME: The Infos should be ordered such that all the mono
 	// devices are handled first
-	for (auto& info : infos) {
+	for (auto i : xrange(unsigned(infos.size()))) {
+		auto& info = infos[i];
 		SoundDevice& device = *info.device;
 		auto l1 = info.left1;
 		auto r1 = info.right1;
 		if (!device.isStereo()) {
 			if (l1 == r1) {
 				if (!(usedBuffers & HAS_MONO_FLAG)) {
-					if (device.updateBuffer(samples, monoBuf, time)) {
+					if (getOutputIn(i, monoBuf, samples)) {
 						usedBuffers |= HAS_MONO_FLAG;
 						mul(monoBuf, samples, l1);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
-						mulAcc(monoBuf, tmpBuf, samples, l1);
+					if (auto* buf = getOutput(i, tmpBuf)) {
+						mulAcc(monoBuf, buf, samples, l1);
 					}
 				}
 			} else {
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
-					if (device.updateBuffer(samples, stereoBuf, time)) {
+					if (getOutputIn(i, stereoBuf, samples)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mulExpand(stereoBuf, samples, l1, r1);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
-						mulExpandAcc(stereoBuf, tmpBuf, samples, l1, r1);
+					if (auto* buf = getOutput(i, tmpBuf)) {
+						mulExpandAcc(stereoBuf, buf, samples, l1, r1);
 					}
 				}
 			}
@@ -472,24 +515,24 @@ void MSXMixer::generate(float* output, EmuTime::param time, unsigned samples)
 				assert(l2 == 0.0f);
 				assert(r1 == 0.0f);
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
-					if (device.updateBuffer(samples, stereoBuf, time)) {
+					if (getOutputIn(i, stereoBuf, 2 * samples)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mul(stereoBuf, 2 * samples, l1);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
-						mulAcc(stereoBuf, tmpBuf, 2 * samples, l1);
+					if (auto* buf = getOutput(i, tmpBuf)) {
+						mulAcc(stereoBuf, buf, 2 * samples, l1);
 					}
 				}
 			} else {
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
-					if (device.updateBuffer(samples, stereoBuf, time)) {
+					if (getOutputIn(i, stereoBuf, 2 * samples)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mulMix2(stereoBuf, samples, l1, l2, r1, r2);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
-						mulMix2Acc(stereoBuf, tmpBuf, samples, l1, l2, r1, r2);
+					if (auto* buf = getOutput(i, tmpBuf)) {
+						mulMix2Acc(stereoBuf, buf, samples, l1, l2, r1, r2);
 					}
 				}
 			}
@@ -624,9 +667,19 @@ void MSXMixer::changeRecordSetting(const Setting& setting)
 		unsigned channel = 0;
 		for (auto& s : info.channelSettings) {
 			if (s.recordSetting.get() == &setting) {
-				info.device->recordChannel(
-					channel,
-					Filename(string(s.recordSetting->getString())));
+				// Start/stop at exactly the current time, so that
+				// the recordings of different channels (and of the
+				// 'record' command) line up sample-exactly.
+				updateStream(getCurrentTime());
+				try {
+					info.device->recordChannel(
+						channel,
+						Filename(string(s.recordSetting->getString())));
+				} catch (MSXException& e) {
+					commandController.getCliComm().printWarning(
+						"Error while recording ", setting.getBaseName(),
+						": ", e.getMessage());
+				}
 				return;
 			}
 			++channel;
@@ -748,6 +801,11 @@ SoundDevice* MSXMixer::findDevice(std::string_view name) const
 	return (it != end(infos)) ? it->device : nullptr;
 }
 
+std::vector<SoundDevice*> MSXMixer::getDevices() const
+{
+	return to_vector(view::transform(infos, [](auto& i) { return i.device; }));
+}
+
 MSXMixer::SoundDeviceInfoTopic::SoundDeviceInfoTopic(
 		InfoCommand& machineInfoCommand)
 	: InfoTopic(machineInfoCommand, "sounddevice")
@@ -792,4 +850,76 @@ void MSXMixer::SoundDeviceInfoTopic::tabCompletion(vector<string>& tokens) const
 	}
 }
 
+
+
+// class SoundStatisticsInfoTopic
+
+MSXMixer::SoundStatisticsInfoTopic::SoundStatisticsInfoTopic(
+		InfoCommand& machineInfoCommand)
+	: InfoTopic(machineInfoCommand, "sound_statistics")
+{
+}
+
+void MSXMixer::SoundStatisticsInfoTopic::execute(
+	span<const TclObject> tokens, TclObject& result) const
+{
+	auto& msxMixer = OUTER(MSXMixer, soundStatisticsInfo);
+	auto getStats = [](const SoundDevice& device) {
+		const auto& stats = device.getStatistics();
+		auto seconds = [](uint64_t ns) { return ns * 1e-9; };
+		TclObject dict;
+		dict.addDictKeyValues(
+			"fragments",        stats.fragments,
+			"silent_fragments", stats.silentFragments,
+			"output_samples",   stats.outputSamples,
+			"input_samples",    stats.inputSamples,
+			"idle_samples",     stats.idleSamples,
+			"synthesis_time",   seconds(stats.synthesisTime),
+			"resample_time",    seconds(stats.updateTime - stats.synthesisTime),
+			"total_time",       seconds(stats.updateTime));
+		return dict;
+	};
+	switch (tokens.size()) {
+	case 2:
+		for (auto& info : msxMixer.infos) {
+			result.addDictKeyValue(info.device->getName(),
+			                       getStats(*info.device));
+		}
+		break;
+	case 3: {
+		SoundDevice* device = msxMixer.findDevice(tokens[2].getString());
+		if (!device) {
+			throw CommandException("Unknown sound device");
+		}
+		result = getStats(*device);
+		break;
+	}
+	default:
+		throw CommandException("Too many parameters");
+	}
+}
+
+string MSXMixer::SoundStatisticsInfoTopic::help(const vector<string>& /*tokens*/) const
+{
+	return "Shows statistics about the cost of the sound devices: the "
+	       "number of generated fragments (and how many of those were "
+	       "silent), the number of output, input and idle (skipped) "
+	       "samples and the time (in seconds) spent in synthesis and in "
+	       "resampling. All values are totals since the device was "
+	       "created. Without argument the statistics of all devices are "
+	       "returned (as a dict).\n"
+	       "See 'openmsx_info sound_output' for statistics about the "
+	       "sound driver (underruns, latency).\n";
+}
+
+void MSXMixer::SoundStatisticsInfoTopic::tabCompletion(vector<string>& tokens) const
+{
+	if (tokens.size() == 3) {
+		auto devices = to_vector(view::transform(
+			OUTER(MSXMixer, soundStatisticsInfo).infos,
+			[](auto& info) { return info.device->getName(); }));
+		completeString(tokens, devices);
+	}
+}
+
 } // namespace openmsx
@@ -6,6 +6,7 @@
 #include "InfoTopic.hh"
 #include "EmuTime.hh"
 #include "DynamicClock.hh"
+#include "MemBuffer.hh"
 #include <vector>
 #include <memory>
 
@@ -23,6 +24,7 @@ class StringSetting;
 class BooleanSetting;
 class Setting;
 class AviRecorder;
+class RegisterLogCommand;
 
 class MSXMixer final : private Schedulable, private Observer<Setting>
                      , private Observer<SpeedManager>
@@ -113,6 +115,7 @@ public:
 	unsigned getSampleRate() const { return hostSampleRate; }
 
 	SoundDevice* findDevice(std::string_view name) const;
+	std::vector<SoundDevice*> getDevices() const;
 
 	void reInit();
 
@@ -165,6 +168,10 @@ private:
 
 	DynamicClock prevTime;
 
+	// used to generate the sound devices in parallel, see generate()
+	MemBuffer<float, SSE2_ALIGNMENT> deviceBuf;
+	unsigned deviceBufSize = 0;
+
 	struct SoundDeviceInfoTopic final : InfoTopic {
 		explicit SoundDeviceInfoTopic(InfoCommand& machineInfoCommand);
 		void execute(span<const TclObject> tokens,
@@ -173,6 +180,16 @@ private:
 		void tabCompletion(std::vector<std::string>& tokens) const override;
 	} soundDeviceInfo;
 
+	struct SoundStatisticsInfoTopic final : InfoTopic {
+		explicit SoundStatisticsInfoTopic(InfoCommand& machineInfoCommand);
+		void execute(span<const TclObject> tokens,
+			     TclObject& result) const override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} soundStatisticsInfo;
+
+	std::unique_ptr<RegisterLogCommand> registerLogCommand;
+
 	AviRecorder* recorder;
 	unsigned synchronousCounter;
 
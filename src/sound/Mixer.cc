@@ -4,8 +4,12 @@
 #include "SDLSoundDriver.hh"
 #include "CommandController.hh"
 #include "CliComm.hh"
+#include "Reactor.hh"
+#include "TclObject.hh"
+#include "ThreadPool.hh"
 #include "MSXException.hh"
 #include "one_of.hh"
+#include "outer.hh"
 #include "stl.hh"
 #include "unreachable.hh"
 #include "build-info.hh"
@@ -49,12 +53,18 @@ Mixer::Mixer(Reactor& reactor_, CommandController& commandController_)
 	, samplesSetting(
 		commandController, "samples",
 		"mixer samples", defaultsamples, 64, 8192)
+	, parallelSetting(
+		commandController, "sound_parallel",
+		"generate the output of the different sound chips on multiple threads",
+		false)
+	, soundOutputInfo(reactor.getOpenMSXInfoCommand())
 	, muteCount(0)
 {
 	muteSetting       .attach(*this);
 	frequencySetting  .attach(*this);
 	samplesSetting    .attach(*this);
 	soundDriverSetting.attach(*this);
+	parallelSetting   .attach(*this);
 
 	// Set correct initial mute state.
 	if (muteSetting.getBoolean()) ++muteCount;
@@ -67,6 +77,7 @@ Mixer::~Mixer()
 	assert(msxMixers.empty());
 	driver.reset();
 
+	parallelSetting   .detach(*this);
 	soundDriverSetting.detach(*this);
 	samplesSetting    .detach(*this);
 	frequencySetting  .detach(*this);
@@ -155,6 +166,15 @@ void Mixer::uploadBuffer(MSXMixer& /*msxMixer*/, float* buffer, unsigned len)
 	driver->uploadBuffer(buffer, len);
 }
 
+ThreadPool* Mixer::getSynthesisThreadPool()
+{
+	if (!parallelSetting.getBoolean()) return nullptr;
+	if (!threadPool) {
+		threadPool = std::make_unique<ThreadPool>();
+	}
+	return threadPool.get();
+}
+
 void Mixer::update(const Setting& setting)
 {
 	if (&setting == &muteSetting) {
@@ -165,9 +185,43 @@ void Mixer::update(const Setting& setting)
 		}
 	} else if (&setting == one_of(&samplesSetting, &soundDriverSetting, &frequencySetting)) {
 		reloadDriver();
+	} else if (&setting == &parallelSetting) {
+		if (!parallelSetting.getBoolean()) {
+			threadPool.reset(); // stop the worker threads
+		}
 	} else {
 		UNREACHABLE;
 	}
 }
 
+
+// class SoundOutputInfo
+
+Mixer::SoundOutputInfo::SoundOutputInfo(InfoCommand& openMSXInfoCommand)
+	: InfoTopic(openMSXInfoCommand, "sound_output")
+{
+}
+
+void Mixer::SoundOutputInfo::execute(span<const TclObject> /*tokens*/,
+                                     TclObject& result) const
+{
+	auto& mixer = OUTER(Mixer, soundOutputInfo);
+	auto stats = mixer.driver->getStatistics();
+	auto frequency = mixer.driver->getFrequency();
+	result.addDictKeyValue("underruns", stats.underruns);
+	result.addDictKeyValue("dropped_samples", stats.droppedSamples);
+	result.addDictKeyValue("buffered_samples", stats.bufferedSamples);
+	result.addDictKeyValue("target_samples", stats.targetSamples);
+	result.addDictKeyValue("latency", frequency ? (1000.0 * stats.targetSamples / frequency) : 0.0);
+	result.addDictKeyValue("rate_adjust", stats.rateAdjust);
+}
+
+std::string Mixer::SoundOutputInfo::help(const std::vector<std::string>& /*tokens*/) const
+{
+	return "Returns statistics about the sound output buffer: number of "
+	       "underruns, number of dropped samples, the current and the "
+	       "target fill level (in samples), the target latency (in ms) and "
+	       "the current sample rate correction factor.";
+}
+
 } // namespace openmsx
@@ -5,6 +5,7 @@
 #include "BooleanSetting.hh"
 #include "EnumSetting.hh"
 #include "IntegerSetting.hh"
+#include "InfoTopic.hh"
 #include <vector>
 #include <memory>
 
@@ -14,6 +15,7 @@ class SoundDriver;
 class Reactor;
 class CommandController;
 class MSXMixer;
+class ThreadPool;
 
 class Mixer final : private Observer<Setting>
 {
@@ -47,6 +49,12 @@ public:
 
 	IntegerSetting& getMasterVolume() { return masterVolume; }
 
+	/** Thread pool to generate the output of the different sound devices
+	 * in parallel, or nullptr when that's disabled (see the
+	 * 'sound_parallel' setting).
+	 */
+	ThreadPool* getSynthesisThreadPool();
+
 private:
 	void reloadDriver();
 	void muteHelper();
@@ -57,6 +65,7 @@ private:
 	std::vector<MSXMixer*> msxMixers; // unordered
 
 	std::unique_ptr<SoundDriver> driver;
+	std::unique_ptr<ThreadPool> threadPool; // created on first use
 	Reactor& reactor;
 	CommandController& commandController;
 
@@ -65,6 +74,14 @@ private:
 	IntegerSetting masterVolume;
 	IntegerSetting frequencySetting;
 	IntegerSetting samplesSetting;
+	BooleanSetting parallelSetting;
+
+	struct SoundOutputInfo final : InfoTopic {
+		explicit SoundOutputInfo(InfoCommand& openMSXInfoCommand);
+		void execute(span<const TclObject> tokens,
+			     TclObject& result) const override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+	} soundOutputInfo;
 
 	int muteCount;
 };
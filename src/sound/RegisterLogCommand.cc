@@ -0,0 +1,282 @@
+#include "RegisterLogCommand.hh"
+#include "RegisterLogWriter.hh"
+#include "RegisterLogPlayer.hh"
+#include "MSXMixer.hh"
+#include "SoundDevice.hh"
+#include "MSXMotherBoard.hh"
+#include "MSXCommandController.hh"
+#include "CommandException.hh"
+#include "FileContext.hh"
+#include "FileOperations.hh"
+#include "File.hh"
+#include "Filename.hh"
+#include "MSXException.hh"
+#include "TclArgParser.hh"
+#include "TclObject.hh"
+#include "one_of.hh"
+#include "stl.hh"
+
+namespace openmsx {
+
+RegisterLogCommand::RegisterLogCommand(MSXMotherBoard& motherBoard_, MSXMixer& mixer_)
+	: RecordedCommand(motherBoard_.getMSXCommandController(),
+	                  motherBoard_.getStateChangeDistributor(),
+	                  motherBoard_.getScheduler(), "register_log")
+	, motherBoard(motherBoard_)
+	, mixer(mixer_)
+{
+}
+
+RegisterLogCommand::~RegisterLogCommand() = default;
+
+void RegisterLogCommand::unregisterSound(SoundDevice& device)
+{
+	if (writer) writer->removeDevice(device);
+	if (player && player->usesDevice(device)) player.reset();
+}
+
+void RegisterLogCommand::execute(
+	span<const TclObject> tokens, TclObject& result, EmuTime::param time)
+{
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	auto subCmd = tokens[1].getString();
+	if (subCmd == "start") {
+		start(tokens, result);
+	} else if (subCmd == "stop") {
+		checkNumArgs(tokens, 2, "");
+		stop(result, time);
+	} else if (subCmd == "marker") {
+		checkNumArgs(tokens, 2, "");
+		if (!writer) throw CommandException("Not recording.");
+		writer->addMarker(time);
+	} else if (subCmd == "status") {
+		checkNumArgs(tokens, 2, "");
+		status(result, time);
+	} else if (subCmd == "play") {
+		checkNumArgs(tokens, 3, "filename");
+		play(tokens, result, time);
+	} else if (subCmd == "stop_play") {
+		checkNumArgs(tokens, 2, "");
+		player.reset();
+	} else {
+		throw CommandException("Invalid subcommand: ", subCmd);
+	}
+}
+
+void RegisterLogCommand::start(span<const TclObject> tokens, TclObject& result)
+{
+	if (writer) {
+		throw CommandException("Already recording to ", recordFilename, '.');
+	}
+	std::string_view prefix = "music";
+	std::string_view formatStr = "vgm";
+	std::vector<std::string_view> chipNames;
+	std::vector<std::string_view> deviceNames;
+	ArgsInfo info[] = {
+		valueArg("-prefix", prefix),
+		valueArg("-format", formatStr),
+		valueArg("-chip", chipNames),
+		valueArg("-device", deviceNames),
+	};
+	auto arguments = parseTclArgs(getInterpreter(), tokens.subspan(2), info);
+	if (arguments.size() > 1) throw SyntaxError();
+
+	RegisterLogWriter::Format format;
+	std::string_view extension;
+	if (formatStr == "vgm") {
+		format = RegisterLogWriter::Format::VGM; extension = ".vgm";
+	} else if (formatStr == "native") {
+		format = RegisterLogWriter::Format::NATIVE; extension = ".rlog";
+	} else {
+		throw CommandException("Unknown format: ", formatStr,
+		                       ", must be one of vgm or native.");
+	}
+	std::vector<RegisterLogger::Chip> chips;
+	for (auto name : chipNames) {
+		auto chip = parseChipName(name);
+		if (!chip) throw CommandException("Unknown chip type: ", name);
+		chips.push_back(*chip);
+	}
+
+	std::vector<SoundDevice*> devices;
+	for (auto* device : mixer.getDevices()) {
+		auto chip = device->getRegisterLogChip();
+		if (!chip) continue;
+		bool all = chips.empty() && deviceNames.empty();
+		if (all || contains(chips, *chip) ||
+		    contains(deviceNames, device->getName())) {
+			devices.push_back(device);
+		}
+	}
+	if (devices.empty()) {
+		throw CommandException("No sound devices to record.");
+	}
+
+	std::string_view filenameArg;
+	if (!arguments.empty()) filenameArg = arguments[0].getString();
+	auto filename = FileOperations::parseCommandFileArgument(
+		filenameArg, "vgm_recordings", prefix, extension);
+	try {
+		writer = std::make_unique<RegisterLogWriter>(
+			format, Filename(filename), devices);
+	} catch (MSXException& e) {
+		throw CommandException("Couldn't start recording: ", e.getMessage());
+	}
+	recordFilename = filename;
+
+	std::string names;
+	for (auto* device : writer->getDevices()) {
+		strAppend(names, names.empty() ? "" : ", ", device->getName());
+	}
+	result = strCat("Recording register writes of ", names, " to ", filename);
+}
+
+void RegisterLogCommand::stop(TclObject& result, EmuTime::param time)
+{
+	if (!writer) throw CommandException("Not recording.");
+	auto w = std::move(writer);
+	try {
+		w->stop(time);
+	} catch (MSXException& e) {
+		throw CommandException("Error while writing ", recordFilename,
+		                       ": ", e.getMessage());
+	}
+	result = recordFilename;
+}
+
+void RegisterLogCommand::status(TclObject& result, EmuTime::param time) const
+{
+	result.addDictKeyValue("recording", bool(writer));
+	if (writer) {
+		auto writes = writer->getNumWrites();
+		result.addDictKeyValues(
+			"filename", recordFilename,
+			"writes", writes);
+		if (writes) {
+			result.addDictKeyValues(
+				"length", (time - writer->getFirstWriteTime()).toDouble(),
+				"idle_time", (time - writer->getLastWriteTime()).toDouble());
+		}
+	}
+	result.addDictKeyValue("playing", player && !player->isFinished());
+	if (player) {
+		result.addDictKeyValues(
+			"play_filename", playFilename,
+			"play_position", (time - player->getStartTime()).toDouble(),
+			"play_length", player->getLength().toDouble());
+	}
+}
+
+void RegisterLogCommand::play(
+	span<const TclObject> tokens, TclObject& result, EmuTime::param time)
+{
+	Filename filename(std::string(tokens[2].getString()), userFileContext());
+	try {
+		File file(filename);
+		auto log = RegisterLog::parse(file.mmap());
+		if (!motherBoard.getMachineConfig()) {
+			throw MSXException("no MSX machine");
+		}
+		// replaces (and stops) a previous player
+		player.reset();
+		player = std::make_unique<RegisterLogPlayer>(
+			motherBoard.getScheduler(), mixer, motherBoard.getCPU(),
+			std::move(log), time);
+	} catch (MSXException& e) {
+		throw CommandException("Can't play ", filename.getOriginal(),
+		                       ": ", e.getMessage());
+	}
+	playFilename = filename.getResolved();
+	result = strCat("Playing ", playFilename);
+}
+
+std::string RegisterLogCommand::help(const std::vector<std::string>& tokens) const
+{
+	if (tokens.size() >= 2) {
+		if (tokens[1] == "start") {
+			return "register_log start [-format vgm|native] [-prefix <prefix>] "
+			       "[-chip <type>]... [-device <name>]... [<filename>]\n"
+			       "Start recording the register writes of the sound chips. "
+			       "Without -chip or -device options all sound chips are "
+			       "recorded. Chip types are: AY8910, YM2413, Y8950, YMF262, "
+			       "OPL4_FM, YMF278, YM2151 and SCC. The default format is "
+			       "VGM, which can hold only one chip of each type. The "
+			       "native format has a higher time resolution and can be "
+			       "played back with 'register_log play'.\n"
+			       "Recording starts at the first register write.\n";
+		} else if (tokens[1] == "stop") {
+			return "register_log stop\n"
+			       "Stop recording, returns the name of the file.\n";
+		} else if (tokens[1] == "marker") {
+			return "register_log marker\n"
+			       "Insert a marker (e.g. for a loop point) in the recording.\n";
+		} else if (tokens[1] == "status") {
+			return "register_log status\n"
+			       "Returns a dict with info about the current recording and "
+			       "playback.\n";
+		} else if (tokens[1] == "play") {
+			return "register_log play <filename>\n"
+			       "Play a register log in the native format on the sound "
+			       "chips of this machine (with the same names as when "
+			       "recorded). Only the register writes of the log are "
+			       "replayed, the MSX CPU is paused until the end of the "
+			       "log (or until 'register_log stop_play').\n";
+		} else if (tokens[1] == "stop_play") {
+			return "register_log stop_play\n"
+			       "Stop playing a register log.\n";
+		}
+	}
+	return "Record or play the register writes of the sound chips.\n"
+	       "  register_log start [<options>] [<filename>]\n"
+	       "  register_log stop\n"
+	       "  register_log marker\n"
+	       "  register_log status\n"
+	       "  register_log play <filename>\n"
+	       "  register_log stop_play\n"
+	       "Use 'help register_log <subcommand>' for more info.\n";
+}
+
+void RegisterLogCommand::tabCompletion(std::vector<std::string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static constexpr const char* const cmds[] = {
+			"start", "stop", "marker", "status", "play", "stop_play",
+		};
+		completeString(tokens, cmds);
+	} else if ((tokens.size() >= 3) && (tokens[1] == "start")) {
+		if (tokens[tokens.size() - 2] == "-format") {
+			static constexpr const char* const formats[] = {"vgm", "native"};
+			completeString(tokens, formats);
+		} else if (tokens[tokens.size() - 2] == "-chip") {
+			static constexpr const char* const types[] = {
+				"AY8910", "YM2413", "Y8950", "YMF262",
+				"OPL4_FM", "YMF278", "YM2151", "SCC",
+			};
+			completeString(tokens, types);
+		} else if (tokens[tokens.size() - 2] == "-device") {
+			std::vector<std::string> names;
+			for (auto* device : mixer.getDevices()) {
+				if (device->getRegisterLogChip()) {
+					names.push_back(device->getName());
+				}
+			}
+			completeString(tokens, names);
+		} else {
+			static constexpr const char* const options[] = {
+				"-format", "-prefix", "-chip", "-device",
+			};
+			completeFileName(tokens, userFileContext(), options);
+		}
+	} else if ((tokens.size() == 3) && (tokens[1] == "play")) {
+		completeFileName(tokens, userFileContext());
+	}
+}
+
+bool RegisterLogCommand::needRecord(span<const TclObject> tokens) const
+{
+	// only playback changes the state of the MSX
+	return (tokens.size() >= 2) &&
+	       (tokens[1].getString() == one_of("play", "stop_play"));
+}
+
+} // namespace openmsx
@@ -0,0 +1,51 @@
+#ifndef REGISTERLOGCOMMAND_HH
+#define REGISTERLOGCOMMAND_HH
+
+#include "RecordedCommand.hh"
+#include <memory>
+#include <string>
+
+namespace openmsx {
+
+class MSXMotherBoard;
+class MSXMixer;
+class SoundDevice;
+class RegisterLogWriter;
+class RegisterLogPlayer;
+
+/** The 'register_log' command: record the register writes of the sound
+  * chips of a machine (as VGM or in the native format), and replay native
+  * logs on those same chips.
+  */
+class RegisterLogCommand final : public RecordedCommand
+{
+public:
+	RegisterLogCommand(MSXMotherBoard& motherBoard, MSXMixer& mixer);
+	~RegisterLogCommand();
+
+	/** Must be called (by MSXMixer) before a sound device is removed. */
+	void unregisterSound(SoundDevice& device);
+
+	void execute(span<const TclObject> tokens, TclObject& result,
+	             EmuTime::param time) override;
+	std::string help(const std::vector<std::string>& tokens) const override;
+	void tabCompletion(std::vector<std::string>& tokens) const override;
+	bool needRecord(span<const TclObject> tokens) const override;
+
+private:
+	void start(span<const TclObject> tokens, TclObject& result);
+	void stop(TclObject& result, EmuTime::param time);
+	void status(TclObject& result, EmuTime::param time) const;
+	void play(span<const TclObject> tokens, TclObject& result, EmuTime::param time);
+
+	MSXMotherBoard& motherBoard;
+	MSXMixer& mixer;
+	std::unique_ptr<RegisterLogWriter> writer;
+	std::unique_ptr<RegisterLogPlayer> player;
+	std::string recordFilename;
+	std::string playFilename;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,176 @@
+#include "RegisterLogPlayer.hh"
+#include "RegisterLogWriter.hh"
+#include "MSXCPU.hh"
+#include "MSXMixer.hh"
+#include "SoundDevice.hh"
+#include "MSXException.hh"
+#include "stl.hh"
+#include "xrange.hh"
+#include <cstring>
+
+namespace openmsx {
+
+using namespace RegisterLogFormat;
+
+namespace {
+class Reader
+{
+public:
+	explicit Reader(span<const uint8_t> data_) : data(data_) {}
+
+	uint8_t byte() {
+		need(1);
+		return data[pos++];
+	}
+	uint32_t u32() {
+		uint32_t result = 0;
+		for (int i = 0; i < 4; ++i) result |= uint32_t(byte()) << (8 * i);
+		return result;
+	}
+	uint64_t leb128() {
+		uint64_t result = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			auto b = byte();
+			result |= uint64_t(b & 0x7F) << shift;
+			if (!(b & 0x80)) return result;
+		}
+		throw MSXException("Invalid register log: bad time value");
+	}
+	span<const uint8_t> bytes(size_t num) {
+		need(num);
+		auto result = data.subspan(pos, num);
+		pos += num;
+		return result;
+	}
+
+private:
+	void need(size_t num) const {
+		if ((data.size() - pos) < num) {
+			throw MSXException("Invalid register log: unexpected end of file");
+		}
+	}
+
+	span<const uint8_t> data;
+	size_t pos = 0;
+};
+} // namespace
+
+RegisterLog RegisterLog::parse(span<const uint8_t> data)
+{
+	Reader reader(data);
+	auto magic = reader.bytes(sizeof(MAGIC));
+	if (memcmp(magic.data(), MAGIC, sizeof(MAGIC)) != 0) {
+		throw MSXException("Not a register log file");
+	}
+	if (auto version = reader.byte(); version != VERSION) {
+		throw MSXException("Unsupported register log version: ", int(version));
+	}
+
+	RegisterLog result;
+	uint64_t time = 0;
+	while (true) {
+		auto tag = reader.byte();
+		if (tag < MAX_DEVICES) {
+			if (tag >= result.devices.size()) {
+				throw MSXException("Invalid register log: unknown device");
+			}
+			auto port  = reader.byte();
+			auto reg   = reader.byte();
+			auto value = reader.byte();
+			result.writes.push_back({time, tag, port, reg, value});
+		} else if (tag == TAG_DEVICE) {
+			auto chip = reader.byte();
+			if (chip >= uint8_t(RegisterLogger::Chip::NUM)) {
+				throw MSXException("Invalid register log: unknown chip type");
+			}
+			auto name = reader.bytes(reader.byte());
+			result.devices.push_back({std::string(name.begin(), name.end()),
+			                          RegisterLogger::Chip(chip), {}});
+		} else if (tag == TAG_MEMORY) {
+			auto device = reader.byte();
+			if (device >= result.devices.size()) {
+				throw MSXException("Invalid register log: unknown device");
+			}
+			auto mem = reader.bytes(reader.u32());
+			result.devices[device].memory.assign(mem.begin(), mem.end());
+		} else if (tag == TAG_WAIT) {
+			time += reader.leb128();
+		} else if (tag == TAG_MARKER) {
+			result.markers.push_back(time);
+		} else if (tag == TAG_END) {
+			break;
+		} else {
+			throw MSXException("Invalid register log: unknown record type");
+		}
+	}
+	result.length = time;
+	return result;
+}
+
+
+RegisterLogPlayer::RegisterLogPlayer(
+		Scheduler& scheduler_, MSXMixer& mixer, MSXCPU& cpu_,
+		RegisterLog log_, EmuTime::param time)
+	: Schedulable(scheduler_)
+	, cpu(cpu_)
+	, log(std::move(log_))
+	, startTime(time)
+{
+	for (auto& d : log.devices) {
+		auto* device = mixer.findDevice(d.name);
+		if (!device || (device->getRegisterLogChip() != d.chip)) {
+			throw MSXException("Register log uses a ", getChipName(d.chip),
+			                   " sound device named '", d.name,
+			                   "', but there's no such device in this machine.");
+		}
+		devices.push_back(device);
+	}
+	for (auto i : xrange(devices.size())) {
+		if (!log.devices[i].memory.empty()) {
+			devices[i]->setSampleMemory(log.devices[i].memory);
+		}
+	}
+	cpu.setPaused(true);
+	cpuPaused = true;
+	scheduleNext();
+}
+
+RegisterLogPlayer::~RegisterLogPlayer()
+{
+	resumeCPU();
+}
+
+void RegisterLogPlayer::resumeCPU()
+{
+	if (!cpuPaused) return;
+	cpuPaused = false;
+	cpu.setPaused(false);
+}
+
+bool RegisterLogPlayer::usesDevice(const SoundDevice& device) const
+{
+	return contains(devices, &device);
+}
+
+void RegisterLogPlayer::scheduleNext()
+{
+	// after the last write, wait till the end of the log to resume the CPU
+	auto next = (pos != log.writes.size()) ? log.writes[pos].time : log.length;
+	setSyncPoint(startTime + EmuDuration(next));
+}
+
+void RegisterLogPlayer::executeUntil(EmuTime::param time)
+{
+	auto ticks = (time - startTime).length();
+	while ((pos != log.writes.size()) && (log.writes[pos].time <= ticks)) {
+		auto& w = log.writes[pos++];
+		devices[w.device]->replayRegisterWrite(w.port, w.reg, w.value, time);
+	}
+	if ((pos == log.writes.size()) && (log.length <= ticks)) {
+		resumeCPU();
+	} else {
+		scheduleNext();
+	}
+}
+
+} // namespace openmsx
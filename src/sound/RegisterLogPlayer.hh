@@ -0,0 +1,93 @@
+#ifndef REGISTERLOGPLAYER_HH
+#define REGISTERLOGPLAYER_HH
+
+#include "RegisterLogger.hh"
+#include "Schedulable.hh"
+#include "EmuTime.hh"
+#include "span.hh"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class MSXCPU;
+class MSXMixer;
+class Scheduler;
+class SoundDevice;
+
+/** A register log in the native format (see RegisterLogFormat), in memory. */
+struct RegisterLog
+{
+	struct Device {
+		std::string name;
+		RegisterLogger::Chip chip;
+		std::vector<uint8_t> memory; // initial sample memory, possibly empty
+	};
+	struct Write {
+		uint64_t time; // EmuTime ticks since the start of the log
+		uint8_t device;
+		uint8_t port;
+		uint8_t reg;
+		uint8_t value;
+	};
+
+	/** Parse a native register log.
+	  * @throws MSXException when the data is not a valid register log.
+	  */
+	[[nodiscard]] static RegisterLog parse(span<const uint8_t> data);
+
+	std::vector<Device> devices;
+	std::vector<Write> writes;
+	std::vector<uint64_t> markers;
+	uint64_t length = 0; // in EmuTime ticks
+};
+
+/** Replays a register log: at the right moments the logged register writes
+  * are sent to the sound devices (see SoundDevice::replayRegisterWrite()).
+  * Nothing else is involved (no I/O ports), so this is a cheap way to
+  * regenerate the audio of a recording. The MSX CPU is paused for the length
+  * of the log, otherwise the running MSX software would write to the same
+  * sound devices in between. Like recording, playback is not part of a
+  * savestate: after loading a state (or a reverse snapshot) that was taken
+  * during playback, the CPU is no longer paused.
+  */
+class RegisterLogPlayer final : private Schedulable
+{
+public:
+	/** Start replaying the log at the given time and pause the CPU until
+	  * the end of the log (or until this object is destroyed). The devices
+	  * in the log are looked up by name.
+	  * @throws MSXException when a device of the log is not present (with
+	  *         the same chip type).
+	  */
+	RegisterLogPlayer(Scheduler& scheduler, MSXMixer& mixer, MSXCPU& cpu,
+	                  RegisterLog log, EmuTime::param time);
+	~RegisterLogPlayer();
+
+	[[nodiscard]] bool isFinished() const { return !cpuPaused; }
+	[[nodiscard]] bool usesDevice(const SoundDevice& device) const;
+	[[nodiscard]] EmuTime getStartTime() const { return startTime; }
+	[[nodiscard]] EmuDuration getLength() const { return EmuDuration(log.length); }
+	[[nodiscard]] size_t getNumWrites() const { return log.writes.size(); }
+	[[nodiscard]] size_t getPosition() const { return pos; }
+
+private:
+	// Schedulable
+	void executeUntil(EmuTime::param time) override;
+
+	void scheduleNext();
+
+	void resumeCPU();
+
+	MSXCPU& cpu;
+	const RegisterLog log;
+	std::vector<SoundDevice*> devices; // indexed like 'log.devices'
+	const EmuTime startTime;
+	size_t pos = 0; // next write
+	bool cpuPaused = false;
+};
+
+} // namespace openmsx
+
+#endif
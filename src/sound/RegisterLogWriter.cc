@@ -0,0 +1,406 @@
+#include "RegisterLogWriter.hh"
+#include "SoundDevice.hh"
+#include "File.hh"
+#include "Filename.hh"
+#include "MSXException.hh"
+#include "ranges.hh"
+#include <algorithm>
+#include <cassert>
+
+namespace openmsx {
+
+using Chip = RegisterLogger::Chip;
+
+// Number of bytes per chunk that's handed over to the writer thread.
+static constexpr size_t CHUNK_SIZE = 64 * 1024;
+static constexpr unsigned MAX_PENDING_CHUNKS = 16;
+
+static void append32(std::vector<uint8_t>& out, uint32_t value)
+{
+	for (int i = 0; i < 4; ++i) out.push_back(uint8_t(value >> (8 * i)));
+}
+
+static void put32(std::vector<uint8_t>& out, size_t offset, uint32_t value)
+{
+	for (int i = 0; i < 4; ++i) out[offset + i] = uint8_t(value >> (8 * i));
+}
+
+
+// VGM, see https://vgmrips.net/wiki/VGM_Specification
+//
+// The port numbers of RegisterLogger were chosen to match the VGM
+// conventions, e.g. for the OPL4 port 0,1 is FM and port 2 is wave, for the
+// SCC (K051649) port 0 is waveform (SCC), 1 frequency, 2 volume, 3 key on/off,
+// 4 waveform (SCC+) and 5 deformation.
+class VGMEncoder final : public RegisterLogWriter::Encoder
+{
+public:
+	static constexpr size_t HEADER_SIZE = 0x100;
+	static constexpr uint64_t SAMPLE_RATE = 44100;
+
+	void encodeStart(std::vector<uint8_t>& out) override
+	{
+		out.resize(out.size() + HEADER_SIZE); // filled in by getHeader()
+	}
+
+	bool accept(Chip chip) override
+	{
+		// only one device per chip type, the OPL4 FM and wave parts
+		// are both needed for one YMF278B
+		auto& u = used[size_t(chip)];
+		if (u) return false;
+		u = true;
+		switch (chip) {
+		case Chip::AY8910:  clock(0x74) = 1789773; break;
+		case Chip::YM2413:  clock(0x10) = 3579545; break;
+		case Chip::Y8950:   clock(0x58) = 3579545; break;
+		case Chip::YMF262:  clock(0x5C) = 14318180; break;
+		case Chip::OPL4_FM:
+		case Chip::YMF278:  clock(0x60) = 33868800; break;
+		case Chip::YM2151:  clock(0x30) = 3579545; break;
+		case Chip::SCC:     clock(0x9C) = 1789773; break;
+		default: return false;
+		}
+		return true;
+	}
+
+	void encodeDevice(std::vector<uint8_t>& out, unsigned /*idx*/, Chip chip,
+	                  std::string_view /*name*/, span<const uint8_t> memory) override
+	{
+		// Sample memory is stored as a data block. Writes to the
+		// memory during the recording are logged as register writes.
+		if (memory.empty()) return;
+		uint8_t type;
+		if (chip == Chip::Y8950) {
+			type = 0x88; // Y8950 DELTA-T ROM data
+		} else if (chip == Chip::YMF278) {
+			type = 0x87; // YMF278B RAM data
+		} else {
+			return;
+		}
+		out.insert(out.end(), {0x67, 0x66, type});
+		append32(out, uint32_t(memory.size() + 8));
+		append32(out, uint32_t(memory.size())); // total size
+		append32(out, 0); // start address
+		out.insert(out.end(), memory.begin(), memory.end());
+		if (chip == Chip::YMF278) {
+			// set the NEW2 bit, so that playback also works when
+			// the recording itself doesn't enable OPL4 mode
+			out.insert(out.end(), {0xD0, 0x01, 0x05, 0x03});
+		}
+	}
+
+	void encodeWrite(std::vector<uint8_t>& out, unsigned /*idx*/, Chip chip,
+	                 uint8_t port, uint8_t reg, uint8_t value,
+	                 EmuDuration time) override
+	{
+		waitUntil(out, time);
+		switch (chip) {
+		case Chip::AY8910: out.insert(out.end(), {0xA0, reg, value}); break;
+		case Chip::YM2413: out.insert(out.end(), {0x51, reg, value}); break;
+		case Chip::Y8950:  out.insert(out.end(), {0x5C, reg, value}); break;
+		case Chip::YM2151: out.insert(out.end(), {0x54, reg, value}); break;
+		case Chip::YMF262:
+			out.insert(out.end(), {uint8_t(port ? 0x5F : 0x5E), reg, value});
+			break;
+		case Chip::OPL4_FM:
+		case Chip::YMF278:
+			out.insert(out.end(), {0xD0, port, reg, value});
+			break;
+		case Chip::SCC:
+			if (port == 4) {
+				// bit 31 of the clock selects SCC+ (K052539)
+				clock(0x9C) |= 0x80000000;
+			}
+			out.insert(out.end(), {0xD2, port, reg, value});
+			break;
+		default:
+			break;
+		}
+	}
+
+	void encodeMarker(std::vector<uint8_t>& out, EmuDuration time) override
+	{
+		// There's no marker command in VGM, use a dummy write to a
+		// (never used) POKEY chip. vgm_cmp removes it again.
+		waitUntil(out, time);
+		out.insert(out.end(), {0xBB, 0xBB, 0xBB});
+	}
+
+	void encodeEnd(std::vector<uint8_t>& out, EmuDuration time) override
+	{
+		waitUntil(out, time);
+		out.push_back(0x66);
+	}
+
+	std::vector<uint8_t> getHeader(size_t fileSize) override
+	{
+		std::vector<uint8_t> header(HEADER_SIZE);
+		header[0] = 'V'; header[1] = 'g'; header[2] = 'm'; header[3] = ' ';
+		put32(header, 0x04, uint32_t(fileSize - 0x04)); // EOF offset
+		put32(header, 0x08, 0x161); // version 1.61
+		put32(header, 0x18, uint32_t(samples)); // total number of samples
+		put32(header, 0x34, uint32_t(HEADER_SIZE - 0x34)); // data offset
+		for (size_t i = 0; i < HEADER_SIZE / 4; ++i) {
+			if (clocks[i]) put32(header, 4 * i, clocks[i]);
+		}
+		return header;
+	}
+
+	/** Number of VGM samples in the given duration (rounded down). */
+	[[nodiscard]] static uint64_t toSamples(EmuDuration time)
+	{
+		// split to avoid overflow in the multiplication
+		auto ticks = time.length();
+		return (ticks / MAIN_FREQ) * SAMPLE_RATE
+		     + (ticks % MAIN_FREQ) * SAMPLE_RATE / MAIN_FREQ;
+	}
+
+private:
+	void waitUntil(std::vector<uint8_t>& out, EmuDuration time)
+	{
+		auto target = toSamples(time);
+		while (samples < target) {
+			auto n = target - samples;
+			if (n <= 16) {
+				out.push_back(uint8_t(0x70 + n - 1));
+			} else if (n == 735) {
+				out.push_back(0x62); // 1/60s
+			} else if (n == 882) {
+				out.push_back(0x63); // 1/50s
+			} else {
+				n = std::min<uint64_t>(n, 0xFFFF);
+				out.insert(out.end(), {0x61, uint8_t(n), uint8_t(n >> 8)});
+			}
+			samples += n;
+		}
+	}
+
+	[[nodiscard]] uint32_t& clock(size_t headerOffset)
+	{
+		return clocks[headerOffset / 4];
+	}
+
+	uint32_t clocks[HEADER_SIZE / 4] = {}; // indexed by header offset / 4
+	bool used[size_t(Chip::NUM)] = {};
+	uint64_t samples = 0;
+};
+
+
+// native format, see RegisterLogFormat
+
+class NativeEncoder final : public RegisterLogWriter::Encoder
+{
+public:
+	void encodeStart(std::vector<uint8_t>& out) override
+	{
+		using namespace RegisterLogFormat;
+		out.insert(out.end(), std::begin(MAGIC), std::end(MAGIC));
+		out.push_back(VERSION);
+	}
+
+	bool accept(Chip /*chip*/) override
+	{
+		return numDevices++ < RegisterLogFormat::MAX_DEVICES;
+	}
+
+	void encodeDevice(std::vector<uint8_t>& out, unsigned idx, Chip chip,
+	                  std::string_view name, span<const uint8_t> memory) override
+	{
+		using namespace RegisterLogFormat;
+		name = name.substr(0, 255);
+		out.insert(out.end(), {TAG_DEVICE, uint8_t(chip), uint8_t(name.size())});
+		out.insert(out.end(), name.begin(), name.end());
+		if (!memory.empty()) {
+			out.insert(out.end(), {TAG_MEMORY, uint8_t(idx)});
+			append32(out, uint32_t(memory.size()));
+			out.insert(out.end(), memory.begin(), memory.end());
+		}
+	}
+
+	void encodeWrite(std::vector<uint8_t>& out, unsigned idx, Chip /*chip*/,
+	                 uint8_t port, uint8_t reg, uint8_t value,
+	                 EmuDuration time) override
+	{
+		waitUntil(out, time);
+		out.insert(out.end(), {uint8_t(idx), port, reg, value});
+	}
+
+	void encodeMarker(std::vector<uint8_t>& out, EmuDuration time) override
+	{
+		waitUntil(out, time);
+		out.push_back(RegisterLogFormat::TAG_MARKER);
+	}
+
+	void encodeEnd(std::vector<uint8_t>& out, EmuDuration time) override
+	{
+		waitUntil(out, time);
+		out.push_back(RegisterLogFormat::TAG_END);
+	}
+
+	std::vector<uint8_t> getHeader(size_t /*fileSize*/) override
+	{
+		return {}; // header doesn't change
+	}
+
+private:
+	void waitUntil(std::vector<uint8_t>& out, EmuDuration time)
+	{
+		auto ticks = time.length();
+		if (ticks <= last) return;
+		auto delta = ticks - last;
+		last = ticks;
+		out.push_back(RegisterLogFormat::TAG_WAIT);
+		do {
+			auto b = uint8_t(delta & 0x7F);
+			delta >>= 7;
+			out.push_back(delta ? (b | 0x80) : b);
+		} while (delta);
+	}
+
+	unsigned numDevices = 0;
+	uint64_t last = 0; // in EmuTime ticks
+};
+
+
+std::unique_ptr<RegisterLogWriter::Encoder> RegisterLogWriter::createEncoder(Format format)
+{
+	if (format == Format::VGM) {
+		return std::make_unique<VGMEncoder>();
+	} else {
+		return std::make_unique<NativeEncoder>();
+	}
+}
+
+RegisterLogWriter::RegisterLogWriter(
+		Format format, const Filename& filename,
+		span<SoundDevice* const> allDevices)
+	: encoder(createEncoder(format))
+	, file(std::make_unique<File>(filename, File::TRUNCATE))
+	, worker(MAX_PENDING_CHUNKS)
+{
+	chunk.reserve(CHUNK_SIZE);
+	encoder->encodeStart(chunk);
+	for (auto* device : allDevices) {
+		auto chip = device->getRegisterLogChip();
+		if (!chip || !encoder->accept(*chip)) continue;
+		encoder->encodeDevice(chunk, unsigned(devices.size()), *chip,
+		                      device->getName(), device->getSampleMemory());
+		devices.push_back(device);
+		checkChunk();
+	}
+	for (auto* device : devices) {
+		device->setRegisterLogger(this);
+	}
+}
+
+RegisterLogWriter::~RegisterLogWriter()
+{
+	try {
+		stop(lastTime);
+	} catch (MSXException&) {
+		// ignore, can't throw from destructor
+	}
+}
+
+void RegisterLogWriter::write(SoundDevice& device, uint8_t port, uint8_t reg,
+                              uint8_t value, EmuTime::param time)
+{
+	assert(!stopped);
+	auto it = ranges::find(devices, &device);
+	if (it == devices.end()) return;
+	auto idx = unsigned(it - devices.begin());
+
+	if (numWrites == 0) {
+		startTime = time;
+		lastTime = time;
+	}
+	++numWrites;
+	encoder->encodeWrite(chunk, idx, *device.getRegisterLogChip(),
+	                     port, reg, value, sinceStart(time));
+	lastTime = std::max(lastTime, time);
+	checkChunk();
+}
+
+void RegisterLogWriter::addMarker(EmuTime::param time)
+{
+	assert(!stopped);
+	encoder->encodeMarker(chunk, sinceStart(time));
+	checkChunk();
+}
+
+void RegisterLogWriter::removeDevice(SoundDevice& device)
+{
+	if (auto it = ranges::find(devices, &device); it != devices.end()) {
+		device.setRegisterLogger(nullptr);
+		*it = nullptr; // keep the other device indices
+	}
+}
+
+EmuDuration RegisterLogWriter::sinceStart(EmuTime::param time) const
+{
+	// Writes can be (slightly) out of order, e.g. when a chip is
+	// synchronized later than the CPU. The log never goes back in time.
+	if (numWrites == 0) return EmuDuration::zero();
+	return std::max(time, lastTime) - startTime;
+}
+
+void RegisterLogWriter::checkChunk()
+{
+	if (chunk.size() >= CHUNK_SIZE) submitChunk();
+}
+
+void RegisterLogWriter::submitChunk()
+{
+	std::vector<uint8_t> data;
+	data.reserve(CHUNK_SIZE);
+	std::swap(data, chunk);
+	submittedSize += data.size();
+	worker.pushMoveOnly([this, data = std::move(data)] {
+		if (!file) return; // stopped after an error
+		try {
+			file->write(data.data(), data.size());
+		} catch (MSXException& e) {
+			setError(e.getMessage());
+			file.reset();
+		}
+	});
+}
+
+void RegisterLogWriter::stop(EmuTime::param time)
+{
+	if (stopped) return;
+	stopped = true;
+	for (auto* device : devices) {
+		if (device) device->setRegisterLogger(nullptr);
+	}
+
+	encoder->encodeEnd(chunk, sinceStart(time));
+	submitChunk();
+	auto header = encoder->getHeader(submittedSize);
+	worker.pushMoveOnly([this, header = std::move(header)] {
+		if (!file) return;
+		try {
+			if (!header.empty()) {
+				file->seek(0);
+				file->write(header.data(), header.size());
+			}
+			file->close();
+		} catch (MSXException& e) {
+			setError(e.getMessage());
+		}
+		file.reset();
+	});
+	worker.flush();
+
+	std::lock_guard<std::mutex> lock(errorMutex);
+	if (!error.empty()) throw MSXException(error);
+}
+
+void RegisterLogWriter::setError(std::string message)
+{
+	std::lock_guard<std::mutex> lock(errorMutex);
+	if (error.empty()) error = std::move(message);
+}
+
+} // namespace openmsx
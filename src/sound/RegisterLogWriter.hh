@@ -0,0 +1,152 @@
+#ifndef REGISTERLOGWRITER_HH
+#define REGISTERLOGWRITER_HH
+
+#include "RegisterLogger.hh"
+#include "EmuDuration.hh"
+#include "EmuTime.hh"
+#include "WorkerThread.hh"
+#include "span.hh"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace openmsx {
+
+class File;
+class Filename;
+class SoundDevice;
+
+/** The native register log format.
+  *
+  * The file starts with MAGIC and VERSION, followed by a sequence of
+  * records. Each record starts with a tag byte:
+  *  - 0x00..MAX_DEVICES-1: a register write for that device, followed by
+  *    the port, register and value bytes.
+  *  - TAG_DEVICE: defines the next device: chip (see RegisterLogger::Chip),
+  *    length of the name (1 byte), the name. Devices are numbered in the
+  *    order they're defined.
+  *  - TAG_MEMORY: the initial sample memory content of a device: device
+  *    number, size (4 bytes), the data.
+  *  - TAG_WAIT: time advances, followed by the number of EmuTime ticks
+  *    (see MAIN_FREQ) as a LEB128 number.
+  *  - TAG_MARKER: a marker, e.g. a loop point.
+  *  - TAG_END: end of the log.
+  * Multi-byte numbers are little endian.
+  */
+namespace RegisterLogFormat {
+	constexpr uint8_t MAGIC[8] = {'O', 'M', 'S', 'X', 'R', 'L', 'O', 'G'};
+	constexpr uint8_t VERSION = 1;
+	constexpr unsigned MAX_DEVICES = 0xF0;
+	constexpr uint8_t TAG_DEVICE = 0xF0;
+	constexpr uint8_t TAG_MEMORY = 0xF1;
+	constexpr uint8_t TAG_WAIT   = 0xF2;
+	constexpr uint8_t TAG_MARKER = 0xF3;
+	constexpr uint8_t TAG_END    = 0xFF;
+}
+
+/** Writes the register writes of (a selection of) sound devices to a file,
+  * either as a VGM file or in the native format (see RegisterLogFormat).
+  *
+  * The data is collected in large chunks on the emulation thread, the
+  * actual file I/O happens on a background thread (like AsyncWavWriter).
+  *
+  * The log starts at the first register write, so leading silence is not
+  * recorded.
+  */
+class RegisterLogWriter final : public RegisterLogger
+{
+public:
+	enum class Format { VGM, NATIVE };
+
+	/** Translates register writes to the bytes of a specific file format.
+	  * All output is appended to 'out'.
+	  */
+	class Encoder {
+	public:
+		virtual ~Encoder() = default;
+		virtual void encodeStart(std::vector<uint8_t>& out) = 0;
+		/** Should a device of this type be logged? Called once per
+		  * device (in order). */
+		[[nodiscard]] virtual bool accept(Chip chip) = 0;
+		/** Called once for each logged device, before anything else
+		  * is logged. */
+		virtual void encodeDevice(std::vector<uint8_t>& out, unsigned idx, Chip chip,
+		                          std::string_view name, span<const uint8_t> memory) = 0;
+		virtual void encodeWrite(std::vector<uint8_t>& out, unsigned idx, Chip chip,
+		                         uint8_t port, uint8_t reg, uint8_t value,
+		                         EmuDuration time) = 0;
+		virtual void encodeMarker(std::vector<uint8_t>& out, EmuDuration time) = 0;
+		virtual void encodeEnd(std::vector<uint8_t>& out, EmuDuration time) = 0;
+		/** The final file header (possibly empty), it overwrites the
+		  * start of the file. */
+		[[nodiscard]] virtual std::vector<uint8_t> getHeader(size_t fileSize) = 0;
+	};
+	[[nodiscard]] static std::unique_ptr<Encoder> createEncoder(Format format);
+
+	/** Create the file and start logging the given devices. Devices that
+	  * don't support register logging are skipped. A VGM file can only
+	  * contain one device per chip type, so only the first device of each
+	  * type is logged.
+	  * @throws MSXException when the file can't be created.
+	  */
+	RegisterLogWriter(Format format, const Filename& filename,
+	                  span<SoundDevice* const> devices);
+
+	/** Calls stop(), but ignores errors. */
+	~RegisterLogWriter();
+
+	RegisterLogWriter(const RegisterLogWriter&) = delete;
+	RegisterLogWriter& operator=(const RegisterLogWriter&) = delete;
+
+	/** Stop logging, finish the file and wait till it's written.
+	  * @param time End of the log (the log is at least as long as the
+	  *             last register write).
+	  * @throws MSXException when something went wrong while writing.
+	  */
+	void stop(EmuTime::param time);
+
+	/** Insert a marker (e.g. a loop point) at the given time. */
+	void addMarker(EmuTime::param time);
+
+	/** Stop logging a device, must be called before it gets destroyed. */
+	void removeDevice(SoundDevice& device);
+
+	[[nodiscard]] const std::vector<SoundDevice*>& getDevices() const { return devices; }
+	[[nodiscard]] unsigned getNumWrites() const { return numWrites; }
+	/** Only valid when getNumWrites() is not zero. */
+	[[nodiscard]] EmuTime getFirstWriteTime() const { return startTime; }
+	[[nodiscard]] EmuTime getLastWriteTime() const { return lastTime; }
+
+private:
+	// RegisterLogger
+	void write(SoundDevice& device, uint8_t port, uint8_t reg,
+	           uint8_t value, EmuTime::param time) override;
+
+	[[nodiscard]] EmuDuration sinceStart(EmuTime::param time) const;
+	void checkChunk();
+	void submitChunk();
+	void setError(std::string message);
+
+	std::unique_ptr<Encoder> encoder;
+	std::vector<SoundDevice*> devices; // logged devices, (at most) one per device index
+	std::vector<uint8_t> chunk; // not yet submitted
+	size_t submittedSize = 0;
+	unsigned numWrites = 0;
+	EmuTime startTime = EmuTime::zero();
+	EmuTime lastTime = EmuTime::zero();
+	bool stopped = false;
+
+	std::unique_ptr<File> file; // only used by 'worker'
+	std::string error; // first error on the worker thread
+	std::mutex errorMutex;
+
+	// Must come last, so that it's stopped first.
+	WorkerThread worker;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef REGISTERLOGGER_HH
+#define REGISTERLOGGER_HH
+
+#include "EmuTime.hh"
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace openmsx {
+
+class SoundDevice;
+
+/** Receives the register writes of sound chips, see
+  * SoundDevice::setRegisterLogger().
+  *
+  * A write is identified by a (port, reg) pair. For most chips 'port' is
+  * always zero, it's only used for chips with more than 256 registers or
+  * with several register banks. The numbering follows the VGM file format,
+  * see RegisterLogWriter for details.
+  */
+class RegisterLogger
+{
+public:
+	enum class Chip : uint8_t {
+		AY8910,  // PSG
+		YM2413,  // MSX-MUSIC
+		Y8950,   // MSX-AUDIO
+		YMF262,  // OPL3
+		OPL4_FM, // the FM part of the YMF278 (a YMF262 with isYMF278 set)
+		YMF278,  // the wave part of the YMF278 (MoonSound)
+		YM2151,  // SFG-01/05
+		SCC,     // SCC and SCC+
+		NUM
+	};
+
+	virtual void write(SoundDevice& device, uint8_t port, uint8_t reg,
+	                   uint8_t value, EmuTime::param time) = 0;
+
+protected:
+	~RegisterLogger() = default;
+};
+
+[[nodiscard]] inline std::string_view getChipName(RegisterLogger::Chip chip)
+{
+	using Chip = RegisterLogger::Chip;
+	switch (chip) {
+	case Chip::AY8910:  return "AY8910";
+	case Chip::YM2413:  return "YM2413";
+	case Chip::Y8950:   return "Y8950";
+	case Chip::YMF262:  return "YMF262";
+	case Chip::OPL4_FM: return "OPL4_FM";
+	case Chip::YMF278:  return "YMF278";
+	case Chip::YM2151:  return "YM2151";
+	case Chip::SCC:     return "SCC";
+	default:            return "unknown";
+	}
+}
+
+[[nodiscard]] inline std::optional<RegisterLogger::Chip> parseChipName(std::string_view name)
+{
+	for (int i = 0; i < int(RegisterLogger::Chip::NUM); ++i) {
+		auto chip = RegisterLogger::Chip(i);
+		if (getChipName(chip) == name) return chip;
+	}
+	return {};
+}
+
+} // namespace openmsx
+
+#endif
@@ -15,7 +15,9 @@ public:
 
 	bool generateOutput(float* dataOut, unsigned num, EmuTime::param time)
 	{
-		bool result = generateOutputImpl(dataOut, num, time);
+		bool result = (input.isIdle() && isDrained())
+		            ? skipIdle(time)
+		            : generateOutputImpl(dataOut, num, time);
 		auto& emuClk = getEmuClock(); (void)emuClk;
 		assert(emuClk.getTime() <= time);
 		assert(emuClk.getFastAdd(1) > time);
@@ -28,6 +30,22 @@ protected:
 	virtual bool generateOutputImpl(float* dataOut, unsigned num,
 	                                EmuTime::param time) = 0;
 
+	/** Is there still (non-silent) output pending from earlier input?
+	  * When not, and the input device is idle, the output is silent as
+	  * well, and generateOutputImpl() can be skipped.
+	  */
+	virtual bool isDrained() const = 0;
+
+private:
+	bool skipIdle(EmuTime::param time)
+	{
+		auto& emuClk = getEmuClock();
+		unsigned emuNum = emuClk.getTicksTill(time);
+		input.skipInput(emuNum);
+		emuClk += emuNum;
+		return false;
+	}
+
 protected:
 	ResampledSoundDevice& input;
 };
@@ -107,6 +107,15 @@ bool ResampleBlip<CHANNELS>::generateOutputImpl(float* dataOut, unsigned hostNum
 	return result;
 }
 
+template <unsigned CHANNELS>
+bool ResampleBlip<CHANNELS>::isDrained() const
+{
+	for (unsigned ch = 0; ch < CHANNELS; ++ch) {
+		if ((lastInput[ch] != 0.0f) || !blip[ch].isDrained()) return false;
+	}
+	return true;
+}
+
 // Force template instantiation.
 template class ResampleBlip<1>;
 template class ResampleBlip<2>;
@@ -17,6 +17,7 @@ public:
 
 	bool generateOutputImpl(float* dataOut, unsigned num,
 	                        EmuTime::param time) override;
+	bool isDrained() const override;
 
 private:
 	BlipBuffer blip[CHANNELS];
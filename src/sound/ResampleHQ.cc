@@ -11,6 +11,7 @@
 
 #include "ResampleHQ.hh"
 #include "ResampledSoundDevice.hh"
+#include "ResampleHQKernels.hh"
 #include "FixedPoint.hh"
 #include "MemBuffer.hh"
 #include "likely.hh"
@@ -18,15 +19,13 @@
 #include "stl.hh"
 #include "vla.hh"
 #include "build-info.hh"
+#include <algorithm>
 #include <vector>
 #include <cmath>
 #include <cstddef>
 #include <cstring>
 #include <cassert>
 #include <iterator>
-#ifdef __SSE2__
-#include <emmintrin.h>
-#endif
 
 namespace openmsx {
 
@@ -53,7 +52,7 @@ public:
 	void releaseCoeffs(double ratio);
 
 private:
-	using Table = MemBuffer<float, SSE2_ALIGNMENT>;
+	using Table = MemBuffer<float, 32>; // rows are aligned for AVX
 	using PermuteTable = MemBuffer<int16_t>;
 
 	ResampleCoeffs() = default;
@@ -332,7 +331,7 @@ ResampleCoeffs::Table ResampleCoeffs::calcTable(
 	int min_idx = -maxFilterIndex.divAsInt(increment);
 	int max_idx = 1 + (maxFilterIndex - (increment - FilterIndex(floatIncr))).divAsInt(increment);
 	int idx_cnt = max_idx - min_idx + 1;
-	filterLen = (idx_cnt + 3) & ~3; // round up to multiple of 4
+	filterLen = (idx_cnt + 7) & ~7; // round up to multiple of 8, see ResampleHQKernels
 	min_idx -= (filterLen - idx_cnt) / 2;
 	Table table(HALF_TAB_LEN * filterLen);
 	memset(table.data(), 0, HALF_TAB_LEN * filterLen * sizeof(float));
@@ -374,6 +373,7 @@ ResampleHQ<CHANNELS>::ResampleHQ(
 	: ResampleAlgo(input_)
 	, hostClock(hostClock_)
 	, ratio(float(hostClock.getPeriod().toDouble() / getEmuClock().getPeriod().toDouble()))
+	, kernel(ResampleHQKernels::getBestKernel())
 {
 	ResampleCoeffs::instance().getCoeffs(double(ratio), permute, table, filterLen);
 
@@ -392,205 +392,22 @@ ResampleHQ<CHANNELS>::~ResampleHQ()
 	ResampleCoeffs::instance().releaseCoeffs(double(ratio));
 }
 
-#ifdef __SSE2__
-template<bool REVERSE>
-static inline void calcSseMono(const float* buf_, const float* tab_, size_t len, float* out)
-{
-	assert((len % 4) == 0);
-	assert((uintptr_t(tab_) % 16) == 0);
-
-	ptrdiff_t x = (len & ~7) * sizeof(float);
-	assert((x % 32) == 0);
-	const char* buf = reinterpret_cast<const char*>(buf_) + x;
-	const char* tab = reinterpret_cast<const char*>(tab_) + (REVERSE ? -x : x);
-	x = -x;
-
-	__m128 a0 = _mm_setzero_ps();
-	__m128 a1 = _mm_setzero_ps();
-	do {
-		__m128 b0 = _mm_loadu_ps(reinterpret_cast<const float*>(buf + x +  0));
-		__m128 b1 = _mm_loadu_ps(reinterpret_cast<const float*>(buf + x + 16));
-		__m128 t0, t1;
-		if (REVERSE) {
-			t0 = _mm_loadr_ps(reinterpret_cast<const float*>(tab - x - 16));
-			t1 = _mm_loadr_ps(reinterpret_cast<const float*>(tab - x - 32));
-		} else {
-			t0 = _mm_load_ps (reinterpret_cast<const float*>(tab + x +  0));
-			t1 = _mm_load_ps (reinterpret_cast<const float*>(tab + x + 16));
-		}
-		__m128 m0 = _mm_mul_ps(b0, t0);
-		__m128 m1 = _mm_mul_ps(b1, t1);
-		a0 = _mm_add_ps(a0, m0);
-		a1 = _mm_add_ps(a1, m1);
-		x += 2 * sizeof(__m128);
-	} while (x < 0);
-	if (len & 4) {
-		__m128 b0 = _mm_loadu_ps(reinterpret_cast<const float*>(buf));
-		__m128 t0;
-		if (REVERSE) {
-			t0 = _mm_loadr_ps(reinterpret_cast<const float*>(tab - 16));
-		} else {
-			t0 = _mm_load_ps (reinterpret_cast<const float*>(tab));
-		}
-		__m128 m0 = _mm_mul_ps(b0, t0);
-		a0 = _mm_add_ps(a0, m0);
-	}
-
-	__m128 a = _mm_add_ps(a0, a1);
-	// The following can be _slightly_ faster by using the SSE3 _mm_hadd_ps()
-	// intrinsic, but not worth the trouble.
-	__m128 t = _mm_add_ps(a, _mm_movehl_ps(a, a));
-	__m128 s = _mm_add_ss(t, _mm_shuffle_ps(t, t, 1));
-
-	_mm_store_ss(out, s);
-}
-
-template<int N> static inline __m128 shuffle(__m128 x)
-{
-	return _mm_castsi128_ps(_mm_shuffle_epi32(_mm_castps_si128(x), N));
-}
-template<bool REVERSE>
-static inline void calcSseStereo(const float* buf_, const float* tab_, size_t len, float* out)
-{
-	assert((len % 4) == 0);
-	assert((uintptr_t(tab_) % 16) == 0);
-
-	ptrdiff_t x = 2 * (len & ~7) * sizeof(float);
-	const char* buf = reinterpret_cast<const char*>(buf_) + x;
-	const char* tab = reinterpret_cast<const char*>(tab_);
-	x = -x;
-
-	__m128 a0 = _mm_setzero_ps();
-	__m128 a1 = _mm_setzero_ps();
-	__m128 a2 = _mm_setzero_ps();
-	__m128 a3 = _mm_setzero_ps();
-	do {
-		__m128 b0 = _mm_loadu_ps(reinterpret_cast<const float*>(buf + x +  0));
-		__m128 b1 = _mm_loadu_ps(reinterpret_cast<const float*>(buf + x + 16));
-		__m128 b2 = _mm_loadu_ps(reinterpret_cast<const float*>(buf + x + 32));
-		__m128 b3 = _mm_loadu_ps(reinterpret_cast<const float*>(buf + x + 48));
-		__m128 ta, tb;
-		if (REVERSE) {
-			ta = _mm_loadr_ps(reinterpret_cast<const float*>(tab - 16));
-			tb = _mm_loadr_ps(reinterpret_cast<const float*>(tab - 32));
-			tab -= 2 * sizeof(__m128);
-		} else {
-			ta = _mm_load_ps (reinterpret_cast<const float*>(tab +  0));
-			tb = _mm_load_ps (reinterpret_cast<const float*>(tab + 16));
-			tab += 2 * sizeof(__m128);
-		}
-		__m128 t0 = shuffle<0x50>(ta);
-		__m128 t1 = shuffle<0xFA>(ta);
-		__m128 t2 = shuffle<0x50>(tb);
-		__m128 t3 = shuffle<0xFA>(tb);
-		__m128 m0 = _mm_mul_ps(b0, t0);
-		__m128 m1 = _mm_mul_ps(b1, t1);
-		__m128 m2 = _mm_mul_ps(b2, t2);
-		__m128 m3 = _mm_mul_ps(b3, t3);
-		a0 = _mm_add_ps(a0, m0);
-		a1 = _mm_add_ps(a1, m1);
-		a2 = _mm_add_ps(a2, m2);
-		a3 = _mm_add_ps(a3, m3);
-		x += 4 * sizeof(__m128);
-	} while (x < 0);
-	if (len & 4) {
-		__m128 b0 = _mm_loadu_ps(reinterpret_cast<const float*>(buf +  0));
-		__m128 b1 = _mm_loadu_ps(reinterpret_cast<const float*>(buf + 16));
-		__m128 ta;
-		if (REVERSE) {
-			ta = _mm_loadr_ps(reinterpret_cast<const float*>(tab - 16));
-		} else {
-			ta = _mm_load_ps (reinterpret_cast<const float*>(tab +  0));
-		}
-		__m128 t0 = shuffle<0x50>(ta);
-		__m128 t1 = shuffle<0xFA>(ta);
-		__m128 m0 = _mm_mul_ps(b0, t0);
-		__m128 m1 = _mm_mul_ps(b1, t1);
-		a0 = _mm_add_ps(a0, m0);
-		a1 = _mm_add_ps(a1, m1);
-	}
-
-	__m128 a01 = _mm_add_ps(a0, a1);
-	__m128 a23 = _mm_add_ps(a2, a3);
-	__m128 a   = _mm_add_ps(a01, a23);
-	// Can faster with SSE3, but (like above) not worth the trouble.
-	__m128 s = _mm_add_ps(a, _mm_movehl_ps(a, a));
-	_mm_store_ss(&out[0], s);
-	_mm_store_ss(&out[1], shuffle<0x55>(s));
-}
-
-#endif
-
 template <unsigned CHANNELS>
-void ResampleHQ<CHANNELS>::calcOutput(
-	float pos, float* __restrict output)
+ResampleHQKernels::Row ResampleHQ<CHANNELS>::getRow(float pos) const
 {
-	assert((filterLen & 3) == 0);
-
 	int bufIdx = int(pos) + bufStart;
 	assert((bufIdx + filterLen) <= bufEnd);
-	bufIdx *= CHANNELS;
-	const float* buf = &buffer[bufIdx];
+	const float* buf = &buffer[bufIdx * CHANNELS];
 
 	int t = unsigned(lrintf(pos * TAB_LEN)) % TAB_LEN;
 	if (!(t & HALF_TAB_LEN)) {
 		// first half, begin of row 't'
 		t = permute[t];
-		const float* tab = &table[t * filterLen];
-
-#ifdef __SSE2__
-		if (CHANNELS == 1) {
-			calcSseMono  <false>(buf, tab, filterLen, output);
-		} else {
-			calcSseStereo<false>(buf, tab, filterLen, output);
-		}
-		return;
-#endif
-
-		// c++ version, both mono and stereo
-		for (unsigned ch = 0; ch < CHANNELS; ++ch) {
-			float r0 = 0.0f;
-			float r1 = 0.0f;
-			float r2 = 0.0f;
-			float r3 = 0.0f;
-			for (unsigned i = 0; i < filterLen; i += 4) {
-				r0 += tab[i + 0] * buf[CHANNELS * (i + 0)];
-				r1 += tab[i + 1] * buf[CHANNELS * (i + 1)];
-				r2 += tab[i + 2] * buf[CHANNELS * (i + 2)];
-				r3 += tab[i + 3] * buf[CHANNELS * (i + 3)];
-			}
-			output[ch] = r0 + r1 + r2 + r3;
-			++buf;
-		}
+		return {buf, &table[t * filterLen], false};
 	} else {
 		// 2nd half, end of row 'TAB_LEN - 1 - t'
 		t = permute[TAB_LEN - 1 - t];
-		const float* tab = &table[(t + 1) * filterLen];
-
-#ifdef __SSE2__
-		if (CHANNELS == 1) {
-			calcSseMono  <true>(buf, tab, filterLen, output);
-		} else {
-			calcSseStereo<true>(buf, tab, filterLen, output);
-		}
-		return;
-#endif
-
-		// c++ version, both mono and stereo
-		for (unsigned ch = 0; ch < CHANNELS; ++ch) {
-			float r0 = 0.0f;
-			float r1 = 0.0f;
-			float r2 = 0.0f;
-			float r3 = 0.0f;
-			for (int i = 0; i < int(filterLen); i += 4) {
-				r0 += tab[-i - 1] * buf[CHANNELS * (i + 0)];
-				r1 += tab[-i - 2] * buf[CHANNELS * (i + 1)];
-				r2 += tab[-i - 3] * buf[CHANNELS * (i + 2)];
-				r3 += tab[-i - 4] * buf[CHANNELS * (i + 3)];
-			}
-			output[ch] = r0 + r1 + r2 + r3;
-			++buf;
-		}
+		return {buf, &table[(t + 1) * filterLen], true};
 	}
 }
 
@@ -654,9 +471,17 @@ bool ResampleHQ<CHANNELS>::generateOutputImpl(
 		assert(host1 > emuClk.getTime());
 		float pos = emuClk.getTicksTillDouble(host1);
 		assert(pos <= (ratio + 2));
-		for (unsigned i = 0; i < hostNum; ++i) {
-			calcOutput(pos, &dataOut[i * CHANNELS]);
-			pos += ratio;
+		// process in chunks, to keep the rows in a small (stack) buffer
+		constexpr unsigned CHUNK = 64;
+		ResampleHQKernels::Row rows[CHUNK];
+		for (unsigned i = 0; i < hostNum; i += CHUNK) {
+			unsigned n = std::min(CHUNK, hostNum - i);
+			for (unsigned j = 0; j < n; ++j) {
+				rows[j] = getRow(pos);
+				pos += ratio;
+			}
+			ResampleHQKernels::calc<CHANNELS>(
+				kernel, rows, n, filterLen, &dataOut[i * CHANNELS]);
 		}
 	}
 	emuClk += emuNum;
@@ -671,6 +496,14 @@ bool ResampleHQ<CHANNELS>::generateOutputImpl(
 	return notMuted;
 }
 
+template <unsigned CHANNELS>
+bool ResampleHQ<CHANNELS>::isDrained() const
+{
+	// All buffered input is zero. Skipping input then only shifts zeros
+	// through the buffer, so the buffer can remain unchanged.
+	return nonzeroSamples == 0;
+}
+
 // Force template instantiation.
 template class ResampleHQ<1>;
 template class ResampleHQ<2>;
@@ -3,6 +3,7 @@
 
 #include "ResampleAlgo.hh"
 #include "DynamicClock.hh"
+#include "ResampleHQKernels.hh"
 #include <cstdint>
 #include <vector>
 
@@ -19,14 +20,16 @@ public:
 
 	bool generateOutputImpl(float* dataOut, unsigned num,
 	                        EmuTime::param time) override;
+	bool isDrained() const override;
 
 private:
-	void calcOutput(float pos, float* output);
+	[[nodiscard]] ResampleHQKernels::Row getRow(float pos) const;
 	void prepareData(unsigned emuNum);
 
 	const DynamicClock& hostClock;
 
 	const float ratio;
+	const ResampleHQKernels::Kernel kernel;
 	unsigned bufStart;
 	unsigned bufEnd;
 	unsigned nonzeroSamples;
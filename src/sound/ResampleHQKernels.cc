@@ -0,0 +1,337 @@
+#include "ResampleHQKernels.hh"
+#include "build-info.hh"
+#include <cassert>
+#include <cstdint>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// The AVX2 kernels are compiled for that instruction set via a function
+// attribute (so the rest of the program doesn't require AVX2), and are only
+// used after checking the CPU at runtime.
+#if ASM_X86 && (defined(__GNUC__) || defined(__clang__))
+#define RESAMPLE_AVX2 1
+#include <immintrin.h>
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+#else
+#define RESAMPLE_AVX2 0
+#endif
+
+namespace openmsx::ResampleHQKernels {
+
+template<unsigned CHANNELS, bool REVERSE>
+static inline void calcScalar(const float* buf, const float* tab, unsigned len, float* out)
+{
+	for (unsigned ch = 0; ch < CHANNELS; ++ch) {
+		float r0 = 0.0f;
+		float r1 = 0.0f;
+		float r2 = 0.0f;
+		float r3 = 0.0f;
+		for (int i = 0; i < int(len); i += 4) {
+			if (REVERSE) {
+				r0 += tab[-i - 1] * buf[CHANNELS * (i + 0)];
+				r1 += tab[-i - 2] * buf[CHANNELS * (i + 1)];
+				r2 += tab[-i - 3] * buf[CHANNELS * (i + 2)];
+				r3 += tab[-i - 4] * buf[CHANNELS * (i + 3)];
+			} else {
+				r0 += tab[i + 0] * buf[CHANNELS * (i + 0)];
+				r1 += tab[i + 1] * buf[CHANNELS * (i + 1)];
+				r2 += tab[i + 2] * buf[CHANNELS * (i + 2)];
+				r3 += tab[i + 3] * buf[CHANNELS * (i + 3)];
+			}
+		}
+		out[ch] = r0 + r1 + r2 + r3;
+		++buf;
+	}
+}
+
+#ifdef __SSE2__
+template<bool REVERSE>
+static inline void calcSseMono(const float* buf_, const float* tab_, size_t len, float* out)
+{
+	assert((len % 4) == 0);
+	assert((uintptr_t(tab_) % 16) == 0);
+
+	ptrdiff_t x = (len & ~7) * sizeof(float);
+	assert((x % 32) == 0);
+	const char* buf = reinterpret_cast<const char*>(buf_) + x;
+	const char* tab = reinterpret_cast<const char*>(tab_) + (REVERSE ? -x : x);
+	x = -x;
+
+	__m128 a0 = _mm_setzero_ps();
+	__m128 a1 = _mm_setzero_ps();
+	do {
+		__m128 b0 = _mm_loadu_ps(reinterpret_cast<const float*>(buf + x +  0));
+		__m128 b1 = _mm_loadu_ps(reinterpret_cast<const float*>(buf + x + 16));
+		__m128 t0, t1;
+		if (REVERSE) {
+			t0 = _mm_loadr_ps(reinterpret_cast<const float*>(tab - x - 16));
+			t1 = _mm_loadr_ps(reinterpret_cast<const float*>(tab - x - 32));
+		} else {
+			t0 = _mm_load_ps (reinterpret_cast<const float*>(tab + x +  0));
+			t1 = _mm_load_ps (reinterpret_cast<const float*>(tab + x + 16));
+		}
+		__m128 m0 = _mm_mul_ps(b0, t0);
+		__m128 m1 = _mm_mul_ps(b1, t1);
+		a0 = _mm_add_ps(a0, m0);
+		a1 = _mm_add_ps(a1, m1);
+		x += 2 * sizeof(__m128);
+	} while (x < 0);
+	if (len & 4) {
+		__m128 b0 = _mm_loadu_ps(reinterpret_cast<const float*>(buf));
+		__m128 t0;
+		if (REVERSE) {
+			t0 = _mm_loadr_ps(reinterpret_cast<const float*>(tab - 16));
+		} else {
+			t0 = _mm_load_ps (reinterpret_cast<const float*>(tab));
+		}
+		__m128 m0 = _mm_mul_ps(b0, t0);
+		a0 = _mm_add_ps(a0, m0);
+	}
+
+	__m128 a = _mm_add_ps(a0, a1);
+	// The following can be _slightly_ faster by using the SSE3 _mm_hadd_ps()
+	// intrinsic, but not worth the trouble.
+	__m128 t = _mm_add_ps(a, _mm_movehl_ps(a, a));
+	__m128 s = _mm_add_ss(t, _mm_shuffle_ps(t, t, 1));
+
+	_mm_store_ss(out, s);
+}
+
+template<int N> static inline __m128 shuffle(__m128 x)
+{
+	return _mm_castsi128_ps(_mm_shuffle_epi32(_mm_castps_si128(x), N));
+}
+template<bool REVERSE>
+static inline void calcSseStereo(const float* buf_, const float* tab_, size_t len, float* out)
+{
+	assert((len % 4) == 0);
+	assert((uintptr_t(tab_) % 16) == 0);
+
+	ptrdiff_t x = 2 * (len & ~7) * sizeof(float);
+	const char* buf = reinterpret_cast<const char*>(buf_) + x;
+	const char* tab = reinterpret_cast<const char*>(tab_);
+	x = -x;
+
+	__m128 a0 = _mm_setzero_ps();
+	__m128 a1 = _mm_setzero_ps();
+	__m128 a2 = _mm_setzero_ps();
+	__m128 a3 = _mm_setzero_ps();
+	do {
+		__m128 b0 = _mm_loadu_ps(reinterpret_cast<const float*>(buf + x +  0));
+		__m128 b1 = _mm_loadu_ps(reinterpret_cast<const float*>(buf + x + 16));
+		__m128 b2 = _mm_loadu_ps(reinterpret_cast<const float*>(buf + x + 32));
+		__m128 b3 = _mm_loadu_ps(reinterpret_cast<const float*>(buf + x + 48));
+		__m128 ta, tb;
+		if (REVERSE) {
+			ta = _mm_loadr_ps(reinterpret_cast<const float*>(tab - 16));
+			tb = _mm_loadr_ps(reinterpret_cast<const float*>(tab - 32));
+			tab -= 2 * sizeof(__m128);
+		} else {
+			ta = _mm_load_ps (reinterpret_cast<const float*>(tab +  0));
+			tb = _mm_load_ps (reinterpret_cast<const float*>(tab + 16));
+			tab += 2 * sizeof(__m128);
+		}
+		__m128 t0 = shuffle<0x50>(ta);
+		__m128 t1 = shuffle<0xFA>(ta);
+		__m128 t2 = shuffle<0x50>(tb);
+		__m128 t3 = shuffle<0xFA>(tb);
+		__m128 m0 = _mm_mul_ps(b0, t0);
+		__m128 m1 = _mm_mul_ps(b1, t1);
+		__m128 m2 = _mm_mul_ps(b2, t2);
+		__m128 m3 = _mm_mul_ps(b3, t3);
+		a0 = _mm_add_ps(a0, m0);
+		a1 = _mm_add_ps(a1, m1);
+		a2 = _mm_add_ps(a2, m2);
+		a3 = _mm_add_ps(a3, m3);
+		x += 4 * sizeof(__m128);
+	} while (x < 0);
+	if (len & 4) {
+		__m128 b0 = _mm_loadu_ps(reinterpret_cast<const float*>(buf +  0));
+		__m128 b1 = _mm_loadu_ps(reinterpret_cast<const float*>(buf + 16));
+		__m128 ta;
+		if (REVERSE) {
+			ta = _mm_loadr_ps(reinterpret_cast<const float*>(tab - 16));
+		} else {
+			ta = _mm_load_ps (reinterpret_cast<const float*>(tab +  0));
+		}
+		__m128 t0 = shuffle<0x50>(ta);
+		__m128 t1 = shuffle<0xFA>(ta);
+		__m128 m0 = _mm_mul_ps(b0, t0);
+		__m128 m1 = _mm_mul_ps(b1, t1);
+		a0 = _mm_add_ps(a0, m0);
+		a1 = _mm_add_ps(a1, m1);
+	}
+
+	__m128 a01 = _mm_add_ps(a0, a1);
+	__m128 a23 = _mm_add_ps(a2, a3);
+	__m128 a   = _mm_add_ps(a01, a23);
+	// Can faster with SSE3, but (like above) not worth the trouble.
+	__m128 s = _mm_add_ps(a, _mm_movehl_ps(a, a));
+	_mm_store_ss(&out[0], s);
+	_mm_store_ss(&out[1], shuffle<0x55>(s));
+}
+#endif
+
+#if RESAMPLE_AVX2
+// Calculates N output samples at once. The coefficients are always loaded
+// as aligned blocks of 8 floats, for reversed rows the order within a block
+// is swapped by the same permute instruction that (for stereo) duplicates
+// each coefficient for the left and right channel. So forward and reversed
+// rows can be mixed freely and there's no per-row branch in the inner loop.
+template<unsigned CHANNELS, unsigned N>
+AVX2_TARGET static void calcAvx(const Row* rows, unsigned len, float* out)
+{
+	assert((len % 8) == 0);
+
+	const float* buf[N];
+	const float* tab[N];
+	ptrdiff_t step[N];
+	__m256i idx0[N], idx1[N];
+	__m256 acc0[N], acc1[N];
+	for (unsigned j = 0; j < N; ++j) {
+		const auto& row = rows[j];
+		buf[j] = row.buf;
+		if (row.reverse) {
+			tab[j] = row.tab - 8;
+			step[j] = -8;
+			if (CHANNELS == 1) {
+				idx0[j] = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+			} else {
+				idx0[j] = _mm256_setr_epi32(7, 7, 6, 6, 5, 5, 4, 4);
+				idx1[j] = _mm256_setr_epi32(3, 3, 2, 2, 1, 1, 0, 0);
+			}
+		} else {
+			tab[j] = row.tab;
+			step[j] = 8;
+			if (CHANNELS == 1) {
+				idx0[j] = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+			} else {
+				idx0[j] = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+				idx1[j] = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+			}
+		}
+		assert((uintptr_t(tab[j]) % 32) == 0);
+		acc0[j] = _mm256_setzero_ps();
+		acc1[j] = _mm256_setzero_ps();
+	}
+
+	for (unsigned i = 0; i < len; i += 8) {
+		// fully unrolled, so that all per-row state stays in registers
+#pragma GCC unroll 4
+		for (unsigned j = 0; j < N; ++j) {
+			__m256 t = _mm256_load_ps(tab[j]);
+			tab[j] += step[j];
+			const float* b = buf[j] + CHANNELS * i;
+			__m256 t0 = _mm256_permutevar8x32_ps(t, idx0[j]);
+			acc0[j] = _mm256_fmadd_ps(_mm256_loadu_ps(b), t0, acc0[j]);
+			if (CHANNELS == 2) {
+				__m256 t1 = _mm256_permutevar8x32_ps(t, idx1[j]);
+				acc1[j] = _mm256_fmadd_ps(_mm256_loadu_ps(b + 8), t1, acc1[j]);
+			}
+		}
+	}
+
+	for (unsigned j = 0; j < N; ++j) {
+		__m256 a = (CHANNELS == 1) ? acc0[j] : _mm256_add_ps(acc0[j], acc1[j]);
+		__m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+		s = _mm_add_ps(s, _mm_movehl_ps(s, s)); // LRLR -> LR
+		if (CHANNELS == 1) {
+			s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+			_mm_store_ss(&out[j], s);
+		} else {
+			_mm_storel_pi(reinterpret_cast<__m64*>(&out[2 * j]), s);
+		}
+	}
+}
+
+static bool cpuHasAvx2()
+{
+	static const bool result = __builtin_cpu_supports("avx2") &&
+	                           __builtin_cpu_supports("fma");
+	return result;
+}
+#endif
+
+bool isSupported(Kernel kernel)
+{
+	switch (kernel) {
+	case Kernel::SCALAR:
+		return true;
+	case Kernel::SSE2:
+#ifdef __SSE2__
+		return true;
+#else
+		return false;
+#endif
+	case Kernel::AVX2:
+#if RESAMPLE_AVX2
+		return cpuHasAvx2();
+#else
+		return false;
+#endif
+	}
+	return false;
+}
+
+Kernel getBestKernel()
+{
+	if (isSupported(Kernel::AVX2)) return Kernel::AVX2;
+	if (isSupported(Kernel::SSE2)) return Kernel::SSE2;
+	return Kernel::SCALAR;
+}
+
+template<unsigned CHANNELS>
+void calc(Kernel kernel, const Row* rows, size_t num, unsigned len, float* out)
+{
+	assert(isSupported(kernel));
+	assert((len % 8) == 0);
+	size_t i = 0;
+#if RESAMPLE_AVX2
+	if (kernel == Kernel::AVX2) {
+		for (/**/; (i + 4) <= num; i += 4) {
+			calcAvx<CHANNELS, 4>(&rows[i], len, &out[CHANNELS * i]);
+		}
+		for (/**/; i < num; ++i) {
+			calcAvx<CHANNELS, 1>(&rows[i], len, &out[CHANNELS * i]);
+		}
+		return;
+	}
+#endif
+#ifdef __SSE2__
+	if (kernel == Kernel::SSE2) {
+		for (/**/; i < num; ++i) {
+			const auto& r = rows[i];
+			float* o = &out[CHANNELS * i];
+			if (CHANNELS == 1) {
+				if (r.reverse) {
+					calcSseMono  <true >(r.buf, r.tab, len, o);
+				} else {
+					calcSseMono  <false>(r.buf, r.tab, len, o);
+				}
+			} else {
+				if (r.reverse) {
+					calcSseStereo<true >(r.buf, r.tab, len, o);
+				} else {
+					calcSseStereo<false>(r.buf, r.tab, len, o);
+				}
+			}
+		}
+		return;
+	}
+#endif
+	for (/**/; i < num; ++i) {
+		const auto& r = rows[i];
+		if (r.reverse) {
+			calcScalar<CHANNELS, true >(r.buf, r.tab, len, &out[CHANNELS * i]);
+		} else {
+			calcScalar<CHANNELS, false>(r.buf, r.tab, len, &out[CHANNELS * i]);
+		}
+	}
+}
+
+// Force template instantiation.
+template void calc<1>(Kernel, const Row*, size_t, unsigned, float*);
+template void calc<2>(Kernel, const Row*, size_t, unsigned, float*);
+
+} // namespace openmsx::ResampleHQKernels
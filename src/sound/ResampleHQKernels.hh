@@ -0,0 +1,48 @@
+#ifndef RESAMPLEHQKERNELS_HH
+#define RESAMPLEHQKERNELS_HH
+
+#include <cstddef>
+
+/** The inner loops of ResampleHQ: each output sample is the dot product of a
+  * row of filter coefficients with a window of input samples.
+  *
+  * Only half of the coefficient table is stored, the other half is the same
+  * table read back-to-front. So a row is either read forwards, starting at
+  * 'tab', or backwards, starting at 'tab[-1]'.
+  *
+  * The filter length must be a multiple of 8 and the coefficient rows must
+  * be 32-byte aligned (ResampleHQ takes care of that).
+  */
+namespace openmsx::ResampleHQKernels {
+
+enum class Kernel {
+	SCALAR, // plain C++
+	SSE2,   // one output sample at a time
+	AVX2,   // AVX2+FMA, several output samples at once
+};
+
+struct Row {
+	const float* buf; // first input sample (frame) in the window
+	const float* tab; // begin (or, when 'reverse', end) of the coefficients
+	bool reverse;
+};
+
+/** Is the given kernel supported by this build and this CPU? */
+[[nodiscard]] bool isSupported(Kernel kernel);
+
+/** The fastest kernel that's supported, see isSupported(). */
+[[nodiscard]] Kernel getBestKernel();
+
+/** Calculate 'num' output samples (frames), one for each row.
+  * @param kernel Which implementation to use, must be supported.
+  * @param rows Array of 'num' rows.
+  * @param num Number of rows.
+  * @param len Filter length (number of coefficients per row).
+  * @param out Output buffer, 'num * CHANNELS' floats.
+  */
+template<unsigned CHANNELS>
+void calc(Kernel kernel, const Row* rows, size_t num, unsigned len, float* out);
+
+} // namespace openmsx::ResampleHQKernels
+
+#endif
@@ -20,6 +20,7 @@ public:
 protected:
 	ResampleLQ(ResampledSoundDevice& input, const DynamicClock& hostClock);
 	bool fetchData(EmuTime::param time, unsigned& valid);
+	bool isDrained() const override;
 
 	const DynamicClock& hostClock;
 	using FP = FixedPoint<14>;
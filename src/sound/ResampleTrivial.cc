@@ -19,4 +19,9 @@ bool ResampleTrivial::generateOutputImpl(float* dataOut, unsigned num,
 	return input.generateInput(dataOut, num);
 }
 
+bool ResampleTrivial::isDrained() const
+{
+	return true; // no internal state
+}
+
 } // namespace openmsx
@@ -13,6 +13,7 @@ public:
 	explicit ResampleTrivial(ResampledSoundDevice& input);
 	bool generateOutputImpl(float* dataOut, unsigned num,
 	                        EmuTime::param time) override;
+	bool isDrained() const override;
 };
 
 } // namespace openmsx
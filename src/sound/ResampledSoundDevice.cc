@@ -47,6 +47,12 @@ bool ResampledSoundDevice::generateInput(float* buffer, unsigned num)
 	return mixChannels(buffer, num);
 }
 
+void ResampledSoundDevice::skipInput(unsigned num)
+{
+	assert(isIdle());
+	skipChannels(num);
+}
+
 
 void ResampledSoundDevice::update(const Setting& setting)
 {
@@ -24,6 +24,11 @@ public:
 	  */
 	bool generateInput(float* buffer, unsigned num);
 
+	/** Skip 'num' input samples, only allowed while idle.
+	  * @see SoundDevice::setIdle()
+	  */
+	void skipInput(unsigned num);
+
 	DynamicClock& getEmuClock() { return emuClock; }
 
 protected:
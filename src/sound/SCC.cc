@@ -294,7 +294,7 @@ void SCC::writeMem(byte address, byte value, EmuTime::param time)
 	case SCC_Real:
 		if (address < 0x80) {
 			// 0x00..0x7F : write wave form 1..4
-			writeWave(address >> 5, address, value);
+			writeWave(address >> 5, address, value, time);
 		} else if (address < 0xA0) {
 			// 0x80..0x9F : freq volume block
 			setFreqVol(address, value, time);
@@ -308,7 +308,7 @@ void SCC::writeMem(byte address, byte value, EmuTime::param time)
 	case SCC_Compatible:
 		if (address < 0x80) {
 			// 0x00..0x7F : write wave form 1..4
-			writeWave(address >> 5, address, value);
+			writeWave(address >> 5, address, value, time);
 		} else if (address < 0xA0) {
 			// 0x80..0x9F : freq volume block
 			setFreqVol(address, value, time);
@@ -324,7 +324,7 @@ void SCC::writeMem(byte address, byte value, EmuTime::param time)
 	case SCC_plusmode:
 		if (address < 0xA0) {
 			// 0x00..0x9F : write wave form 1..5
-			writeWave(address >> 5, address, value);
+			writeWave(address >> 5, address, value, time);
 		} else if (address < 0xC0) {
 			// 0xA0..0xBF : freq volume block
 			setFreqVol(address, value, time);
@@ -345,6 +345,53 @@ float SCC::getAmplificationFactorImpl() const
 	return 1.0f / 128.0f;
 }
 
+std::optional<RegisterLogger::Chip> SCC::getRegisterLogChip() const
+{
+	return RegisterLogger::Chip::SCC;
+}
+
+void SCC::replayRegisterWrite(uint8_t port, uint8_t reg, uint8_t value,
+                              EmuTime::param time)
+{
+	updateStream(time);
+
+	// The log may come from a chip in another mode, so don't use
+	// writeWave() (its behaviour depends on the current mode).
+	auto setWave = [&](unsigned channel) {
+		if (readOnly[channel]) return;
+		unsigned p = reg & 0x1F;
+		wave[channel][p] = value;
+		volAdjustedWave[channel][p] = adjust(value, volume[channel]);
+	};
+	switch (port) {
+	case 0: // SCC waveform, channel 4 and 5 share the same waveform
+		if (reg < 0x80) {
+			logRegisterWrite(port, reg, value, time);
+			setWave(reg >> 5);
+			if ((reg >> 5) == 3) setWave(4);
+		}
+		break;
+	case 4: // SCC+ waveform
+		if (reg < 0xA0) {
+			logRegisterWrite(port, reg, value, time);
+			setWave(reg >> 5);
+		}
+		break;
+	case 1: // frequency
+		if (reg < 0x0A) setFreqVol(reg, value, time);
+		break;
+	case 2: // volume
+		if (reg < 0x05) setFreqVol(0x0A + reg, value, time);
+		break;
+	case 3: // channel enable
+		setFreqVol(0x0F, value, time);
+		break;
+	case 5: // deformation
+		setDeformReg(value, time);
+		break;
+	}
+}
+
 inline float SCC::adjust(signed char wav, byte vol)
 {
 	// The result is an integer value, but we store it as a float because
@@ -353,12 +400,17 @@ inline float SCC::adjust(signed char wav, byte vol)
 	return float((int(wav) * vol) >> 4);
 }
 
-void SCC::writeWave(unsigned channel, unsigned address, byte value)
+void SCC::writeWave(unsigned channel, unsigned address, byte value,
+                    EmuTime::param time)
 {
 	// write to channel 5 only possible in SCC+ mode
 	assert(channel < 5);
 	assert((channel != 4) || (currentChipMode == SCC_plusmode));
 
+	// VGM uses port 0 for SCC waveform writes and port 4 for SCC+
+	logRegisterWrite((currentChipMode == SCC_plusmode) ? 4 : 0,
+	                 address, value, time);
+
 	if (!readOnly[channel]) {
 		unsigned p = address & 0x1F;
 		wave[channel][p] = value;
@@ -374,6 +426,14 @@ void SCC::writeWave(unsigned channel, unsigned address, byte value)
 void SCC::setFreqVol(unsigned address, byte value, EmuTime::param time)
 {
 	address &= 0x0F; // region is visible twice
+	if (address < 0x0A) {
+		logRegisterWrite(1, address, value, time);
+	} else if (address < 0x0F) {
+		logRegisterWrite(2, address - 0x0A, value, time);
+	} else {
+		logRegisterWrite(3, 0, value, time);
+	}
+
 	if (address < 0x0A) {
 		// change frequency
 		unsigned channel = address / 2;
@@ -419,6 +479,7 @@ void SCC::setDeformReg(byte value, EmuTime::param time)
 	if (value == deformValue) {
 		return;
 	}
+	logRegisterWrite(5, 0, value, time);
 	deformTimer.advance(time);
 	setDeformRegHelper(value);
 }
@@ -466,6 +527,7 @@ void SCC::setDeformRegHelper(byte value)
 void SCC::generateChannels(float** bufs, unsigned num)
 {
 	unsigned enable = ch_enable;
+	bool allMuted = true;
 	for (unsigned i = 0; i < 5; ++i, enable >>= 1) {
 		if ((enable & 1) && (volume[i] || out[i])) {
 			auto out2 = out[i];
@@ -473,12 +535,42 @@ void SCC::generateChannels(float** bufs, unsigned num)
 			unsigned pos2 = pos[i];
 			unsigned incr2 = incr[i];
 			unsigned period2 = period[i] + 1;
-			for (unsigned j = 0; j < num; ++j) {
-				bufs[i][j] += out2;
-				count2 += incr2;
-				// Note: only for very small periods
-				//       this will take more than 1 iteration
-				while (unlikely(count2 >= period2)) {
+			auto* buf = bufs[i];
+			assert(count2 < period2);
+			if (incr2 == 0) {
+				// frequency too high: output doesn't change
+				addFill(buf, out2, num);
+			} else if (period2 <= 32) {
+				// (very) high frequency: next waveform byte in
+				// every sample
+				assert(incr2 == 32);
+				for (unsigned j = 0; j < num; ++j) {
+					buf[j] += out2;
+					count2 += 32;
+					// Note: only for very small periods
+					//       this will take more than 1 iteration
+					while (count2 >= period2) {
+						count2 -= period2;
+						pos2 = (pos2 + 1) % 32;
+						out2 = volAdjustedWave[i][pos2];
+					}
+				}
+			} else {
+				// Output remains constant for several samples,
+				// calculate the length of such a run upfront.
+				assert(incr2 == 32);
+				unsigned remaining = num;
+				while (remaining != 0) {
+					unsigned n = (period2 - count2 + 31) / 32;
+					if (n > remaining) {
+						addFill(buf, out2, remaining);
+						count2 += remaining * 32;
+						break;
+					}
+					addFill(buf, out2, n);
+					remaining -= n;
+					count2 += n * 32;
+					// only one step, because period2 > 32
 					count2 -= period2;
 					pos2 = (pos2 + 1) % 32;
 					out2 = volAdjustedWave[i][pos2];
@@ -487,16 +579,34 @@ void SCC::generateChannels(float** bufs, unsigned num)
 			out[i] = out2;
 			count[i] = count2;
 			pos[i] = pos2;
+			allMuted = false;
 		} else {
 			bufs[i] = nullptr; // channel muted
-			// Update phase counter.
-			unsigned newCount = count[i] + num * incr[i];
-			count[i] = newCount % (period[i] + 1);
-			pos[i] = (pos[i] + newCount / (period[i] + 1)) % 32;
-			// Channel stays off until next waveform index.
-			out[i] = 0.0f;
+			advanceMuted(i, num);
 		}
 	}
+	if (allMuted) {
+		// Remains muted until the next register write (the phase
+		// counters are updated via advanceIdle()).
+		setIdle();
+	}
+}
+
+void SCC::advanceMuted(unsigned channel, unsigned num)
+{
+	// Update phase counter.
+	unsigned newCount = count[channel] + num * incr[channel];
+	count[channel] = newCount % (period[channel] + 1);
+	pos[channel] = (pos[channel] + newCount / (period[channel] + 1)) % 32;
+	// Channel stays off until next waveform index.
+	out[channel] = 0.0f;
+}
+
+void SCC::advanceIdle(unsigned num)
+{
+	for (unsigned i = 0; i < 5; ++i) {
+		advanceMuted(i, num);
+	}
 }
 
 
@@ -528,9 +638,10 @@ byte SCC::Debuggable::read(unsigned address, EmuTime::param time)
 void SCC::Debuggable::write(unsigned address, byte value, EmuTime::param time)
 {
 	auto& scc = OUTER(SCC, debuggable);
+	scc.updateStream(time); // also ends the idle state
 	if (address < 0xA0) {
 		// read wave form 1..5
-		scc.writeWave(address >> 5, address, value);
+		scc.writeWave(address >> 5, address, value, time);
 	} else if (address < 0xC0) {
 		// freq volume block
 		scc.setFreqVol(address, value, time);
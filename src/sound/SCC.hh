@@ -32,10 +32,16 @@ private:
 	// SoundDevice
 	float getAmplificationFactorImpl() const override;
 	void generateChannels(float** bufs, unsigned num) override;
+	void advanceIdle(unsigned num) override;
+	void advanceMuted(unsigned channel, unsigned num);
+	std::optional<RegisterLogger::Chip> getRegisterLogChip() const override;
+	void replayRegisterWrite(uint8_t port, uint8_t reg, uint8_t value,
+	                         EmuTime::param time) override;
 
 	inline float adjust(signed char wav, byte vol);
 	byte readWave(unsigned channel, unsigned address, EmuTime::param time) const;
-	void writeWave(unsigned channel, unsigned address, byte value);
+	void writeWave(unsigned channel, unsigned address, byte value,
+	               EmuTime::param time);
 	void setDeformReg(byte value, EmuTime::param time);
 	void setDeformRegHelper(byte value);
 	void setFreqVol(unsigned address, byte value, EmuTime::param time);
@@ -13,9 +13,22 @@
 
 namespace openmsx {
 
+// Smoothing factor for the measured fill level (per uploadBuffer() call).
+constexpr double FILL_SMOOTHING = 1.0 / 32;
+// Rate correction per unit of relative fill error, and its maximum.
+constexpr double RATE_GAIN = 0.02;
+constexpr double MAX_RATE_ADJUST = 0.005;
+// Lower the target fill level after this long without underruns.
+constexpr uint64_t DECREASE_INTERVAL = 10 * 1000 * 1000; // 10s in us
+
 SDLSoundDriver::SDLSoundDriver(Reactor& reactor_,
                                unsigned wantedFreq, unsigned wantedSamples)
 	: reactor(reactor_)
+	, rateBufferSize(0)
+	, rateAdjust(1.0)
+	, seenUnderruns(0)
+	, droppedSamples(0)
+	, underruns(0)
 	, muted(true)
 {
 	SDL_AudioSpec desired;
@@ -34,10 +47,17 @@ SDLSoundDriver::SDLSoundDriver(Reactor& reactor_,
 	}
 
 	frequency = obtained.freq;
-	fragmentSize = obtained.samples;
+	callbackSize = obtained.samples;
+	// Deliver in smaller pieces than SDL requests them, so that the fill
+	// level doesn't need a full callback buffer worth of headroom.
+	fragmentSize = std::max(64u, callbackSize / 2);
+
+	// The audio callback takes 'callbackSize' samples at once, so aim to
+	// have (a bit more than) that much buffered.
+	targetFill = callbackSize + callbackSize / 2;
+	lastUnderrunTime = Timer::getTime();
 
-	mixBufferSize = 3 * (obtained.size / sizeof(float)) + 2;
-	mixBuffer.resize(mixBufferSize);
+	ring.resize(2 * 4 * callbackSize); // stereo
 	reInit();
 }
 
@@ -48,10 +68,24 @@ SDLSoundDriver::~SDLSoundDriver()
 
 void SDLSoundDriver::reInit()
 {
-	SDL_LockAudioDevice(deviceID);
-	readIdx  = 0;
-	writeIdx = 0;
-	SDL_UnlockAudioDevice(deviceID);
+	// Only called while the audio device is paused, so the audio callback
+	// doesn't access the ring buffer.
+	ring.clear();
+	pushSilence(targetFill);
+	avgFill = targetFill;
+	rateAdjust = 1.0;
+	resamplePos = 1.0;
+	lastFrame[0] = lastFrame[1] = 0.0f;
+}
+
+void SDLSoundDriver::pushSilence(unsigned num)
+{
+	float zeros[2 * 64] = {};
+	while (num) {
+		unsigned n = std::min(num, 64u);
+		if (ring.push(zeros, 2 * n) != 2 * n) break; // full
+		num -= n;
+	}
 }
 
 void SDLSoundDriver::mute()
@@ -88,81 +122,110 @@ void SDLSoundDriver::audioCallbackHelper(void* userdata, uint8_t* strm, int len)
 		audioCallback(reinterpret_cast<float*>(strm), len / sizeof(float));
 }
 
-unsigned SDLSoundDriver::getBufferFilled() const
+void SDLSoundDriver::audioCallback(float* stream, unsigned len)
 {
-	int result = writeIdx - readIdx;
-	if (result < 0) result += mixBufferSize;
-	assert((0 <= result) && (unsigned(result) < mixBufferSize));
-	return result;
+	assert((len & 1) == 0); // stereo
+	unsigned num = ring.pop(stream, len);
+	if (num < len) {
+		// buffer underrun
+		memset(&stream[num], 0, (len - num) * sizeof(float));
+		underruns.fetch_add(1, std::memory_order_relaxed);
+	}
 }
 
-unsigned SDLSoundDriver::getBufferFree() const
+void SDLSoundDriver::updateTarget()
 {
-	// we can't distinguish completely filled from completely empty
-	// (in both cases readIx would be equal to writeIdx), so instead
-	// we define full as '(writeIdx + 2) == readIdx' (note that index
-	// increases in steps of 2 (stereo)).
-	int result = mixBufferSize - 2 - getBufferFilled();
-	assert((0 <= result) && (unsigned(result) < mixBufferSize));
-	return result;
+	auto now = Timer::getTime();
+	auto u = underruns.load(std::memory_order_relaxed);
+	if (u != seenUnderruns) {
+		// We ran dry, buffer more from now on. And refill right away,
+		// rate control alone would take several seconds.
+		seenUnderruns = u;
+		targetFill = std::min(targetFill + callbackSize / 4, 3 * callbackSize);
+		lastUnderrunTime = now;
+		auto fill = unsigned(ring.size() / 2);
+		if (fill < targetFill) pushSilence(targetFill - fill);
+		avgFill = targetFill;
+	} else if ((now - lastUnderrunTime) > DECREASE_INTERVAL) {
+		// Stable for a while, try with a bit less latency.
+		targetFill = std::max(targetFill - callbackSize / 8, callbackSize);
+		lastUnderrunTime = now;
+	}
 }
 
-void SDLSoundDriver::audioCallback(float* stream, unsigned len)
+unsigned SDLSoundDriver::adjustRate(const float* buffer, unsigned len)
 {
-	assert((len & 1) == 0); // stereo
-	unsigned available = getBufferFilled();
-	unsigned num = std::min(len, available);
-	if ((readIdx + num) < mixBufferSize) {
-		memcpy(stream, &mixBuffer[readIdx], num * sizeof(float));
-		readIdx += num;
-	} else {
-		unsigned len1 = mixBufferSize - readIdx;
-		memcpy(stream, &mixBuffer[readIdx], len1 * sizeof(float));
-		unsigned len2 = num - len1;
-		memcpy(&stream[len1], &mixBuffer[0], len2 * sizeof(float));
-		readIdx = len2;
+	// Nudge the rate so that the (smoothed) fill level moves towards the
+	// target. The fill level itself jumps by 'callbackSize' each time the
+	// audio callback runs, the smoothing takes that out.
+	auto fill = double(ring.size() / 2);
+	avgFill += (fill - avgFill) * FILL_SMOOTHING;
+	double error = (avgFill - targetFill) / targetFill;
+	rateAdjust = 1.0 - std::clamp(error * RATE_GAIN, -MAX_RATE_ADJUST, MAX_RATE_ADJUST);
+
+	unsigned maxOut = len + len / 128 + 2; // rateAdjust <= 1.005
+	if (maxOut > rateBufferSize) {
+		rateBufferSize = maxOut;
+		rateBuffer.resize(2 * rateBufferSize);
 	}
-	int missing = len - available;
-	if (missing > 0) {
-		// buffer underrun
-		memset(&stream[available], 0, missing * sizeof(float));
+
+	// Linear interpolation. Position 0 is 'lastFrame' (the last sample of
+	// the previous call), position 'i + 1' is 'buffer[i]'. So with
+	// rateAdjust == 1.0 this is an exact copy.
+	double step = 1.0 / rateAdjust;
+	double pos = resamplePos;
+	float* out = rateBuffer.data();
+	unsigned num = 0;
+	while (pos < len) {
+		auto idx = unsigned(pos);
+		auto frac = float(pos - idx);
+		const float* b = &buffer[2 * idx];
+		const float* a = idx ? (b - 2) : lastFrame;
+		out[2 * num + 0] = a[0] + (b[0] - a[0]) * frac;
+		out[2 * num + 1] = a[1] + (b[1] - a[1]) * frac;
+		++num;
+		pos += step;
 	}
+	assert(num <= maxOut);
+	resamplePos = pos - len;
+	if (len) {
+		lastFrame[0] = buffer[2 * len - 2];
+		lastFrame[1] = buffer[2 * len - 1];
+	}
+	return num;
 }
 
 void SDLSoundDriver::uploadBuffer(float* buffer, unsigned len)
 {
-	SDL_LockAudioDevice(deviceID);
-	len *= 2; // stereo
-	unsigned free = getBufferFree();
-	if (len > free) {
+	updateTarget();
+	unsigned num = 2 * adjustRate(buffer, len); // stereo
+	const float* data = rateBuffer.data();
+	unsigned pushed = ring.push(data, num);
+	if (pushed < num) {
 		auto* board = reactor.getMotherBoard();
 		if (board && !board->getMSXMixer().isSynchronousMode() && // when not recording
 		    reactor.getGlobalSettings().getThrottleManager().isThrottled()) {
 			do {
-				SDL_UnlockAudioDevice(deviceID);
 				Timer::sleep(5000); // 5ms
-				SDL_LockAudioDevice(deviceID);
 				board->getRealTime().resync();
-				free = getBufferFree();
-			} while (len > free);
+				pushed += ring.push(data + pushed, num - pushed);
+			} while (pushed < num);
 		} else {
 			// drop excess samples
-			len = free;
+			droppedSamples += (num - pushed) / 2;
 		}
 	}
-	assert(len <= free);
-	if ((writeIdx + len) < mixBufferSize) {
-		memcpy(&mixBuffer[writeIdx], buffer, len * sizeof(float));
-		writeIdx += len;
-	} else {
-		unsigned len1 = mixBufferSize - writeIdx;
-		memcpy(&mixBuffer[writeIdx], buffer, len1 * sizeof(float));
-		unsigned len2 = len - len1;
-		memcpy(&mixBuffer[0], &buffer[len1], len2 * sizeof(float));
-		writeIdx = len2;
-	}
+}
 
-	SDL_UnlockAudioDevice(deviceID);
+SoundDriver::Statistics SDLSoundDriver::getStatistics() const
+{
+	Statistics result;
+	result.underruns = underruns.load(std::memory_order_relaxed);
+	result.droppedSamples = droppedSamples;
+	result.bufferedSamples = unsigned(ring.size() / 2);
+	result.targetSamples = targetFill;
+	result.rateAdjust = rateAdjust;
+	return result;
 }
 
 } // namespace openmsx
@@ -3,13 +3,29 @@
 
 #include "SoundDriver.hh"
 #include "SDLSurfacePtr.hh"
+#include "SPSCRingBuffer.hh"
 #include "MemBuffer.hh"
 #include <SDL.h>
+#include <atomic>
+#include <cstdint>
 
 namespace openmsx {
 
 class Reactor;
 
+/** Sound output via SDL.
+  *
+  * The emulation thread (producer) and the SDL audio callback (consumer)
+  * communicate via a lock-free ring buffer. The emulation and the sound
+  * card each run on their own clock, so the fill level of that buffer slowly
+  * drifts. Instead of only reacting when the buffer is completely empty
+  * (underrun, audible click) or completely full (dropped samples), the input
+  * is resampled by a tiny amount (at most +/- 0.5%, inaudible) to keep the
+  * fill level close to a target. That target starts low (low latency) and
+  * is raised on each underrun (and slowly lowered again when there are no
+  * more underruns). After an underrun (and when (re)starting the output) the
+  * buffer is immediately padded with silence up to the target level.
+  */
 class SDLSoundDriver final : public SoundDriver
 {
 public:
@@ -27,20 +43,38 @@ public:
 
 	void uploadBuffer(float* buffer, unsigned len) override;
 
+	Statistics getStatistics() const override;
+
 private:
 	void reInit();
-	unsigned getBufferFilled() const;
-	unsigned getBufferFree() const;
+	void pushSilence(unsigned num);
+	void updateTarget();
+	unsigned adjustRate(const float* buffer, unsigned len);
 	static void audioCallbackHelper(void* userdata, uint8_t* strm, int len);
 	void audioCallback(float* stream, unsigned len);
 
 	Reactor& reactor;
 	SDL_AudioDeviceID deviceID;
-	MemBuffer<float> mixBuffer;
-	unsigned mixBufferSize;
+	SPSCRingBuffer<float> ring; // interleaved stereo
+	MemBuffer<float> rateBuffer; // output of adjustRate()
+	unsigned rateBufferSize; // in stereo samples
 	unsigned frequency;
+	unsigned callbackSize; // in stereo samples
 	unsigned fragmentSize;
-	unsigned readIdx, writeIdx;
+
+	// Rate control, only accessed from the emulation thread.
+	double avgFill;     // smoothed fill level of 'ring', in stereo samples
+	double rateAdjust;  // output/input ratio, close to 1.0
+	double resamplePos; // position relative to 'lastFrame', see adjustRate()
+	float lastFrame[2];
+	unsigned targetFill; // in stereo samples
+	uint64_t lastUnderrunTime; // in us
+	unsigned seenUnderruns;
+	unsigned droppedSamples;
+
+	// Written by the audio callback.
+	std::atomic<unsigned> underruns;
+
 	bool muted;
 	SDLSubSystemInitializer<SDL_INIT_AUDIO> audioInitializer;
 };
@@ -2,7 +2,7 @@
 #include "MSXMixer.hh"
 #include "DeviceConfig.hh"
 #include "XMLElement.hh"
-#include "WavWriter.hh"
+#include "AsyncWavWriter.hh"
 #include "Filename.hh"
 #include "StringOp.hh"
 #include "MemoryOps.hh"
@@ -14,14 +14,17 @@
 #include "vla.hh"
 #include "xrange.hh"
 #include <cassert>
+#include <chrono>
 #include <memory>
+#include <utility>
 
 using std::string;
 
 namespace openmsx {
 
-static MemBuffer<float, SSE2_ALIGNMENT> mixBuffer;
-static unsigned mixBufferSize = 0;
+// Per thread, because the mixer can generate several sound devices in parallel.
+static thread_local MemBuffer<float, SSE2_ALIGNMENT> mixBuffer;
+static thread_local unsigned mixBufferSize = 0;
 
 static void allocateMixBuffer(unsigned size)
 {
@@ -137,6 +140,62 @@ void SoundDevice::unregisterSound()
 void SoundDevice::updateStream(EmuTime::param time)
 {
 	mixer.updateStream(time);
+	idle = false;
+}
+
+void SoundDevice::advanceIdle(unsigned /*num*/)
+{
+}
+
+std::optional<RegisterLogger::Chip> SoundDevice::getRegisterLogChip() const
+{
+	return {};
+}
+
+void SoundDevice::replayRegisterWrite(
+	uint8_t /*port*/, uint8_t /*reg*/, uint8_t /*value*/, EmuTime::param /*time*/)
+{
+}
+
+span<const uint8_t> SoundDevice::getSampleMemory() const
+{
+	return {};
+}
+
+void SoundDevice::setSampleMemory(span<const uint8_t> /*data*/)
+{
+}
+
+static uint64_t getNanoTime()
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(
+		steady_clock::now().time_since_epoch()).count();
+}
+
+bool SoundDevice::timedUpdateBuffer(unsigned length, float* buffer,
+                                    EmuTime::param time)
+{
+	auto start = getNanoTime();
+	bool result = updateBuffer(length, buffer, time);
+	statistics.updateTime += getNanoTime() - start;
+	if (length) {
+		++statistics.fragments;
+		statistics.outputSamples += length;
+		if (!result) ++statistics.silentFragments;
+	}
+	return result;
+}
+
+void SoundDevice::skipChannels(unsigned samples)
+{
+	statistics.idleSamples += samples;
+	advanceIdle(samples);
+	for (unsigned i = 0; i < numChannels; ++i) {
+		if (writer[i]) {
+			writer[i]->writeSilence(stereo, samples);
+		}
+	}
 }
 
 void SoundDevice::setSoftwareVolume(float volume, EmuTime::param time)
@@ -156,12 +215,12 @@ void SoundDevice::recordChannel(unsigned channel, const Filename& filename)
 {
 	assert(channel < numChannels);
 	bool wasRecording = writer[channel] != nullptr;
+	std::unique_ptr<AsyncWavWriter> newWriter;
 	if (!filename.empty()) {
-		writer[channel] = std::make_unique<Wav16Writer>(
+		newWriter = std::make_unique<AsyncWavWriter>(
 			filename, stereo, inputSampleRate);
-	} else {
-		writer[channel].reset();
 	}
+	auto oldWriter = std::exchange(writer[channel], std::move(newWriter));
 	bool recording = writer[channel] != nullptr;
 	if (recording != wasRecording) {
 		if (recording) {
@@ -178,6 +237,10 @@ void SoundDevice::recordChannel(unsigned channel, const Filename& filename)
 			}
 		}
 	}
+	if (oldWriter) {
+		// Waits till everything is written, reports write errors.
+		oldWriter->close();
+	}
 }
 
 void SoundDevice::muteChannel(unsigned channel, bool muted)
@@ -192,6 +255,10 @@ bool SoundDevice::mixChannels(float* dataOut, unsigned samples)
 	assert((uintptr_t(dataOut) & 15) == 0); // must be 16-byte aligned
 #endif
 	if (samples == 0) return true;
+	if (idle) {
+		skipChannels(samples);
+		return false;
+	}
 	unsigned outputStereo = isStereo() ? 2 : 1;
 
 	static_assert(sizeof(float) == sizeof(uint32_t));
@@ -235,7 +302,10 @@ bool SoundDevice::mixChannels(float* dataOut, unsigned samples)
 		assert(count == separateChannels);
 	}
 
+	auto start = getNanoTime();
 	generateChannels(bufs, samples);
+	statistics.synthesisTime += getNanoTime() - start;
+	statistics.inputSamples += samples;
 
 	if (separateChannels == 0) {
 		return ranges::any_of(xrange(numChannels),
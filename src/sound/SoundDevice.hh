@@ -2,14 +2,19 @@
 #define SOUNDDEVICE_HH
 
 #include "MSXMixer.hh"
+#include "RegisterLogger.hh"
 #include "EmuTime.hh"
+#include "likely.hh"
+#include "span.hh"
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string_view>
 
 namespace openmsx {
 
 class DeviceConfig;
-class Wav16Writer;
+class AsyncWavWriter;
 class Filename;
 class DynamicClock;
 
@@ -66,6 +71,53 @@ public:
 	void recordChannel(unsigned channel, const Filename& filename);
 	void muteChannel  (unsigned channel, bool muted);
 
+	/** Is this sound device idle? See setIdle(). */
+	bool isIdle() const { return idle; }
+
+	/** Which chip this is for register logging, or std::nullopt when this
+	  * device doesn't support register logging (the default).
+	  */
+	virtual std::optional<RegisterLogger::Chip> getRegisterLogChip() const;
+
+	/** Send all register writes of this device to the given logger (or
+	  * stop logging when nullptr).
+	  */
+	void setRegisterLogger(RegisterLogger* logger) { registerLogger = logger; }
+
+	/** Redo a register write that was earlier passed to a RegisterLogger.
+	  * The default implementation does nothing.
+	  */
+	virtual void replayRegisterWrite(uint8_t port, uint8_t reg, uint8_t value,
+	                                 EmuTime::param time);
+
+	/** Chips that play samples from their own memory (e.g. Y8950 ADPCM RAM)
+	  * expose that memory here, so that it can be stored together with
+	  * a register log. The default has no sample memory.
+	  */
+	virtual span<const uint8_t> getSampleMemory() const;
+	virtual void setSampleMemory(span<const uint8_t> data);
+
+	/** Some numbers about the cost of this sound device. All values are
+	  * totals since the creation of the device. Times are in nanoseconds.
+	  */
+	struct Statistics {
+		uint64_t fragments = 0;       // updateBuffer() calls (with samples)
+		uint64_t silentFragments = 0; // ... that produced silence
+		uint64_t outputSamples = 0;   // at the host sample rate
+		uint64_t inputSamples = 0;    // generated by generateChannels()
+		uint64_t idleSamples = 0;     // skipped because the device was idle
+		uint64_t updateTime = 0;      // total time in updateBuffer()
+		uint64_t synthesisTime = 0;   // time in generateChannels()
+	};
+	const Statistics& getStatistics() const { return statistics; }
+
+	/** Calls updateBuffer() and updates the statistics. Used by MSXMixer.
+	  * Note: with 'sound_parallel' enabled this is called concurrently
+	  * for different sound devices, that's fine because each device only
+	  * updates its own statistics.
+	  */
+	bool timedUpdateBuffer(unsigned length, float* buffer, EmuTime::param time);
+
 protected:
 	/** Constructor.
 	  * @param mixer The Mixer object
@@ -103,9 +155,30 @@ protected:
 	 */
 	void unregisterSound();
 
-	/** @see Mixer::updateStream */
+	/** @see Mixer::updateStream
+	  * This also ends the idle state, see setIdle().
+	  */
 	void updateStream(EmuTime::param time);
 
+	/** Declare this sound device idle: its output remains silent until
+	  * the next register write. Sound devices call updateStream() right
+	  * before each register write, so that call ends the idle state.
+	  *
+	  * While idle, generateChannels() is not called anymore (instead
+	  * advanceIdle() is), and once the resampler has no more pending
+	  * output, also the resampling is skipped. Typically this method is
+	  * called from generateChannels() when it detects that all channels
+	  * are (and will remain) silent.
+	  */
+	void setIdle() { idle = true; }
+
+	/** Called instead of generateChannels() while this device is idle.
+	  * Should update the state that keeps changing even when the output
+	  * is silent (e.g. phase counters). The default does nothing.
+	  * @param num The number of (skipped) samples.
+	  */
+	virtual void advanceIdle(unsigned num);
+
 	void setInputRate(unsigned sampleRate) { inputSampleRate = sampleRate; }
 	unsigned getInputRate() const { return inputSampleRate; }
 
@@ -134,6 +207,10 @@ public: // Will be called by Mixer:
 	  * fill the output buffer with up to 3 extra samples. Those extra
 	  * samples should be ignored, though the caller must make sure the
 	  * buffer has enough space to hold them.
+	  *
+	  * Note: With the 'sound_parallel' setting enabled, this method is
+	  * called concurrently for different sound devices. So it should
+	  * only modify state that belongs to this sound device.
 	  */
 	virtual bool updateBuffer(unsigned length, float* buffer,
 	                          EmuTime::param time) = 0;
@@ -178,6 +255,21 @@ protected:
 	  */
 	bool mixChannels(float* dataOut, unsigned samples);
 
+	/** Like mixChannels(), but for an idle device: calls advanceIdle()
+	  * and records silence for the recorded channels.
+	  */
+	void skipChannels(unsigned samples);
+
+	/** Must be called for each register write, when register logging is
+	  * supported (see getRegisterLogChip()).
+	  */
+	void logRegisterWrite(uint8_t port, uint8_t reg, uint8_t value,
+	                      EmuTime::param time) {
+		if (unlikely(registerLogger != nullptr)) {
+			registerLogger->write(*this, port, reg, value, time);
+		}
+	}
+
 	/** See MSXMixer::getHostSampleClock(). */
 	const DynamicClock& getHostSampleClock() const;
 	double getEffectiveSpeed() const;
@@ -187,7 +279,9 @@ private:
 	const std::string name;
 	const std::string description;
 
-	std::unique_ptr<Wav16Writer> writer[MAX_CHANNELS];
+	std::unique_ptr<AsyncWavWriter> writer[MAX_CHANNELS];
+	RegisterLogger* registerLogger = nullptr;
+	Statistics statistics;
 
 	float softwareVolumeLeft = 1.0f;
 	float softwareVolumeRight = 1.0f;
@@ -198,6 +292,7 @@ private:
 	int channelBalance[MAX_CHANNELS];
 	bool channelMuted[MAX_CHANNELS];
 	bool balanceCenter;
+	bool idle = false;
 };
 
 } // namespace openmsx
@@ -6,6 +6,17 @@ namespace openmsx {
 class SoundDriver
 {
 public:
+	/** Some numbers about the (health of the) output buffer, see
+	  * getStatistics(). All sizes are in stereo samples.
+	  */
+	struct Statistics {
+		unsigned underruns = 0;      // number of times the output ran dry
+		unsigned droppedSamples = 0; // because the buffer was full
+		unsigned bufferedSamples = 0;
+		unsigned targetSamples = 0;  // the fill level the driver aims for
+		double rateAdjust = 1.0;     // output/input sample rate correction
+	};
+
 	virtual ~SoundDriver() = default;
 
 	/** Mute the sound system
@@ -28,6 +39,11 @@ public:
 
 	virtual void uploadBuffer(float* buffer, unsigned len) = 0;
 
+	/** Statistics about the output buffer. Drivers that don't buffer
+	  * (e.g. the null driver) return the default values.
+	  */
+	virtual Statistics getStatistics() const { return {}; }
+
 protected:
 	SoundDriver() = default;
 };
@@ -239,6 +239,7 @@ void VLM5030::generateChannels(float** bufs, unsigned num)
 	// Single channel device: replace content of bufs[0] (not add to it).
 	if (phase == PH_IDLE) {
 		bufs[0] = nullptr;
+		setIdle(); // until the next writeControl()
 		return;
 	}
 
@@ -307,8 +308,8 @@ void VLM5030::generateChannels(float** bufs, unsigned num)
 				current_val = 0x00;
 			} else if (old_pitch <= 1) {
 				// generate unvoiced samples here
-				current_val = random_bool() ?  int(current_energy)
-				                            : -int(current_energy);
+				current_val = (noiseGenerator() & 1) ?  int(current_energy)
+				                                     : -int(current_energy);
 			} else {
 				// generate voiced samples here
 				current_val = (pitch_count == 0) ? current_energy : 0;
@@ -527,6 +528,7 @@ VLM5030::VLM5030(const std::string& name_, const std::string& desc,
                  const std::string& romFilename, const DeviceConfig& config)
 	: ResampledSoundDevice(config.getMotherBoard(), name_, desc, 1, INPUT_RATE, false)
 	, rom(name_ + " ROM", "rom", DeviceConfig(config, getRomConfig(name_, romFilename)))
+	, noiseGenerator(random_32bit())
 {
 	// reset input pins
 	pin_RST = pin_ST = pin_VCU = false;
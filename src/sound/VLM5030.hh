@@ -5,6 +5,7 @@
 #include "Rom.hh"
 #include "EmuTime.hh"
 #include "openmsx.hh"
+#include <random>
 #include <string>
 
 namespace openmsx {
@@ -76,6 +77,10 @@ private:
 	byte sample_count; // sample number within interp
 	byte pitch_count;
 
+	// for the unvoiced samples, not shared with other sound devices (those
+	// may be generated concurrently, see 'sound_parallel')
+	std::minstd_rand0 noiseGenerator;
+
 	byte latch_data;
 	byte parameter;
 	byte phase;
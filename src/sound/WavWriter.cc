@@ -1,6 +1,5 @@
 #include "WavWriter.hh"
 #include "MSXException.hh"
-#include "Math.hh"
 #include "endian.hh"
 #include "one_of.hh"
 #include "vla.hh"
@@ -101,32 +100,6 @@ void Wav16Writer::write(const int16_t* buffer, unsigned samples)
 	bytes += size;
 }
 
-static int16_t float2int16(float f)
-{
-	return Math::clipIntToShort(lrintf(32768.0f * f));
-}
-
-void Wav16Writer::write(const float* buffer, unsigned stereo, unsigned samples,
-                        float ampLeft, float ampRight)
-{
-	assert(stereo == one_of(1u, 2u));
-	std::vector<Endian::L16> buf(samples * stereo);
-	if (stereo == 1) {
-		assert(ampLeft == ampRight);
-		for (unsigned i = 0; i < samples; ++i) {
-			buf[i] = float2int16(buffer[i] * ampLeft);
-		}
-	} else {
-		for (unsigned i = 0; i < samples; ++i) {
-			buf[2 * i + 0] = float2int16(buffer[2 * i + 0] * ampLeft);
-			buf[2 * i + 0] = float2int16(buffer[2 * i + 0] * ampRight);
-		}
-	}
-	unsigned size = sizeof(int16_t) * samples * stereo;
-	file.write(buf.data(), size);
-	bytes += size;
-}
-
 void Wav16Writer::writeSilence(unsigned samples)
 {
 	VLA(int16_t, buf, samples);
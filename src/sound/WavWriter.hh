@@ -62,8 +62,6 @@ public:
 		assert(stereo == one_of(1u, 2u));
 		write(buffer, stereo * samples);
 	}
-	void write(const float* buffer, unsigned stereo, unsigned samples,
-	           float ampLeft, float ampRight);
 	void writeSilence(unsigned stereo, unsigned samples) {
 		assert(stereo == one_of(1u, 2u));
 		writeSilence(stereo * samples);
@@ -804,6 +804,27 @@ float Y8950::getAmplificationFactorImpl() const
 	return 1.0f / (1 << DB2LIN_AMP_BITS);
 }
 
+std::optional<RegisterLogger::Chip> Y8950::getRegisterLogChip() const
+{
+	return RegisterLogger::Chip::Y8950;
+}
+
+void Y8950::replayRegisterWrite(uint8_t port, uint8_t rg, uint8_t value,
+                                EmuTime::param time)
+{
+	if (port == 0) writeReg(rg, value, time);
+}
+
+span<const uint8_t> Y8950::getSampleMemory() const
+{
+	return adpcm.getRam();
+}
+
+void Y8950::setSampleMemory(span<const uint8_t> data)
+{
+	adpcm.setRam(data);
+}
+
 void Y8950::setEnabled(bool enabled_, EmuTime::param time)
 {
 	updateStream(time);
@@ -843,6 +864,8 @@ void Y8950::generateChannels(float** bufs, unsigned num)
 		for (int i = 0; i < 9 + 5 + 1; ++i) {
 			bufs[i] = nullptr;
 		}
+		// remains muted until the next register write
+		setIdle();
 		return;
 	}
 
@@ -944,6 +967,7 @@ void Y8950::writeReg(byte rg, byte data, EmuTime::param time)
 		// update the output buffer before changing the register
 		updateStream(time);
 	//}
+	logRegisterWrite(0, rg, data, time);
 
 	switch (rg & 0xe0) {
 	case 0x00: {
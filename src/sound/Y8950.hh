@@ -76,6 +76,11 @@ private:
 	// SoundDevice
 	float getAmplificationFactorImpl() const override;
 	void generateChannels(float** bufs, unsigned num) override;
+	std::optional<RegisterLogger::Chip> getRegisterLogChip() const override;
+	void replayRegisterWrite(uint8_t port, uint8_t reg, uint8_t value,
+	                         EmuTime::param time) override;
+	span<const uint8_t> getSampleMemory() const override;
+	void setSampleMemory(span<const uint8_t> data) override;
 
 	inline void keyOn_BD();
 	inline void keyOn_SD();
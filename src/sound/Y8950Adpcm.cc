@@ -15,6 +15,8 @@
 #include "MSXMotherBoard.hh"
 #include "Math.hh"
 #include "serialize.hh"
+#include <algorithm>
+#include <cstring>
 
 namespace openmsx {
 
@@ -59,6 +61,19 @@ void Y8950Adpcm::clearRam()
 	ram.clear(0xFF);
 }
 
+span<const byte> Y8950Adpcm::getRam() const
+{
+	if (ram.getSize() == 0) return {};
+	return {&ram[0], ram.getSize()};
+}
+
+void Y8950Adpcm::setRam(span<const byte> data)
+{
+	auto size = std::min<size_t>(data.size(), ram.getSize());
+	if (size == 0) return;
+	memcpy(ram.getWriteBackdoor(), data.data(), size);
+}
+
 void Y8950Adpcm::reset(EmuTime::param time)
 {
 	removeSyncPoint();
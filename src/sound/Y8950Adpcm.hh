@@ -6,6 +6,7 @@
 #include "Clock.hh"
 #include "serialize_meta.hh"
 #include "openmsx.hh"
+#include "span.hh"
 
 namespace openmsx {
 
@@ -28,6 +29,9 @@ public:
 	void sync(EmuTime::param time);
 	void resetStatus();
 
+	span<const byte> getRam() const;
+	void setRam(span<const byte> data);
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -617,6 +617,7 @@ void YM2151::refreshEG(YM2151Operator* op)
 void YM2151::writeReg(byte r, byte v, EmuTime::param time)
 {
 	updateStream(time);
+	logRegisterWrite(0, r, v, time);
 
 	YM2151Operator* op = &oper[(r & 0x07) * 4 + ((r & 0x18) >> 3)];
 
@@ -1450,6 +1451,17 @@ void YM2151::advance()
 	}
 }
 
+std::optional<RegisterLogger::Chip> YM2151::getRegisterLogChip() const
+{
+	return RegisterLogger::Chip::YM2151;
+}
+
+void YM2151::replayRegisterWrite(uint8_t port, uint8_t reg, uint8_t value,
+                                 EmuTime::param time)
+{
+	if (port == 0) writeReg(reg, value, time);
+}
+
 void YM2151::generateChannels(float** bufs, unsigned num)
 {
 	if (checkMuteHelper()) {
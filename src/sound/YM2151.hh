@@ -119,6 +119,9 @@ private:
 
 	// SoundDevice
 	void generateChannels(float** bufs, unsigned num) override;
+	std::optional<RegisterLogger::Chip> getRegisterLogChip() const override;
+	void replayRegisterWrite(uint8_t port, uint8_t reg, uint8_t value,
+	                         EmuTime::param time) override;
 
 	void callback(byte flag) override;
 	void setStatus(byte flags);
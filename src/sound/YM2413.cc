@@ -92,6 +92,12 @@ void YM2413::writePort(bool port, byte value, EmuTime::param time)
 	assert(offset < 18);
 
 	core->writePort(port, value, offset);
+
+	if (!port) {
+		registerLatch = value;
+	} else if (registerLatch < 0x40) {
+		logRegisterWrite(0, registerLatch, value, time);
+	}
 }
 
 void YM2413::pokeReg(byte reg, byte value, EmuTime::param time)
@@ -110,6 +116,22 @@ float YM2413::getAmplificationFactorImpl() const
 	return core->getAmplificationFactor();
 }
 
+std::optional<RegisterLogger::Chip> YM2413::getRegisterLogChip() const
+{
+	return RegisterLogger::Chip::YM2413;
+}
+
+void YM2413::replayRegisterWrite(uint8_t port, uint8_t reg, uint8_t value,
+                                 EmuTime::param time)
+{
+	// Go through the normal write pipeline (not pokeReg(), that's not
+	// supported by all cores).
+	if ((port == 0) && (reg < 0x40)) {
+		writePort(false, reg,   time);
+		writePort(true,  value, time);
+	}
+}
+
 
 template<typename Archive>
 void YM2413::serialize(Archive& ar, unsigned /*version*/)
@@ -29,8 +29,12 @@ private:
 	// SoundDevice
 	void generateChannels(float** bufs, unsigned num) override;
 	float getAmplificationFactorImpl() const override;
+	std::optional<RegisterLogger::Chip> getRegisterLogChip() const override;
+	void replayRegisterWrite(uint8_t port, uint8_t reg, uint8_t value,
+	                         EmuTime::param time) override;
 
 	const std::unique_ptr<YM2413Core> core;
+	byte registerLatch = 0; // only used for register logging
 
 	struct Debuggable final : SimpleDebuggable {
 		Debuggable(MSXMotherBoard& motherBoard, const std::string& name);
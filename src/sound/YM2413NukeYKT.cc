@@ -34,6 +34,7 @@
 #include "unreachable.hh"
 #include <algorithm>
 #include <cstring>
+#include <utility>
 
 namespace openmsx {
 namespace YM2413NukeYKT {
@@ -267,23 +268,28 @@ template<uint32_t CYCLES, bool TEST_MODE> ALWAYS_INLINE void YM2413::envelopeTim
 
 template<uint32_t CYCLES> ALWAYS_INLINE bool YM2413::envelopeGenerate1()
 {
-	int32_t level = eg_level[(CYCLES + 16) % 18];
-	bool prev2_eg_off   = eg_off[(CYCLES + 16) & 1];
-	bool prev2_eg_kon   = eg_kon[(CYCLES + 16) & 1];
-	bool prev2_eg_dokon = eg_dokon[(CYCLES + 16) % 18];
+	return envelopeGenerate((CYCLES + 16) % 18,
+	                        eg_off[(CYCLES + 16) & 1], eg_kon[(CYCLES + 16) & 1],
+	                        eg_sl[CYCLES & 1], eg_rate[(CYCLES + 16) & 1]);
+}
+
+// The inputs were latched by envelopeGenerate2(), two cycles earlier.
+ALWAYS_INLINE bool YM2413::envelopeGenerate(uint32_t slot, bool prev2_eg_off, bool prev2_eg_kon, uint8_t prev2_eg_sl, uint8_t prev2_rate)
+{
+	int32_t level = eg_level[slot];
+	bool prev2_eg_dokon = eg_dokon[slot];
 
-	auto state = eg_state[(CYCLES + 16) % 18];
+	auto state = eg_state[slot];
 	if (unlikely(prev2_eg_dokon)) {
-		eg_state[(CYCLES + 16) % 18] = EgState::attack;
+		eg_state[slot] = EgState::attack;
 	} else if (!prev2_eg_kon) {
-		eg_state[(CYCLES + 16) % 18] = EgState::release;
+		eg_state[slot] = EgState::release;
 	} else if (unlikely((state == EgState::attack) && (level == 0))) {
-		eg_state[(CYCLES + 16) % 18] = EgState::decay;
-	} else if (unlikely((state == EgState::decay) && ((level >> 3) == eg_sl[CYCLES & 1]))) {
-		eg_state[(CYCLES + 16) % 18] = EgState::sustain;
+		eg_state[slot] = EgState::decay;
+	} else if (unlikely((state == EgState::decay) && ((level >> 3) == prev2_eg_sl))) {
+		eg_state[slot] = EgState::sustain;
 	}
 
-	auto prev2_rate = eg_rate[(CYCLES + 16) & 1];
 	int32_t next_level
 	    = (state != EgState::attack && prev2_eg_off && !prev2_eg_dokon) ? 0x7f
 	    : ((prev2_rate >= 60) && prev2_eg_dokon)                        ? 0x00
@@ -296,7 +302,7 @@ template<uint32_t CYCLES> ALWAYS_INLINE bool YM2413::envelopeGenerate1()
 			}
 			break;
 		case EgState::decay:
-			if ((level >> 3) == eg_sl[CYCLES & 1]) return 0;
+			if ((level >> 3) == prev2_eg_sl) return 0;
 			[[fallthrough]];
 		case EgState::sustain:
 		case EgState::release:
@@ -309,11 +315,39 @@ template<uint32_t CYCLES> ALWAYS_INLINE bool YM2413::envelopeGenerate1()
 		}
 		return 0;
 	}();
-	eg_level[(CYCLES + 16) % 18] = next_level + step;
+	eg_level[slot] = next_level + step;
 
 	return level == 0x7f; // eg_silent
 }
 
+template<uint32_t CYCLES> ALWAYS_INLINE bool YM2413::envelopeKeyOn(bool use_rm_patches) const
+{
+	bool result = sk_on[CH_OFFSET[CYCLES]] & 1;
+	if (is_rm_cycle(CYCLES) && use_rm_patches) {
+		switch (rm_for_cycle(CYCLES)) {
+			case rm_num_bd0:
+			case rm_num_bd1:
+				result |= bool(rhythm & 0x10);
+				break;
+			case rm_num_sd:
+				result |= bool(rhythm & 0x08);
+				break;
+			case rm_num_tom:
+				result |= bool(rhythm & 0x04);
+				break;
+			case rm_num_tc:
+				result |= bool(rhythm & 0x02);
+				break;
+			case rm_num_hh:
+				result |= bool(rhythm & 0x01);
+				break;
+			default:
+				break; // suppress warning
+		}
+	}
+	return result;
+}
+
 template<uint32_t CYCLES> ALWAYS_INLINE void YM2413::envelopeGenerate2(const Patch& patch1, bool use_rm_patches)
 {
 	constexpr uint32_t mcsel = ((CYCLES + 1) / 3) & 1;
@@ -323,32 +357,7 @@ template<uint32_t CYCLES> ALWAYS_INLINE void YM2413::envelopeGenerate2(const Pat
 	eg_off[CYCLES & 1] = new_eg_off;
 
 	auto sk = sk_on[CH_OFFSET[CYCLES]];
-	bool new_eg_kon = [&]() {
-		bool result = sk & 1;
-		if (is_rm_cycle(CYCLES) && use_rm_patches) {
-			switch (rm_for_cycle(CYCLES)) {
-				case rm_num_bd0:
-				case rm_num_bd1:
-					result |= bool(rhythm & 0x10);
-					break;
-				case rm_num_sd:
-					result |= bool(rhythm & 0x08);
-					break;
-				case rm_num_tom:
-					result |= bool(rhythm & 0x04);
-					break;
-				case rm_num_tc:
-					result |= bool(rhythm & 0x02);
-					break;
-				case rm_num_hh:
-					result |= bool(rhythm & 0x01);
-					break;
-				default:
-					break; // suppress warning
-			}
-		}
-		return result;
-	}();
+	bool new_eg_kon = envelopeKeyOn<CYCLES>(use_rm_patches);
 	eg_kon[CYCLES & 1] = new_eg_kon;
 
 	// Calculate rate
@@ -622,6 +631,20 @@ void YM2413::doModeWrite(uint8_t address, uint8_t value)
 	}
 }
 
+static ALWAYS_INLINE int32_t operatorOutput(uint16_t prev2_phase, uint8_t prev2_eg_out, bool half_wave)
+{
+	uint8_t quarter = (prev2_phase & 0x100) ? ~prev2_phase : prev2_phase;
+	auto logsin = rom.logsin[quarter];
+	auto op_level = std::min(4095, logsin + (prev2_eg_out << 4));
+	uint32_t op_exp_m = rom.exp[op_level & 0xff];
+	auto  op_exp_s = op_level >> 8;
+	if (prev2_phase & 0x200) {
+		return unlikely(half_wave) ? ~0 : ~(op_exp_m >> op_exp_s);
+	} else {
+		return op_exp_m >> op_exp_s;
+	}
+}
+
 template<uint32_t CYCLES> ALWAYS_INLINE void YM2413::doOperator(float* out[9 + 5], bool eg_silent)
 {
 	bool ismod1 = ((rhythm & 0x20) && (CYCLES == one_of(14u, 15u)))
@@ -629,22 +652,9 @@ template<uint32_t CYCLES> ALWAYS_INLINE void YM2413::doOperator(float* out[9 + 5
 	            : (((CYCLES + 2) / 3) & 1);
 	constexpr bool is_next_mod3 = ((CYCLES + 2) / 3) & 1; // approximate: will 'ismod3' possibly be true next step
 
-	auto output = [&]() -> int32_t {
-		if (eg_silent) return 0;
-		auto prev2_phase = op_phase[(CYCLES - 2) & 1];
-		uint8_t quarter = (prev2_phase & 0x100) ? ~prev2_phase : prev2_phase;
-		auto logsin = rom.logsin[quarter];
-		auto op_level = std::min(4095, logsin + (eg_out[(CYCLES - 2) & 1] << 4));
-		uint32_t op_exp_m = rom.exp[op_level & 0xff];
-		auto  op_exp_s = op_level >> 8;
-		if (prev2_phase & 0x200) {
-			return unlikely(c_dcm[(CYCLES + 16) % 3] & (ismod1 ? 1 : 2))
-			       ? ~0
-			       : ~(op_exp_m >> op_exp_s);
-		} else {
-			return op_exp_m >> op_exp_s;
-		}
-	}();
+	int32_t output = eg_silent ? 0 : operatorOutput(op_phase[(CYCLES - 2) & 1],
+	                                               eg_out[(CYCLES - 2) & 1],
+	                                               c_dcm[(CYCLES + 16) % 3] & (ismod1 ? 1 : 2));
 
 	if (ismod1) {
 		constexpr uint32_t cycles9 = (CYCLES + 1) % 9;
@@ -825,13 +835,315 @@ void YM2413::generateChannels(float* out_[9 + 5], uint32_t n)
 			step18<true>(out);
 		}
 	} else {
-		for (uint32_t i = 0; i < n; ++i) {
+		// A register write takes effect in a specific cycle, emulate
+		// those samples with the full pipeline.
+		uint32_t i = 0;
+		for (/**/; (i < n) && hasPendingWrites(); ++i) {
 			step18<false>(out);
 		}
+		if (i < n) {
+			// From here on the registers remain constant.
+			SlotParams p;
+			calcSlotParams(std::make_integer_sequence<uint32_t, 18>(), p);
+			bool rhythmMode = rhythm & 0x20;
+			for (/**/; i < n; ++i) {
+				// Every now and then check whether the chip became idle.
+				// The last sample is always fully emulated, that restores
+				// all the latches between the pipeline stages.
+				if (((i & 15) == 0) && ((n - i) >= 2) && idleFastForward && isIdle()) {
+					skipIdle(out, n - i - 1);
+					i = n - 1;
+					// skipIdle() doesn't keep 'incr' up-to-date
+					calcIncrements(std::make_integer_sequence<uint32_t, 18>(), p.incr);
+				}
+				if (rhythmMode) {
+					step18Batch<true>(p, out);
+				} else {
+					step18Batch<false>(p, out);
+				}
+			}
+		}
 	}
 	test_mode_active = testmode;
 }
 
+bool YM2413::hasPendingWrites() const
+{
+	if (write_fm_cycle != uint8_t(-1)) return true;
+	for (const auto& w : writes) {
+		if (w.port != uint8_t(-1)) return true;
+	}
+	return false;
+}
+
+// Idle: all operators are silent (and stay silent), no pending register
+// writes and no test-mode. The output is then guaranteed to be zero, but
+// some counters still advance (and influence the sound when a note is
+// started again).
+bool YM2413::isIdle() const
+{
+	if (testmode || test_mode_active) return false;
+	if (hasPendingWrites()) return false;
+	for (auto sk : sk_on) {
+		if (sk & 1) return false; // key-on
+	}
+	if ((rhythm & 0x20) && (rhythm & 0x1f)) return false; // rhythm key-on
+	for (int i = 0; i < 18; ++i) {
+		if ((eg_level[i] != 0x7f) || (eg_state[i] != EgState::release) || eg_dokon[i]) {
+			return false;
+		}
+	}
+	if (eg_kon[0] || eg_kon[1] || !eg_off[0] || !eg_off[1]) return false;
+	for (int i = 0; i < 9; ++i) {
+		if (op_fb1[i] || op_fb2[i]) return false;
+	}
+	return !(op_mod || delay6 || delay7 || delay10 || delay11 || delay12);
+}
+
+template<uint32_t... CYCLES>
+void YM2413::calcIncrements(std::integer_sequence<uint32_t, CYCLES...>, uint32_t* incr) const
+{
+	bool use_rm_patches = rhythm & 0x20;
+	((incr[CYCLES] = phaseCalcIncrement<CYCLES>(preparePatch1<CYCLES>(use_rm_patches))), ...);
+}
+
+// Equivalent to 'n' times step18<false>() while isIdle() remains true. The
+// output (all zero) is skipped, only the state that keeps on changing is
+// updated: the phase generators, the LFO, the rhythm noise generator and
+// the envelope timer.
+NEVER_INLINE void YM2413::skipIdle(float* out[9 + 5], uint32_t n)
+{
+	uint32_t incr[18];
+	calcIncrements(std::make_integer_sequence<uint32_t, 18>(), incr);
+
+	bool dummy = false;
+	for (uint32_t i = 0; i < n; ++i) {
+		envelopeTimer1<0>();
+		envelopeTimer2<0, false>(dummy);
+		if (rhythm & 0x20) {
+			rm_tc_bits = pg_phase[16] >> 8; // see getPhase()
+		}
+		for (int j = 0; j < 17; ++j) {
+			pg_phase[j] += incr[j];
+		}
+		// vibrato changes in cycle 17, before the increment for that
+		// cycle is calculated
+		auto old_vib = lfo_vib;
+		doLFO<17, false>(dummy);
+		if (unlikely(lfo_vib != old_vib)) {
+			calcIncrements(std::make_integer_sequence<uint32_t, 18>(), incr);
+		}
+		pg_phase[17] += incr[17];
+		doRhythm<17, false>();
+	}
+
+	for (int i = 0; i < 9 + 5; ++i) out[i] += n;
+	allowed_offset = std::max<int>(0, allowed_offset - 18 * int(n)); // see writePort()
+}
+
+template<uint32_t... CYCLES>
+void YM2413::calcSlotParams(std::integer_sequence<uint32_t, CYCLES...>, SlotParams& p) const
+{
+	(calcSlotParams<CYCLES>(p), ...);
+}
+
+// Same calculations as in step(), but done once instead of every sample.
+template<uint32_t CYCLES> void YM2413::calcSlotParams(SlotParams& p) const
+{
+	constexpr uint32_t mcsel = ((CYCLES + 1) / 3) & 1;
+	constexpr uint32_t ch = CH_OFFSET[CYCLES];
+	bool use_rm_patches = rhythm & 0x20;
+	const Patch& patch1 = preparePatch1<CYCLES>(use_rm_patches);
+
+	p.ksltl[CYCLES] = envelopeKSLTL<CYCLES>(patch1, use_rm_patches);
+	p.incr [CYCLES] = phaseCalcIncrement<CYCLES>(patch1);
+	p.sl   [CYCLES] = patch1.sl[mcsel];
+	p.fb_t [CYCLES] = patch1.fb_t;
+	p.dcm  [CYCLES] = patch1.dcm;
+	p.am_t [CYCLES] = patch1.am_t[mcsel];
+
+	// see envelopeGenerate2()
+	auto sk = sk_on[ch];
+	bool kon = envelopeKeyOn<CYCLES>(use_rm_patches);
+	p.kon[CYCLES] = kon;
+	auto rate = [&](uint32_t rate4) -> uint8_t {
+		if (rate4 == 0) return 0;
+		auto tmp = rate4 + (p_ksr_freq[ch] >> patch1.ksr_t[mcsel]);
+		return (tmp < 0x40) ? tmp
+		                    : (0x3c | (tmp & 3));
+	};
+	auto rate4 = [&](EgState state) -> uint32_t {
+		if (!kon && !(sk & 2) && mcsel == 1 && !patch1.et[mcsel]) {
+			return 7 * 4;
+		}
+		bool tom_or_hh = (rm_for_cycle(CYCLES) == one_of(rm_num_tom, rm_num_hh)) && use_rm_patches;
+		if (!kon && !mcsel && !tom_or_hh) {
+			return 0 * 4;
+		}
+		return (state == EgState::attack ) ?   patch1.ar4[mcsel]
+		   :   (state == EgState::decay  ) ?   patch1.dr4[mcsel]
+		   :   (state == EgState::sustain) ?   (patch1.et[mcsel] ? (0 * 4) : patch1.rr4[mcsel])
+		   : /*(state == EgState::release) ?*/ ((sk & 2) ? (5 * 4) : patch1.rr4[mcsel]);
+	};
+	for (auto state : {EgState::attack, EgState::decay, EgState::sustain, EgState::release}) {
+		p.rate[uint8_t(state)][CYCLES] = rate(rate4(state));
+	}
+	p.rate_kon[CYCLES] = rate(12 * 4);
+}
+
+// The first half of step() for one slot: envelopeGenerate2(), keyOnEvent(),
+// getPhaseMod(), getPhase(), incrementPhase() and envelopeOutput().
+template<uint32_t SLOT, bool RHYTHM>
+ALWAYS_INLINE void YM2413::batchFront(const SlotParams& p, SlotLatches& l, int16_t mod_out)
+{
+	constexpr bool ismod = (RHYTHM && (SLOT == one_of(12u, 13u)))
+	                     ? false
+	                     : (((SLOT + 4) / 3) & 1);
+	constexpr bool ismod3 = (RHYTHM && (SLOT == one_of(15u, 16u)))
+	                      ? false
+	                      : (((SLOT + 1) / 3) & 1);
+
+	bool new_eg_off = eg_level[SLOT] >= 124;
+	auto state = eg_state[SLOT];
+	bool release = state == EgState::release;
+	bool dokon = p.kon[SLOT] && release && new_eg_off;
+	eg_dokon[SLOT] = dokon;
+	l.eg_off[SLOT] = new_eg_off;
+	l.eg_rate[SLOT] = (p.kon[SLOT] && release && !new_eg_off)
+	                ? p.rate_kon[SLOT]
+	                : p.rate[dokon ? uint8_t(EgState::attack) : uint8_t(state)][SLOT];
+
+	bool key_on_event = ismod ? eg_dokon[(SLOT + 3) % 18] : dokon;
+
+	uint32_t phaseMod = [&]() -> uint32_t {
+		if (ismod3) return mod_out << 1;
+		if (ismod) {
+			constexpr uint32_t cycles9 = (SLOT + 3) % 9;
+			uint32_t op_fbsum = (op_fb1[cycles9] + op_fb2[cycles9]) & 0x7fffffff;
+			return op_fbsum >> p.fb_t[SLOT];
+		}
+		return 0;
+	}();
+	uint32_t pg_out = getPhase<SLOT, false>(l.rm_hh_bits);
+	l.op_phase[SLOT] = phaseMod + pg_out;
+	pg_phase[SLOT] = (key_on_event ? 0 : pg_phase[SLOT]) + p.incr[SLOT];
+
+	int32_t level = eg_level[SLOT] + p.ksltl[SLOT] + (p.am_t[SLOT] & lfo_am_out);
+	l.eg_out[SLOT] = std::min(127, level);
+}
+
+// The second half, two cycles later: envelopeGenerate1() and doOperator().
+// Returns the channel output (only meaningful for carriers, and in rhythm mode
+// for the high hat and the tom).
+template<uint32_t SLOT, bool RHYTHM>
+ALWAYS_INLINE int32_t YM2413::batchBack(const SlotParams& p, SlotLatches& l)
+{
+	constexpr bool ismod1 = (RHYTHM && (SLOT == one_of(12u, 13u)))
+	                      ? false
+	                      : (((SLOT + 4) / 3) & 1);
+
+	bool eg_silent = envelopeGenerate(SLOT, l.eg_off[SLOT], p.kon[SLOT], p.sl[SLOT], l.eg_rate[SLOT]);
+	int32_t output = eg_silent ? 0 : operatorOutput(l.op_phase[SLOT], l.eg_out[SLOT],
+	                                               p.dcm[SLOT] & (ismod1 ? 1 : 2));
+	if (ismod1) {
+		constexpr uint32_t cycles9 = (SLOT + 3) % 9;
+		op_fb2[cycles9] = op_fb1[cycles9];
+		op_fb1[cycles9] = output;
+	}
+	l.mod_out[SLOT] = output & 0x1ff;
+	return output >> 3;
+}
+
+// Equivalent to step18<false>() while there are no pending register writes.
+// Instead of cycle-by-cycle, this processes the pipeline stage-by-stage over
+// all channels: first all modulators, then all carriers. Within one sample the
+// channels only depend on each other via the global state (envelope timer,
+// LFO, noise), and that only changes in cycles 0 and 17.
+template<bool RHYTHM>
+NEVER_INLINE void YM2413::step18Batch(SlotParams& p, float* out[9 + 5])
+{
+	// cycles 0 and 1: the last stage of slots 16 and 17 of the previous sample
+	bool dummy = false;
+	envelopeTimer1<0>();
+	bool eg_silent16 = envelopeGenerate1<0>();
+	envelopeTimer2<0, false>(dummy);
+	doOperator<0>(out, eg_silent16);
+	bool eg_silent17 = envelopeGenerate1<1>();
+	doOperator<1>(out, eg_silent17);
+
+	SlotLatches l;
+	// modulators (and in rhythm mode also the high hat and the tom)
+	batchFront< 0, RHYTHM>(p, l, 0);
+	batchFront< 1, RHYTHM>(p, l, 0);
+	batchFront< 5, RHYTHM>(p, l, 0);
+	batchFront< 6, RHYTHM>(p, l, 0);
+	batchFront< 7, RHYTHM>(p, l, 0);
+	batchFront<11, RHYTHM>(p, l, 0);
+	batchFront<12, RHYTHM>(p, l, 0);
+	batchFront<13, RHYTHM>(p, l, 0);
+	batchBack< 0, RHYTHM>(p, l);
+	batchBack< 1, RHYTHM>(p, l);
+	batchBack< 5, RHYTHM>(p, l);
+	batchBack< 6, RHYTHM>(p, l);
+	batchBack< 7, RHYTHM>(p, l);
+	batchBack<11, RHYTHM>(p, l);
+	auto hh  = batchBack<12, RHYTHM>(p, l);
+	auto tom = batchBack<13, RHYTHM>(p, l);
+
+	// carriers
+	batchFront< 2, RHYTHM>(p, l, op_mod); // modulator in slot 17, see doOperator<1>()
+	batchFront< 3, RHYTHM>(p, l, l.mod_out[ 0]);
+	batchFront< 4, RHYTHM>(p, l, l.mod_out[ 1]);
+	batchFront< 8, RHYTHM>(p, l, l.mod_out[ 5]);
+	batchFront< 9, RHYTHM>(p, l, l.mod_out[ 6]);
+	batchFront<10, RHYTHM>(p, l, l.mod_out[ 7]);
+	batchFront<14, RHYTHM>(p, l, l.mod_out[11]);
+	batchFront<15, RHYTHM>(p, l, l.mod_out[12]);
+	batchFront<16, RHYTHM>(p, l, l.mod_out[13]);
+	*out[0]++ += batchBack< 2, RHYTHM>(p, l);
+	*out[1]++ += batchBack< 3, RHYTHM>(p, l);
+	*out[2]++ += batchBack< 4, RHYTHM>(p, l);
+	*out[3]++ += batchBack< 8, RHYTHM>(p, l);
+	*out[4]++ += batchBack< 9, RHYTHM>(p, l);
+	*out[5]++ += batchBack<10, RHYTHM>(p, l);
+	auto bd = batchBack<14, RHYTHM>(p, l);
+	auto sd = batchBack<15, RHYTHM>(p, l);
+	// see channelOutput()
+	*out[ 9]++ += RHYTHM ? 2 * hh : 0;
+	*out[10]++ += delay10;
+	*out[ 6]++ += delay6;
+	*out[11]++ += delay11;
+	*out[ 7]++ += delay7;
+	*out[12]++ += delay12;
+	delay10 = RHYTHM ? 2 * tom : 0;
+	delay6  = RHYTHM ? 0 : bd;
+	delay11 = RHYTHM ? 2 * bd : 0;
+	delay7  = RHYTHM ? 0 : sd;
+	delay12 = RHYTHM ? 2 * sd : 0;
+
+	// cycle 17: the LFO and the noise generator step before the phase of
+	// slot 17 is calculated
+	auto old_vib = lfo_vib;
+	doLFO<17, false>(dummy);
+	doRhythm<17, false>();
+	if (unlikely(lfo_vib != old_vib)) {
+		calcIncrements(std::make_integer_sequence<uint32_t, 18>(), p.incr);
+	}
+	batchFront<17, RHYTHM>(p, l, 0);
+
+	// latches for slots 16 and 17, see step18<false>()
+	eg_off  [0] = l.eg_off  [16]; eg_off  [1] = l.eg_off  [17];
+	eg_kon  [0] = p.kon     [16]; eg_kon  [1] = p.kon     [17];
+	eg_rate [0] = l.eg_rate [16]; eg_rate [1] = l.eg_rate [17];
+	eg_sl   [0] = p.sl      [16]; eg_sl   [1] = p.sl      [17];
+	eg_out  [0] = l.eg_out  [16]; eg_out  [1] = l.eg_out  [17];
+	op_phase[0] = l.op_phase[16]; op_phase[1] = l.op_phase[17];
+	c_dcm[0] = p.dcm[15]; c_dcm[1] = p.dcm[16]; c_dcm[2] = p.dcm[17];
+	op_mod = l.mod_out[13];
+
+	allowed_offset = std::max<int>(0, allowed_offset - 18); // see writePort()
+}
+
 template<bool TEST_MODE>
 NEVER_INLINE void YM2413::step18(float* out[9 + 5])
 {
@@ -887,7 +1199,9 @@ void YM2413::writePort(bool port, uint8_t value, int cycle_offset)
 	allowed_offset = ((port ? 84 : 12) / 4) + cycle_offset;
 
 	writes[cycle_offset] = {port, value};
-	if (port && (write_address == 0xf)) {
+	// Use 'latch' instead of 'write_address': the address write may still
+	// be pending in 'writes[]'. (A false positive only costs some speed.)
+	if (port && (latch == 0xf)) {
 		test_mode_active = true;
 	}
 
@@ -39,7 +39,8 @@
 *   carefully.
 * - The current code runs (on average) over 3x faster than the original, while
 *   still generating identical output. This was measured/tested on a large set
-*   of vgm files.
+*   of vgm files. The unittest compares the output with YM2413OriginalNukeYKT
+*   for (long) random register write logs.
 *  - TODO document better what kind of transformations were done.
 *      * Emulate 18-steps at-a-time.
 *      * Specialize for the common case that testmode==0 (but still have slower
@@ -47,12 +48,16 @@
 *      * Move sub-operations in the pipeline (e.g. to eliminate temporary state)
 *        when this doesn't have an observable effect.
 *      * Lots of small tweak.
+*      * As long as no registers are written, all register dependent
+*        parameters of the 18 slots are calculated once (see SlotParams), and
+*        the pipeline is processed stage-by-stage over all channels instead of
+*        cycle-by-cycle (see step18Batch()).
+*      * In openMSX the YM2413 is often silent for large periods of time
+*        (e.g. maybe the emulated MSX program doesn't use the YM2413). Such an
+*        idle YM2413 is detected, and then only the few counters that still
+*        change (phase, LFO, noise, envelope timer) are updated, for all
+*        operators at once (see skipIdle()).
 *      * ...
-*
-* TODO:
-* - In openMSX the YM2413 is often silent for large periods of time (e.g. maybe 
-*   the emulated MSX program doesn't use the YM2413). Can we easily detect an
-*   idle YM2413 and then bypass large parts of the emulation?
 */
 
 #ifndef YM2413NUKEYKT_HH
@@ -61,6 +66,7 @@
 #include "YM2413Core.hh"
 #include "inline.hh"
 #include <array>
+#include <utility>
 
 namespace openmsx {
 namespace YM2413NukeYKT {
@@ -76,6 +82,11 @@ public:
 	void generateChannels(float* out[9 + 5], uint32_t n) override;
 	float getAmplificationFactor() const override;
 
+	/** Enable/disable the fast path for an idle YM2413 (see skipIdle()).
+	  * The output is the same either way, this is meant for testing.
+	  */
+	void setIdleFastForward(bool enabled) { idleFastForward = enabled; }
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -157,9 +168,45 @@ private:
 		template<typename Archive>
 		void serialize(Archive& ar, unsigned version);
 	};
+	// The register dependent parameters of all 18 slots (indexed by the
+	// cycle in which the phase of that slot is calculated). These remain
+	// constant as long as no registers are written, except for 'incr',
+	// which also changes when the vibrato LFO steps. Used by step18Batch().
+	struct SlotParams {
+		uint32_t ksltl[18];
+		uint32_t incr[18];
+		uint8_t rate[4][18]; // eg_rate for each EgState
+		uint8_t rate_kon[18]; // eg_rate for a key-on during release
+		uint8_t sl[18];
+		uint8_t fb_t[18];
+		uint8_t dcm[18];
+		int8_t am_t[18];
+		bool kon[18];
+	};
+	// The pipeline latches of all 18 slots, only for the duration of one
+	// step18Batch() call (step18() only keeps the last two).
+	struct SlotLatches {
+		uint16_t op_phase[18];
+		int16_t mod_out[18];
+		uint8_t eg_out[18];
+		uint8_t eg_rate[18];
+		bool eg_off[18];
+		uint8_t rm_hh_bits;
+	};
 
 private:
 	template<bool TEST_MODE> NEVER_INLINE void step18(float* out[9 + 5]);
+	[[nodiscard]] bool hasPendingWrites() const;
+	[[nodiscard]] bool isIdle() const;
+	NEVER_INLINE void skipIdle(float* out[9 + 5], uint32_t n);
+	template<uint32_t... CYCLES> void calcIncrements(
+		std::integer_sequence<uint32_t, CYCLES...>, uint32_t* incr) const;
+	template<uint32_t... CYCLES> void calcSlotParams(
+		std::integer_sequence<uint32_t, CYCLES...>, SlotParams& p) const;
+	template<uint32_t CYCLES> void calcSlotParams(SlotParams& p) const;
+	template<bool RHYTHM> NEVER_INLINE void step18Batch(SlotParams& p, float* out[9 + 5]);
+	template<uint32_t SLOT, bool RHYTHM> ALWAYS_INLINE void batchFront(const SlotParams& p, SlotLatches& l, int16_t mod_out);
+	template<uint32_t SLOT, bool RHYTHM> ALWAYS_INLINE int32_t batchBack(const SlotParams& p, SlotLatches& l);
 	template<uint32_t CYCLES, bool TEST_MODE> ALWAYS_INLINE void step(Locals& l);
 
 	template<uint32_t CYCLES>                 ALWAYS_INLINE uint32_t phaseCalcIncrement(const Patch& patch1) const;
@@ -175,6 +222,8 @@ private:
 	template<uint32_t CYCLES>                 ALWAYS_INLINE void envelopeTimer1();
 	template<uint32_t CYCLES, bool TEST_MODE> ALWAYS_INLINE void envelopeTimer2(bool& eg_timer_carry);
 	template<uint32_t CYCLES>                 ALWAYS_INLINE bool envelopeGenerate1();
+	                                          ALWAYS_INLINE bool envelopeGenerate(uint32_t slot, bool prev2_eg_off, bool prev2_eg_kon, uint8_t prev2_eg_sl, uint8_t prev2_rate);
+	template<uint32_t CYCLES>                 ALWAYS_INLINE bool envelopeKeyOn(bool use_rm_patches) const;
 	template<uint32_t CYCLES>                 ALWAYS_INLINE void envelopeGenerate2(const Patch& patch1, bool use_rm_patches);
 	template<uint32_t CYCLES, bool TEST_MODE> ALWAYS_INLINE void doLFO(bool& lfo_am_car);
 	template<uint32_t CYCLES, bool TEST_MODE> ALWAYS_INLINE void doRhythm();
@@ -267,6 +316,7 @@ private:
 	uint8_t latch;
 
 	int allowed_offset = 0; // Hack: see comments in writePort()
+	bool idleFastForward = true;
 };
 
 } // namespace NukeYKT
@@ -53,12 +53,12 @@ void YM2413::generateChannels(float* out_[9 + 5], uint32_t n)
 		}
 		f();
 	}
+	allowed_offset = std::max<int>(0, allowed_offset - 18 * int(n)); // see writePort()
+
 	n = (n - 1) * 18;
 	for (uint32_t i = 0; i < n; ++i) {
 		f();
 	}
-
-	allowed_offset = std::max<int>(0, allowed_offset - 18); // see writePort()
 }
 
 void YM2413::writePort(bool port, uint8_t value, int cycle_offset)
@@ -115,8 +115,10 @@ private:
 	class Channel {
 	public:
 		Channel();
-		void chan_calc(unsigned lfo_am);
-		void chan_calc_ext(unsigned lfo_am);
+		void chan_calc(unsigned lfo_am, int& phase_modulation,
+		               int& phase_modulation2);
+		void chan_calc_ext(unsigned lfo_am, int& phase_modulation,
+		                   int phase_modulation2);
 
 		template<typename Archive>
 		void serialize(Archive& ar, unsigned version);
@@ -144,6 +146,9 @@ private:
 	// SoundDevice
 	float getAmplificationFactorImpl() const override;
 	void generateChannels(float** bufs, unsigned num) override;
+	std::optional<RegisterLogger::Chip> getRegisterLogChip() const override;
+	void replayRegisterWrite(uint8_t port, uint8_t reg, uint8_t value,
+	                         EmuTime::param time) override;
 
 	void callback(byte flag) override;
 
@@ -192,6 +197,9 @@ private:
 	IRQHelper irq;
 
 	int chanout[18]; // 18 channels
+	int phase_modulation;  // phase modulation input (SLOT 2)
+	int phase_modulation2; // phase modulation input (SLOT 3
+	                       // in 4 operator channels)
 
 	byte reg[512];
 	Channel channel[18];	// OPL3 chips have 18 channels
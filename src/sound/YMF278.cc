@@ -39,6 +39,8 @@
 #include "outer.hh"
 #include "ranges.hh"
 #include "serialize.hh"
+#include <algorithm>
+#include <cstring>
 
 namespace openmsx {
 
@@ -320,138 +322,152 @@ uint16_t YMF278::Slot::compute_am() const
 }
 
 
-void YMF278::advance()
+void YMF278::Slot::advance(unsigned egCnt)
 {
-	eg_cnt++;
+	// volume interpolation
+	interpolateTL(egCnt);
 
-	// modulo counters for volume interpolation
-	int tl_int_cnt  =  eg_cnt % 9;      // 0 .. 8
-	int tl_int_step = (eg_cnt / 9) % 3; // 0 .. 2
-
-	for (auto& op : slots) {
-		// volume interpolation
-		if (tl_int_cnt == 0) {
-			if (tl_int_step == 0) {
-				// decrease volume by one step every 27 samples
-				if (op.TL < op.TLdest) ++op.TL;
-			} else {
-				// increase volume by one step every 13.5 samples
-				if (op.TL > op.TLdest) --op.TL;
-			}
-		}
+	if (lfo_active) {
+		lfo_cnt = (lfo_cnt + lfo_period[lfo]) & (LFO_PERIOD - 1);
+	}
 
-		if (op.lfo_active) {
-			op.lfo_cnt = (op.lfo_cnt + lfo_period[op.lfo]) & (LFO_PERIOD - 1);
+	// Envelope Generator
+	switch (state) {
+	case EG_ATT: { // attack phase
+		uint8_t rate = compute_rate(AR);
+		// Verified by HW recording (and matches Nemesis' tests of the YM2612):
+		// AR = 0xF during KeyOn results in instant switch to EG_DEC. (see keyOnHelper)
+		// Setting AR = 0xF while the attack phase is in progress freezes the envelope.
+		if (rate >= 63) {
+			break;
 		}
-
-		// Envelope Generator
-		switch (op.state) {
-		case EG_ATT: { // attack phase
-			uint8_t rate = op.compute_rate(op.AR);
-			// Verified by HW recording (and matches Nemesis' tests of the YM2612):
-			// AR = 0xF during KeyOn results in instant switch to EG_DEC. (see keyOnHelper)
-			// Setting AR = 0xF while the attack phase is in progress freezes the envelope.
-			if (rate >= 63) {
-				break;
+		uint8_t shift = eg_rate_shift[rate];
+		if (!(egCnt & ((1 << shift) - 1))) {
+			uint8_t select = eg_rate_select[rate];
+			// >>4 makes the attack phase's shape match the actual chip -Valley Bell
+			env_vol += (~env_vol * eg_inc[select + ((egCnt >> shift) & 7)]) >> 4;
+			if (env_vol <= MIN_ATT_INDEX) {
+				env_vol = MIN_ATT_INDEX;
+				// TODO does the real HW skip EG_DEC completely,
+				//      or is it active for 1 sample?
+				state = DL ? EG_DEC : EG_SUS;
 			}
-			uint8_t shift = eg_rate_shift[rate];
-			if (!(eg_cnt & ((1 << shift) - 1))) {
-				uint8_t select = eg_rate_select[rate];
-				// >>4 makes the attack phase's shape match the actual chip -Valley Bell
-				op.env_vol += (~op.env_vol * eg_inc[select + ((eg_cnt >> shift) & 7)]) >> 4;
-				if (op.env_vol <= MIN_ATT_INDEX) {
-					op.env_vol = MIN_ATT_INDEX;
-					// TODO does the real HW skip EG_DEC completely,
-					//      or is it active for 1 sample?
-					op.state = op.DL ? EG_DEC : EG_SUS;
-				}
-			}
-			break;
 		}
-		case EG_DEC: { // decay phase
-			uint8_t rate = op.compute_decay_rate(op.D1R);
-			uint8_t shift = eg_rate_shift[rate];
-			if (!(eg_cnt & ((1 << shift) - 1))) {
-				uint8_t select = eg_rate_select[rate];
-				op.env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
-				if (op.env_vol >= op.DL) {
-					op.state = (op.env_vol < MAX_ATT_INDEX) ? EG_SUS : EG_OFF;
-				}
+		break;
+	}
+	case EG_DEC: { // decay phase
+		uint8_t rate = compute_decay_rate(D1R);
+		uint8_t shift = eg_rate_shift[rate];
+		if (!(egCnt & ((1 << shift) - 1))) {
+			uint8_t select = eg_rate_select[rate];
+			env_vol += eg_inc[select + ((egCnt >> shift) & 7)];
+			if (env_vol >= DL) {
+				state = (env_vol < MAX_ATT_INDEX) ? EG_SUS : EG_OFF;
 			}
-			break;
 		}
-		case EG_SUS: { // sustain phase
-			uint8_t rate = op.compute_decay_rate(op.D2R);
-			uint8_t shift = eg_rate_shift[rate];
-			if (!(eg_cnt & ((1 << shift) - 1))) {
-				uint8_t select = eg_rate_select[rate];
-				op.env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
-				if (op.env_vol >= MAX_ATT_INDEX) {
-					op.env_vol = MAX_ATT_INDEX;
-					op.state = EG_OFF;
-				}
+		break;
+	}
+	case EG_SUS: { // sustain phase
+		uint8_t rate = compute_decay_rate(D2R);
+		uint8_t shift = eg_rate_shift[rate];
+		if (!(egCnt & ((1 << shift) - 1))) {
+			uint8_t select = eg_rate_select[rate];
+			env_vol += eg_inc[select + ((egCnt >> shift) & 7)];
+			if (env_vol >= MAX_ATT_INDEX) {
+				env_vol = MAX_ATT_INDEX;
+				state = EG_OFF;
 			}
-			break;
 		}
-		case EG_REL: { // release phase
-			uint8_t rate = op.compute_decay_rate(op.RR);
-			uint8_t shift = eg_rate_shift[rate];
-			if (!(eg_cnt & ((1 << shift) - 1))) {
-				uint8_t select = eg_rate_select[rate];
-				op.env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
-				if (op.env_vol >= MAX_ATT_INDEX) {
-					op.env_vol = MAX_ATT_INDEX;
-					op.state = EG_OFF;
-				}
+		break;
+	}
+	case EG_REL: { // release phase
+		uint8_t rate = compute_decay_rate(RR);
+		uint8_t shift = eg_rate_shift[rate];
+		if (!(egCnt & ((1 << shift) - 1))) {
+			uint8_t select = eg_rate_select[rate];
+			env_vol += eg_inc[select + ((egCnt >> shift) & 7)];
+			if (env_vol >= MAX_ATT_INDEX) {
+				env_vol = MAX_ATT_INDEX;
+				state = EG_OFF;
 			}
-			break;
 		}
-		case EG_OFF:
-			// nothing
-			break;
+		break;
+	}
+	case EG_OFF:
+		// nothing
+		break;
 
-		default:
-			UNREACHABLE;
-		}
+	default:
+		UNREACHABLE;
 	}
 }
 
-int16_t YMF278::getSample(Slot& op) const
+void YMF278::Slot::advanceOff(unsigned egCnt, unsigned num)
 {
-	// TODO How does this behave when R#2 bit 0 = 1?
-	//      As-if read returns 0xff? (Like for CPU memory reads.) Or is
-	//      sound generation blocked at some higher level?
-	int16_t sample;
-	switch (op.bits) {
-	case 0: {
-		// 8 bit
-		sample = readMem(op.startaddr + op.pos) << 8;
-		break;
+	assert(state == EG_OFF);
+	if (lfo_active) {
+		// same as 'num' times the update in advance()
+		lfo_cnt = (lfo_cnt + num * lfo_period[lfo]) & (LFO_PERIOD - 1);
+	}
+	for (unsigned i = 1; (i <= num) && (TL != TLdest); ++i) {
+		interpolateTL(egCnt + i);
 	}
-	case 1: {
+}
+
+void YMF278::Slot::interpolateTL(unsigned egCnt)
+{
+	// modulo counters for volume interpolation
+	if ((egCnt % 9) != 0) return;
+	if (((egCnt / 9) % 3) == 0) {
+		// decrease volume by one step every 27 samples
+		if (TL < TLdest) ++TL;
+	} else {
+		// increase volume by one step every 13.5 samples
+		if (TL > TLdest) --TL;
+	}
+}
+
+// Decode the sample at position 'pos'. 'mem' reads one byte from the sample
+// memory (ROM or RAM).
+template<int BITS, typename Mem>
+static int16_t decodeSample(Mem mem, unsigned startaddr, uint16_t pos)
+{
+	if constexpr (BITS == 0) {
+		// 8 bit
+		return int16_t(mem(startaddr + pos) << 8);
+	} else if constexpr (BITS == 1) {
 		// 12 bit
-		unsigned addr = op.startaddr + ((op.pos / 2) * 3);
-		if (op.pos & 1) {
-			sample = (readMem(addr + 2) << 8) |
-				 ((readMem(addr + 1) << 4) & 0xF0);
+		unsigned addr = startaddr + ((pos / 2) * 3);
+		if (pos & 1) {
+			return int16_t((mem(addr + 2) << 8) |
+			               ((mem(addr + 1) << 4) & 0xF0));
 		} else {
-			sample = (readMem(addr + 0) << 8) |
-				 (readMem(addr + 1) & 0xF0);
+			return int16_t((mem(addr + 0) << 8) |
+			               (mem(addr + 1) & 0xF0));
 		}
-		break;
-	}
-	case 2: {
+	} else if constexpr (BITS == 2) {
 		// 16 bit
-		unsigned addr = op.startaddr + (op.pos * 2);
-		sample = (readMem(addr + 0) << 8) |
-			 (readMem(addr + 1));
-		break;
-	}
-	default:
+		unsigned addr = startaddr + (pos * 2);
+		return int16_t((mem(addr + 0) << 8) |
+		               (mem(addr + 1)));
+	} else {
 		// TODO unspecified
-		sample = 0;
+		return 0;
+	}
+}
+
+int16_t YMF278::getSample(Slot& op) const
+{
+	// TODO How does this behave when R#2 bit 0 = 1?
+	//      As-if read returns 0xff? (Like for CPU memory reads.) Or is
+	//      sound generation blocked at some higher level?
+	auto mem = [&](unsigned addr) { return readMem(addr); };
+	switch (op.bits) {
+	case 0:  return decodeSample<0>(mem, op.startaddr, op.pos);
+	case 1:  return decodeSample<1>(mem, op.startaddr, op.pos);
+	case 2:  return decodeSample<2>(mem, op.startaddr, op.pos);
+	default: return decodeSample<3>(mem, op.startaddr, op.pos);
 	}
-	return sample;
 }
 
 bool YMF278::anyActive()
@@ -494,61 +510,126 @@ void YMF278::generateChannels(float** bufs, unsigned num)
 		for (int i = 0; i < 24; ++i) {
 			bufs[i] = nullptr;
 		}
+		// remains muted until the next register write
+		setIdle();
 		return;
 	}
 
+	// The slots are independent of each other (they only share the
+	// 'eg_cnt' counter), so generate the whole buffer for one slot before
+	// moving on to the next. This allows to specialize the inner loop per
+	// slot, see below.
+	for (int i = 0; i < 24; ++i) {
+		auto& sl = slots[i];
+		if (sl.state == EG_OFF) {
+			// can't become active during this buffer (that requires
+			// a register write)
+			sl.advanceOff(eg_cnt, num);
+			bufs[i] = nullptr;
+		} else {
+			generateSlot(sl, bufs[i], num);
+		}
+	}
+	eg_cnt += num;
+}
+
+void YMF278::generateSlot(Slot& sl, float* buf, unsigned num)
+{
+	// Most samples are located in ROM. If the whole sample (including the
+	// part beyond the end address, see the 'loop glitch' below) is in ROM,
+	// it can be read without the address translation in readMem().
+	constexpr unsigned MAX_SAMPLE_BYTES[4] = {
+		0x10000, // 8 bit:  65536 samples * 1   byte
+		0x18000, // 12 bit: 65536 samples * 1.5 bytes
+		0x20000, // 16 bit: 65536 samples * 2   bytes
+		0,       // unspecified: doesn't read memory
+	};
+	if ((sl.startaddr + MAX_SAMPLE_BYTES[sl.bits]) <= 0x200000) {
+		const byte* romData = &rom[0];
+		generateSlot(sl, buf, num, [romData](unsigned addr) { return romData[addr]; });
+	} else {
+		generateSlot(sl, buf, num, [this](unsigned addr) { return readMem(addr); });
+	}
+}
+
+template<typename Mem>
+void YMF278::generateSlot(Slot& sl, float* buf, unsigned num, Mem mem)
+{
+	// Sample format and LFO (vibrato or tremolo) can only change via a
+	// register write, so they're constant during this buffer. Note:
+	// vibrato and tremolo with depth 0 have no effect.
+	bool lfo = sl.lfo_active && (sl.vib || sl.AM);
+	switch (sl.bits) {
+	case 0:
+		lfo ? generateSlot<0, true >(sl, buf, num, mem)
+		    : generateSlot<0, false>(sl, buf, num, mem);
+		break;
+	case 1:
+		lfo ? generateSlot<1, true >(sl, buf, num, mem)
+		    : generateSlot<1, false>(sl, buf, num, mem);
+		break;
+	case 2:
+		lfo ? generateSlot<2, true >(sl, buf, num, mem)
+		    : generateSlot<2, false>(sl, buf, num, mem);
+		break;
+	default:
+		lfo ? generateSlot<3, true >(sl, buf, num, mem)
+		    : generateSlot<3, false>(sl, buf, num, mem);
+		break;
+	}
+}
+
+template<int BITS, bool LFO, typename Mem>
+void YMF278::generateSlot(Slot& sl, float* buf, unsigned num, Mem mem)
+{
+	// Panning is also done separately. (low-volume TL + low-volume panning goes below -60dB)
+	// I'll be taking wild guess and assume that -3dB is approximated with 75%. (same as with TL and envelope levels)
+	// The same applies to the PCM mix level.
+	int32_t volLeft  = pan_left [sl.pan]; // note: register 0xF9 is handled externally
+	int32_t volRight = pan_right[sl.pan];
+	// 0 -> 0x20, 8 -> 0x18, 16 -> 0x10, 24 -> 0x0C, etc. (not using vol_factor here saves array boundary checks)
+	volLeft  = (0x20 - (volLeft  & 0x0f)) >> (volLeft  >> 4);
+	volRight = (0x20 - (volRight & 0x0f)) >> (volRight >> 4);
+
 	for (unsigned j = 0; j < num; ++j) {
-		for (int i = 0; i < 24; ++i) {
-			auto& sl = slots[i];
-			if (sl.state == EG_OFF) {
-				//bufs[i][2 * j + 0] += 0;
-				//bufs[i][2 * j + 1] += 0;
-				continue;
-			}
+		if (sl.state == EG_OFF) {
+			// remainder of the buffer stays silent
+			sl.advanceOff(eg_cnt + j, num - j);
+			return;
+		}
 
-			int16_t sample = (sl.sample1 * (0x10000 - sl.stepptr) +
-			                  sl.sample2 * sl.stepptr) >> 16;
-			// TL levels are 00..FF internally (TL register value 7F is mapped to TL level FF)
-			// Envelope levels have 4x the resolution (000..3FF)
-			// Volume levels are approximate logarithmic. -6dB result in half volume. Steps in between use linear interpolation.
-			// A volume of -60dB or lower results in silence. (value 0x280..0x3FF).
-			// Recordings from actual hardware indicate that TL level and envelope level are applied separarely.
-			// Each of them is clipped to silence below -60dB, but TL+envelope might result in a lower volume. -Valley Bell
-			uint16_t envVol = std::min(sl.env_vol + ((sl.lfo_active && sl.AM) ? sl.compute_am() : 0),
-			                           MAX_ATT_INDEX);
-			int smplOut = vol_factor(vol_factor(sample, envVol), sl.TL << TL_SHIFT);
-
-			// Panning is also done separately. (low-volume TL + low-volume panning goes below -60dB)
-			// I'll be taking wild guess and assume that -3dB is approximated with 75%. (same as with TL and envelope levels)
-			// The same applies to the PCM mix level.
-			int32_t volLeft  = pan_left [sl.pan]; // note: register 0xF9 is handled externally
-			int32_t volRight = pan_right[sl.pan];
-			// 0 -> 0x20, 8 -> 0x18, 16 -> 0x10, 24 -> 0x0C, etc. (not using vol_factor here saves array boundary checks)
-			volLeft  = (0x20 - (volLeft  & 0x0f)) >> (volLeft  >> 4);
-			volRight = (0x20 - (volRight & 0x0f)) >> (volRight >> 4);
-
-			bufs[i][2 * j + 0] += (smplOut * volLeft ) >> 5;
-			bufs[i][2 * j + 1] += (smplOut * volRight) >> 5;
-
-			unsigned step = (sl.lfo_active && sl.vib)
-			              ? calcStep(sl.OCT, sl.FN, sl.compute_vib())
-			              : sl.step;
-			sl.stepptr += step;
-
-			// If there is a 4-sample loop and you advance 12 samples per step,
-			// it may exceed the end offset.
-			// This is abused by the "Lizard Star" song to generate noise at 0:52. -Valley Bell
-			if (sl.stepptr >= 0x10000) {
-				sl.sample1 = sl.sample2;
-				sl.sample2 = getSample(sl);
-				sl.pos += (sl.stepptr >> 16);
-				sl.stepptr &= 0xffff;
-				if ((uint32_t(sl.pos) + sl.endaddr) >= 0x10000) { // check position >= (negated) end address
-					sl.pos += sl.endaddr + sl.loopaddr; // This is how the actual chip does it.
-				}
+		int16_t sample = (sl.sample1 * (0x10000 - sl.stepptr) +
+		                  sl.sample2 * sl.stepptr) >> 16;
+		// TL levels are 00..FF internally (TL register value 7F is mapped to TL level FF)
+		// Envelope levels have 4x the resolution (000..3FF)
+		// Volume levels are approximate logarithmic. -6dB result in half volume. Steps in between use linear interpolation.
+		// A volume of -60dB or lower results in silence. (value 0x280..0x3FF).
+		// Recordings from actual hardware indicate that TL level and envelope level are applied separarely.
+		// Each of them is clipped to silence below -60dB, but TL+envelope might result in a lower volume. -Valley Bell
+		int am = LFO ? sl.compute_am() : 0;
+		uint16_t envVol = std::min(sl.env_vol + am, MAX_ATT_INDEX);
+		int smplOut = vol_factor(vol_factor(sample, envVol), sl.TL << TL_SHIFT);
+
+		buf[2 * j + 0] += (smplOut * volLeft ) >> 5;
+		buf[2 * j + 1] += (smplOut * volRight) >> 5;
+
+		unsigned step = LFO ? calcStep(sl.OCT, sl.FN, sl.compute_vib())
+		                    : sl.step;
+		sl.stepptr += step;
+
+		// If there is a 4-sample loop and you advance 12 samples per step,
+		// it may exceed the end offset.
+		// This is abused by the "Lizard Star" song to generate noise at 0:52. -Valley Bell
+		if (sl.stepptr >= 0x10000) {
+			sl.sample1 = sl.sample2;
+			sl.sample2 = decodeSample<BITS>(mem, sl.startaddr, sl.pos);
+			sl.pos += (sl.stepptr >> 16);
+			sl.stepptr &= 0xffff;
+			if ((uint32_t(sl.pos) + sl.endaddr) >= 0x10000) { // check position >= (negated) end address
+				sl.pos += sl.endaddr + sl.loopaddr; // This is how the actual chip does it.
 			}
 		}
-		advance();
+		sl.advance(eg_cnt + j + 1);
 	}
 }
 
@@ -575,9 +656,35 @@ void YMF278::keyOnHelper(YMF278::Slot& slot)
 void YMF278::writeReg(byte reg, byte data, EmuTime::param time)
 {
 	updateStream(time); // TODO optimize only for regs that directly influence sound
+	// VGM numbers the OPL4 ports as: 0,1 = FM, 2 = wave
+	logRegisterWrite(2, reg, data, time);
 	writeRegDirect(reg, data, time);
 }
 
+std::optional<RegisterLogger::Chip> YMF278::getRegisterLogChip() const
+{
+	return RegisterLogger::Chip::YMF278;
+}
+
+void YMF278::replayRegisterWrite(uint8_t port, uint8_t reg, uint8_t value,
+                                 EmuTime::param time)
+{
+	if (port == 2) writeReg(reg, value, time);
+}
+
+span<const uint8_t> YMF278::getSampleMemory() const
+{
+	if (ram.getSize() == 0) return {};
+	return {&ram[0], ram.getSize()};
+}
+
+void YMF278::setSampleMemory(span<const uint8_t> data)
+{
+	auto size = std::min<size_t>(data.size(), ram.getSize());
+	if (size == 0) return;
+	memcpy(ram.getWriteBackdoor(), data.data(), size);
+}
+
 void YMF278::writeRegDirect(byte reg, byte data, EmuTime::param time)
 {
 	// Handle slot registers specifically
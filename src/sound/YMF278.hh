@@ -45,6 +45,9 @@ private:
 		void envelope_next(int sample_rate);
 		int16_t compute_vib() const;
 		uint16_t compute_am() const;
+		void advance(unsigned egCnt);
+		void advanceOff(unsigned egCnt, unsigned num);
+		void interpolateTL(unsigned egCnt);
 
 		template<typename Archive>
 		void serialize(Archive& ar, unsigned version);
@@ -89,11 +92,20 @@ private:
 
 	// SoundDevice
 	void generateChannels(float** bufs, unsigned num) override;
+	std::optional<RegisterLogger::Chip> getRegisterLogChip() const override;
+	void replayRegisterWrite(uint8_t port, uint8_t reg, uint8_t value,
+	                         EmuTime::param time) override;
+	span<const uint8_t> getSampleMemory() const override;
+	void setSampleMemory(span<const uint8_t> data) override;
 
 	void writeRegDirect(byte reg, byte data, EmuTime::param time);
 	unsigned getRamAddress(unsigned addr) const;
 	int16_t getSample(Slot& op) const;
-	void advance();
+	void generateSlot(Slot& sl, float* buf, unsigned num);
+	template<typename Mem>
+	void generateSlot(Slot& sl, float* buf, unsigned num, Mem mem);
+	template<int BITS, bool LFO, typename Mem>
+	void generateSlot(Slot& sl, float* buf, unsigned num, Mem mem);
 	bool anyActive();
 	void keyOnHelper(Slot& slot);
 
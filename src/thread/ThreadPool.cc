@@ -0,0 +1,101 @@
+#include "ThreadPool.hh"
+#include <algorithm>
+#include <cassert>
+
+namespace openmsx {
+
+unsigned ThreadPool::getDefaultNumThreads()
+{
+	unsigned cores = std::thread::hardware_concurrency(); // may return 0
+	return std::min(std::max(cores, 2u) - 2, 7u);
+}
+
+ThreadPool::ThreadPool()
+{
+	start(getDefaultNumThreads());
+}
+
+ThreadPool::ThreadPool(unsigned numThreads)
+{
+	start(numThreads);
+}
+
+void ThreadPool::start(unsigned numThreads)
+{
+	threads.reserve(numThreads);
+	for (unsigned i = 0; i < numThreads; ++i) {
+		threads.emplace_back([this]() { run(); });
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		exitLoop = true;
+	}
+	workAvailable.notify_all();
+	for (auto& t : threads) t.join();
+}
+
+void ThreadPool::parallelFor(unsigned n, const std::function<void(unsigned)>& f)
+{
+	if (threads.empty() || (n <= 1)) {
+		// no need for any synchronization
+		for (unsigned i = 0; i < n; ++i) f(i);
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	assert(!func); // no concurrent calls
+	func = &f;
+	nextIndex = 0;
+	endIndex = n;
+	++generation;
+	workAvailable.notify_all();
+
+	work(lock); // also participate from this thread
+	workDone.wait(lock, [&] { return numBusy == 0; });
+
+	func = nullptr;
+	if (exception) {
+		auto e = exception;
+		exception = nullptr;
+		std::rethrow_exception(e);
+	}
+}
+
+void ThreadPool::run()
+{
+	unsigned seenGeneration = 0;
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		workAvailable.wait(lock, [&] {
+			return exitLoop || (generation != seenGeneration);
+		});
+		if (exitLoop) break;
+		seenGeneration = generation;
+		work(lock);
+	}
+}
+
+void ThreadPool::work(std::unique_lock<std::mutex>& lock)
+{
+	// precondition: lock is held
+	++numBusy;
+	while (nextIndex < endIndex) {
+		unsigned i = nextIndex++;
+		lock.unlock();
+		try {
+			(*func)(i);
+		} catch (...) {
+			lock.lock();
+			if (!exception) exception = std::current_exception();
+			continue;
+		}
+		lock.lock();
+	}
+	if (--numBusy == 0) workDone.notify_all();
+}
+
+} // namespace openmsx
@@ -0,0 +1,71 @@
+#ifndef THREADPOOL_HH
+#define THREADPOOL_HH
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace openmsx {
+
+/** A fixed set of threads to execute independent pieces of work in parallel.
+  *
+  * This is meant for data-parallel work (e.g. process all tiles of an image,
+  * all sound chips for one audio fragment). The calling thread also takes
+  * part in the work, so a pool with 0 extra threads simply executes all
+  * work items on the calling thread.
+  */
+class ThreadPool
+{
+public:
+	/** Use a reasonable number of threads for this host, see below. */
+	ThreadPool();
+	/** Use exactly the given number of extra (worker) threads. */
+	explicit ThreadPool(unsigned numThreads);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/** A reasonable number of extra threads for this host: leave one core
+	  * for the rest of the system (e.g. the main thread is often busy with
+	  * something else as well) and don't go overboard on big machines.
+	  */
+	[[nodiscard]] static unsigned getDefaultNumThreads();
+
+	/** Number of extra threads (so excluding the calling thread). */
+	[[nodiscard]] unsigned getNumThreads() const { return unsigned(threads.size()); }
+
+	/** Calls 'func(i)' for all 'i' in range [0, n). The calls are
+	  * distributed over the worker threads and the calling thread, in
+	  * no particular order. Only returns when all calls have finished.
+	  * 'func' must be safe to call concurrently (for different 'i').
+	  * If a call throws, the (first) exception is rethrown here, after
+	  * all other calls have finished.
+	  * Should not be called concurrently from multiple threads.
+	  */
+	void parallelFor(unsigned n, const std::function<void(unsigned)>& func);
+
+private:
+	void start(unsigned numThreads);
+	void run();
+	void work(std::unique_lock<std::mutex>& lock);
+
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable workAvailable;
+	std::condition_variable workDone;
+	const std::function<void(unsigned)>* func = nullptr;
+	std::exception_ptr exception;
+	unsigned nextIndex = 0;
+	unsigned endIndex = 0;
+	unsigned numBusy = 0;
+	unsigned generation = 0; // incremented for each parallelFor() call
+	bool exitLoop = false;
+};
+
+} // namespace openmsx
+
+#endif
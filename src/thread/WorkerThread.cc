@@ -0,0 +1,73 @@
+#include "WorkerThread.hh"
+#include <cassert>
+
+namespace openmsx {
+
+WorkerThread::WorkerThread(unsigned maxPending_)
+	: maxPending(maxPending_)
+{
+	assert(maxPending > 0);
+	thread = std::thread([this]() { run(); });
+}
+
+WorkerThread::~WorkerThread()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		exitLoop = true;
+	}
+	jobAvailable.notify_one();
+	thread.join();
+	assert(jobs.empty());
+}
+
+void WorkerThread::push(std::function<void()> job)
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		jobFinished.wait(lock, [&] { return numPending < maxPending; });
+		jobs.push_back(std::move(job));
+		++numPending;
+	}
+	jobAvailable.notify_one();
+}
+
+void WorkerThread::flush()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	jobFinished.wait(lock, [&] { return numPending == 0; });
+}
+
+unsigned WorkerThread::getNumPending()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return numPending;
+}
+
+void WorkerThread::run()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		jobAvailable.wait(lock, [&] { return exitLoop || !jobs.empty(); });
+		if (jobs.empty()) {
+			assert(exitLoop);
+			break; // only exit once all jobs are finished
+		}
+		auto job = std::move(jobs.front());
+		jobs.pop_front();
+
+		lock.unlock();
+		try {
+			job();
+		} catch (...) {
+			// ignore, see class comment
+		}
+		job = nullptr; // release resources outside the lock
+		lock.lock();
+
+		--numPending;
+		jobFinished.notify_all();
+	}
+}
+
+} // namespace openmsx
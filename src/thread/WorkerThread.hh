@@ -0,0 +1,76 @@
+#ifndef WORKERTHREAD_HH
+#define WORKERTHREAD_HH
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+namespace openmsx {
+
+/** Executes jobs, in submission order, on a dedicated background thread.
+  *
+  * The number of queued (not yet finished) jobs is bounded. When the queue
+  * is full, push() blocks until the worker has caught up. This provides
+  * back-pressure on the producer (typically the emulation thread) and keeps
+  * the memory held by pending jobs bounded.
+  *
+  * Jobs should not throw; if they do the exception is swallowed (after all
+  * there's nobody on the worker thread to report it to). Jobs that can fail
+  * should themselves record the error so it can later be reported from the
+  * main thread.
+  */
+class WorkerThread
+{
+public:
+	explicit WorkerThread(unsigned maxPending);
+
+	/** Finishes all pending jobs before returning. */
+	~WorkerThread();
+
+	WorkerThread(const WorkerThread&) = delete;
+	WorkerThread& operator=(const WorkerThread&) = delete;
+
+	/** Queue a job. Blocks while there are already 'maxPending' jobs
+	  * queued or in progress.
+	  */
+	void push(std::function<void()> job);
+
+	/** Same as above, but also accepts move-only function objects (e.g.
+	  * a lambda that captured a MemBuffer or unique_ptr).
+	  */
+	template<typename Job>
+	void pushMoveOnly(Job&& job) {
+		auto p = std::make_shared<std::decay_t<Job>>(std::forward<Job>(job));
+		push([p]() { (*p)(); });
+	}
+
+	/** Block until all previously pushed jobs have finished. */
+	void flush();
+
+	/** Number of queued jobs, including the one that's currently being
+	  * executed.
+	  */
+	[[nodiscard]] unsigned getNumPending();
+
+	[[nodiscard]] unsigned getMaxPending() const { return maxPending; }
+
+private:
+	void run();
+
+	std::deque<std::function<void()>> jobs;
+	std::mutex mutex;
+	std::condition_variable jobAvailable; // signaled by producer
+	std::condition_variable jobFinished;  // signaled by worker
+	const unsigned maxPending;
+	unsigned numPending = 0; // jobs.size() + (busy ? 1 : 0)
+	bool exitLoop = false;
+	std::thread thread; // should be initialized last
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,70 @@
+#include "catch.hpp"
+#include "AsyncWavWriter.hh"
+#include "File.hh"
+#include "FileOperations.hh"
+#include "Filename.hh"
+#include "WavData.hh"
+#include <vector>
+
+using namespace openmsx;
+
+TEST_CASE("AsyncWavWriter: mono")
+{
+	auto filename = FileOperations::getTempDir() + "/asyncwavwriter_mono.wav";
+	{
+		AsyncWavWriter writer(Filename(filename), 1, 22050);
+		// much more than one chunk, in pieces that don't line up with
+		// the chunk boundaries
+		std::vector<int16_t> ramp(1000);
+		for (int i = 0; i < 100; ++i) {
+			for (int j = 0; j < 1000; ++j) ramp[j] = int16_t(i * 1000 + j);
+			writer.write(ramp.data(), 1, 1000);
+		}
+		writer.writeSilence(1, 40000);
+		float f[3] = {0.5f, -0.5f, 2.0f};
+		writer.write(f, 1, 3, 0.5f, 0.5f);
+		writer.close();
+	}
+
+	WavData wav(filename);
+	CHECK(wav.getFreq() == 22050);
+	REQUIRE(wav.getSize() == 100000 + 40000 + 3);
+	bool ok = true;
+	for (unsigned i = 0; i < 100000; ++i) ok &= wav.getSample(i) == int16_t(i);
+	for (unsigned i = 100000; i < 140000; ++i) ok &= wav.getSample(i) == 0;
+	CHECK(ok);
+	CHECK(wav.getSample(140000) ==  8192);
+	CHECK(wav.getSample(140001) == -8192);
+	CHECK(wav.getSample(140002) == 32767); // clipped
+	FileOperations::unlink(filename);
+}
+
+TEST_CASE("AsyncWavWriter: stereo")
+{
+	auto filename = FileOperations::getTempDir() + "/asyncwavwriter_stereo.wav";
+	constexpr unsigned NUM = 50000;
+	{
+		AsyncWavWriter writer(Filename(filename), 2, 44100);
+		std::vector<float> buf(2 * NUM);
+		for (unsigned i = 0; i < NUM; ++i) {
+			buf[2 * i + 0] =  0.25f;
+			buf[2 * i + 1] = -0.25f;
+		}
+		writer.write(buf.data(), 2, NUM, 1.0f, 2.0f);
+		// closed by the destructor
+	}
+
+	File file(filename);
+	REQUIRE(file.getSize() == 44 + 4 * NUM);
+	std::vector<Endian::L16> data(2 * NUM);
+	file.seek(44);
+	file.read(data.data(), 4 * NUM);
+	bool ok = true;
+	for (unsigned i = 0; i < NUM; ++i) {
+		ok &= int16_t(data[2 * i + 0]) ==   8192;
+		ok &= int16_t(data[2 * i + 1]) == -16384;
+	}
+	CHECK(ok);
+	file.close();
+	FileOperations::unlink(filename);
+}
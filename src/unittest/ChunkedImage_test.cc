@@ -0,0 +1,170 @@
+#include "catch.hpp"
+#include "ChunkedImage.hh"
+#include "File.hh"
+#include "FileOperations.hh"
+#include "MSXException.hh"
+#include "TigerTree.hh"
+#include "endian.hh"
+#include "random.hh"
+#include "xxhash.hh"
+#include <cstring>
+#include <vector>
+
+using namespace openmsx;
+
+// Hash the content of a ChunkedImage, optionally using its stored hashes.
+struct TTChunkedData final : public TTData
+{
+	TTChunkedData(ChunkedImage& image_, bool useHashes_)
+		: image(image_), useHashes(useHashes_) {}
+
+	uint8_t* getData(size_t offset, size_t size) override
+	{
+		image.read(offset, buffer + 1, size);
+		return buffer + 1;
+	}
+	bool isCacheStillValid(time_t&) override
+	{
+		return false;
+	}
+	const TigerHash* getHash(size_t offset, size_t size) override
+	{
+		return useHashes ? image.getHash(offset, size) : nullptr;
+	}
+
+	ChunkedImage& image;
+	bool useHashes;
+	uint8_t buffer[1024 + 1];
+};
+
+static std::string calcTTH(ChunkedImage& image, bool useHashes, const std::string& name)
+{
+	TTChunkedData data(image, useHashes);
+	TigerTree tt(data, image.getSize(), name);
+	return tt.calcHash({}).toString();
+}
+
+TEST_CASE("ChunkedImage")
+{
+	auto tmp = FileOperations::getTempDir() + "/chunked_image_unittest";
+	FileOperations::deleteRecursive(tmp);
+	FileOperations::mkdirp(tmp);
+	auto rawName     = tmp + "/raw.dsk";
+	auto chunkedName = tmp + "/image.chunked";
+	auto overlayName = tmp + "/overlay";
+
+	// partly random, partly compressible, partly zero, partial last chunk
+	constexpr size_t SIZE = 10 * 4096 + 1536;
+	std::vector<uint8_t> content(SIZE);
+	auto& gen = global_urng();
+	std::uniform_int_distribution<int> distr(0, 255);
+	for (size_t i = 0; i < 4096; ++i) content[i] = uint8_t(distr(gen));
+	for (size_t i = 4096; i < 3 * 4096; ++i) content[i] = uint8_t(i / 100);
+	for (size_t i = 6 * 4096; i < SIZE; ++i) content[i] = uint8_t(distr(gen));
+	{
+		File raw(rawName, File::TRUNCATE);
+		raw.write(content.data(), content.size());
+	}
+	{
+		File raw(rawName);
+		ChunkedImage::create(raw, chunkedName, 4096);
+	}
+
+	auto check = [&](ChunkedImage& image) {
+		REQUIRE(image.getSize() == SIZE);
+		std::vector<uint8_t> buf(SIZE);
+		image.read(0, buf.data(), SIZE);
+		CHECK(buf == content);
+		image.read(4000, buf.data(), 5000); // crosses a chunk boundary
+		CHECK(memcmp(buf.data(), &content[4000], 5000) == 0);
+	};
+
+	SECTION("base image") {
+		ChunkedImage image(chunkedName);
+		CHECK(image.isReadOnly());
+		check(image);
+		CHECK(image.getHash(0, 4096) != nullptr);
+		CHECK(image.getHash(0, 2048) == nullptr);
+		CHECK(image.getHash(10 * 4096, 1536) == nullptr); // partial last chunk
+		// the stored hashes give the same result as hashing the data
+		CHECK(calcTTH(image, true, "a") == calcTTH(image, false, "b"));
+	}
+	SECTION("overlay") {
+		ChunkedImage::createOverlay("image.chunked", overlayName); // relative to overlay
+		{
+			ChunkedImage image(overlayName);
+			CHECK(!image.isReadOnly());
+			check(image);
+			uint8_t data[600];
+			memset(data, 0x55, sizeof(data));
+			image.write(4000, data, sizeof(data));
+			image.write(7 * 4096, data, 10); // in a zero chunk
+			memcpy(&content[4000], data, sizeof(data));
+			memcpy(&content[7 * 4096], data, 10);
+			check(image);
+			CHECK(image.getHash(0, 4096) == nullptr); // modified
+			CHECK(image.getHash(2 * 4096, 4096) != nullptr);
+			CHECK(calcTTH(image, true, "c") == calcTTH(image, false, "d"));
+		}
+		{
+			// modifications are persistent, base image is unchanged
+			ChunkedImage image(overlayName);
+			check(image);
+			ChunkedImage base(chunkedName);
+			uint8_t b;
+			base.read(4000, &b, 1);
+			CHECK(b != 0x55);
+		}
+		// the base image must not be modified anymore
+		{
+			File raw(rawName);
+			ChunkedImage::create(raw, chunkedName, 8192);
+		}
+		CHECK_THROWS_AS(ChunkedImage(overlayName), MSXException);
+	}
+	SECTION("malformed chunk") {
+		// Replace the compressed data of chunk 1 with crafted LZ4 data,
+		// with a matching size and checksum in the chunk table.
+		auto craft = [&](const std::vector<uint8_t>& data) {
+			File file(chunkedName);
+			uint8_t entry[16];
+			file.seek(32 + 1 * 40); // header, chunk table entry 1
+			file.read(entry, sizeof(entry));
+			auto offset = Endian::read_UA_L64(entry + 0);
+			REQUIRE(Endian::read_UA_L32(entry + 8) < 4096); // compressed
+			auto size = uint32_t(data.size());
+			Endian::write_UA_L32(entry +  8, size);
+			Endian::write_UA_L32(entry + 12, xxhash_impl<false>(data.data(), size));
+			file.seek(offset);
+			file.write(data.data(), size);
+			file.seek(32 + 1 * 40);
+			file.write(entry, sizeof(entry));
+		};
+		auto checkThrows = [&] {
+			ChunkedImage image(chunkedName);
+			uint8_t buf[16];
+			image.read(0, buf, sizeof(buf)); // chunk 0 is fine
+			CHECK_THROWS_AS(image.read(4096, buf, sizeof(buf)), MSXException);
+		};
+		// a match referring to data before the start of the chunk
+		craft({0x1F, 0x41, 0xFF, 0xFF, 0xFF, 0xFF, 0x00});
+		checkThrows();
+		// a match that's longer than the chunk
+		craft({0x1F, 0x41, 0x01, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+		       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00});
+		checkThrows();
+		// literals beyond the end of the input
+		craft({0xF0, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x41, 0x41});
+		checkThrows();
+		// valid, but decodes to less than a full chunk
+		craft({0x10, 0x41});
+		checkThrows();
+	}
+	SECTION("not a chunked image") {
+		File raw(rawName);
+		CHECK(!ChunkedImage::isChunkedImage(raw));
+		CHECK_THROWS_AS(ChunkedImage(rawName), MSXException);
+	}
+
+	FileOperations::deleteRecursive(tmp);
+}
@@ -0,0 +1,146 @@
+#include "catch.hpp"
+#include "DirectoryWatcher.hh"
+#include "File.hh"
+#include "FileOperations.hh"
+#include "foreach_file.hh"
+#include "strCat.hh"
+#include "Timer.hh"
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace openmsx;
+
+static void writeFile(const std::string& filename, const std::string& content)
+{
+	File file(filename, File::TRUNCATE);
+	file.write(content.data(), content.size());
+}
+
+using Dirs = std::vector<std::string>;
+
+TEST_CASE("DirectoryWatcher")
+{
+	auto tmp = FileOperations::getTempDir() + "/directory_watcher_unittest/";
+	FileOperations::deleteRecursive(tmp);
+	FileOperations::mkdirp(tmp + "sub");
+	FileOperations::mkdirp(tmp + ".hidden");
+	writeFile(tmp + "a.txt", "a");
+	writeFile(tmp + "sub/b.txt", "b");
+
+	DirectoryWatcher watcher(tmp);
+	if (!watcher.isActive()) {
+		// not supported on this platform
+		CHECK(watcher.hasChanges());
+		CHECK(watcher.getChanges().all);
+		FileOperations::deleteRecursive(tmp);
+		return;
+	}
+
+	// initial state is not a change
+	CHECK(!watcher.hasChanges());
+	auto changes = watcher.getChanges();
+	CHECK(!changes.all);
+	CHECK(changes.dirs.empty());
+
+	// create file in the top directory
+	writeFile(tmp + "c.txt", "c");
+	CHECK(watcher.hasChanges());
+	changes = watcher.getChanges();
+	CHECK(!changes.all);
+	CHECK(changes.dirs == Dirs{""});
+	CHECK(!watcher.hasChanges());
+
+	// modify file in a subdirectory
+	writeFile(tmp + "sub/b.txt", "bb");
+	CHECK(watcher.getChanges().dirs == Dirs{"sub/"});
+
+	// hidden directories are not watched, unless requested
+	{
+		DirectoryWatcher all(tmp, true);
+		writeFile(tmp + ".hidden/d.txt", "d");
+		CHECK(!watcher.hasChanges());
+		CHECK(all.getChanges().dirs == Dirs{".hidden/"});
+	}
+
+	// new subdirectory (and its content) is watched as well
+	FileOperations::mkdirp(tmp + "new/deeper");
+	writeFile(tmp + "new/deeper/e.txt", "e");
+	changes = watcher.getChanges();
+	CHECK(changes.dirs.front() == ""); // parents come first
+	CHECK(!watcher.hasChanges());
+	writeFile(tmp + "new/deeper/e.txt", "ee");
+	CHECK(watcher.getChanges().dirs == Dirs{"new/deeper/"});
+
+	// rename subdirectory
+	REQUIRE(std::rename((tmp + "new").c_str(), (tmp + "renamed").c_str()) == 0);
+	changes = watcher.getChanges();
+	CHECK(changes.dirs.front() == "");
+	CHECK(!watcher.hasChanges());
+	writeFile(tmp + "renamed/deeper/e.txt", "eee");
+	CHECK(watcher.getChanges().dirs == Dirs{"renamed/deeper/"});
+
+	// delete files and subdirectories
+	FileOperations::unlink(tmp + "a.txt");
+	FileOperations::deleteRecursive(tmp + "sub");
+	changes = watcher.getChanges();
+	CHECK(!changes.all);
+	CHECK(changes.dirs == Dirs{"", "sub/"});
+
+	FileOperations::deleteRecursive(tmp);
+	CHECK(watcher.getChanges().all);
+}
+
+TEST_CASE("DirectoryWatcher: benchmark", "[.benchmark]")
+{
+	// e.g. a DirAsDSK directory with a large (mostly unrelated) tree
+	auto tmp = FileOperations::getTempDir() + "/directory_watcher_benchmark/";
+	FileOperations::deleteRecursive(tmp);
+	constexpr int NUM_DIRS = 100;
+	constexpr int FILES_PER_DIR = 200;
+	for (int d = 0; d < NUM_DIRS; ++d) {
+		auto dir = strCat(tmp, "dir", d, '/');
+		FileOperations::mkdirp(dir);
+		for (int f = 0; f < FILES_PER_DIR; ++f) {
+			writeFile(strCat(dir, "file", f, ".txt"), "x");
+		}
+	}
+
+	constexpr int REPEAT = 10;
+
+	// what a sync without change notification does: stat all files
+	auto start = Timer::getTime();
+	size_t count = 0;
+	for (int r = 0; r < REPEAT; ++r) {
+		foreach_file_recursive(tmp, [&](const std::string&, const FileOperations::Stat&) {
+			++count;
+		});
+	}
+	auto rescan = Timer::getTime() - start; // us
+	CHECK(count == size_t(REPEAT * NUM_DIRS * FILES_PER_DIR));
+
+	start = Timer::getTime();
+	DirectoryWatcher watcher(tmp);
+	auto setup = Timer::getTime() - start;
+
+	// with change notification: only look at the changed directories
+	start = Timer::getTime();
+	for (int r = 0; r < REPEAT; ++r) {
+		auto dir = strCat(tmp, "dir", r, '/');
+		writeFile(dir + "file0.txt", "y");
+		auto changes = watcher.getChanges();
+		for (const auto& d : changes.dirs) {
+			foreach_file(tmp + d, [&](const std::string&, const FileOperations::Stat&) {});
+		}
+	}
+	auto incremental = Timer::getTime() - start;
+
+	std::cout << NUM_DIRS * FILES_PER_DIR << " files, per sync:\n"
+	          << "  full rescan: " << (rescan / REPEAT) << "us\n"
+	          << "  watcher (" << (watcher.isActive() ? "active" : "inactive")
+	          << "): " << (incremental / REPEAT) << "us (setup "
+	          << setup << "us)\n";
+
+	FileOperations::deleteRecursive(tmp);
+}
@@ -1,6 +1,7 @@
 #include "catch.hpp"
 
 #include "FilePoolCore.hh"
+#include "Date.hh"
 #include "File.hh"
 #include "FileOperations.hh"
 #include "one_of.hh"
@@ -117,19 +118,140 @@ TEST_CASE("FilePoolCore")
 		}
 	}
 
-	// write 'filecache' to disk
+	// 'filecache' was written to disk, a new pool finds the files without
+	// scanning the directories
+	{
+		FilePoolCore pool(tmp + "/cache",
+				  [] { return FilePoolCore::Directories(); },
+				  [](const std::string&) { /* report progress: nothing */});
+		auto file1 = pool.getFile(FileType::ROM, Sha1Sum("637a81ed8e8217bb01c15c67c39b43b0ab4e20f1"));
+		CHECK(file1.is_open());
+		CHECK(file1.getURL() == tmp + "/e");
+		auto file2 = pool.getFile(FileType::ROM, Sha1Sum("7e240de74fb1ed08fa08d38063f6a6a91462a815"));
+		CHECK(file2.is_open());
+		CHECK(file2.getURL() == one_of(tmp + "/a", tmp + "/a2"));
+		auto file3 = pool.getFile(FileType::ROM, Sha1Sum("f36b4825e5db2cf7dd2d2593b3f5c24c0311d8b2"));
+		CHECK(file3.is_open());
+		CHECK(file3.getURL() == tmp + "/c");
+		auto file4 = pool.getFile(FileType::ROM, Sha1Sum("aa6878b1c31a9420245df1daffb7b223338737a3"));
+		CHECK(!file4.is_open());
+	}
+
+	FileOperations::deleteRecursive(tmp);
+}
+
+TEST_CASE("FilePoolCore: file modified in place")
+{
+	auto tmp = FileOperations::getTempDir() + "/filepool_unittest";
+	FileOperations::deleteRecursive(tmp);
+	FileOperations::mkdirp(tmp);
+	createFile(tmp + "/d", "ddd"); // 9c969ddf454079e3d439973bbab63ea6233e4087
+	Timer::sleep(1'000'000); // sleep because timestamps are only accurate to 1 second
+
+	auto getDirectories = [&] {
+		FilePoolCore::Directories result;
+		result.push_back(FilePoolCore::Dir{tmp, FileType::ROM});
+		return result;
+	};
+	FilePoolCore pool(tmp + "/cache",
+			  getDirectories,
+			  [](const std::string&) { /* report progress: nothing */});
+
+	// scan the directory (lookup, not present)
+	{
+		auto file = pool.getFile(FileType::ROM, Sha1Sum("4ed61e15c9f84e9fc98ae553ff46010035aac24d"));
+		CHECK(!file.is_open());
+	}
+	// overwrite the content of the existing file, this does not change
+	// the modification time of the directory
+	auto getDirTime = [&] {
+		FileOperations::Stat st;
+		REQUIRE(FileOperations::getStat(tmp, st));
+		return FileOperations::getModificationDate(st);
+	};
+	auto dirTime = getDirTime();
+	Timer::sleep(1'000'000);
+	createFile(tmp + "/d", "DDD"); // 4ed61e15c9f84e9fc98ae553ff46010035aac24d
+	CHECK(getDirTime() == dirTime);
+	{
+		auto file = pool.getFile(FileType::ROM, Sha1Sum("4ed61e15c9f84e9fc98ae553ff46010035aac24d"));
+		CHECK(file.is_open());
+		CHECK(file.getURL() == tmp + "/d");
+	}
+	{
+		auto file = pool.getFile(FileType::ROM, Sha1Sum("9c969ddf454079e3d439973bbab63ea6233e4087"));
+		CHECK(!file.is_open());
+	}
+
+	FileOperations::deleteRecursive(tmp);
+}
+
+TEST_CASE("FilePoolCore: changes after a complete scan")
+{
+	auto tmp = FileOperations::getTempDir() + "/filepool_unittest";
+	FileOperations::deleteRecursive(tmp);
+	FileOperations::mkdirp(tmp + "/a");
+	createFile(tmp + "/a/a", "aaa"); // 7e240de74fb1ed08fa08d38063f6a6a91462a815
+
+	auto getDirectories = [&] {
+		FilePoolCore::Directories result;
+		result.push_back(FilePoolCore::Dir{tmp, FileType::ROM});
+		return result;
+	};
+	FilePoolCore pool(tmp + "/cache",
+			  getDirectories,
+			  [](const std::string&) { /* report progress: nothing */});
+	auto find = [&](const char* sum) {
+		auto file = pool.getFile(FileType::ROM, Sha1Sum(sum));
+		return file.is_open() ? file.getURL() : std::string();
+	};
+
+	// complete scan (lookup, not present)
+	CHECK(find("4ed61e15c9f84e9fc98ae553ff46010035aac24d") == "");
+
+	// new file in an existing subdirectory
+	createFile(tmp + "/a/d", "DDD"); // 4ed61e15c9f84e9fc98ae553ff46010035aac24d
+	CHECK(find("4ed61e15c9f84e9fc98ae553ff46010035aac24d") == tmp + "/a/d");
+
+	// new (nested, hidden) subdirectories
+	FileOperations::mkdirp(tmp + "/b/.c");
+	createFile(tmp + "/b/.c/d", "ddd"); // 9c969ddf454079e3d439973bbab63ea6233e4087
+	CHECK(find("9c969ddf454079e3d439973bbab63ea6233e4087") == tmp + "/b/.c/d");
+
+	// not present, nothing changed
+	CHECK(find("e1f2a2c5a2e3dbcf7f1bcad1b7b1e2e2e4e4c3c3") == "");
+
+	// new file in the top directory, the earlier files are still found
+	createFile(tmp + "/e", "eee"); // 637a81ed8e8217bb01c15c67c39b43b0ab4e20f1
+	CHECK(find("637a81ed8e8217bb01c15c67c39b43b0ab4e20f1") == tmp + "/e");
+	CHECK(find("7e240de74fb1ed08fa08d38063f6a6a91462a815") == tmp + "/a/a");
+
+	FileOperations::deleteRecursive(tmp);
+}
+
+TEST_CASE("FilePoolCore: old text format")
+{
+	auto tmp = FileOperations::getTempDir() + "/filepool_unittest";
+	FileOperations::deleteRecursive(tmp);
+	FileOperations::mkdirp(tmp);
+	createFile(tmp + "/a",  "aaa"); // 7e240de74fb1ed08fa08d38063f6a6a91462a815
+	auto time = File(tmp + "/a").getModificationDate();
+	createFile(tmp + "/cache",
+	           "7e240de74fb1ed08fa08d38063f6a6a91462a815  " +
+	           Date::toString(time) + "  " + tmp + "/a\n");
+
+	auto noDirectories = [] { return FilePoolCore::Directories(); };
+	for (int i = 0; i < 2; ++i) {
+		// first read the text format, then the converted binary format
+		FilePoolCore pool(tmp + "/cache", noDirectories,
+				  [](const std::string&) { /* report progress: nothing */});
+		auto file = pool.getFile(FileType::ROM, Sha1Sum("7e240de74fb1ed08fa08d38063f6a6a91462a815"));
+		CHECK(file.is_open());
+		CHECK(file.getURL() == tmp + "/a");
+	}
 	auto lines = readLines(tmp + "/cache");
-	CHECK(lines.size() == 4);
-	CHECK(StringOp::startsWith(lines[0], "637a81ed8e8217bb01c15c67c39b43b0ab4e20f1"));
-	CHECK(StringOp::endsWith(lines[0], tmp + "/e"));
-	CHECK(StringOp::startsWith(lines[1], "7e240de74fb1ed08fa08d38063f6a6a91462a815"));
-	CHECK((StringOp::endsWith(lines[1], tmp + "/a") ||
-	       StringOp::endsWith(lines[1], tmp + "/a2")));
-	CHECK(StringOp::startsWith(lines[2], "7e240de74fb1ed08fa08d38063f6a6a91462a815"));
-	CHECK((StringOp::endsWith(lines[2], tmp + "/a") ||
-	       StringOp::endsWith(lines[2], tmp + "/a2")));
-	CHECK(StringOp::startsWith(lines[3], "f36b4825e5db2cf7dd2d2593b3f5c24c0311d8b2"));
-	CHECK(StringOp::endsWith(lines[3], tmp + "/c"));
+	CHECK(!lines.empty());
+	CHECK(!StringOp::startsWith(lines[0], "7e240de74fb1ed08fa08d38063f6a6a91462a815"));
 
 	FileOperations::deleteRecursive(tmp);
 }
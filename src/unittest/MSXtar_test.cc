@@ -0,0 +1,207 @@
+#include "catch.hpp"
+
+#include "MSXtar.hh"
+#include "RamDSKDiskImage.hh"
+#include "DiskImageUtils.hh"
+#include "FileOperations.hh"
+#include "MSXException.hh"
+#include "StringOp.hh"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace openmsx;
+
+using Data = std::vector<char>;
+
+static Data makeData(size_t size, unsigned seed)
+{
+	Data result(size);
+	unsigned x = seed;
+	for (auto& c : result) {
+		x = x * 1103515245 + 12345;
+		c = char(x >> 16);
+	}
+	return result;
+}
+
+static void createFile(const std::string& filename, const Data& data)
+{
+	std::ofstream of(filename, std::ios::binary);
+	of.write(data.data(), data.size());
+}
+
+static Data readFile(const std::string& filename)
+{
+	std::ifstream is(filename, std::ios::binary);
+	return Data(std::istreambuf_iterator<char>(is),
+	            std::istreambuf_iterator<char>());
+}
+
+// A formatted in-memory disk image, plus a temp directory for the host files.
+struct Fixture
+{
+	Fixture()
+		: tmp(FileOperations::getTempDir() + "/msxtar_unittest")
+	{
+		FileOperations::deleteRecursive(tmp);
+		FileOperations::mkdirp(tmp + "/in");
+		FileOperations::mkdirp(tmp + "/out");
+	}
+	~Fixture()
+	{
+		FileOperations::deleteRecursive(tmp);
+	}
+
+	std::string add(const std::string& name, const Data& data)
+	{
+		createFile(tmp + "/in/" + name, data);
+		MSXtar tar(disk);
+		return tar.addFile(tmp + "/in/" + name);
+	}
+	Data extract(const std::string& name)
+	{
+		MSXtar tar(disk);
+		tar.getItemFromDir(tmp + "/out", name);
+		return readFile(tmp + "/out/" + name);
+	}
+
+	// Read a FAT entry directly from the image.
+	unsigned readFAT(unsigned cluster)
+	{
+		unsigned offset = (cluster * 3) / 2;
+		SectorBuffer buf;
+		uint8_t p[2];
+		for (unsigned i = 0; i < 2; ++i) {
+			disk.readSector(1 + (offset + i) / 512, buf);
+			p[i] = buf.raw[(offset + i) % 512];
+		}
+		return (cluster & 1) ? (p[0] >> 4) + (p[1] << 4)
+		                     : p[0] + ((p[1] & 0x0F) << 8);
+	}
+	void writeFAT(unsigned cluster, unsigned value)
+	{
+		unsigned offset = (cluster * 3) / 2;
+		SectorBuffer buf;
+		for (unsigned i = 0; i < 2; ++i) {
+			unsigned sector = 1 + (offset + i) / 512;
+			disk.readSector(sector, buf);
+			auto& p = buf.raw[(offset + i) % 512];
+			if (i == 0) {
+				p = (cluster & 1) ? ((p & 0x0F) | (value << 4))
+				                  : value;
+			} else {
+				p = (cluster & 1) ? (value >> 4)
+				                  : ((p & 0xF0) | ((value >> 8) & 0x0F));
+			}
+			disk.writeSector(sector, buf);
+		}
+	}
+
+	// Delete a file in the root directory (MSXtar itself can't do that).
+	void remove(const std::string& msxName)
+	{
+		SectorBuffer buf;
+		disk.readSector(0, buf);
+		unsigned rootDir = 1 + buf.bootSector.nrFats * buf.bootSector.sectorsFat;
+		unsigned numSectors = buf.bootSector.dirEntries / 16;
+		for (unsigned s = rootDir; s < rootDir + numSectors; ++s) {
+			disk.readSector(s, buf);
+			for (auto& entry : buf.dirEntry) {
+				if (memcmp(entry.filename, msxName.data(), 11) != 0) continue;
+				unsigned cluster = entry.startCluster;
+				while ((2 <= cluster) && (cluster < 0xFF7)) {
+					unsigned next = readFAT(cluster);
+					writeFAT(cluster, 0);
+					cluster = next;
+				}
+				entry.filename[0] = char(0xE5);
+				disk.writeSector(s, buf);
+				return;
+			}
+		}
+		FAIL("not found: " << msxName);
+	}
+
+	RamDSKDiskImage disk; // 720kB, 2 sectors per cluster
+	std::string tmp;
+};
+
+TEST_CASE("MSXtar: round trip")
+{
+	Fixture f;
+	struct Test {
+		std::string name;
+		size_t size;
+	} tests[] = {
+		{"empty.bin",   0},
+		{"partial.bin", 3 * 1024 + 123}, // ends in a partial sector
+		{"sector.bin",  3 * 512}, // ends in a partial cluster
+		{"big.bin",     200 * 1024}, // several runs of MAX_RUN_SECTORS
+	};
+	unsigned seed = 0;
+	for (auto& t : tests) {
+		INFO(t.name);
+		auto data = makeData(t.size, ++seed);
+		CHECK(f.add(t.name, data).empty());
+		CHECK(f.extract(t.name) == data);
+	}
+	// all files are (still) intact
+	seed = 0;
+	for (auto& t : tests) {
+		INFO(t.name);
+		CHECK(f.extract(t.name) == makeData(t.size, ++seed));
+	}
+}
+
+TEST_CASE("MSXtar: fragmented chain")
+{
+	Fixture f;
+	auto a = makeData(5 * 1024, 1); // clusters 2-6
+	auto b = makeData(3 * 1024, 2); // clusters 7-9
+	auto c = makeData(2 * 1024, 3); // clusters 10-11
+	f.add("a.bin", a);
+	f.add("b.bin", b);
+	f.add("c.bin", c);
+	f.remove("B       BIN");
+
+	// fills the hole of 'b' first, then continues after 'c'
+	auto d = makeData(8 * 1024 + 100, 4);
+	CHECK(f.add("d.bin", d).empty());
+	CHECK(f.readFAT(9) == 12);
+
+	CHECK(f.extract("a.bin") == a);
+	CHECK(f.extract("c.bin") == c);
+	CHECK(f.extract("d.bin") == d);
+}
+
+TEST_CASE("MSXtar: existing file is preserved")
+{
+	// There's no overwrite option (yet): adding a (shorter) file with the
+	// same name leaves the existing file untouched.
+	Fixture f;
+	auto longer = makeData(4 * 1024 + 1, 1);
+	auto shorter = makeData(1000, 2);
+	CHECK(f.add("x.bin", longer).empty());
+	CHECK(StringOp::startsWith(f.add("x.bin", shorter), "Warning: preserving entry"));
+	CHECK(f.extract("x.bin") == longer);
+}
+
+TEST_CASE("MSXtar: disk full")
+{
+	Fixture f;
+	auto data = makeData(800 * 1024, 1); // doesn't fit on a 720kB disk
+	CHECK_THROWS_AS(f.add("full.bin", data), MSXException);
+
+	// the file is truncated to a whole number of clusters
+	auto result = f.extract("full.bin");
+	CHECK(result.size() > 700 * 1024);
+	CHECK(result.size() < data.size());
+	CHECK((result.size() % 1024) == 0);
+	CHECK(std::equal(result.begin(), result.end(), data.begin()));
+
+	// no space left for another file
+	CHECK_THROWS_AS(f.add("more.bin", makeData(1, 2)), MSXException);
+}
@@ -0,0 +1,61 @@
+#include "catch.hpp"
+#include "RawVideoWriter.hh"
+#include "PixelFormat.hh"
+#include <cstdint>
+
+using namespace openmsx;
+
+TEST_CASE("RawVideoWriter: Y4M header")
+{
+	CHECK(RawVideoWriter::getY4MHeader(320, 240, 50.0f) ==
+	      "YUV4MPEG2 W320 H240 F50000:1000 Ip A1:1 C444 XCOLORRANGE=LIMITED\n");
+	CHECK(RawVideoWriter::getY4MHeader(640, 480, 59.922743f) ==
+	      "YUV4MPEG2 W640 H480 F59923:1000 Ip A1:1 C444 XCOLORRANGE=LIMITED\n");
+}
+
+TEST_CASE("RawVideoWriter: toRGB")
+{
+	SECTION("32bpp") {
+		PixelFormat format(32,
+			0x000000FF,  0, 0,
+			0x0000FF00,  8, 0,
+			0x00FF0000, 16, 0,
+			0xFF000000, 24, 0);
+		uint32_t in[2] = {0xFF332211, 0xFFFFFFFF};
+		uint8_t out[6];
+		RawVideoWriter::toRGB(in, format, 2, out);
+		CHECK(out[0] == 0x11); CHECK(out[1] == 0x22); CHECK(out[2] == 0x33);
+		CHECK(out[3] == 0xFF); CHECK(out[4] == 0xFF); CHECK(out[5] == 0xFF);
+	}
+	SECTION("16bpp (565)") {
+		PixelFormat format(16,
+			0xF800, 11, 3,
+			0x07E0,  5, 2,
+			0x001F,  0, 3,
+			0x0000,  0, 8);
+		uint16_t in[3] = {0x0000, 0xFFFF, 0x8410};
+		uint8_t out[9];
+		RawVideoWriter::toRGB(in, format, 3, out);
+		// full range is preserved: 0 -> 0, max -> 255
+		CHECK(out[0] == 0x00); CHECK(out[1] == 0x00); CHECK(out[2] == 0x00);
+		CHECK(out[3] == 0xFF); CHECK(out[4] == 0xFF); CHECK(out[5] == 0xFF);
+		// 10000 -> 10000100, 100000 -> 10000010
+		CHECK(out[6] == 0x84); CHECK(out[7] == 0x82); CHECK(out[8] == 0x84);
+	}
+}
+
+TEST_CASE("RawVideoWriter: rgbToYCbCr")
+{
+	const uint8_t rgb[] = {
+		0x00, 0x00, 0x00, // black
+		0xFF, 0xFF, 0xFF, // white
+		0xFF, 0x00, 0x00, // red
+		0x00, 0x00, 0xFF, // blue
+	};
+	uint8_t y[4], cb[4], cr[4];
+	RawVideoWriter::rgbToYCbCr(rgb, 4, y, cb, cr);
+	CHECK(int(y[0]) ==  16); CHECK(int(cb[0]) == 128); CHECK(int(cr[0]) == 128);
+	CHECK(int(y[1]) == 235); CHECK(int(cb[1]) == 128); CHECK(int(cr[1]) == 128);
+	CHECK(int(y[2]) ==  82); CHECK(int(cb[2]) ==  90); CHECK(int(cr[2]) == 240);
+	CHECK(int(y[3]) ==  41); CHECK(int(cb[3]) == 240); CHECK(int(cr[3]) == 110);
+}
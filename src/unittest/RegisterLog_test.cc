@@ -0,0 +1,110 @@
+#include "catch.hpp"
+#include "RegisterLogWriter.hh"
+#include "RegisterLogPlayer.hh"
+#include "MSXException.hh"
+#include <cstdint>
+#include <vector>
+
+using namespace openmsx;
+using Chip = RegisterLogger::Chip;
+
+static EmuDuration ticks(uint64_t t) { return EmuDuration(t); }
+
+static uint32_t read32(const std::vector<uint8_t>& v, size_t offset)
+{
+	return v[offset + 0] <<  0 | v[offset + 1] <<  8 |
+	       v[offset + 2] << 16 | uint32_t(v[offset + 3]) << 24;
+}
+
+TEST_CASE("RegisterLog: native format round trip")
+{
+	auto encoder = RegisterLogWriter::createEncoder(RegisterLogWriter::Format::NATIVE);
+	std::vector<uint8_t> out;
+	encoder->encodeStart(out);
+	std::vector<uint8_t> ram = {1, 2, 3, 4, 5};
+	REQUIRE(encoder->accept(Chip::AY8910));
+	REQUIRE(encoder->accept(Chip::Y8950));
+	encoder->encodeDevice(out, 0, Chip::AY8910, "PSG", {});
+	encoder->encodeDevice(out, 1, Chip::Y8950, "MSX-AUDIO", ram);
+	encoder->encodeWrite(out, 0, Chip::AY8910, 0, 7, 0xB8, ticks(0));
+	encoder->encodeWrite(out, 1, Chip::Y8950, 0, 0x20, 0x01, ticks(0));
+	encoder->encodeWrite(out, 0, Chip::AY8910, 0, 8, 15, ticks(100));
+	encoder->encodeMarker(out, ticks(12345678));
+	encoder->encodeWrite(out, 1, Chip::Y8950, 0, 0xA0, 0x55, ticks(3579545ull * 960 * 100));
+	encoder->encodeEnd(out, ticks(3579545ull * 960 * 101));
+	CHECK(encoder->getHeader(out.size()).empty());
+
+	auto log = RegisterLog::parse(out);
+	REQUIRE(log.devices.size() == 2);
+	CHECK(log.devices[0].name == "PSG");
+	CHECK(log.devices[0].chip == Chip::AY8910);
+	CHECK(log.devices[0].memory.empty());
+	CHECK(log.devices[1].name == "MSX-AUDIO");
+	CHECK(log.devices[1].chip == Chip::Y8950);
+	CHECK(log.devices[1].memory == ram);
+
+	REQUIRE(log.writes.size() == 4);
+	auto check = [&](size_t i, uint64_t time, int device, int reg, int value) {
+		CHECK(log.writes[i].time == time);
+		CHECK(log.writes[i].device == device);
+		CHECK(log.writes[i].port == 0);
+		CHECK(log.writes[i].reg == reg);
+		CHECK(log.writes[i].value == value);
+	};
+	check(0, 0, 0, 7, 0xB8);
+	check(1, 0, 1, 0x20, 0x01);
+	check(2, 100, 0, 8, 15);
+	check(3, 3579545ull * 960 * 100, 1, 0xA0, 0x55);
+	REQUIRE(log.markers.size() == 1);
+	CHECK(log.markers[0] == 12345678);
+	CHECK(log.length == 3579545ull * 960 * 101);
+
+	// truncated or corrupt files are rejected
+	auto truncated = out;
+	truncated.pop_back();
+	CHECK_THROWS_AS(RegisterLog::parse(truncated), MSXException);
+	auto corrupt = out;
+	corrupt[0] = 'X';
+	CHECK_THROWS_AS(RegisterLog::parse(corrupt), MSXException);
+}
+
+TEST_CASE("RegisterLog: VGM format")
+{
+	constexpr uint64_t SAMPLE = 3579545ull * 960 / 44100; // (rounded down)
+
+	auto encoder = RegisterLogWriter::createEncoder(RegisterLogWriter::Format::VGM);
+	std::vector<uint8_t> out;
+	encoder->encodeStart(out);
+	REQUIRE(out.size() == 0x100);
+	CHECK( encoder->accept(Chip::AY8910));
+	CHECK(!encoder->accept(Chip::AY8910)); // only one per type
+	CHECK( encoder->accept(Chip::SCC));
+	encoder->encodeDevice(out, 0, Chip::AY8910, "PSG", {});
+	encoder->encodeDevice(out, 1, Chip::SCC, "SCC", {});
+	CHECK(out.size() == 0x100);
+
+	encoder->encodeWrite(out, 0, Chip::AY8910, 0, 7, 0xB8, ticks(0));
+	encoder->encodeWrite(out, 0, Chip::AY8910, 0, 8, 15, ticks(3 * SAMPLE + 1));
+	encoder->encodeWrite(out, 1, Chip::SCC, 4, 0x10, 0x20, ticks((3 + 735) * SAMPLE + 800));
+	encoder->encodeEnd(out, EmuDuration(1.0));
+	std::vector<uint8_t> expected = {
+		0xA0, 7, 0xB8,
+		0x72, // wait 3 samples
+		0xA0, 8, 15,
+		0x62, // wait 735 samples
+		0xD2, 4, 0x10, 0x20,
+		0x61, 0x62, 0xA9, // wait 44100 - 738 samples
+		0x66,
+	};
+	CHECK(std::vector<uint8_t>(out.begin() + 0x100, out.end()) == expected);
+
+	auto header = encoder->getHeader(out.size());
+	REQUIRE(header.size() == 0x100);
+	CHECK(read32(header, 0x00) == 0x206D6756); // "Vgm "
+	CHECK(read32(header, 0x04) == out.size() - 4);
+	CHECK(read32(header, 0x18) == 44100);
+	CHECK(read32(header, 0x34) == 0x100 - 0x34);
+	CHECK(read32(header, 0x74) == 1789773);
+	CHECK(read32(header, 0x9C) == (1789773 | 0x80000000)); // SCC+ used
+	CHECK(read32(header, 0x10) == 0); // no YM2413
+}
@@ -0,0 +1,113 @@
+#include "catch.hpp"
+#include "ResampleHQKernels.hh"
+#include "MemBuffer.hh"
+#include "Timer.hh"
+#include "random.hh"
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace openmsx;
+using namespace openmsx::ResampleHQKernels;
+
+static const char* kernelName(Kernel kernel)
+{
+	switch (kernel) {
+	case Kernel::SCALAR: return "scalar";
+	case Kernel::SSE2:   return "SSE2";
+	case Kernel::AVX2:   return "AVX2";
+	}
+	return "?";
+}
+
+// Coefficient rows like ResampleHQ uses them: 'len' a multiple of 8 and
+// each row 32-byte aligned.
+struct TestData {
+	TestData(unsigned len_, unsigned channels, unsigned numRows, unsigned numOut,
+	         bool sequential = false)
+		: len(len_), table(numRows * len)
+	{
+		auto& gen = global_urng();
+		std::uniform_real_distribution<float> distr(-1.0f, 1.0f);
+		for (unsigned i = 0; i < numRows * len; ++i) table[i] = distr(gen);
+		input.resize((numOut + len + 1) * channels);
+		for (auto& s : input) s = distr(gen);
+
+		std::uniform_int_distribution<unsigned> rowDistr(0, numRows - 1);
+		for (unsigned i = 0; i < numOut; ++i) {
+			// ResampleHQ permutes the table so that it's visited
+			// (mostly) sequentially
+			unsigned r = sequential ? (i % (numRows - 1)) : rowDistr(gen);
+			bool reverse = (i % 3) == 1;
+			const float* tab = &table[(reverse ? r + 1 : r) * len];
+			rows.push_back({&input[i * channels], tab, reverse});
+		}
+	}
+
+	unsigned len;
+	MemBuffer<float, 32> table;
+	std::vector<float> input;
+	std::vector<Row> rows;
+};
+
+TEST_CASE("ResampleHQKernels: all kernels give the same result")
+{
+	CHECK(isSupported(Kernel::SCALAR));
+	CHECK(isSupported(getBestKernel()));
+
+	for (unsigned channels : {1, 2}) {
+		for (unsigned len : {8, 16, 40, 96}) {
+			for (unsigned num : {1, 3, 4, 5, 37}) {
+				TestData data(len, channels, 16, num);
+				auto run = [&](Kernel kernel) {
+					std::vector<float> out(num * channels);
+					if (channels == 1) {
+						calc<1>(kernel, data.rows.data(), num, len, out.data());
+					} else {
+						calc<2>(kernel, data.rows.data(), num, len, out.data());
+					}
+					return out;
+				};
+				auto expected = run(Kernel::SCALAR);
+				for (auto kernel : {Kernel::SSE2, Kernel::AVX2}) {
+					if (!isSupported(kernel)) continue;
+					auto out = run(kernel);
+					for (unsigned i = 0; i < out.size(); ++i) {
+						// only the summation order differs
+						CHECK(std::abs(out[i] - expected[i]) < 1e-4f);
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE("ResampleHQKernels: benchmark", "[.benchmark]")
+{
+	// A typical 1 second fragment, for a few filter lengths (the length
+	// depends on the ratio between input and output sample rate).
+	constexpr unsigned NUM = 48000;
+	for (unsigned channels : {1, 2}) {
+		for (unsigned len : {32, 64, 128}) {
+			TestData data(len, channels, 2048, NUM, true);
+			std::vector<float> out(NUM * channels);
+			for (auto kernel : {Kernel::SCALAR, Kernel::SSE2, Kernel::AVX2}) {
+				if (!isSupported(kernel)) continue;
+				constexpr unsigned REPEAT = 20;
+				auto start = Timer::getTime();
+				for (unsigned r = 0; r < REPEAT; ++r) {
+					if (channels == 1) {
+						calc<1>(kernel, data.rows.data(), NUM, len, out.data());
+					} else {
+						calc<2>(kernel, data.rows.data(), NUM, len, out.data());
+					}
+				}
+				auto duration = Timer::getTime() - start; // us
+				std::cout << "channels=" << channels
+				          << " len=" << len
+				          << ' ' << kernelName(kernel) << ": "
+				          << (double(NUM) * REPEAT / duration) << " Msamples/s\n";
+			}
+		}
+	}
+}
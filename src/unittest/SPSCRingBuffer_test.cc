@@ -0,0 +1,81 @@
+#include "catch.hpp"
+#include "SPSCRingBuffer.hh"
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace openmsx;
+
+TEST_CASE("SPSCRingBuffer")
+{
+	SPSCRingBuffer<int> buf(5);
+	CHECK(buf.capacity() == 8); // rounded up
+	CHECK(buf.size() == 0);
+	CHECK(buf.reserve() == 8);
+
+	int in[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+	int out[10] = {};
+
+	CHECK(buf.pop(out, 3) == 0); // empty
+
+	CHECK(buf.push(in, 6) == 6);
+	CHECK(buf.size() == 6);
+	CHECK(buf.reserve() == 2);
+
+	CHECK(buf.pop(out, 4) == 4);
+	CHECK(out[0] == 1);
+	CHECK(out[3] == 4);
+	CHECK(buf.size() == 2);
+
+	// wraps around the end of the storage, and only partly fits
+	CHECK(buf.push(in, 10) == 6);
+	CHECK(buf.size() == 8);
+	CHECK(buf.reserve() == 0);
+	CHECK(buf.push(in, 1) == 0); // full
+
+	CHECK(buf.pop(out, 10) == 8);
+	int expected[8] = {5, 6, 1, 2, 3, 4, 5, 6};
+	for (int i = 0; i < 8; ++i) CHECK(out[i] == expected[i]);
+	CHECK(buf.size() == 0);
+
+	CHECK(buf.push(in, 3) == 3);
+	buf.clear();
+	CHECK(buf.size() == 0);
+	CHECK(buf.pop(out, 3) == 0);
+}
+
+TEST_CASE("SPSCRingBuffer: producer and consumer thread")
+{
+	// Transfer a long sequence in randomly sized pieces, the consumer
+	// must see exactly the same sequence.
+	constexpr unsigned NUM = 1000000;
+	SPSCRingBuffer<unsigned> buf(64);
+
+	std::thread producer([&] {
+		unsigned next = 0;
+		unsigned chunk[37];
+		while (next < NUM) {
+			unsigned n = std::min(1 + next % 37, NUM - next);
+			for (unsigned i = 0; i < n; ++i) chunk[i] = next + i;
+			unsigned done = 0;
+			while (done < n) {
+				done += unsigned(buf.push(chunk + done, n - done));
+			}
+			next += n;
+		}
+	});
+
+	std::vector<unsigned> received;
+	received.reserve(NUM);
+	unsigned chunk[29];
+	while (received.size() < NUM) {
+		auto n = buf.pop(chunk, 1 + received.size() % 29);
+		received.insert(received.end(), chunk, chunk + n);
+	}
+	producer.join();
+
+	bool ok = true;
+	for (unsigned i = 0; i < NUM; ++i) ok &= received[i] == i;
+	CHECK(ok);
+	CHECK(buf.size() == 0);
+}
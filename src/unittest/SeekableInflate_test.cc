@@ -0,0 +1,98 @@
+#include "catch.hpp"
+#include "SeekableInflate.hh"
+#include "FileOperations.hh"
+#include "random.hh"
+#include <cstring>
+#include <vector>
+#include <zlib.h>
+
+using namespace openmsx;
+
+static std::vector<uint8_t> rawDeflate(const std::vector<uint8_t>& in)
+{
+	z_stream s = {};
+	REQUIRE(deflateInit2(&s, 6, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+	std::vector<uint8_t> out(deflateBound(&s, uLong(in.size())));
+	s.next_in = const_cast<uint8_t*>(in.data());
+	s.avail_in = uInt(in.size());
+	s.next_out = out.data();
+	s.avail_out = uInt(out.size());
+	REQUIRE(deflate(&s, Z_FINISH) == Z_STREAM_END);
+	out.resize(s.total_out);
+	deflateEnd(&s);
+	return out;
+}
+
+TEST_CASE("SeekableInflate")
+{
+	// compressible, but not trivially: repeated random snippets
+	std::vector<uint8_t> data;
+	auto& gen = global_urng();
+	std::uniform_int_distribution<int> byteDistr(0, 255);
+	std::uniform_int_distribution<int> lenDistr(1, 300);
+	while (data.size() < 3'000'000) {
+		auto len = lenDistr(gen);
+		if (data.size() > 1000 && (len & 1)) {
+			auto start = data.size() - 1000 + lenDistr(gen);
+			for (int i = 0; i < len; ++i) data.push_back(data[start + i]);
+		} else {
+			for (int i = 0; i < len; ++i) data.push_back(uint8_t(byteDistr(gen)));
+		}
+	}
+	auto compressed = rawDeflate(data);
+
+	auto tmp = FileOperations::getTempDir() + "/seekable_inflate_unittest";
+	FileOperations::deleteRecursive(tmp);
+	auto indexFile = tmp + "/index";
+
+	auto check = [&](SeekableInflate& s) {
+		REQUIRE(s.getSize() == data.size());
+		std::uniform_int_distribution<size_t> posDistr(0, data.size() - 1);
+		std::vector<uint8_t> buf;
+		for (int i = 0; i < 100; ++i) {
+			auto pos = posDistr(gen);
+			auto num = std::min(data.size() - pos, lenDistr(gen) * size_t(1000));
+			buf.resize(num);
+			s.read(pos, buf.data(), num);
+			CHECK(memcmp(buf.data(), &data[pos], num) == 0);
+		}
+		// last byte, and all of it
+		uint8_t last;
+		s.read(data.size() - 1, &last, 1);
+		CHECK(last == data.back());
+		buf.resize(data.size());
+		s.read(0, buf.data(), buf.size());
+		CHECK(buf == data);
+	};
+
+	SECTION("no index file") {
+		SeekableInflate s(compressed, "", "", 65536);
+		CHECK(!s.loadedIndex());
+		check(s);
+	}
+	SECTION("with index file") {
+		{
+			SeekableInflate s(compressed, indexFile, "key", 65536);
+			CHECK(!s.loadedIndex());
+			check(s);
+		}
+		{
+			SeekableInflate s(compressed, indexFile, "key", 65536);
+			CHECK(s.loadedIndex());
+			check(s);
+		}
+		{
+			// e.g. file was modified
+			SeekableInflate s(compressed, indexFile, "other key", 65536);
+			CHECK(!s.loadedIndex());
+			check(s);
+		}
+	}
+	SECTION("corrupt stream") {
+		auto truncated = compressed;
+		truncated.resize(truncated.size() / 2);
+		CHECK_THROWS(SeekableInflate(truncated, "", "", 65536));
+	}
+
+	FileOperations::deleteRecursive(tmp);
+}
@@ -0,0 +1,50 @@
+#include "catch.hpp"
+#include "ThreadPool.hh"
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using namespace openmsx;
+
+static void check(ThreadPool& pool)
+{
+	for (unsigned n : {0, 1, 2, 7, 100, 1000}) {
+		std::vector<int> result(n, 0);
+		pool.parallelFor(n, [&](unsigned i) { result[i] += int(i) + 1; });
+		for (unsigned i = 0; i < n; ++i) {
+			CHECK(result[i] == int(i) + 1);
+		}
+	}
+}
+
+TEST_CASE("ThreadPool: all indices executed exactly once")
+{
+	SECTION("no extra threads") {
+		ThreadPool pool(0);
+		CHECK(pool.getNumThreads() == 0);
+		check(pool);
+	}
+	SECTION("3 extra threads") {
+		ThreadPool pool(3);
+		CHECK(pool.getNumThreads() == 3);
+		for (int i = 0; i < 20; ++i) check(pool);
+	}
+	SECTION("default") {
+		ThreadPool pool;
+		check(pool);
+	}
+}
+
+TEST_CASE("ThreadPool: exceptions are propagated")
+{
+	ThreadPool pool(2);
+	std::atomic<int> count = 0;
+	CHECK_THROWS_AS(pool.parallelFor(50, [&](unsigned i) {
+		++count;
+		if (i == 10) throw std::runtime_error("boom");
+	}), std::runtime_error);
+	CHECK(count == 50); // other work items still executed
+
+	// pool is still usable afterwards
+	check(pool);
+}
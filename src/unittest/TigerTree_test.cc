@@ -1,7 +1,9 @@
 #include "catch.hpp"
 #include "TigerTree.hh"
 #include "tiger.hh"
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
 using namespace openmsx;
 
@@ -9,6 +11,7 @@ struct TTTestData final : public TTData
 {
 	uint8_t* getData(size_t offset, size_t /*size*/) override
 	{
+		++numReads;
 		return buffer + offset;
 	}
 
@@ -17,7 +20,43 @@ struct TTTestData final : public TTData
 		return false;
 	}
 
+	bool isZero(size_t offset, size_t size) override
+	{
+		if (!checkZero) return false;
+		return std::all_of(buffer + offset, buffer + offset + size,
+		                   [](uint8_t b) { return b == 0; });
+	}
+
 	uint8_t* buffer;
+	bool checkZero = false;
+	int numReads = 0;
+};
+
+// The data is all zero, except for [dataOffset, dataOffset + dataSize).
+struct TTSparseData final : public TTData
+{
+	uint8_t* getData(size_t offset, size_t size) override
+	{
+		REQUIRE(offset >= dataOffset);
+		REQUIRE((offset + size) <= (dataOffset + sizeof(data)));
+		++numReads;
+		return data + 1 + (offset - dataOffset);
+	}
+
+	bool isCacheStillValid(time_t&) override
+	{
+		return false;
+	}
+
+	bool isZero(size_t offset, size_t size) override
+	{
+		return ((offset + size) <= dataOffset) ||
+		       (offset >= (dataOffset + sizeof(data) - 1));
+	}
+
+	size_t dataOffset;
+	uint8_t data[1 + 2048] = {};
+	int numReads = 0;
 };
 
 
@@ -64,6 +103,19 @@ TEST_CASE("TigerTree")
 		CHECK(tt.calcHash(dummyCallback).toString() ==
 		       "IPV53CDVB2I63HXIXVK2OUPNS26YB7V7G2Y7XIA");
 	}
+	SECTION("7 full blocks, zero ranges are not read") {
+		data.checkZero = true;
+		TigerTree tt(data, 7 * 1024, dummyName);
+		memset(buffer, 0, 7 * 1024);
+		CHECK(tt.calcHash(dummyCallback).toString() ==
+		       "FPSZ35773WS4WGBVXM255KWNETQZXMTEJGFMLTA");
+		CHECK(data.numReads == 0);
+		memset(buffer + 512, 1, 512);
+		tt.notifyChange(512, 512, dummyTime); // part of block-0
+		CHECK(tt.calcHash(dummyCallback).toString() ==
+		       "Z32BC2WSHPW5DYUSNSZGLDIFTEIP3DBFJ7MG2MQ");
+		CHECK(data.numReads == 1); // only block-0
+	}
 	SECTION("7 full blocks (unbalanced internal binary tree)") {
 		TigerTree tt(data, 7 * 1024, dummyName);
 		memset(buffer, 0, 7 * 1024);
@@ -79,3 +131,38 @@ TEST_CASE("TigerTree")
 		       "SJUYB3QVIJXNKZMSQZGIMHA7GA2MYU2UECDA26A");
 	}
 }
+
+TEST_CASE("TigerTree, sparse")
+{
+	// A 64GB image with only 2 blocks of data, hashing it must neither
+	// read nor allocate (memory for) the full tree.
+	std::string dummyName;
+	time_t dummyTime = 0;
+	size_t size = size_t(64) << 30;
+
+	TTSparseData sparse;
+	sparse.dataOffset = 5 * 1024 * 1024;
+	TigerTree tt(sparse, size, dummyName);
+	auto h1 = tt.calcHash({}).toString();
+	CHECK(sparse.numReads == 2);
+
+	memset(sparse.data + 1, 1, 100);
+	tt.notifyChange(sparse.dataOffset, 100, dummyTime);
+	auto h2 = tt.calcHash({}).toString();
+	CHECK(sparse.numReads == 3);
+	CHECK(h1 != h2);
+
+	// same hash as when all data is read
+	memset(sparse.data + 1, 0, 100);
+	tt.notifyChange(sparse.dataOffset, 100, dummyTime);
+	CHECK(tt.calcHash({}).toString() == h1);
+
+	std::vector<uint8_t> buffer(1 + 16 * 1024 * 1024);
+	TTTestData data;
+	data.buffer = buffer.data() + 1;
+	TigerTree tt2(data, buffer.size() - 1, "dense");
+	TTSparseData sparse2;
+	sparse2.dataOffset = 0;
+	TigerTree tt3(sparse2, buffer.size() - 1, "sparse");
+	CHECK(tt2.calcHash({}).toString() == tt3.calcHash({}).toString());
+}
@@ -0,0 +1,424 @@
+#include "catch.hpp"
+#include "V9990CmdKernels.hh"
+#include "V9990VRAM.hh"
+#include "StringOp.hh"
+#include "one_of.hh"
+#include "Timer.hh"
+#include "random.hh"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace openmsx;
+using namespace openmsx::V9990CmdKernels;
+
+// The command engine processes one byte at a time, using a lookup table.
+static void refFill(byte* dst, size_t num, byte color, byte mask, const byte* lut)
+{
+	for (size_t i = 0; i < num; ++i) {
+		byte d = dst[i];
+		dst[i] = (d & ~mask) | (lut[256 * d + color] & mask);
+	}
+}
+static void refCopy(byte* dst, const byte* src, size_t num, byte mask, const byte* lut)
+{
+	for (size_t i = 0; i < num; ++i) {
+		byte d = dst[i];
+		dst[i] = (d & ~mask) | (lut[256 * d + src[i]] & mask);
+	}
+}
+
+static std::vector<byte> makeLUT(LogOp op)
+{
+	std::vector<byte> lut(256 * 256);
+	auto& gen = global_urng();
+	std::uniform_int_distribution<int> distr(0, 255);
+	for (unsigned d = 0; d < 256; ++d) {
+		for (unsigned s = 0; s < 256; ++s) {
+			lut[256 * d + s] = (op == LogOp::IMP)  ? s
+			                 : (op == LogOp::TIMP) ? (s ? s : d)
+			                 : distr(gen);
+		}
+	}
+	return lut;
+}
+
+static std::vector<byte> randomBuffer(size_t size)
+{
+	std::vector<byte> result(size);
+	auto& gen = global_urng();
+	// lots of zeros, to test transparency
+	std::uniform_int_distribution<int> distr(-128, 255);
+	for (auto& b : result) b = std::max(0, distr(gen));
+	return result;
+}
+
+TEST_CASE("V9990CmdKernels: classify")
+{
+	CHECK(classify(0x0C, false) == LogOp::IMP);
+	CHECK(classify(0x0C, true ) == LogOp::IMP);
+	CHECK(classify(0x1C, true ) == LogOp::TIMP);
+	CHECK(classify(0x1C, false) == LogOp::GENERIC); // per pixel transparency
+	CHECK(classify(0x03, true ) == LogOp::GENERIC);
+	CHECK(classify(0x1A, true ) == LogOp::GENERIC);
+}
+
+TEST_CASE("V9990CmdKernels: same result as byte per byte")
+{
+	auto& gen = global_urng();
+	std::uniform_int_distribution<int> byteDistr(0, 255);
+	for (auto op : {LogOp::IMP, LogOp::TIMP, LogOp::GENERIC}) {
+		auto lut = makeLUT(op);
+		for (byte mask : {0xFF, 0x00, 0x0F, 0x5A}) {
+			for (size_t num : {0, 1, 15, 16, 17, 100}) {
+				// fill
+				auto buf = randomBuffer(num);
+				auto ref = buf;
+				byte color = byteDistr(gen) & (op == LogOp::TIMP ? 1 : 0xFF);
+				refFill(ref.data(), num, color, mask, lut.data());
+				fill(buf.data(), num, color, mask, lut.data(), op);
+				CHECK(buf == ref);
+
+				// copy, overlapping in both directions (that
+				// matters, including for small distances)
+				for (int dist : {-200, -17, -16, -15, -1, 0, 1, 3, 15, 16, 17, 200}) {
+					auto buf2 = randomBuffer(num + 400);
+					auto ref2 = buf2;
+					size_t s = 200;
+					size_t d = s + dist;
+					refCopy(&ref2[d], &ref2[s], num, mask, lut.data());
+					copy(&buf2[d], &buf2[s], num, mask, lut.data(), op);
+					CHECK(buf2 == ref2);
+				}
+			}
+		}
+	}
+}
+
+// The lookup table of a V9990 logical operation, with transparency per group
+// of 'transpBits' bits (pixel), like in V9990CmdEngine. 0 means no
+// transparency.
+static std::vector<byte> makeLogOpLUT(unsigned transpBits, byte log)
+{
+	std::vector<byte> lut(256 * 256);
+	for (unsigned d = 0; d < 256; ++d) {
+		for (unsigned s = 0; s < 256; ++s) {
+			unsigned res = 0;
+			for (unsigned bit = 0; bit < 8; ++bit) {
+				unsigned sb = (s >> bit) & 1;
+				unsigned db = (d >> bit) & 1;
+				res |= ((log >> (2 * sb + db)) & 1) << bit;
+			}
+			for (unsigned b = 0; transpBits && (b < 8); b += transpBits) {
+				unsigned m = ((1 << transpBits) - 1) << b;
+				if (!(s & m)) res = (res & ~m) | (d & m);
+			}
+			lut[256 * d + s] = byte(res);
+		}
+	}
+	return lut;
+}
+static const byte* getLogOpLUT(unsigned transpBits, byte log)
+{
+	static std::vector<byte> cache[4][16];
+	auto& lut = cache[(transpBits == 8) ? 3 : (transpBits / 2)][log & 0x0F];
+	if (lut.empty()) lut = makeLogOpLUT(transpBits, log & 0x0F);
+	return lut.data();
+}
+
+// A subset of the V9990 block commands (LMMV, LMMM, BMLL) in the 2, 4, 8 and
+// 16 bpp modes, as executed by V9990CmdEngine (ignoring timing). With 'bulk'
+// whole rows are executed with the V9990CmdKernels (when possible), otherwise
+// pixel per pixel (as in the V9990BppN::pset() functions).
+struct Cmd {
+	std::string name;
+	unsigned bpp = 8;
+	unsigned width = 512;
+	word SX = 0, SY = 0, DX = 0, DY = 0, NX = 0, NY = 0;
+	byte ARG = 0, LOG = 0x0C;
+	word WM = 0xFFFF, FC = 0;
+};
+
+struct Engine {
+	byte* vram;
+	const Cmd& c;
+	unsigned pitch, nx, ny;
+	int dx, dy;
+	const byte* lut;
+	LogOp op;
+	unsigned bulkRows = 0;
+
+	Engine(byte* vram_, const Cmd& c_)
+		: vram(vram_), c(c_)
+		, pitch(c.bpp == 16 ? c.width : (c.width * c.bpp / 8))
+		, nx(c.NX ? c.NX : 2048), ny(c.NY ? c.NY : 4096)
+		, dx((c.ARG & 0x04) ? -1 : 1), dy((c.ARG & 0x08) ? -1 : 1)
+		, lut(getLogOpLUT(((c.LOG & 0x10) && (c.bpp != 16)) ? c.bpp : 0, c.LOG))
+		, op(classify(c.LOG, c.bpp == 8))
+	{
+	}
+
+	unsigned addressOf(unsigned x, unsigned y) const {
+		if (c.bpp == 16) return ((x & (pitch - 1)) + y * pitch) & 0x3FFFF;
+		unsigned ppb = 8 / c.bpp;
+		return V9990VRAM::transformBx(((x / ppb) & (pitch - 1)) + y * pitch) & 0x7FFFF;
+	}
+	byte shiftMask(unsigned x) const {
+		if (c.bpp >= 8) return 0xFF;
+		unsigned ppb = 8 / c.bpp;
+		return byte(((1 << c.bpp) - 1) << (8 - c.bpp * (1 + x % ppb)));
+	}
+	word point(unsigned x, unsigned y) const {
+		unsigned addr = addressOf(x, y);
+		return (c.bpp == 16) ? (vram[addr] + 256 * vram[addr + 0x40000])
+		                     : vram[addr];
+	}
+	// 'src' is a pixel (16bpp) or a (shifted) byte
+	void pset(unsigned x, unsigned y, word src, bool color) {
+		unsigned addr = addressOf(x, y);
+		if (c.bpp == 16) {
+			word d = vram[addr] + 256 * vram[addr + 0x40000];
+			word n = ((c.LOG & 0x10) && (src == 0)) ? d
+			       : word(lut[256 * (d & 0xFF) + (src & 0xFF)] +
+			              256 * lut[256 * (d >> 8) + (src >> 8)]);
+			word r = (d & ~c.WM) | (n & c.WM);
+			vram[addr] = r & 0xFF;
+			vram[addr + 0x40000] = r >> 8;
+		} else {
+			bool high = (addr & 0x40000) != 0;
+			byte s = !color ? byte(src) : high ? (src >> 8) : (src & 0xFF);
+			byte d = vram[addr];
+			byte mask = (high ? (c.WM >> 8) : (c.WM & 0xFF)) & shiftMask(x);
+			vram[addr] = (d & ~mask) | (lut[256 * d + s] & mask);
+		}
+	}
+	word shift(word value, unsigned fromX, unsigned toX) const {
+		if (c.bpp >= 8) return value;
+		unsigned ppb = 8 / c.bpp;
+		int sh = int(c.bpp) * (int(toX % ppb) - int(fromX % ppb));
+		return byte((sh > 0) ? (value >> sh) : (value << -sh));
+	}
+
+	void run(bool bulk) {
+		// 16bpp transparency can't be done per byte
+		bulk &= (c.bpp != 16) || !(c.LOG & 0x10);
+		if (c.name == "LMMV") {
+			runLMMV(bulk);
+		} else if (c.name == "LMMM") {
+			runLMMM(bulk);
+		} else if (c.name == "BMLL") {
+			runBMLL(bulk);
+		}
+	}
+
+	void runLMMV(bool bulk) {
+		word x = c.DX, y = c.DY;
+		for (unsigned row = 0; row < ny; ++row, y += dy) {
+			unsigned addr, num;
+			if (bulk && getRowRange(c.bpp, x, y, pitch, nx, dx, addr, num)) {
+				fillBx(vram, addr, num, c.FC, c.WM, lut, op);
+				++bulkRows;
+				continue;
+			}
+			word px = x;
+			for (unsigned i = 0; i < nx; ++i, px += dx) {
+				pset(px, y, c.FC, true);
+			}
+		}
+	}
+
+	void runLMMM(bool bulk) {
+		word sx = c.SX, sy = c.SY, x = c.DX, y = c.DY;
+		for (unsigned row = 0; row < ny; ++row, sy += dy, y += dy) {
+			unsigned src, dst, num;
+			if (bulk && getRowRange(c.bpp, sx, sy, pitch, nx, dx, src, num) &&
+			    getRowRange(c.bpp, x, y, pitch, nx, dx, dst, num) &&
+			    canCopyBx(src, dst, num, dx > 0)) {
+				copyBx(vram, src, dst, num, c.WM, lut, op);
+				++bulkRows;
+				continue;
+			}
+			word psx = sx, px = x;
+			for (unsigned i = 0; i < nx; ++i, psx += dx, px += dx) {
+				pset(px, y, shift(point(psx, sy), psx, px), false);
+			}
+		}
+	}
+
+	void runBMLL(bool bulk) {
+		// (only the Bx modes)
+		unsigned src = (c.SX & 0xFF) + ((c.SY & 0x7FF) << 8);
+		unsigned dst = (c.DX & 0xFF) + ((c.DY & 0x7FF) << 8);
+		unsigned n   = (c.NX & 0xFF) + ((c.NY & 0x7FF) << 8);
+		if (n == 0) n = 0x80000;
+		while (n) {
+			// as many bytes as possible without wrapping
+			unsigned num = std::min({n, 0x80000 - src, 0x80000 - dst});
+			if (bulk && canCopyBx(src, dst, num, true)) {
+				copyBx(vram, src, dst, num, c.WM, lut, op);
+				++bulkRows;
+			} else {
+				num = 1;
+				unsigned addr = V9990VRAM::transformBx(dst);
+				byte s = vram[V9990VRAM::transformBx(src)];
+				byte d = vram[addr];
+				byte mask = (addr & 0x40000) ? (c.WM >> 8) : (c.WM & 0xFF);
+				vram[addr] = (d & ~mask) | (lut[256 * d + s] & mask);
+			}
+			src = (src + num) & 0x7FFFF;
+			dst = (dst + num) & 0x7FFFF;
+			n -= num;
+		}
+	}
+};
+
+TEST_CASE("V9990CmdKernels: bulk commands same as per pixel")
+{
+	auto& gen = global_urng();
+	auto rnd = [&](int lo, int hi) {
+		return std::uniform_int_distribution<int>(lo, hi)(gen);
+	};
+	auto init = randomBuffer(V9990VRAM::VRAM_SIZE);
+	unsigned bulkRows = 0;
+	for (int i = 0; i < 1500; ++i) {
+		Cmd c;
+		c.name = std::array{"LMMV", "LMMM", "BMLL"}[rnd(0, 2)];
+		c.bpp = std::array{2, 4, 8, 16}[rnd(0, 3)];
+		c.width = 256 << rnd(0, 2);
+		// aligned (so that rows can be done in bulk) or not
+		auto coord = [&](int max) {
+			return word(rnd(0, 1) ? rnd(0, max) : 8 * rnd(0, max / 8));
+		};
+		c.SX = coord(2047); c.SY = coord(4095);
+		c.DX = coord(2047); c.DY = coord(4095);
+		if (rnd(0, 1)) {
+			// (nearly) overlapping source and destination
+			c.SX = c.DX + rnd(-20, 20);
+			c.SY = c.DY + rnd(-2, 2);
+		}
+		c.NX = rnd(0, 3) ? word(rnd(1, 64) * (rnd(0, 1) ? 4 : 1))
+		                 : word(rnd(0, 1) ? c.width : 0);
+		c.NY = rnd(1, 20);
+		if (c.name == "BMLL") {
+			c.bpp = 8; // same in all Bx modes
+			c.NY &= 0x7;
+		}
+		c.ARG = rnd(0, 3) << 2;
+		c.LOG = std::array{0x0C, 0x1C, 0x03, 0x16, 0x1A}[rnd(0, 4)];
+		c.WM = rnd(0, 2) ? 0xFFFF : rnd(0, 0xFFFF);
+		c.FC = rnd(0, 2) ? rnd(0, 0xFFFF) : 0;
+		INFO(c.name << " bpp=" << c.bpp << " width=" << c.width
+		     << " SX=" << c.SX << " SY=" << c.SY
+		     << " DX=" << c.DX << " DY=" << c.DY
+		     << " NX=" << c.NX << " NY=" << c.NY
+		     << " ARG=" << int(c.ARG) << " LOG=" << int(c.LOG)
+		     << " WM=" << c.WM << " FC=" << c.FC);
+
+		auto perPixel = init;
+		Engine(perPixel.data(), c).run(false);
+		auto bulk = init;
+		Engine e(bulk.data(), c);
+		e.run(true);
+		bulkRows += e.bulkRows;
+		bool same = bulk == perPixel; // don't print 512kB on failure
+		CHECK(same);
+	}
+	CHECK(bulkRows > 1000); // the bulk path is really tested
+}
+
+// Replay a stream of commands, as recorded with 'set v9990cmdtrace on', e.g.
+//   V9990Cmd LMMV SX=0 SY=0 DX=0 DY=0 NX=512 NY=424 ARG=0 LOG=c WM=ffff ...
+//   ... FC=1111 BC=0 CMD=20 MODE=BPP8 WIDTH=512
+// Only the LMMV, LMMM and BMLL commands are executed.
+static std::vector<Cmd> parseCmdTrace(std::istream& is)
+{
+	std::vector<Cmd> result;
+	std::string line;
+	while (std::getline(is, line)) {
+		std::istringstream ls(line);
+		std::string token;
+		if (!(ls >> token) || (token != "V9990Cmd")) continue;
+		Cmd c;
+		ls >> c.name;
+		while (ls >> token) {
+			auto [key, value] = StringOp::splitOnFirst(token, '=');
+			auto dec = [&] { return word(strtoul(std::string(value).c_str(), nullptr, 10)); };
+			auto hex = [&] { return word(strtoul(std::string(value).c_str(), nullptr, 16)); };
+			if      (key == "SX")  c.SX = dec();
+			else if (key == "SY")  c.SY = dec();
+			else if (key == "DX")  c.DX = dec();
+			else if (key == "DY")  c.DY = dec();
+			else if (key == "NX")  c.NX = dec();
+			else if (key == "NY")  c.NY = dec();
+			else if (key == "ARG") c.ARG = byte(hex());
+			else if (key == "LOG") c.LOG = byte(hex());
+			else if (key == "WM")  c.WM = hex();
+			else if (key == "FC")  c.FC = hex();
+			else if (key == "WIDTH") c.width = dec();
+			else if (key == "MODE") {
+				c.bpp = (value == "BPP2")  ? 2
+				      : (value == "BPP4")  ? 4
+				      : (value == "BPP16") ? 16
+				      : (value == "BPP8")  ? 8
+				      : 0; // P1/P2, not supported here
+			}
+		}
+		if ((c.name == one_of("LMMV", "LMMM", "BMLL")) && c.bpp) {
+			result.push_back(c);
+		}
+	}
+	return result;
+}
+
+// Runs the command stream recorded in the file given by the environment
+// variable V9990_CMD_TRACE, or otherwise a typical mix of commands (8bpp,
+// 512 pixels per line): a screen clear, a (horizontal) scroll and a batch of
+// transparent 16x16 sprites/tiles.
+TEST_CASE("V9990CmdKernels: benchmark", "[.benchmark]")
+{
+	std::vector<Cmd> cmds;
+	if (const char* trace = getenv("V9990_CMD_TRACE")) {
+		std::ifstream is(trace);
+		cmds = parseCmdTrace(is);
+	} else {
+		std::ostringstream os;
+		for (unsigned frame = 0; frame < 50; ++frame) {
+			const char* mode = " MODE=BPP8 WIDTH=512\n";
+			os << "V9990Cmd LMMV SX=0 SY=0 DX=0 DY=0 NX=512 NY=424"
+			      " ARG=0 LOG=c WM=ffff FC=1111 BC=0 CMD=20" << mode;
+			os << "V9990Cmd LMMM SX=4 SY=0 DX=0 DY=0 NX=508 NY=424"
+			      " ARG=0 LOG=c WM=ffff FC=0 BC=0 CMD=40" << mode;
+			for (unsigned t = 0; t < 256; ++t) {
+				os << "V9990Cmd LMMM"
+				   << " SX=" << 16 * (t % 32) << " SY=" << 256 + 16 * (t / 32 % 8)
+				   << " DX=" << (7 * t) % (512 - 16) << " DY=" << (13 * t) % 240
+				   << " NX=16 NY=16 ARG=0 LOG=1c WM=ffff FC=0 BC=0 CMD=40"
+				   << mode;
+			}
+		}
+		std::istringstream is(os.str());
+		cmds = parseCmdTrace(is);
+	}
+	std::cout << cmds.size() << " commands\n";
+
+	auto init = randomBuffer(V9990VRAM::VRAM_SIZE);
+	std::vector<byte> result[2];
+	for (bool bulk : {false, true}) {
+		auto vram = init;
+		auto start = Timer::getTime();
+		for (const auto& c : cmds) {
+			Engine(vram.data(), c).run(bulk);
+		}
+		auto duration = Timer::getTime() - start;
+		std::cout << (bulk ? "bulk kernels: " : "pixel per pixel: ")
+		          << duration / 1000.0 << "ms\n";
+		result[bulk] = std::move(vram);
+	}
+	bool same = result[0] == result[1];
+	CHECK(same);
+}
@@ -0,0 +1,44 @@
+#include "catch.hpp"
+#include "WorkerThread.hh"
+#include <atomic>
+#include <vector>
+
+using namespace openmsx;
+
+TEST_CASE("WorkerThread: jobs run in order")
+{
+	std::vector<int> result; // only accessed by worker until flush()
+	WorkerThread worker(3);
+	for (int i = 0; i < 100; ++i) {
+		worker.push([&result, i] { result.push_back(i); });
+		CHECK(worker.getNumPending() <= 3);
+	}
+	worker.flush();
+	CHECK(worker.getNumPending() == 0);
+	REQUIRE(result.size() == 100);
+	for (int i = 0; i < 100; ++i) {
+		CHECK(result[i] == i);
+	}
+}
+
+TEST_CASE("WorkerThread: destructor finishes pending jobs")
+{
+	std::atomic<int> count = 0;
+	{
+		WorkerThread worker(10);
+		for (int i = 0; i < 10; ++i) {
+			worker.push([&] { ++count; });
+		}
+	}
+	CHECK(count == 10);
+}
+
+TEST_CASE("WorkerThread: exceptions are swallowed")
+{
+	int count = 0;
+	WorkerThread worker(1);
+	worker.push([] { throw 42; });
+	worker.push([&] { ++count; });
+	worker.flush();
+	CHECK(count == 1);
+}
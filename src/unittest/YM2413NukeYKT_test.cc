@@ -0,0 +1,177 @@
+#include "catch.hpp"
+#include "YM2413NukeYKT.hh"
+#include "YM2413OriginalNukeYKT.hh"
+#include "Timer.hh"
+#include "random.hh"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+using namespace openmsx;
+
+// A log of register writes with (sub-sample) timing, as the YM2413 class
+// passes them to its core.
+struct Write {
+	uint32_t sample; // number of samples to generate before this write
+	uint8_t reg;
+	uint8_t value;
+	uint8_t offset; // [0..13], see YM2413Core::writePort()
+};
+using Log = std::vector<Write>;
+
+// Something that resembles music: notes on random channels, instrument and
+// volume changes, user patch edits, rhythm mode, (optionally) test register
+// writes, and (long) pauses so that the chip regularly becomes
+// completely silent.
+static Log makeLog(unsigned numEvents, bool withTestReg)
+{
+	auto& gen = global_urng();
+	auto rnd = [&](int lo, int hi) {
+		return std::uniform_int_distribution<int>(lo, hi)(gen);
+	};
+
+	Log log;
+	auto write = [&](uint32_t wait, int reg, int value) {
+		// A data write needs 84 cycles (@3.57MHz) before the next
+		// access, that's a bit more than one sample. So keep (at
+		// least) 2 samples between writes, otherwise we only test
+		// the too-fast-access workaround in writePort().
+		log.push_back({std::max(wait, 2u), uint8_t(reg), uint8_t(value), uint8_t(rnd(0, 13))});
+	};
+	for (unsigned i = 0; i < numEvents; ++i) {
+		uint32_t wait = (rnd(0, 20) == 0) ? rnd(5000, 50000) // pause
+		              : (rnd(0, 3) == 0)  ? 0                // quickly after the previous write
+		                                  : rnd(1, 3000);
+		int ch = rnd(0, 8);
+		switch (rnd(0, 9)) {
+		case 0: case 1: case 2: // key on
+			write(wait, 0x10 + ch, rnd(0, 255));
+			write(0, 0x20 + ch, 0x10 | rnd(0, 0x2f));
+			break;
+		case 3: case 4: // key off
+			write(wait, 0x20 + ch, rnd(0, 0x0f) | (rnd(0, 1) << 5));
+			break;
+		case 5: // instrument/volume
+			write(wait, 0x30 + ch, rnd(0, 255));
+			break;
+		case 6: // user patch
+			write(wait, rnd(0, 7), rnd(0, 255));
+			break;
+		case 7: // rhythm
+			write(wait, 0x0e, (rnd(0, 2) == 0) ? 0 : rnd(0, 0x3f));
+			break;
+		case 8: // fnum only
+			write(wait, 0x10 + ch, rnd(0, 255));
+			break;
+		case 9:
+			if (withTestReg && (rnd(0, 10) == 0)) {
+				write(wait, 0x0f, rnd(0, 15));
+				write(rnd(1, 100), 0x0f, 0);
+			} else {
+				write(wait, 0x20 + ch, 0);
+			}
+			break;
+		}
+	}
+	// and end with all channels off, for a while
+	for (int ch = 0; ch < 9; ++ch) write(0, 0x20 + ch, 0);
+	write(0, 0x0e, 0);
+	write(50000, 0x10, 0);
+	return log;
+}
+
+// Generate all samples for the given log, return them interleaved per sample
+// (14 channels).
+static std::vector<float> run(YM2413Core& core, const Log& log)
+{
+	std::vector<float> result;
+	auto generate = [&](uint32_t n) {
+		if (n == 0) return;
+		size_t start = result.size();
+		result.resize(start + 14 * n, 0.0f);
+		std::vector<float> bufs(14 * n, 0.0f);
+		float* out[14];
+		for (int c = 0; c < 14; ++c) out[c] = &bufs[c * n];
+		core.generateChannels(out, n);
+		for (uint32_t i = 0; i < n; ++i) {
+			for (int c = 0; c < 14; ++c) {
+				result[start + 14 * i + c] = bufs[c * n + i];
+			}
+		}
+	};
+	for (const auto& w : log) {
+		// generate in smaller pieces, like the mixer does
+		uint32_t n = w.sample;
+		while (n) {
+			uint32_t m = std::min(n, 1000u);
+			generate(m);
+			n -= m;
+		}
+		core.writePort(false, w.reg,   w.offset);
+		core.writePort(true,  w.value, w.offset + 4);
+	}
+	return result;
+}
+
+static size_t firstMismatch(const std::vector<float>& a, const std::vector<float>& b)
+{
+	size_t i = 0;
+	while ((i < a.size()) && (a[i] == b[i])) ++i;
+	return i;
+}
+
+TEST_CASE("YM2413NukeYKT: idle fast-forward is exact")
+{
+	for (bool testReg : {false, true}) {
+		auto log = makeLog(1000, testReg);
+		YM2413NukeYKT::YM2413 fast;
+		YM2413NukeYKT::YM2413 slow;
+		slow.setIdleFastForward(false);
+		auto expected = run(slow, log);
+		auto actual = run(fast, log);
+		REQUIRE(actual.size() == expected.size());
+		auto mismatch = firstMismatch(actual, expected);
+		INFO("first mismatch at sample " << (mismatch / 14)
+		     << " channel " << (mismatch % 14));
+		CHECK(mismatch == actual.size());
+	}
+}
+
+TEST_CASE("YM2413NukeYKT: identical to the original NukeYKT core")
+{
+	// The original (unoptimized) core is the reference: all the
+	// transformations in YM2413NukeYKT (including the idle fast-forward)
+	// must not change the output.
+	for (bool testReg : {false, true}) {
+		auto log = makeLog(1000, testReg);
+		YM2413OriginalNukeYKT::YM2413 original;
+		YM2413NukeYKT::YM2413 nuke;
+		auto expected = run(original, log);
+		auto actual = run(nuke, log);
+		REQUIRE(actual.size() == expected.size());
+		auto mismatch = firstMismatch(actual, expected);
+		INFO("first mismatch at sample " << (mismatch / 14)
+		     << " channel " << (mismatch % 14));
+		CHECK(mismatch == actual.size());
+	}
+}
+
+TEST_CASE("YM2413NukeYKT: benchmark", "[.benchmark]")
+{
+	auto bench = [](const char* name, const Log& log) {
+		for (bool ff : {false, true}) {
+			YM2413NukeYKT::YM2413 nuke;
+			nuke.setIdleFastForward(ff);
+			auto start = Timer::getTime();
+			auto samples = run(nuke, log).size() / 14;
+			auto duration = Timer::getTime() - start; // us
+			std::cout << "NukeYKT " << name
+			          << " (idle fast-forward " << (ff ? "on" : "off")
+			          << "): " << samples << " samples in "
+			          << duration / 1000.0 << "ms\n";
+		}
+	};
+	// Often the YM2413 isn't used at all.
+	bench("silent", {{10000000, 0x10, 0, 0}});
+	bench("music", makeLog(5000, false));
+}
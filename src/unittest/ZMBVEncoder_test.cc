@@ -0,0 +1,95 @@
+#include "catch.hpp"
+#include "ZMBVEncoder.hh"
+#include "RawFrame.hh"
+#include "Timer.hh"
+#include "random.hh"
+#include "build-info.hh"
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace openmsx;
+
+template<typename P> static void testCompareBlock()
+{
+	constexpr unsigned PITCH = 16 + 2 * 16;
+	std::vector<P> a(PITCH * 16 + 1), b(PITCH * 16 + 1);
+	auto& gen = global_urng();
+	std::uniform_int_distribution<int> distr(0, 3);
+	for (int i = 0; i < 100; ++i) {
+		for (auto& p : a) p = P(distr(gen));
+		for (auto& p : b) p = P(distr(gen));
+		// also test unaligned addresses
+		for (unsigned ofst : {0, 1}) {
+			CHECK(ZMBVEncoder::compareBlock(&a[ofst], &b[0], PITCH) ==
+			      ZMBVEncoder::compareBlockScalar(&a[ofst], &b[0], PITCH));
+		}
+	}
+	CHECK(ZMBVEncoder::compareBlock(&a[0], &a[0], PITCH) == 0);
+}
+
+TEST_CASE("ZMBVEncoder: compareBlock")
+{
+	testCompareBlock<uint16_t>();
+	testCompareBlock<uint32_t>();
+}
+
+#if HAVE_32BPP
+static const PixelFormat format32(32,
+	0x00FF0000, 16, 0,
+	0x0000FF00,  8, 0,
+	0x000000FF,  0, 0,
+	0xFF000000, 24, 0);
+
+// Some moving content, so that the motion search has something to find.
+static void drawFrame(RawFrame& frame, unsigned width, unsigned n)
+{
+	for (unsigned y = 0; y < frame.getHeight(); ++y) {
+		auto* line = frame.getLinePtrDirect<uint32_t>(y);
+		for (unsigned x = 0; x < width; ++x) {
+			uint32_t c = ((x + n) / 8 + (y / 8)) & 1 ? 0x102030 : 0x405060;
+			if (((x - 3 * n) % 97) < 20 && ((y + n) % 61) < 30) c = 0xFFFFFF;
+			line[x] = c;
+		}
+		frame.setLineWidth(y, width);
+	}
+}
+
+static std::vector<std::vector<uint8_t>> encode(
+	unsigned width, unsigned height, unsigned numFrames, unsigned numThreads)
+{
+	std::vector<std::vector<uint8_t>> result;
+	RawFrame frame(format32, width, height);
+	ZMBVEncoder encoder(width, height, 32, numThreads);
+	for (unsigned n = 0; n < numFrames; ++n) {
+		drawFrame(frame, width, n);
+		void* buffer;
+		unsigned size;
+		encoder.compressFrame(n == 0, &frame, buffer, size);
+		auto* p = static_cast<uint8_t*>(buffer);
+		result.emplace_back(p, p + size);
+	}
+	return result;
+}
+
+TEST_CASE("ZMBVEncoder: output doesn't depend on the number of threads")
+{
+	auto ref = encode(320, 240, 10, 0);
+	CHECK(encode(320, 240, 10, 1) == ref);
+	CHECK(encode(320, 240, 10, 3) == ref);
+}
+
+TEST_CASE("ZMBVEncoder: benchmark", "[.benchmark]")
+{
+	constexpr unsigned NUM_FRAMES = 200;
+	for (unsigned threads : {0u, ThreadPool::getDefaultNumThreads()}) {
+		auto start = Timer::getTime();
+		auto result = encode(640, 480, NUM_FRAMES, threads);
+		auto duration = Timer::getTime() - start;
+		std::cout << "ZMBV 640x480, " << threads << " extra threads: "
+		          << (NUM_FRAMES * 1e6 / duration) << " frames/s\n";
+		CHECK(result.size() == NUM_FRAMES);
+	}
+}
+#endif
@@ -114,6 +114,15 @@ TEST_CASE("cb_queue") {
 	CHECK(q.pop_front() == 2); check_queue(q, 8, {4,5,6,7});
 	CHECK(q.pop_front() == 4); check_queue(q, 8, {5,6,7});
 	q.clear();                 check_queue(q, 8, {});
+
+	vector<int> v = {1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17};
+	q.push_back(v.begin(), v.begin() + 3); check_queue(q, 8, {1,2,3});
+	q.push_back(v.rbegin(), v.rbegin() + 2); check_queue(q, 8, {1,2,3,17,16});
+	q.push_back(v.begin(), v.end());
+	CHECK(q.getBuffer().capacity() == 22);
+	CHECK(q.size() == 22);
+	CHECK(q[5] == 1);
+	CHECK(q.back() == 17);
 }
 
 static void check_queue(
@@ -1,7 +1,11 @@
 #include "catch.hpp"
 #include "sha1.hh"
+#include "Timer.hh"
+#include "random.hh"
 #include <cstring>
+#include <iostream>
 #include <sstream>
+#include <vector>
 
 using namespace openmsx;
 
@@ -132,3 +136,69 @@ TEST_CASE("sha1: update,digest")
 		CHECK(sum.toString() == "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
 	}
 }
+
+static const char* backendName(SHA1::Backend backend)
+{
+	switch (backend) {
+	case SHA1::Backend::SCALAR: return "scalar";
+	case SHA1::Backend::SHA_NI: return "SHA-NI";
+	}
+	return "?";
+}
+
+static constexpr SHA1::Backend allBackends[] = {
+	SHA1::Backend::SCALAR, SHA1::Backend::SHA_NI,
+};
+
+TEST_CASE("sha1: all backends give the same result")
+{
+	CHECK(SHA1::isSupported(SHA1::Backend::SCALAR));
+	CHECK(SHA1::isSupported(SHA1::getBestBackend()));
+
+	std::vector<uint8_t> data(5000);
+	auto& gen = global_urng();
+	std::uniform_int_distribution<int> distr(0, 255);
+	for (auto& d : data) d = uint8_t(distr(gen));
+
+	for (auto backend : allBackends) {
+		if (!SHA1::isSupported(backend)) continue;
+		INFO(backendName(backend));
+		const char* in = "abc";
+		SHA1 abc(backend);
+		abc.update(reinterpret_cast<const uint8_t*>(in), strlen(in));
+		CHECK(abc.digest().toString() == "a9993e364706816aba3e25717850c26c9cd0d89d");
+
+		// all lengths around the block size, and split in several calls
+		for (size_t len : {0, 1, 55, 56, 63, 64, 65, 127, 128, 129, 1000, 5000}) {
+			SHA1 scalar(SHA1::Backend::SCALAR);
+			scalar.update(data.data(), len);
+			SHA1 sha1(backend);
+			size_t split = len / 3;
+			sha1.update(data.data(), split);
+			sha1.update(data.data() + split, len - split);
+			CHECK(sha1.digest() == scalar.digest());
+		}
+	}
+}
+
+TEST_CASE("sha1: benchmark", "[.benchmark]")
+{
+	// e.g. a large disk image or a pool full of ROMs
+	for (size_t size : {size_t(32 * 1024), size_t(64 * 1024 * 1024)}) {
+		std::vector<uint8_t> data(size, 0x55);
+		for (auto backend : allBackends) {
+			if (!SHA1::isSupported(backend)) continue;
+			size_t repeat = (256 * 1024 * 1024) / size;
+			Sha1Sum sum;
+			auto start = Timer::getTime();
+			for (size_t r = 0; r < repeat; ++r) {
+				SHA1 sha1(backend);
+				sha1.update(data.data(), data.size());
+				sum = sha1.digest();
+			}
+			auto duration = Timer::getTime() - start; // us
+			std::cout << "size=" << size << ' ' << backendName(backend) << ": "
+			          << (double(size) * repeat / duration) << " MB/s\n";
+		}
+	}
+}
@@ -0,0 +1,114 @@
+#ifndef SPSCRINGBUFFER_HH
+#define SPSCRINGBUFFER_HH
+
+#include "MemBuffer.hh"
+#include "Math.hh"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+namespace openmsx {
+
+/** Lock-free ring buffer for exactly one producer thread and exactly one
+  * consumer thread (e.g. the emulation thread and an audio callback).
+  *
+  * Only the producer modifies the write index and only the consumer modifies
+  * the read index, so no locking is needed. Elements are copied with memcpy,
+  * so T must be trivially copyable.
+  */
+template<typename T> class SPSCRingBuffer
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+	SPSCRingBuffer() = default;
+	explicit SPSCRingBuffer(size_t capacity) { resize(capacity); }
+
+	/** Change the capacity, rounded up to a power of 2. This also
+	  * discards the content. Not allowed while push() or pop() are
+	  * running.
+	  */
+	void resize(size_t capacity)
+	{
+		cap = Math::ceil2(std::max<size_t>(capacity, 1));
+		buf.resize(cap);
+		clear();
+	}
+
+	/** Discard the content. Not allowed while push() or pop() are
+	  * running.
+	  */
+	void clear()
+	{
+		readIdx .store(0, std::memory_order_relaxed);
+		writeIdx.store(0, std::memory_order_relaxed);
+	}
+
+	[[nodiscard]] size_t capacity() const { return cap; }
+
+	/** Number of elements in the buffer. When called from a thread other
+	  * than the producer and the consumer, the result is only an
+	  * estimate.
+	  */
+	[[nodiscard]] size_t size() const
+	{
+		auto w = writeIdx.load(std::memory_order_acquire);
+		auto r = readIdx .load(std::memory_order_acquire);
+		return w - r;
+	}
+
+	/** Number of elements that can still be pushed. */
+	[[nodiscard]] size_t reserve() const { return capacity() - size(); }
+
+	/** Producer: append (up to) 'num' elements.
+	  * @result The number of elements actually appended, less than 'num'
+	  *         when the buffer is full.
+	  */
+	size_t push(const T* data, size_t num)
+	{
+		auto w = writeIdx.load(std::memory_order_relaxed);
+		auto r = readIdx .load(std::memory_order_acquire);
+		num = std::min(num, cap - (w - r));
+		if (num == 0) return 0;
+		size_t pos = w & (cap - 1);
+		size_t len1 = std::min(num, cap - pos);
+		memcpy(&buf[pos], data, len1 * sizeof(T));
+		memcpy(&buf[0], data + len1, (num - len1) * sizeof(T));
+		writeIdx.store(w + num, std::memory_order_release);
+		return num;
+	}
+
+	/** Consumer: remove (up to) 'num' elements from the front.
+	  * @result The number of elements actually copied to 'out', less than
+	  *         'num' when the buffer contained fewer elements.
+	  */
+	size_t pop(T* out, size_t num)
+	{
+		auto r = readIdx .load(std::memory_order_relaxed);
+		auto w = writeIdx.load(std::memory_order_acquire);
+		num = std::min(num, w - r);
+		if (num == 0) return 0;
+		size_t pos = r & (cap - 1);
+		size_t len1 = std::min(num, cap - pos);
+		memcpy(out, &buf[pos], len1 * sizeof(T));
+		memcpy(out + len1, &buf[0], (num - len1) * sizeof(T));
+		readIdx.store(r + num, std::memory_order_release);
+		return num;
+	}
+
+private:
+	MemBuffer<T> buf;
+	size_t cap = 0; // always a power of 2 (or 0 before the first resize())
+	// Both indices only increase (and wrap around at the size_t boundary),
+	// this allows to distinguish a full from an empty buffer. They're on
+	// separate cache lines to avoid false sharing between the two threads.
+	alignas(64) std::atomic<size_t> readIdx{0};
+	alignas(64) std::atomic<size_t> writeIdx{0};
+};
+
+} // namespace openmsx
+
+#endif
@@ -1,19 +1,75 @@
 #include "TigerTree.hh"
 #include "tiger.hh"
 #include "Math.hh"
-#include "MemBuffer.hh"
+#include <algorithm>
 #include <map>
-#include <cstring>
+#include <memory>
+#include <vector>
 #include <cassert>
 
 namespace openmsx {
 
 constexpr size_t BLOCK_SIZE = 1024;
 
+// The nodes of the tree are allocated in groups, on first use. So for a huge
+// but mostly empty (sparse) image, memory is only needed for the nodes that
+// are actually calculated.
+class TTNodes
+{
+public:
+	void reset(size_t numNodes)
+	{
+		groups.clear();
+		groups.resize((numNodes + GROUP_SIZE - 1) / GROUP_SIZE);
+	}
+
+	[[nodiscard]] bool isValid(size_t n) const
+	{
+		const auto& g = groups[n / GROUP_SIZE];
+		return g && g->valid[n % GROUP_SIZE];
+	}
+
+	/** Returns true iff the node was valid. */
+	bool invalidate(size_t n)
+	{
+		auto& g = groups[n / GROUP_SIZE];
+		if (!g || !g->valid[n % GROUP_SIZE]) return false;
+		g->valid[n % GROUP_SIZE] = false;
+		return true;
+	}
+
+	void setValid(size_t n)
+	{
+		getGroup(n).valid[n % GROUP_SIZE] = true;
+	}
+
+	/** The returned reference remains valid, also when other groups get
+	  * allocated. */
+	[[nodiscard]] TigerHash& getHash(size_t n)
+	{
+		return getGroup(n).hash[n % GROUP_SIZE];
+	}
+
+private:
+	static constexpr size_t GROUP_SIZE = 4096;
+	struct Group {
+		TigerHash hash[GROUP_SIZE];
+		bool valid[GROUP_SIZE] = {};
+	};
+
+	[[nodiscard]] Group& getGroup(size_t n)
+	{
+		auto& g = groups[n / GROUP_SIZE];
+		if (!g) g = std::make_unique<Group>();
+		return *g;
+	}
+
+	std::vector<std::unique_ptr<Group>> groups;
+};
+
 struct TTCacheEntry
 {
-	MemBuffer<TigerHash> hash;
-	MemBuffer<bool> valid;
+	TTNodes nodes;
 	size_t numNodes;
 	time_t time = -1;
 	size_t numNodesValid;
@@ -35,15 +91,29 @@ static TTCacheEntry& getCacheEntry(
 	auto& result = ttCache[std::pair(dataSize, name)];
 	if (!data.isCacheStillValid(result.time)) { // note: has side effect
 		size_t numNodes = calcNumNodes(dataSize);
-		result.hash .resize(numNodes);
-		result.valid.resize(numNodes);
+		result.nodes.reset(numNodes); // all invalid
 		result.numNodes = numNodes;
-		memset(result.valid.data(), 0, numNodes); // all invalid
 		result.numNodesValid = 0;
 	}
 	return result;
 }
 
+// The hash of a full subtree of the given level with only zeros as data.
+static TigerHash getZeroHash(size_t level)
+{
+	static std::vector<TigerHash> zeroHashes; // index: log2(level)
+	if (zeroHashes.empty()) {
+		static uint8_t zeros[1 + BLOCK_SIZE]; // tiger_leaf() writes data[-1]
+		tiger_leaf(zeros + 1, zeroHashes.emplace_back());
+	}
+	auto index = Math::log2p1(level) - 1;
+	while (zeroHashes.size() <= index) {
+		auto h = zeroHashes.back();
+		tiger_int(h, h, zeroHashes.emplace_back());
+	}
+	return zeroHashes[index];
+}
+
 TigerTree::TigerTree(TTData& data_, size_t dataSize_, const std::string& name)
 	: data(data_)
 	, dataSize(dataSize_)
@@ -63,18 +133,23 @@ void TigerTree::notifyChange(size_t offset, size_t len, time_t time)
 	assert((offset + len) <= dataSize);
 	if (len == 0) return;
 
-	if (entry.valid[getTop().n]) {
-		entry.valid[getTop().n] = false; // set sentinel
+	if (entry.nodes.invalidate(getTop().n)) { // set sentinel
 		entry.numNodesValid--;
 	}
 	auto first = offset / BLOCK_SIZE;
 	auto last = (offset + len - 1) / BLOCK_SIZE;
 	assert(first <= last); // requires len != 0
+	auto top = getTop().n;
 	do {
+		// Normally all parents of an invalid node are invalid as well.
+		// But not when a parent was obtained via TTData::getHash(), so
+		// walk all the way up.
 		auto node = getLeaf(first);
-		while (entry.valid[node.n]) {
-			entry.valid[node.n] = false;
-			entry.numNodesValid--;
+		while (true) {
+			if (entry.nodes.invalidate(node.n)) {
+				entry.numNodesValid--;
+			}
+			if (node.n == top) break;
 			node = getParent(node);
 		}
 	} while (++first <= last);
@@ -83,38 +158,52 @@ void TigerTree::notifyChange(size_t offset, size_t len, time_t time)
 const TigerHash& TigerTree::calcHash(Node node, const std::function<void(size_t, size_t)>& progressCallback)
 {
 	auto n = node.n;
-	if (!entry.valid[n]) {
+	auto& hash = entry.nodes.getHash(n);
+	if (!entry.nodes.isValid(n)) {
 		if (n & 1) {
 			// interior node
-			auto left  = getLeftChild (node);
-			auto right = getRightChild(node);
-			auto& h1 = calcHash(left, progressCallback);
-			auto& h2 = calcHash(right, progressCallback);
-			tiger_int(h1, h2, entry.hash[n]);
+			size_t offset = (n + 1 - node.l) * (BLOCK_SIZE / 2);
+			size_t size = std::min(node.l * BLOCK_SIZE, dataSize - offset);
+			if (const auto* h = data.getHash(offset, size)) {
+				hash = *h;
+			} else if ((size == node.l * BLOCK_SIZE) &&
+			           data.isZero(offset, size)) {
+				hash = getZeroHash(node.l);
+			} else {
+				auto left  = getLeftChild (node);
+				auto right = getRightChild(node);
+				auto& h1 = calcHash(left, progressCallback);
+				auto& h2 = calcHash(right, progressCallback);
+				tiger_int(h1, h2, hash);
+			}
 		} else {
 			// leaf node
 			size_t b = n * (BLOCK_SIZE / 2);
 			size_t l = dataSize - b;
 
 			if (l >= BLOCK_SIZE) {
-				auto* d = data.getData(b, BLOCK_SIZE);
-				tiger_leaf(d, entry.hash[n]);
+				if (data.isZero(b, BLOCK_SIZE)) {
+					hash = getZeroHash(1);
+				} else {
+					auto* d = data.getData(b, BLOCK_SIZE);
+					tiger_leaf(d, hash);
+				}
 			} else {
 				// partial last block
 				auto* d = data.getData(b, l);
 				auto backup = d[-1];
 				d[-1] = 0;
-				tiger(d - 1, l + 1, entry.hash[n]);
+				tiger(d - 1, l + 1, hash);
 				d[-1] = backup;
 			}
 		}
-		entry.valid[n] = true;
+		entry.nodes.setValid(n);
 		entry.numNodesValid++;
 		if (progressCallback) {
 			progressCallback(entry.numNodesValid, entry.numNodes);
 		}
 	}
-	return entry.hash[n];
+	return hash;
 }
 
 
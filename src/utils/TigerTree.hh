@@ -59,6 +59,18 @@ public:
 	  */
 	[[nodiscard]] virtual bool isCacheStillValid(time_t& time) = 0;
 
+	/** Optionally return an already known hash of (the subtree covering)
+	  * the given range. E.g. an image format that stores such hashes. The
+	  * default implementation returns nullptr: calculate it from the data.
+	  */
+	[[nodiscard]] virtual const TigerHash* getHash(size_t /*offset*/, size_t /*size*/) { return nullptr; }
+
+	/** Optionally tell that the given range only contains zeros, without
+	  * reading it. E.g. because it's a hole in a sparse file. The default
+	  * implementation returns false: read the data.
+	  */
+	[[nodiscard]] virtual bool isZero(size_t /*offset*/, size_t /*size*/) { return false; }
+
 protected:
 	~TTData() = default;
 };
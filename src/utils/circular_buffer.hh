@@ -362,6 +362,14 @@ public:
 		for (auto& e : list) push_back(e);
 	}
 
+	/** Append all elements in the range [first, last). The buffer is
+	  * grown (at most) once, instead of checked for each element. */
+	template<typename InputIt>
+	void push_back(InputIt first, InputIt last) {
+		checkGrow(size_t(std::distance(first, last)));
+		for (/**/; first != last; ++first) buf.push_back(*first);
+	}
+
 	T pop_front() {
 		T t = std::move(buf.front());
 		buf.pop_front();
@@ -394,6 +402,12 @@ private:
 			buf.set_capacity(std::max(size_t(4), buf.capacity() * 2));
 		}
 	}
+	void checkGrow(size_t n) {
+		if (buf.reserve() < n) {
+			buf.set_capacity(std::max({size_t(4), buf.capacity() * 2,
+			                           buf.size() + n}));
+		}
+	}
 
 	circular_buffer<T> buf;
 };
@@ -37,8 +37,9 @@
 //
 // The most important changes are:
 // - Stripped out all functions we don't use.
-// - Removed all safety checks. We only decompress data returned from the
-//   compress function, and that data is never stored/reloaded from disk.
+// - Removed all safety checks from decompress(). That function is only used
+//   for data returned from the compress function that was never stored on
+//   disk. For untrusted data (e.g. loaded from a file) use decompressSafe().
 // - Rewrite in C++ style.
 // - Use existing openMSX helper functions.
 
@@ -55,6 +56,13 @@ namespace LZ4 {
 
 	[[nodiscard]] int compress  (const uint8_t* src, uint8_t* dst, int srcSize);
 	int decompress(const uint8_t* src, uint8_t* dst, int compressedSize, int dstCapacity);
+
+	/** Like decompress(), but checks the input: never reads beyond
+	  * 'src + compressedSize', never writes beyond 'dst + dstCapacity' and
+	  * never copies a match from before 'dst'.
+	  * @return Number of decompressed bytes, or -1 for malformed input.
+	  */
+	[[nodiscard]] int decompressSafe(const uint8_t* src, uint8_t* dst, int compressedSize, int dstCapacity);
 }
 
 #endif
@@ -20,6 +20,7 @@ A million repetitions of "a"
 
 #include "sha1.hh"
 #include "MSXException.hh"
+#include "build-info.hh"
 #include "endian.hh"
 #include "likely.hh"
 #include "ranges.hh"
@@ -29,6 +30,18 @@ A million repetitions of "a"
 #include <emmintrin.h> // SSE2
 #endif
 
+// The SHA-NI code is compiled for that instruction set via a function
+// attribute (so the rest of the program doesn't require it), and is only
+// used after checking the CPU at runtime.
+#if ASM_X86 && (defined(__GNUC__) || defined(__clang__))
+#define SHA1_SHANI 1
+#include <cpuid.h>
+#include <immintrin.h>
+#define SHANI_TARGET __attribute__((target("sha,ssse3,sse4.1")))
+#else
+#define SHA1_SHANI 0
+#endif
+
 using std::string;
 
 namespace openmsx {
@@ -251,31 +264,18 @@ void Sha1Sum::clear()
 }
 
 
-// class SHA1
-
-SHA1::SHA1()
-{
-	// SHA1 initialization constants
-	m_state.a[0] = 0x67452301;
-	m_state.a[1] = 0xEFCDAB89;
-	m_state.a[2] = 0x98BADCFE;
-	m_state.a[3] = 0x10325476;
-	m_state.a[4] = 0xC3D2E1F0;
-
-	m_count = 0;
-	m_finalized = false;
-}
+// SHA-1 compression function
 
-void SHA1::transform(const uint8_t buffer[64])
+static void transformScalar(uint32_t state[5], const uint8_t buffer[64])
 {
 	WorkspaceBlock block(buffer);
 
-	// Copy m_state[] to working vars
-	uint32_t a = m_state.a[0];
-	uint32_t b = m_state.a[1];
-	uint32_t c = m_state.a[2];
-	uint32_t d = m_state.a[3];
-	uint32_t e = m_state.a[4];
+	// Copy state[] to working vars
+	uint32_t a = state[0];
+	uint32_t b = state[1];
+	uint32_t c = state[2];
+	uint32_t d = state[3];
+	uint32_t e = state[4];
 
 	// 4 rounds of 20 operations each. Loop unrolled
 	block.r0(a,b,c,d,e, 0); block.r0(e,a,b,c,d, 1); block.r0(d,e,a,b,c, 2);
@@ -306,12 +306,150 @@ void SHA1::transform(const uint8_t buffer[64])
 	block.r4(a,b,c,d,e,75); block.r4(e,a,b,c,d,76); block.r4(d,e,a,b,c,77);
 	block.r4(c,d,e,a,b,78); block.r4(b,c,d,e,a,79);
 
-	// Add the working vars back into m_state[]
-	m_state.a[0] += a;
-	m_state.a[1] += b;
-	m_state.a[2] += c;
-	m_state.a[3] += d;
-	m_state.a[4] += e;
+	// Add the working vars back into state[]
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+}
+
+#if SHA1_SHANI
+// One group of 4 rounds. The message schedule (w[0..79]) is kept in 4
+// registers, 'msg[g % 4]' holds w[4g .. 4g+3]. Based on the description in
+// Intel's "New Instructions Supporting the Secure Hash Algorithm on Intel
+// Architecture Processors".
+template<int G>
+SHANI_TARGET static inline void shaNiRounds(
+	__m128i& abcd, __m128i& e0, __m128i& e1, __m128i msg[4], const uint8_t* data)
+{
+	const __m128i BYTE_SWAP = _mm_set_epi64x(0x0001020304050607, 0x08090a0b0c0d0e0f);
+	auto& cur = msg[G % 4];
+	// alternate between 'e0' and 'e1'
+	auto& e    = (G & 1) ? e1 : e0;
+	auto& next = (G & 1) ? e0 : e1;
+
+	if (G < 4) {
+		cur = _mm_shuffle_epi8(_mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(data + 16 * G)), BYTE_SWAP);
+	}
+	e = (G == 0) ? _mm_add_epi32(e, cur) : _mm_sha1nexte_epu32(e, cur);
+	next = abcd;
+	if (3 <= G && G <= 18) {
+		msg[(G + 1) % 4] = _mm_sha1msg2_epu32(msg[(G + 1) % 4], cur);
+	}
+	abcd = _mm_sha1rnds4_epu32(abcd, e, G / 5);
+	if (1 <= G && G <= 16) {
+		msg[(G + 3) % 4] = _mm_sha1msg1_epu32(msg[(G + 3) % 4], cur);
+	}
+	if (2 <= G && G <= 17) {
+		msg[(G + 2) % 4] = _mm_xor_si128(msg[(G + 2) % 4], cur);
+	}
+}
+
+SHANI_TARGET static void transformShaNi(uint32_t state[5], const uint8_t* data, size_t numBlocks)
+{
+	__m128i abcd = _mm_shuffle_epi32(
+		_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1B);
+	__m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+	for (/**/; numBlocks; --numBlocks, data += 64) {
+		__m128i abcdSave = abcd;
+		__m128i e0Save = e0;
+		__m128i e1;
+		__m128i msg[4];
+		shaNiRounds< 0>(abcd, e0, e1, msg, data);
+		shaNiRounds< 1>(abcd, e0, e1, msg, data);
+		shaNiRounds< 2>(abcd, e0, e1, msg, data);
+		shaNiRounds< 3>(abcd, e0, e1, msg, data);
+		shaNiRounds< 4>(abcd, e0, e1, msg, data);
+		shaNiRounds< 5>(abcd, e0, e1, msg, data);
+		shaNiRounds< 6>(abcd, e0, e1, msg, data);
+		shaNiRounds< 7>(abcd, e0, e1, msg, data);
+		shaNiRounds< 8>(abcd, e0, e1, msg, data);
+		shaNiRounds< 9>(abcd, e0, e1, msg, data);
+		shaNiRounds<10>(abcd, e0, e1, msg, data);
+		shaNiRounds<11>(abcd, e0, e1, msg, data);
+		shaNiRounds<12>(abcd, e0, e1, msg, data);
+		shaNiRounds<13>(abcd, e0, e1, msg, data);
+		shaNiRounds<14>(abcd, e0, e1, msg, data);
+		shaNiRounds<15>(abcd, e0, e1, msg, data);
+		shaNiRounds<16>(abcd, e0, e1, msg, data);
+		shaNiRounds<17>(abcd, e0, e1, msg, data);
+		shaNiRounds<18>(abcd, e0, e1, msg, data);
+		shaNiRounds<19>(abcd, e0, e1, msg, data);
+		e0 = _mm_sha1nexte_epu32(e0, e0Save);
+		abcd = _mm_add_epi32(abcd, abcdSave);
+	}
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_shuffle_epi32(abcd, 0x1B));
+	state[4] = _mm_extract_epi32(e0, 3);
+}
+
+static bool cpuHasShaNi()
+{
+	static const bool result = [] {
+		unsigned eax, ebx, ecx, edx;
+		if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+		bool ssse3  = ecx & (1 << 9);
+		bool sse41  = ecx & (1 << 19);
+		if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+		bool sha = ebx & (1 << 29);
+		return ssse3 && sse41 && sha;
+	}();
+	return result;
+}
+#endif
+
+
+// class SHA1
+
+bool SHA1::isSupported(Backend backend)
+{
+	switch (backend) {
+	case Backend::SCALAR:
+		return true;
+	case Backend::SHA_NI:
+#if SHA1_SHANI
+		return cpuHasShaNi();
+#else
+		return false;
+#endif
+	}
+	return false;
+}
+
+SHA1::Backend SHA1::getBestBackend()
+{
+	if (isSupported(Backend::SHA_NI)) return Backend::SHA_NI;
+	return Backend::SCALAR;
+}
+
+SHA1::SHA1(Backend backend)
+	: m_backend(backend)
+{
+	assert(isSupported(backend));
+
+	// SHA1 initialization constants
+	m_state.a[0] = 0x67452301;
+	m_state.a[1] = 0xEFCDAB89;
+	m_state.a[2] = 0x98BADCFE;
+	m_state.a[3] = 0x10325476;
+	m_state.a[4] = 0xC3D2E1F0;
+
+	m_count = 0;
+	m_finalized = false;
+}
+
+void SHA1::transform(const uint8_t* data, size_t numBlocks)
+{
+#if SHA1_SHANI
+	if (m_backend == Backend::SHA_NI) {
+		transformShaNi(m_state.a, data, numBlocks);
+		return;
+	}
+#endif
+	for (/**/; numBlocks; --numBlocks, data += 64) {
+		transformScalar(m_state.a, data);
+	}
 }
 
 // Use this function to hash in binary data and strings
@@ -325,10 +463,10 @@ void SHA1::update(const uint8_t* data, size_t len)
 	size_t i;
 	if ((j + len) > 63) {
 		memcpy(&m_buffer[j], data, (i = 64 - j));
-		transform(m_buffer);
-		for (; i + 63 < len; i += 64) {
-			transform(&data[i]);
-		}
+		transform(m_buffer, 1);
+		size_t numBlocks = (len - i) / 64;
+		transform(&data[i], numBlocks);
+		i += 64 * numBlocks;
 		j = 0;
 	} else {
 		i = 0;
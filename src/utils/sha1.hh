@@ -78,7 +78,20 @@ private:
 class SHA1
 {
 public:
-	SHA1();
+	/** Implementations of the SHA-1 compression function. */
+	enum class Backend {
+		SCALAR, // plain C++
+		SHA_NI, // x86 SHA extensions
+	};
+
+	/** Is the given backend supported by this build and this CPU? */
+	[[nodiscard]] static bool isSupported(Backend backend);
+	/** The fastest supported backend, used by default. */
+	[[nodiscard]] static Backend getBestBackend();
+
+	SHA1() : SHA1(getBestBackend()) {}
+	/** Use a specific backend (for testing), must be supported. */
+	explicit SHA1(Backend backend);
 
 	/** Incrementally calculate the hash value. */
 	void update(const uint8_t* data, size_t len);
@@ -91,13 +104,14 @@ public:
 	[[nodiscard]] static Sha1Sum calc(const uint8_t* data, size_t len);
 
 private:
-	void transform(const uint8_t buffer[64]);
+	void transform(const uint8_t* data, size_t numBlocks);
 	void finalize();
 
 	uint64_t m_count;
 	Sha1Sum m_state;
 	uint8_t m_buffer[64];
 	bool m_finalized;
+	Backend m_backend;
 };
 
 } // namespace openmsx
@@ -1,12 +1,14 @@
 #include "AviRecorder.hh"
 #include "AviWriter.hh"
-#include "WavWriter.hh"
+#include "RawVideoWriter.hh"
+#include "AsyncWavWriter.hh"
 #include "Reactor.hh"
 #include "MSXMotherBoard.hh"
 #include "FileContext.hh"
 #include "CommandException.hh"
 #include "Display.hh"
 #include "PostProcessor.hh"
+#include "ScreenShotWriter.hh"
 #include "Math.hh"
 #include "MSXMixer.hh"
 #include "Filename.hh"
@@ -14,6 +16,7 @@
 #include "FileOperations.hh"
 #include "TclArgParser.hh"
 #include "TclObject.hh"
+#include "StringOp.hh"
 #include "outer.hh"
 #include "view.hh"
 #include "vla.hh"
@@ -37,12 +40,13 @@ AviRecorder::AviRecorder(Reactor& reactor_)
 
 AviRecorder::~AviRecorder()
 {
-	assert(!aviWriter);
+	assert(!videoWriter);
 	assert(!wavWriter);
 }
 
 void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
-                        bool recordStereo, const Filename& filename)
+                        bool recordStereo, VideoFormat format,
+                        const Filename& filename, const string& wavFilename)
 {
 	stop();
 	MSXMotherBoard* motherBoard = reactor.getMotherBoard();
@@ -83,17 +87,29 @@ void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
 		duration = EmuDuration::infinity();
 		prevTime = EmuTime::infinity();
 
+		unsigned channels = (recordAudio && stereo) ? 2 : 1;
 		try {
-			aviWriter = std::make_unique<AviWriter>(
-				filename, frameWidth, frameHeight, bpp,
-				(recordAudio && stereo) ? 2 : 1, sampleRate);
+			if (format == VideoFormat::AVI) {
+				videoWriter = std::make_unique<AviWriter>(
+					filename, frameWidth, frameHeight, bpp,
+					channels, sampleRate);
+			} else {
+				auto rawFormat = (format == VideoFormat::Y4M) ? RawVideoWriter::Format::Y4M
+				               : (format == VideoFormat::RGB) ? RawVideoWriter::Format::RGB
+				                                              : RawVideoWriter::Format::PNG;
+				videoWriter = std::make_unique<RawVideoWriter>(
+					rawFormat, filename.getResolved(),
+					recordAudio ? wavFilename : string{},
+					frameWidth, frameHeight, channels, sampleRate,
+					reactor.getDisplay().getScreenShotWriter().getCompression());
+			}
 		} catch (MSXException& e) {
 			throw CommandException("Can't start recording: ",
 			                       e.getMessage());
 		}
 	} else {
 		assert(recordAudio);
-		wavWriter = std::make_unique<Wav16Writer>(
+		wavWriter = std::make_unique<AsyncWavWriter>(
 			filename, stereo ? 2 : 1, sampleRate);
 	}
 	// only set recorders when all errors are checked for
@@ -114,8 +130,16 @@ void AviRecorder::stop()
 		mixer = nullptr;
 	}
 	sampleRate = 0;
-	aviWriter.reset();
-	wavWriter.reset();
+	videoWriter.reset();
+	if (wavWriter) {
+		try {
+			wavWriter->close();
+		} catch (MSXException& e) {
+			reactor.getCliComm().printWarning(
+				"Error while recording: ", e.getMessage());
+		}
+		wavWriter.reset();
+	}
 }
 
 static int16_t float2int16(float f)
@@ -140,7 +164,7 @@ void AviRecorder::addWave(unsigned num, float* fdata)
 		if (wavWriter) {
 			wavWriter->write(buf, 2, num);
 		} else {
-			assert(aviWriter);
+			assert(videoWriter);
 			audioBuf.insert(end(audioBuf), buf, buf + 2 * num);
 		}
 	} else {
@@ -165,7 +189,7 @@ void AviRecorder::addWave(unsigned num, float* fdata)
 		if (wavWriter) {
 			wavWriter->write(buf, 1, num);
 		} else {
-			assert(aviWriter);
+			assert(videoWriter);
 			audioBuf.insert(end(audioBuf), buf, buf + num);
 		}
 	}
@@ -184,14 +208,22 @@ void AviRecorder::addImage(FrameSource* frame, EmuTime::param time)
 		}
 	} else if (prevTime != EmuTime::infinity()) {
 		duration = time - prevTime;
-		aviWriter->setFps(1.0 / duration.toDouble());
+		videoWriter->setFps(1.0 / duration.toDouble());
 	}
 	prevTime = time;
 
 	if (mixer) {
 		mixer->updateStream(time);
 	}
-	aviWriter->addFrame(frame, unsigned(audioBuf.size()), audioBuf.data());
+	try {
+		videoWriter->addFrame(frame, unsigned(audioBuf.size()), audioBuf.data());
+	} catch (MSXException& e) {
+		audioBuf.clear();
+		reactor.getCliComm().printWarning(
+			"Recording stopped: ", e.getMessage());
+		stop();
+		return;
+	}
 	audioBuf.clear();
 }
 
@@ -204,6 +236,7 @@ unsigned AviRecorder::getFrameHeight() const {
 void AviRecorder::processStart(Interpreter& interp, span<const TclObject> tokens, TclObject& result)
 {
 	std::string_view prefix = "openmsx";
+	std::string_view formatStr = "avi";
 	bool audioOnly    = false;
 	bool videoOnly    = false;
 	bool recordMono   = false;
@@ -212,6 +245,7 @@ void AviRecorder::processStart(Interpreter& interp, span<const TclObject> tokens
 	bool tripleSize   = false;
 	ArgsInfo info[] = {
 		valueArg("-prefix", prefix),
+		valueArg("-format", formatStr),
 		flagArg("-audioonly", audioOnly),
 		flagArg("-videoonly", videoOnly),
 		flagArg("-mono",      recordMono),
@@ -233,6 +267,23 @@ void AviRecorder::processStart(Interpreter& interp, span<const TclObject> tokens
 	if (videoOnly && (recordStereo || recordMono)) {
 		throw CommandException("Can't have both -videoonly and -stereo or -mono.");
 	}
+	VideoFormat format;
+	std::string_view extension;
+	if (formatStr == "avi") {
+		format = VideoFormat::AVI; extension = ".avi";
+	} else if (formatStr == "y4m") {
+		format = VideoFormat::Y4M; extension = ".y4m";
+	} else if (formatStr == "rgb") {
+		format = VideoFormat::RGB; extension = ".rgb";
+	} else if (formatStr == "png") {
+		format = VideoFormat::PNG; extension = ""; // directory
+	} else {
+		throw CommandException("Unknown format: ", formatStr,
+		                       ", must be one of avi, y4m, rgb or png.");
+	}
+	if (audioOnly && (format != VideoFormat::AVI)) {
+		throw CommandException("Can't have both -audioonly and -format.");
+	}
 	std::string_view filenameArg;
 	switch (arguments.size()) {
 	case 0:
@@ -257,27 +308,52 @@ void AviRecorder::processStart(Interpreter& interp, span<const TclObject> tokens
 	bool recordAudio = !videoOnly;
 	bool recordVideo = !audioOnly;
 	string directory = recordVideo ? "videos" : "soundlogs";
-	string extension = recordVideo ? ".avi"   : ".wav";
+	if (!recordVideo) extension = ".wav";
 	string filename = FileOperations::parseCommandFileArgument(
 		filenameArg, directory, prefix, extension);
 
-	if (aviWriter || wavWriter) {
+	// The non-AVI formats write the audio to a separate WAV file.
+	string wavFilename;
+	if (recordAudio && recordVideo && (format != VideoFormat::AVI)) {
+		if (format == VideoFormat::PNG) {
+			wavFilename = FileOperations::join(filename, "audio.wav");
+		} else {
+			std::string_view base = filename;
+			if (StringOp::endsWith(base, extension)) {
+				base.remove_suffix(extension.size());
+			}
+			wavFilename = strCat(base, ".wav");
+		}
+	}
+
+	if (videoWriter || wavWriter) {
 		result = "Already recording.";
 	} else {
 		start(recordAudio, recordVideo, recordMono, recordStereo,
-				Filename(filename));
+		      format, Filename(filename), wavFilename);
 		result = "Recording to " + filename;
+		if (!wavFilename.empty()) {
+			result = strCat(result.getString(), " (audio to ", wavFilename, ')');
+		}
 	}
 }
 
 void AviRecorder::processStop(span<const TclObject> /*tokens*/)
 {
+	if (mixer) {
+		// Also record the samples till the current time (instead of
+		// only till the last fragment boundary).
+		auto* motherBoard = reactor.getMotherBoard();
+		if (motherBoard && (&motherBoard->getMSXMixer() == mixer)) {
+			mixer->updateStream(motherBoard->getCurrentTime());
+		}
+	}
 	stop();
 }
 
 void AviRecorder::processToggle(Interpreter& interp, span<const TclObject> tokens, TclObject& result)
 {
-	if (aviWriter || wavWriter) {
+	if (videoWriter || wavWriter) {
 		// drop extra tokens
 		processStop(tokens.first<2>());
 	} else {
@@ -287,7 +363,7 @@ void AviRecorder::processToggle(Interpreter& interp, span<const TclObject> token
 
 void AviRecorder::status(span<const TclObject> /*tokens*/, TclObject& result) const
 {
-	result.addDictKeyValue("status", (aviWriter || wavWriter) ? "recording" : "idle");
+	result.addDictKeyValue("status", (videoWriter || wavWriter) ? "recording" : "idle");
 }
 
 // class AviRecorder::Cmd
@@ -327,7 +403,17 @@ string AviRecorder::Cmd::help(const vector<string>& /*tokens*/) const
 	       "The start subcommand also accepts an optional -audioonly, -videoonly, "
 	       " -mono, -stereo, -doublesize, -triplesize flag.\n"
 	       "Videos are recorded in a 320x240 size by default, at 640x480 when the "
-	       "-doublesize flag is used and at 960x720 when the -triplesize flag is used.";
+	       "-doublesize flag is used and at 960x720 when the -triplesize flag is used.\n"
+	       "\n"
+	       "The -format option selects the video format:\n"
+	       "  avi  ZMBV video + PCM audio in one .avi file (default)\n"
+	       "  y4m  uncompressed YUV4MPEG2 stream (4:4:4) in a .y4m file\n"
+	       "  rgb  uncompressed 24-bit RGB frames without header in a .rgb file\n"
+	       "  png  one PNG file per frame, written to the given directory\n"
+	       "For the last three formats the audio is written to a separate .wav "
+	       "file (audio.wav in the directory for png). These files are written "
+	       "from a background thread and can be named pipes (FIFOs), e.g. to "
+	       "feed the recording directly to ffmpeg.";
 }
 
 void AviRecorder::Cmd::tabCompletion(vector<string>& tokens) const
@@ -340,7 +426,7 @@ void AviRecorder::Cmd::tabCompletion(vector<string>& tokens) const
 	} else if ((tokens.size() >= 3) && (tokens[1] == "start")) {
 		static constexpr const char* const options[] = {
 			"-prefix", "-videoonly", "-audioonly", "-doublesize", "-triplesize",
-			"-mono", "-stereo",
+			"-mono", "-stereo", "-format",
 		};
 		completeFileName(tokens, userFileContext(), options);
 	}
@@ -7,10 +7,10 @@
 #include <cstdint>
 #include <vector>
 #include <memory>
+#include <string>
 
 namespace openmsx {
 
-class AviWriter;
 class Filename;
 class FrameSource;
 class Interpreter;
@@ -18,7 +18,8 @@ class MSXMixer;
 class PostProcessor;
 class Reactor;
 class TclObject;
-class Wav16Writer;
+class VideoWriter;
+class AsyncWavWriter;
 
 class AviRecorder
 {
@@ -32,8 +33,11 @@ public:
 	unsigned getFrameHeight() const;
 
 private:
+	enum class VideoFormat { AVI, Y4M, RGB, PNG };
+
 	void start(bool recordAudio, bool recordVideo, bool recordMono,
-		   bool recordStereo, const Filename& filename);
+		   bool recordStereo, VideoFormat format,
+		   const Filename& filename, const std::string& wavFilename);
 	void status(span<const TclObject> tokens, TclObject& result) const;
 
 	void processStart (Interpreter& interp, span<const TclObject> tokens, TclObject& result);
@@ -50,8 +54,8 @@ private:
 	} recordCommand;
 
 	std::vector<int16_t> audioBuf;
-	std::unique_ptr<AviWriter>   aviWriter; // can be nullptr
-	std::unique_ptr<Wav16Writer> wavWriter; // can be nullptr
+	std::unique_ptr<VideoWriter> videoWriter; // can be nullptr
+	std::unique_ptr<AsyncWavWriter> wavWriter; // can be nullptr
 	std::vector<PostProcessor*> postProcessors;
 	MSXMixer* mixer;
 	EmuDuration duration;
@@ -18,12 +18,14 @@ AviWriter::AviWriter(const Filename& filename, unsigned width_,
                      unsigned height_, unsigned bpp, unsigned channels_,
                      unsigned freq_)
 	: file(filename, "wb")
-	, codec(width_, height_, bpp)
+	, codec(width_, height_, bpp, ThreadPool::getDefaultNumThreads())
 	, fps(0.0f) // will be filled in later
 	, width(width_)
 	, height(height_)
 	, channels(channels_)
 	, audiorate(freq_)
+	, writeWorker(2)
+	, encodeWorker(2)
 {
 	uint8_t dummy[AVI_HEADER_SIZE] = {};
 	file.write(dummy, sizeof(dummy));
@@ -37,6 +39,10 @@ AviWriter::AviWriter(const Filename& filename, unsigned width_,
 
 AviWriter::~AviWriter()
 {
+	// Finish encoding all queued frames. Errors can't be reported anymore.
+	encodeWorker.flush();
+	writeWorker.flush();
+
 	if (written == 0) {
 		// no data written yet (a recording less than one video frame)
 		std::string filename = file.getURL();
@@ -263,22 +269,48 @@ void AviWriter::addAviChunk(const char* tag, unsigned size, void* data, unsigned
 
 void AviWriter::addFrame(FrameSource* frame, unsigned samples, int16_t* sampleData)
 {
+	{
+		std::lock_guard<std::mutex> lock(errorMutex);
+		if (!error.empty()) throw MSXException(error);
+	}
+	if (samples) {
+		assert((samples % channels) == 0);
+		assert(audiorate != 0);
+	}
+
 	bool keyFrame = (frames++ % 300 == 0);
+	encodeWorker.pushMoveOnly([this, keyFrame,
+	                           grabbed = codec.grabFrame(frame),
+	                           audio = std::vector<int16_t>(sampleData, sampleData + samples)]() mutable {
+		writeWorker.pushMoveOnly([this, keyFrame,
+		                          work = codec.encodeFrame(keyFrame, std::move(grabbed)),
+		                          audio = std::move(audio)]() mutable {
+			try {
+				writeFrame(keyFrame, work, audio);
+			} catch (MSXException& e) {
+				std::lock_guard<std::mutex> lock(errorMutex);
+				if (error.empty()) error = e.getMessage();
+			}
+		});
+	});
+}
+
+void AviWriter::writeFrame(bool keyFrame, const std::vector<uint8_t>& work,
+                           std::vector<int16_t>& audio)
+{
 	void* buffer;
 	unsigned size;
-	codec.compressFrame(keyFrame, frame, buffer, size);
+	codec.compressFrame(keyFrame, work, buffer, size);
 	addAviChunk("00dc", size, buffer, keyFrame ? 0x10 : 0x0);
 
-	if (samples) {
-		assert((samples % channels) == 0);
-		assert(audiorate != 0);
+	if (unsigned samples = unsigned(audio.size())) {
 		if (OPENMSX_BIGENDIAN) {
 			// See comment in WavWriter::write()
 			//VLA(Endian::L16, buf, samples); // doesn't work in clang
-			std::vector<Endian::L16> buf(sampleData, sampleData + samples);
+			std::vector<Endian::L16> buf(begin(audio), end(audio));
 			addAviChunk("01wb", samples * sizeof(int16_t), buf.data(), 0);
 		} else {
-			addAviChunk("01wb", samples * sizeof(int16_t), sampleData, 0);
+			addAviChunk("01wb", samples * sizeof(int16_t), audio.data(), 0);
 		}
 		audiowritten += samples;
 	}
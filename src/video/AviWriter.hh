@@ -3,10 +3,14 @@
 #ifndef AVIWRITER_HH
 #define AVIWRITER_HH
 
+#include "VideoWriter.hh"
 #include "ZMBVEncoder.hh"
 #include "File.hh"
+#include "WorkerThread.hh"
 #include "endian.hh"
 #include <cstdint>
+#include <mutex>
+#include <string>
 #include <vector>
 
 namespace openmsx {
@@ -14,16 +18,30 @@ namespace openmsx {
 class Filename;
 class FrameSource;
 
-class AviWriter
+/** Writes video (ZMBV) and audio (16-bit PCM) to an AVI file.
+  *
+  * Only copying the frame happens on the calling (emulation) thread. The
+  * actual encoding is pipelined over two background threads: one does the
+  * motion search (itself parallelized, see ZMBVEncoder), the other does the
+  * zlib compression and writes the result to the file. Both stages have a
+  * bounded queue, so when the encoder can't keep up, addFrame() blocks.
+  */
+class AviWriter final : public VideoWriter
 {
 public:
 	AviWriter(const Filename& filename, unsigned width, unsigned height,
 	          unsigned bpp, unsigned channels, unsigned freq);
-	~AviWriter();
-	void addFrame(FrameSource* frame, unsigned samples, int16_t* sampleData);
-	void setFps(float fps_) { fps = fps_; }
+	~AviWriter() override;
+
+	/** Queue a frame (plus the audio that belongs to it) for encoding.
+	  * @throws MSXException when writing a previous frame failed.
+	  */
+	void addFrame(FrameSource* frame, unsigned samples, int16_t* sampleData) override;
+	void setFps(float fps_) override { fps = fps_; }
 
 private:
+	void writeFrame(bool keyFrame, const std::vector<uint8_t>& work,
+	                std::vector<int16_t>& audio);
 	void addAviChunk(const char* tag, unsigned size, void* data, unsigned flags);
 
 	File file;
@@ -37,8 +55,15 @@ private:
 	const unsigned audiorate;
 
 	unsigned frames;
-	unsigned audiowritten;
-	unsigned written;
+	unsigned audiowritten; // only accessed from the write thread
+	unsigned written;      //   (and the destructor)
+
+	std::string error; // first error from the write thread
+	std::mutex errorMutex;
+
+	// Must come last, so that these threads are stopped first.
+	WorkerThread writeWorker;  // zlib compression + write to file
+	WorkerThread encodeWorker; // motion search
 };
 
 } // namespace openmsx
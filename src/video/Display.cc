@@ -45,6 +45,7 @@ Display::Display(Reactor& reactor_)
 	, renderSettings(reactor.getCommandController())
 	, commandConsole(reactor.getGlobalCommandController(),
 	                 reactor.getEventDistributor(), *this)
+	, screenShotWriter(reactor.getCommandController(), *this)
 	, currentRenderer(RenderSettings::UNINITIALIZED)
 	, switchInProgress(false)
 {
@@ -188,6 +189,7 @@ int Display::signalEvent(const std::shared_ptr<const Event>& event)
 				std::make_shared<SimpleEvent>(
 					OPENMSX_FRAME_DRAWN_EVENT));
 		}
+		screenShotWriter.frameFinished(ffe);
 	} else if (event->getType() == OPENMSX_SWITCH_RENDERER_EVENT) {
 		doRendererSwitch();
 	} else if (event->getType() == OPENMSX_MACHINE_LOADED_EVENT) {
@@ -449,6 +451,7 @@ void Display::ScreenShotCmd::execute(span<const TclObject> tokens, TclObject& re
 	string filename = FileOperations::parseCommandFileArgument(
 		fname, "screenshots", prefix, ".png");
 
+	bool async = false;
 	if (!rawShot) {
 		// include all layers (OSD stuff, console)
 		try {
@@ -466,14 +469,18 @@ void Display::ScreenShotCmd::execute(span<const TclObject> tokens, TclObject& re
 		}
 		unsigned height = doubleSize ? 480 : 240;
 		try {
-			videoLayer->takeRawScreenShot(height, filename);
+			async = videoLayer->takeRawScreenShot(height, filename);
 		} catch (MSXException& e) {
 			throw CommandException(
 				"Failed to take screenshot: ", e.getMessage());
 		}
 	}
 
-	display.getCliComm().printInfo("Screen saved to ", filename);
+	if (async) {
+		display.getCliComm().printInfo("Screen will be saved to ", filename);
+	} else {
+		display.getCliComm().printInfo("Screen saved to ", filename);
+	}
 	result = filename;
 }
 
@@ -486,7 +493,12 @@ string Display::ScreenShotCmd::help(const vector<string>& /*tokens*/) const
 	       "screenshot -raw              320x240 raw screenshot (of MSX screen only)\n"
 	       "screenshot -raw -doublesize  640x480 raw screenshot (of MSX screen only)\n"
 	       "screenshot -with-osd         Include OSD elements in the screenshot\n"
-	       "screenshot -no-sprites       Don't include sprites in the screenshot\n";
+	       "screenshot -no-sprites       Don't include sprites in the screenshot\n"
+	       "\n"
+	       "Raw screenshots are written from a background thread when the "
+	       "'screenshot_async' setting is enabled. See also the "
+	       "'screenshot_compression' setting and the 'screenshot_sequence' "
+	       "command.\n";
 }
 
 void Display::ScreenShotCmd::tabCompletion(vector<string>& tokens) const
@@ -5,6 +5,7 @@
 #include "Command.hh"
 #include "CommandConsole.hh"
 #include "InfoTopic.hh"
+#include "ScreenShotWriter.hh"
 #include "OSDGUI.hh"
 #include "EventListener.hh"
 #include "LayerListener.hh"
@@ -44,6 +45,7 @@ public:
 	RenderSettings& getRenderSettings() { return renderSettings; }
 	OSDGUI& getOSDGUI() { return osdGui; }
 	CommandConsole& getCommandConsole() { return commandConsole; }
+	ScreenShotWriter& getScreenShotWriter() { return screenShotWriter; }
 
 	/** Redraw the display.
 	  * repaint() should only be called from the VideoSystem.
@@ -118,6 +120,7 @@ private:
 	Reactor& reactor;
 	RenderSettings renderSettings;
 	CommandConsole commandConsole;
+	ScreenShotWriter screenShotWriter;
 
 	// the current renderer
 	RenderSettings::RendererID currentRenderer;
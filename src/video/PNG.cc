@@ -294,7 +294,8 @@ static void flushData(png_structp ctx)
 }
 
 static void IMG_SavePNG_RW(int width, int height, const void** row_pointers,
-                           const std::string& filename, bool color)
+                           const std::string& filename, bool color,
+                           int compression = DEFAULT_COMPRESSION)
 {
 	try {
 		File file(filename, File::TRUNCATE);
@@ -317,6 +318,16 @@ static void IMG_SavePNG_RW(int width, int height, const void** row_pointers,
 		// Set up the output control.
 		png_set_write_fn(png.ptr, &file, writeData, flushData);
 
+		if (compression != DEFAULT_COMPRESSION) {
+			png_set_compression_level(png.ptr, compression);
+			if (compression <= 1) {
+				// When speed matters more than size, also skip
+				// the (relatively expensive) adaptive filtering.
+				png_set_filter(png.ptr, PNG_FILTER_TYPE_BASE,
+				               PNG_FILTER_NONE);
+			}
+		}
+
 		// Mark this image as being generated by openMSX and add creation time.
 		std::string version = Version::full();
 		png_text text[2];
@@ -363,7 +374,8 @@ static void IMG_SavePNG_RW(int width, int height, const void** row_pointers,
 	}
 }
 
-static void save(SDL_Surface* image, const std::string& filename)
+static void save(SDL_Surface* image, const std::string& filename,
+                 int compression)
 {
 	SDLAllocFormatPtr frmt24(SDL_AllocFormat(
 		OPENMSX_BIGENDIAN ? SDL_PIXELFORMAT_BGR24 : SDL_PIXELFORMAT_RGB24));
@@ -375,11 +387,13 @@ static void save(SDL_Surface* image, const std::string& filename)
 		row_pointers[i] = surf24.getLinePtr(i);
 	}
 
-	IMG_SavePNG_RW(image->w, image->h, row_pointers, filename, true);
+	IMG_SavePNG_RW(image->w, image->h, row_pointers, filename, true,
+	               compression);
 }
 
 void save(unsigned width, unsigned height, const void** rowPointers,
-          const PixelFormat& format, const std::string& filename)
+          const PixelFormat& format, const std::string& filename,
+          int compression)
 {
 	// this implementation creates 1 extra copy, can be optimized if required
 	SDLSurfacePtr surface(
@@ -389,13 +403,14 @@ void save(unsigned width, unsigned height, const void** rowPointers,
 		memcpy(surface.getLinePtr(y),
 		       rowPointers[y], width * format.getBytesPerPixel());
 	}
-	save(surface.get(), filename);
+	save(surface.get(), filename, compression);
 }
 
 void save(unsigned width, unsigned height,
-          const void** rowPointers, const std::string& filename)
+          const void** rowPointers, const std::string& filename,
+          int compression)
 {
-	IMG_SavePNG_RW(width, height, rowPointers, filename, true);
+	IMG_SavePNG_RW(width, height, rowPointers, filename, true, compression);
 }
 
 void saveGrayscale(unsigned width, unsigned height,
@@ -16,10 +16,17 @@ namespace openmsx::PNG {
 	 */
 	SDLSurfacePtr load(const std::string& filename, bool want32bpp);
 
+	/** Use zlib's default compression level (currently 6). Other valid
+	  * values range from 0 (store only, fastest) till 9 (best compression).
+	  */
+	constexpr int DEFAULT_COMPRESSION = -1;
+
 	void save(unsigned width, unsigned height, const void** rowPointers,
-	          const PixelFormat& format, const std::string& filename);
+	          const PixelFormat& format, const std::string& filename,
+	          int compression = DEFAULT_COMPRESSION);
 	void save(unsigned width, unsigned height, const void** rowPointers,
-	          const std::string& filename);
+	          const std::string& filename,
+	          int compression = DEFAULT_COMPRESSION);
 	void saveGrayscale(unsigned width, unsigned height,
 	                   const void** rowPointers, const std::string& filename);
 
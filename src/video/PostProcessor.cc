@@ -5,7 +5,6 @@
 #include "DoubledFrame.hh"
 #include "Deflicker.hh"
 #include "SuperImposedFrame.hh"
-#include "PNG.hh"
 #include "RenderSettings.hh"
 #include "RawFrame.hh"
 #include "AviRecorder.hh"
@@ -254,7 +253,7 @@ static void getScaledFrame(FrameSource& paintFrame, unsigned bpp,
 	}
 }
 
-void PostProcessor::takeRawScreenShot(unsigned height2, const std::string& filename)
+bool PostProcessor::takeRawScreenShot(unsigned height2, const std::string& filename)
 {
 	if (!paintFrame) {
 		throw CommandException("TODO");
@@ -264,7 +263,8 @@ void PostProcessor::takeRawScreenShot(unsigned height2, const std::string& filen
 	WorkBuffer workBuffer;
 	getScaledFrame(*paintFrame, getBpp(), height2, lines, workBuffer);
 	unsigned width = (height2 == 240) ? 320 : 640;
-	PNG::save(width, height2, lines, paintFrame->getPixelFormat(), filename);
+	return display.getScreenShotWriter().save(
+		width, height2, lines, paintFrame->getPixelFormat(), filename);
 }
 
 unsigned PostProcessor::getBpp() const
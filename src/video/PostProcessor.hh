@@ -87,7 +87,7 @@ public:
 	FrameSource* getPaintFrame() const { return paintFrame; }
 
 	// VideoLayer
-	void takeRawScreenShot(unsigned height, const std::string& filename) override;
+	bool takeRawScreenShot(unsigned height, const std::string& filename) override;
 
 
 	CliComm& getCliComm();
@@ -0,0 +1,272 @@
+#include "RawVideoWriter.hh"
+#include "FrameSource.hh"
+#include "File.hh"
+#include "Filename.hh"
+#include "FileOperations.hh"
+#include "MSXException.hh"
+#include "PNG.hh"
+#include "WavWriter.hh"
+#include "build-info.hh"
+#include "cstdiop.hh" // for snprintf
+#include "unreachable.hh"
+#include "vla.hh"
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace openmsx {
+
+// Number of frames that can be queued for writing. At 960x720 32bpp this is
+// about 16MB. When the consumer (e.g. of a FIFO) can't keep up, addFrame()
+// blocks.
+static constexpr unsigned MAX_PENDING_FRAMES = 6;
+static constexpr unsigned MAX_PENDING_AUDIO = 2 * MAX_PENDING_FRAMES;
+
+// Only used when the recording is stopped before the frame rate is known.
+static constexpr float DEFAULT_FPS = 60.0f;
+
+RawVideoWriter::RawVideoWriter(
+		Format format_, std::string filename_, std::string wavFilename_,
+		unsigned width_, unsigned height_, unsigned channels_,
+		unsigned freq_, int pngCompression_)
+	: filename(std::move(filename_))
+	, wavFilename(std::move(wavFilename_))
+	, format(format_)
+	, width(width_)
+	, height(height_)
+	, channels(channels_)
+	, audiorate(freq_)
+	, pngCompression(pngCompression_)
+	, audioWorker(MAX_PENDING_AUDIO)
+	, videoWorker(MAX_PENDING_FRAMES)
+{
+	if (format == Format::PNG) {
+		FileOperations::mkdirp(filename);
+	}
+	if (!wavFilename.empty()) {
+		audioWorker.push([this] {
+			try {
+				wavWriter = std::make_unique<Wav16Writer>(
+					Filename(wavFilename), channels, audiorate);
+			} catch (MSXException& e) {
+				setError(e.getMessage());
+			}
+		});
+	}
+}
+
+RawVideoWriter::~RawVideoWriter()
+{
+	if (firstFrame) {
+		if (fps == 0.0f) fps = DEFAULT_FPS;
+		queueFrame(std::move(*firstFrame));
+	}
+	// Remaining jobs are finished by the WorkerThread destructors, errors
+	// can't be reported anymore.
+}
+
+void RawVideoWriter::addFrame(FrameSource* frame, unsigned samples, int16_t* sampleData)
+{
+	{
+		std::lock_guard<std::mutex> lock(errorMutex);
+		if (!error.empty()) throw MSXException(error);
+	}
+
+	if (samples && !wavFilename.empty()) {
+		assert((samples % channels) == 0);
+		audioWorker.pushMoveOnly([this,
+		                          audio = std::vector<int16_t>(sampleData, sampleData + samples)] {
+			if (!wavWriter) return; // opening failed
+			try {
+				wavWriter->write(audio.data(), channels,
+				                 unsigned(audio.size()) / channels);
+			} catch (MSXException& e) {
+				setError(e.getMessage());
+			}
+		});
+	}
+
+	auto grabbed = grabFrame(frame);
+	if ((frames++ == 0) && (fps == 0.0f)) {
+		firstFrame = std::move(grabbed);
+		return;
+	}
+	if (firstFrame) {
+		queueFrame(std::move(*firstFrame));
+		firstFrame.reset();
+	}
+	queueFrame(std::move(grabbed));
+}
+
+template<typename Pixel>
+static void copyLines(FrameSource* frame, unsigned width, unsigned height,
+                      uint8_t* dest_)
+{
+	auto* dest = reinterpret_cast<Pixel*>(dest_);
+	for (unsigned y = 0; y < height; ++y, dest += width) {
+		const Pixel* line;
+		switch (height) {
+		case 240:
+			line = frame->getLinePtr320_240(y, dest);
+			break;
+		case 480:
+			line = frame->getLinePtr640_480(y, dest);
+			break;
+		case 720:
+			line = frame->getLinePtr960_720(y, dest);
+			break;
+		default:
+			UNREACHABLE;
+		}
+		if (line != dest) memcpy(dest, line, width * sizeof(Pixel));
+	}
+}
+
+RawVideoWriter::Frame RawVideoWriter::grabFrame(FrameSource* frame) const
+{
+	Frame result;
+	result.pixelFormat = frame->getPixelFormat();
+	unsigned pixelSize = result.pixelFormat.getBytesPerPixel();
+	result.pixels.resize(size_t(width) * height * pixelSize);
+	switch (pixelSize) {
+#if HAVE_16BPP
+	case 2:
+		copyLines<uint16_t>(frame, width, height, result.pixels.data());
+		break;
+#endif
+#if HAVE_32BPP
+	case 4:
+		copyLines<uint32_t>(frame, width, height, result.pixels.data());
+		break;
+#endif
+	default:
+		UNREACHABLE;
+	}
+	return result;
+}
+
+void RawVideoWriter::queueFrame(Frame frame)
+{
+	videoWorker.pushMoveOnly([this, frame = std::move(frame), frameFps = fps] {
+		writeFrame(frame, frameFps);
+	});
+}
+
+void RawVideoWriter::writeFrame(const Frame& frame, float frameFps)
+{
+	{
+		std::lock_guard<std::mutex> lock(errorMutex);
+		if (!error.empty()) return; // don't retry after an error
+	}
+	unsigned num = width * height;
+	std::vector<uint8_t> rgb(3 * num);
+	toRGB(frame.pixels.data(), frame.pixelFormat, num, rgb.data());
+	try {
+		switch (format) {
+		case Format::PNG: {
+			char name[32];
+			snprintf(name, sizeof(name), "frame%06u.png", written);
+			VLA(const void*, rows, height);
+			for (unsigned y = 0; y < height; ++y) {
+				rows[y] = &rgb[3 * width * y];
+			}
+			PNG::save(width, height, rows,
+			          FileOperations::join(filename, name),
+			          pngCompression);
+			break;
+		}
+		case Format::RGB:
+			if (!file) file = std::make_unique<File>(filename, "wb");
+			file->write(rgb.data(), rgb.size());
+			break;
+		case Format::Y4M: {
+			if (!file) {
+				file = std::make_unique<File>(filename, "wb");
+				auto header = getY4MHeader(width, height, frameFps);
+				file->write(header.data(), header.size());
+			}
+			std::vector<uint8_t> planes(3 * num);
+			rgbToYCbCr(rgb.data(), num, &planes[0 * num],
+			           &planes[1 * num], &planes[2 * num]);
+			static constexpr char FRAME[] = "FRAME\n";
+			file->write(FRAME, sizeof(FRAME) - 1);
+			file->write(planes.data(), planes.size());
+			break;
+		}
+		default:
+			UNREACHABLE;
+		}
+		++written;
+	} catch (MSXException& e) {
+		setError(e.getMessage());
+	}
+}
+
+void RawVideoWriter::setError(std::string message)
+{
+	std::lock_guard<std::mutex> lock(errorMutex);
+	if (error.empty()) error = std::move(message);
+}
+
+std::string RawVideoWriter::getY4MHeader(unsigned width, unsigned height, float fps)
+{
+	// Frame rate as a fraction, in 1/1000 fps units (NTSC is not an
+	// integer frame rate).
+	char buf[128];
+	snprintf(buf, sizeof(buf),
+	         "YUV4MPEG2 W%u H%u F%ld:1000 Ip A1:1 C444 XCOLORRANGE=LIMITED\n",
+	         width, height, lrintf(fps * 1000.0f));
+	return buf;
+}
+
+// Extend a color component of (8 - loss) bits to 8 bits, such that the
+// minimum and maximum values map to 0 and 255.
+static inline uint8_t expandComponent(unsigned v, unsigned loss)
+{
+	v <<= loss;
+	return uint8_t(loss ? (v | (v >> (8 - loss))) : v);
+}
+
+template<typename Pixel>
+static void toRGBImpl(const Pixel* src, const PixelFormat& format,
+                      unsigned num, uint8_t* rgb)
+{
+	for (unsigned i = 0; i < num; ++i) {
+		unsigned p = src[i];
+		rgb[3 * i + 0] = expandComponent(
+			(p & format.getRmask()) >> format.getRshift(), format.getRloss());
+		rgb[3 * i + 1] = expandComponent(
+			(p & format.getGmask()) >> format.getGshift(), format.getGloss());
+		rgb[3 * i + 2] = expandComponent(
+			(p & format.getBmask()) >> format.getBshift(), format.getBloss());
+	}
+}
+
+void RawVideoWriter::toRGB(const void* src, const PixelFormat& format,
+                           unsigned num, uint8_t* rgb)
+{
+	if (format.getBytesPerPixel() == 2) {
+		toRGBImpl(static_cast<const uint16_t*>(src), format, num, rgb);
+	} else {
+		assert(format.getBytesPerPixel() == 4);
+		toRGBImpl(static_cast<const uint32_t*>(src), format, num, rgb);
+	}
+}
+
+void RawVideoWriter::rgbToYCbCr(const uint8_t* rgb, unsigned num,
+                                uint8_t* y, uint8_t* cb, uint8_t* cr)
+{
+	// BT.601, limited range (Y in [16..235], Cb/Cr in [16..240]), 8-bit
+	// fixed point. The +(128 << 8) keeps the intermediate results positive.
+	for (unsigned i = 0; i < num; ++i) {
+		int r = rgb[3 * i + 0];
+		int g = rgb[3 * i + 1];
+		int b = rgb[3 * i + 2];
+		y [i] = uint8_t((( 66 * r + 129 * g +  25 * b + 128) >> 8) +  16);
+		cb[i] = uint8_t(( -38 * r -  74 * g + 112 * b + 128 + (128 << 8)) >> 8);
+		cr[i] = uint8_t(( 112 * r -  94 * g -  18 * b + 128 + (128 << 8)) >> 8);
+	}
+}
+
+} // namespace openmsx
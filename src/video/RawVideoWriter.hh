@@ -0,0 +1,104 @@
+#ifndef RAWVIDEOWRITER_HH
+#define RAWVIDEOWRITER_HH
+
+#include "VideoWriter.hh"
+#include "PixelFormat.hh"
+#include "MemBuffer.hh"
+#include "WorkerThread.hh"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace openmsx {
+
+class File;
+class Wav16Writer;
+
+/** Writes uncompressed video, so that it can be consumed directly by
+  * external tools (e.g. ffmpeg) without the cost of ZMBV encoding and
+  * decoding. Supported formats:
+  *  - Y4M: YUV4MPEG2 stream, 4:4:4 chroma, BT.601 limited range.
+  *  - RGB: stream of packed 24-bit RGB frames without any header.
+  *  - PNG: a directory containing one (lossless) PNG file per frame.
+  * The audio (if any) is written to a separate 16-bit WAV file.
+  *
+  * On the emulation thread the frame is only copied. Converting and writing
+  * happens on background threads, one for video and one for audio. Also
+  * opening the output files happens on those threads, so the output can be
+  * a named pipe (FIFO) that only gets opened for reading by the consumer
+  * after the recording has started.
+  */
+class RawVideoWriter final : public VideoWriter
+{
+public:
+	enum class Format { Y4M, RGB, PNG };
+
+	/** @param filename Output file, or output directory for PNG.
+	  * @param wavFilename Output file for the audio, empty for no audio.
+	  * @param pngCompression zlib compression level for PNG (0-9).
+	  */
+	RawVideoWriter(Format format, std::string filename,
+	               std::string wavFilename, unsigned width, unsigned height,
+	               unsigned channels, unsigned freq, int pngCompression);
+	~RawVideoWriter() override;
+
+	void addFrame(FrameSource* frame, unsigned samples, int16_t* sampleData) override;
+	void setFps(float fps_) override { fps = fps_; }
+
+	// The following are only public for the unittests.
+
+	/** The stream header of the Y4M format. */
+	[[nodiscard]] static std::string getY4MHeader(
+		unsigned width, unsigned height, float fps);
+
+	/** Convert 'num' pixels in the given format to packed 24-bit RGB. */
+	static void toRGB(const void* src, const PixelFormat& format,
+	                  unsigned num, uint8_t* rgb);
+
+	/** Convert 'num' packed RGB pixels to Y, Cb and Cr planes. */
+	static void rgbToYCbCr(const uint8_t* rgb, unsigned num,
+	                       uint8_t* y, uint8_t* cb, uint8_t* cr);
+
+private:
+	struct Frame {
+		MemBuffer<uint8_t, SSE2_ALIGNMENT> pixels; // in the native format
+		PixelFormat pixelFormat;
+	};
+
+	[[nodiscard]] Frame grabFrame(FrameSource* frame) const;
+	void queueFrame(Frame frame);
+	void writeFrame(const Frame& frame, float frameFps);
+	void setError(std::string message);
+
+	const std::string filename;
+	const std::string wavFilename;
+	const Format format;
+	const unsigned width;
+	const unsigned height;
+	const unsigned channels;
+	const unsigned audiorate;
+	const int pngCompression;
+
+	float fps = 0.0f;
+	unsigned frames = 0;
+	// The Y4M header needs the frame rate, but that's only known after the
+	// second frame. So the first frame is held back till then.
+	std::optional<Frame> firstFrame;
+
+	std::unique_ptr<File> file;             // only used by videoWorker
+	unsigned written = 0;                   //   "
+	std::unique_ptr<Wav16Writer> wavWriter; // only used by audioWorker
+
+	std::string error; // first error from one of the worker threads
+	std::mutex errorMutex;
+
+	// Must come last, so that these threads are stopped first.
+	WorkerThread audioWorker;
+	WorkerThread videoWorker;
+};
+
+} // namespace openmsx
+
+#endif
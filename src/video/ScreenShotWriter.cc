@@ -0,0 +1,238 @@
+#include "ScreenShotWriter.hh"
+#include "Display.hh"
+#include "VideoLayer.hh"
+#include "FinishFrameEvent.hh"
+#include "PNG.hh"
+#include "PixelFormat.hh"
+#include "CliComm.hh"
+#include "CommandException.hh"
+#include "FileContext.hh"
+#include "FileOperations.hh"
+#include "TclArgParser.hh"
+#include "TclObject.hh"
+#include "outer.hh"
+#include "vla.hh"
+#include "cstdiop.hh"
+#include <cstdint>
+#include <cstring>
+
+using std::string;
+using std::vector;
+
+namespace openmsx {
+
+// Maximum number of frames that can be waiting to be encoded. At 640x480
+// 32bpp this limits the memory usage to about 10MB.
+static constexpr unsigned MAX_PENDING = 8;
+
+ScreenShotWriter::ScreenShotWriter(
+		CommandController& commandController, Display& display_)
+	: display(display_)
+	, asyncSetting(commandController, "screenshot_async",
+		"write raw screenshots from a background thread, so that taking "
+		"a screenshot doesn't stall the emulation", false)
+	, compressionSetting(commandController, "screenshot_compression",
+		"zlib compression level for raw screenshots: 0 = store only "
+		"(fastest, largest files), 9 = best compression (slowest)",
+		6, 0, 9)
+	, sequenceCmd(commandController)
+	, worker(MAX_PENDING)
+{
+}
+
+ScreenShotWriter::~ScreenShotWriter()
+{
+	// Note: pending jobs are still finished by the WorkerThread destructor,
+	// but their errors can't be reported anymore.
+	flush();
+}
+
+bool ScreenShotWriter::isAsync() const
+{
+	return asyncSetting.getBoolean() || (sequenceEvery != 0);
+}
+
+bool ScreenShotWriter::save(
+	unsigned width, unsigned height, const void** rowPointers,
+	const PixelFormat& format, const string& filename)
+{
+	reportErrors();
+
+	int compression = compressionSetting.getInt();
+	if (!isAsync()) {
+		PNG::save(width, height, rowPointers, format, filename, compression);
+		return false;
+	}
+
+	// Copy the frame, the encoding happens later.
+	unsigned pitch = width * format.getBytesPerPixel();
+	vector<uint8_t> pixels(size_t(pitch) * height);
+	for (unsigned y = 0; y < height; ++y) {
+		memcpy(&pixels[size_t(y) * pitch], rowPointers[y], pitch);
+	}
+
+	worker.push([this, width, height, pitch, format, filename, compression,
+	             pixels = std::move(pixels)]() {
+		VLA(const void*, lines, height);
+		for (unsigned y = 0; y < height; ++y) {
+			lines[y] = &pixels[size_t(y) * pitch];
+		}
+		try {
+			PNG::save(width, height, lines, format, filename, compression);
+		} catch (MSXException& e) {
+			std::lock_guard<std::mutex> lock(errorMutex);
+			errors.push_back(e.getMessage());
+		}
+	});
+	return true;
+}
+
+void ScreenShotWriter::flush()
+{
+	worker.flush();
+}
+
+void ScreenShotWriter::reportErrors()
+{
+	vector<string> errorsCopy;
+	{
+		std::lock_guard<std::mutex> lock(errorMutex);
+		swap(errors, errorsCopy);
+	}
+	for (auto& e : errorsCopy) {
+		display.getCliComm().printWarning(
+			"Failed to take screenshot: ", e);
+	}
+}
+
+void ScreenShotWriter::frameFinished(const FinishFrameEvent& event)
+{
+	reportErrors();
+
+	if (sequenceEvery == 0) return;
+	// only count frames that are actually rendered (of the selected video
+	// source), a skipped frame would capture the previous image again
+	if (!event.needRender()) return;
+	if (++frameCounter < sequenceEvery) return;
+	frameCounter = 0;
+	saveSequenceFrame();
+}
+
+void ScreenShotWriter::saveSequenceFrame()
+{
+	auto* videoLayer = dynamic_cast<VideoLayer*>(display.findActiveLayer());
+	if (!videoLayer) return; // e.g. no machine, try again next frame
+
+	char num[16];
+	snprintf(num, sizeof(num), "%06u", imageCounter++);
+	string filename = FileOperations::join(
+		sequenceDir, strCat(sequencePrefix, num, ".png"));
+	try {
+		videoLayer->takeRawScreenShot(sequenceHeight, filename);
+	} catch (MSXException& e) {
+		sequenceEvery = 0;
+		display.getCliComm().printWarning(
+			"Screenshot sequence stopped: ", e.getMessage());
+	}
+}
+
+
+// class ScreenShotWriter::SequenceCmd
+
+ScreenShotWriter::SequenceCmd::SequenceCmd(CommandController& commandController_)
+	: Command(commandController_, "screenshot_sequence")
+{
+}
+
+void ScreenShotWriter::SequenceCmd::execute(
+	span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	auto& writer = OUTER(ScreenShotWriter, sequenceCmd);
+	executeSubCommand(tokens[1].getString(),
+		"start", [&]{
+			std::string_view prefix = "frame";
+			int every = 1;
+			bool doubleSize = false;
+			ArgsInfo info[] = {
+				valueArg("-prefix", prefix),
+				valueArg("-every", every),
+				flagArg("-doublesize", doubleSize),
+			};
+			auto arguments = parseTclArgs(
+				getInterpreter(), tokens.subspan(2), info);
+			if (arguments.size() != 1) {
+				throw SyntaxError();
+			}
+			if (every < 1) {
+				throw CommandException("-every must be at least 1");
+			}
+			string dir(arguments[0].getString());
+			if (FileOperations::getDirName(dir).empty()) {
+				// no path given, put it in the standard location
+				dir = FileOperations::join(
+					FileOperations::getUserOpenMSXDir(),
+					"screenshots", dir);
+			} else {
+				dir = FileOperations::expandTilde(dir);
+			}
+			FileOperations::mkdirp(dir);
+
+			writer.sequenceDir = dir;
+			writer.sequencePrefix = string(prefix);
+			writer.sequenceEvery = every;
+			writer.sequenceHeight = doubleSize ? 480 : 240;
+			writer.frameCounter = 0;
+			writer.imageCounter = 0;
+			result = "Capturing screenshots to " + dir;
+		},
+		"stop", [&]{
+			checkNumArgs(tokens, 2, Prefix{2}, nullptr);
+			writer.sequenceEvery = 0;
+			writer.flush();
+			writer.reportErrors();
+			result = int(writer.imageCounter);
+		},
+		"status", [&]{
+			checkNumArgs(tokens, 2, Prefix{2}, nullptr);
+			bool active = writer.sequenceEvery != 0;
+			result.addDictKeyValue("status", active ? "capturing" : "idle");
+			result.addDictKeyValue("frames", int(writer.imageCounter));
+			result.addDictKeyValue("pending", int(writer.worker.getNumPending()));
+			if (active) {
+				result.addDictKeyValue("directory", writer.sequenceDir);
+			}
+		});
+}
+
+string ScreenShotWriter::SequenceCmd::help(const vector<string>& /*tokens*/) const
+{
+	return "Capture a sequence of raw screenshots (320x240) to a directory.\n"
+	       "screenshot_sequence start <dir>            Write every frame to <dir>/frameNNNNNN.png\n"
+	       "screenshot_sequence start -every N <dir>   Only write every N-th frame\n"
+	       "screenshot_sequence start -prefix foo <dir> Write to <dir>/fooNNNNNN.png\n"
+	       "screenshot_sequence start -doublesize <dir> Capture at 640x480\n"
+	       "screenshot_sequence stop                   Stop capturing, returns the number of frames\n"
+	       "screenshot_sequence status                 Query capture state\n"
+	       "\n"
+	       "The PNG files are written from a background thread. See also the "
+	       "'screenshot_compression' setting, e.g. set it to 0 or 1 for "
+	       "the fastest possible capturing.";
+}
+
+void ScreenShotWriter::SequenceCmd::tabCompletion(vector<string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static constexpr const char* const cmds[] = {
+			"start", "stop", "status",
+		};
+		completeString(tokens, cmds);
+	} else if ((tokens.size() >= 3) && (tokens[1] == "start")) {
+		static constexpr const char* const options[] = {
+			"-prefix", "-every", "-doublesize",
+		};
+		completeFileName(tokens, userFileContext(), options);
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,93 @@
+#ifndef SCREENSHOTWRITER_HH
+#define SCREENSHOTWRITER_HH
+
+#include "Command.hh"
+#include "BooleanSetting.hh"
+#include "IntegerSetting.hh"
+#include "WorkerThread.hh"
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class CommandController;
+class Display;
+class FinishFrameEvent;
+class PixelFormat;
+
+/** Writes (raw) screenshots to PNG files.
+  *
+  * Encoding a PNG file is relatively slow. Optionally the frame data can be
+  * copied and the actual encoding can happen on a background thread, so
+  * that the emulation thread doesn't hitch when screenshots are taken often
+  * (e.g. by automated capture jobs). The number of frames that are waiting
+  * to be encoded is bounded, when that limit is reached the emulation
+  * thread will block (back-pressure).
+  *
+  * This class also implements the 'screenshot_sequence' command, which
+  * captures every N-th frame to a directory.
+  */
+class ScreenShotWriter final
+{
+public:
+	ScreenShotWriter(CommandController& commandController, Display& display);
+	~ScreenShotWriter();
+
+	/** Write the given image to a PNG file.
+	  * The image data is copied, so it's fine if rowPointers become
+	  * invalid after this call returns.
+	  * @return true iff the file is written asynchronously, so it's not
+	  *         yet (completely) written when this method returns.
+	  * @throws MSXException when writing synchronously failed.
+	  */
+	bool save(unsigned width, unsigned height, const void** rowPointers,
+	          const PixelFormat& format, const std::string& filename);
+
+	/** Wait till all pending asynchronous writes have finished. */
+	void flush();
+
+	/** Print all errors that occurred during asynchronous writes.
+	  * Must be called from the main thread.
+	  */
+	void reportErrors();
+
+	/** The zlib compression level for PNG files (0-9). */
+	[[nodiscard]] int getCompression() const { return compressionSetting.getInt(); }
+
+	/** Called by Display for every finished frame. */
+	void frameFinished(const FinishFrameEvent& event);
+
+private:
+	[[nodiscard]] bool isAsync() const;
+	void saveSequenceFrame();
+
+	Display& display;
+
+	BooleanSetting asyncSetting;
+	IntegerSetting compressionSetting;
+
+	struct SequenceCmd final : Command {
+		explicit SequenceCmd(CommandController& commandController);
+		void execute(span<const TclObject> tokens, TclObject& result) override;
+		std::string help(const std::vector<std::string>& tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} sequenceCmd;
+
+	// screenshot_sequence state
+	std::string sequenceDir;
+	std::string sequencePrefix;
+	unsigned sequenceEvery = 0; // 0 means not active
+	unsigned sequenceHeight = 240;
+	unsigned frameCounter = 0;
+	unsigned imageCounter = 0;
+
+	std::vector<std::string> errors; // shared with worker thread
+	std::mutex errorMutex;           // protects 'errors'
+
+	WorkerThread worker; // must come last: destroyed (joined) first
+};
+
+} // namespace openmsx
+
+#endif
@@ -78,6 +78,24 @@ public:
 		}
 	}
 
+	/** Position within the current line (in VDP ticks). Together with
+	  * skip() this allows to memoize the timing of a repeating pattern of
+	  * accesses (see bulk fast path in VDPCmdEngine). */
+	inline int getLinePos() const {
+		return ticks;
+	}
+
+	/** Advance exactly 'n' ticks. This does not round to an access slot,
+	  * so 'n' should be obtained from an earlier sequence of next() calls
+	  * that started at the same line position. */
+	inline void skip(int n) {
+		ticks += n;
+		int lines = ticks / TICKS;
+		ticks -= lines * TICKS;
+		limit -= lines * TICKS;
+		ref   += lines * TICKS;
+	}
+
 private:
 	int ticks;
 	int limit;
@@ -36,10 +36,12 @@ TODO:
 #include "VDPCmdEngine.hh"
 #include "EmuTime.hh"
 #include "VDPVRAM.hh"
+#include "CliComm.hh"
 #include "serialize.hh"
 #include "unreachable.hh"
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <iostream>
 
 using std::min;
@@ -176,6 +178,10 @@ struct Graphic4Mode
 	template <typename LogOp>
 	static inline void pset(EmuTime::param time, VDPVRAM& vram,
 		unsigned x, unsigned addr, byte src, byte color, LogOp op);
+	static inline byte point(const byte* mem, unsigned x, unsigned y);
+	template <typename LogOp>
+	static inline void pset(byte* mem, unsigned x, unsigned addr,
+		byte src, byte color, LogOp op);
 	static inline byte duplicate(byte color);
 };
 
@@ -203,6 +209,19 @@ inline void Graphic4Mode::pset(
 	op(time, vram, addr, src, color << sh, ~(15 << sh));
 }
 
+inline byte Graphic4Mode::point(const byte* mem, unsigned x, unsigned y)
+{
+	return (mem[addressOf(x, y, false)] >> (((~x) & 1) << 2)) & 15;
+}
+
+template<typename LogOp>
+inline void Graphic4Mode::pset(
+	byte* mem, unsigned x, unsigned addr, byte src, byte color, LogOp op)
+{
+	byte sh = ((~x) & 1) << 2;
+	op(mem, addr, src, color << sh, ~(15 << sh));
+}
+
 inline byte Graphic4Mode::duplicate(byte color)
 {
 	assert((color & 0xF0) == 0);
@@ -226,6 +245,10 @@ struct Graphic5Mode
 	template <typename LogOp>
 	static inline void pset(EmuTime::param time, VDPVRAM& vram,
 		unsigned x, unsigned addr, byte src, byte color, LogOp op);
+	static inline byte point(const byte* mem, unsigned x, unsigned y);
+	template <typename LogOp>
+	static inline void pset(byte* mem, unsigned x, unsigned addr,
+		byte src, byte color, LogOp op);
 	static inline byte duplicate(byte color);
 };
 
@@ -253,6 +276,19 @@ inline void Graphic5Mode::pset(
 	op(time, vram, addr, src, color << sh, ~(3 << sh));
 }
 
+inline byte Graphic5Mode::point(const byte* mem, unsigned x, unsigned y)
+{
+	return (mem[addressOf(x, y, false)] >> (((~x) & 3) << 1)) & 3;
+}
+
+template<typename LogOp>
+inline void Graphic5Mode::pset(
+	byte* mem, unsigned x, unsigned addr, byte src, byte color, LogOp op)
+{
+	byte sh = ((~x) & 3) << 1;
+	op(mem, addr, src, color << sh, ~(3 << sh));
+}
+
 inline byte Graphic5Mode::duplicate(byte color)
 {
 	assert((color & 0xFC) == 0);
@@ -278,6 +314,10 @@ struct Graphic6Mode
 	template <typename LogOp>
 	static inline void pset(EmuTime::param time, VDPVRAM& vram,
 		unsigned x, unsigned addr, byte src, byte color, LogOp op);
+	static inline byte point(const byte* mem, unsigned x, unsigned y);
+	template <typename LogOp>
+	static inline void pset(byte* mem, unsigned x, unsigned addr,
+		byte src, byte color, LogOp op);
 	static inline byte duplicate(byte color);
 };
 
@@ -305,6 +345,19 @@ inline void Graphic6Mode::pset(
 	op(time, vram, addr, src, color << sh, ~(15 << sh));
 }
 
+inline byte Graphic6Mode::point(const byte* mem, unsigned x, unsigned y)
+{
+	return (mem[addressOf(x, y, false)] >> (((~x) & 1) << 2)) & 15;
+}
+
+template<typename LogOp>
+inline void Graphic6Mode::pset(
+	byte* mem, unsigned x, unsigned addr, byte src, byte color, LogOp op)
+{
+	byte sh = ((~x) & 1) << 2;
+	op(mem, addr, src, color << sh, ~(15 << sh));
+}
+
 inline byte Graphic6Mode::duplicate(byte color)
 {
 	assert((color & 0xF0) == 0);
@@ -328,6 +381,10 @@ struct Graphic7Mode
 	template<typename LogOp>
 	static inline void pset(EmuTime::param time, VDPVRAM& vram,
 		unsigned x, unsigned addr, byte src, byte color, LogOp op);
+	static inline byte point(const byte* mem, unsigned x, unsigned y);
+	template<typename LogOp>
+	static inline void pset(byte* mem, unsigned x, unsigned addr,
+		byte src, byte color, LogOp op);
 	static inline byte duplicate(byte color);
 };
 
@@ -353,6 +410,18 @@ inline void Graphic7Mode::pset(
 	op(time, vram, addr, src, color, 0);
 }
 
+inline byte Graphic7Mode::point(const byte* mem, unsigned x, unsigned y)
+{
+	return mem[addressOf(x, y, false)];
+}
+
+template<typename LogOp>
+inline void Graphic7Mode::pset(
+	byte* mem, unsigned /*x*/, unsigned addr, byte src, byte color, LogOp op)
+{
+	op(mem, addr, src, color, 0);
+}
+
 inline byte Graphic7Mode::duplicate(byte color)
 {
 	return color;
@@ -376,6 +445,10 @@ struct NonBitmapMode
 	template<typename LogOp>
 	static inline void pset(EmuTime::param time, VDPVRAM& vram,
 		unsigned x, unsigned addr, byte src, byte color, LogOp op);
+	static inline byte point(const byte* mem, unsigned x, unsigned y);
+	template<typename LogOp>
+	static inline void pset(byte* mem, unsigned x, unsigned addr,
+		byte src, byte color, LogOp op);
 	static inline byte duplicate(byte color);
 };
 
@@ -401,6 +474,18 @@ inline void NonBitmapMode::pset(
 	op(time, vram, addr, src, color, 0);
 }
 
+inline byte NonBitmapMode::point(const byte* mem, unsigned x, unsigned y)
+{
+	return mem[addressOf(x, y, false)];
+}
+
+template<typename LogOp>
+inline void NonBitmapMode::pset(
+	byte* mem, unsigned /*x*/, unsigned addr, byte src, byte color, LogOp op)
+{
+	op(mem, addr, src, color, 0);
+}
+
 inline byte NonBitmapMode::duplicate(byte color)
 {
 	return color;
@@ -651,51 +736,98 @@ struct IncrShift7
 
 // Logical operations:
 
+// Each operation also has a variant that operates directly on a block of
+// memory, this is used by the bulk fast path.
+
 struct DummyOp {
 	void operator()(EmuTime::param /*time*/, VDPVRAM& /*vram*/, unsigned /*addr*/,
 	                byte /*src*/, byte /*color*/, byte /*mask*/) const
 	{
 		// Undefined logical operations do nothing.
 	}
+	void operator()(byte* /*mem*/, unsigned /*addr*/,
+	                byte /*src*/, byte /*color*/, byte /*mask*/) const
+	{
+	}
 };
 
 struct ImpOp {
+	static byte calc(byte src, byte color, byte mask) {
+		return (src & mask) | color;
+	}
 	void operator()(EmuTime::param time, VDPVRAM& vram, unsigned addr,
 	                byte src, byte color, byte mask) const
 	{
-		vram.cmdWrite(addr, (src & mask) | color, time);
+		vram.cmdWrite(addr, calc(src, color, mask), time);
+	}
+	void operator()(byte* mem, unsigned addr,
+	                byte src, byte color, byte mask) const
+	{
+		mem[addr] = calc(src, color, mask);
 	}
 };
 
 struct AndOp {
+	static byte calc(byte src, byte color, byte mask) {
+		return src & (color | mask);
+	}
 	void operator()(EmuTime::param time, VDPVRAM& vram, unsigned addr,
 	                byte src, byte color, byte mask) const
 	{
-		vram.cmdWrite(addr, src & (color | mask), time);
+		vram.cmdWrite(addr, calc(src, color, mask), time);
+	}
+	void operator()(byte* mem, unsigned addr,
+	                byte src, byte color, byte mask) const
+	{
+		mem[addr] = calc(src, color, mask);
 	}
 };
 
 struct OrOp {
+	static byte calc(byte src, byte color, byte /*mask*/) {
+		return src | color;
+	}
 	void operator()(EmuTime::param time, VDPVRAM& vram, unsigned addr,
-	                byte src, byte color, byte /*mask*/) const
+	                byte src, byte color, byte mask) const
+	{
+		vram.cmdWrite(addr, calc(src, color, mask), time);
+	}
+	void operator()(byte* mem, unsigned addr,
+	                byte src, byte color, byte mask) const
 	{
-		vram.cmdWrite(addr, src | color, time);
+		mem[addr] = calc(src, color, mask);
 	}
 };
 
 struct XorOp {
+	static byte calc(byte src, byte color, byte /*mask*/) {
+		return src ^ color;
+	}
 	void operator()(EmuTime::param time, VDPVRAM& vram, unsigned addr,
-	                byte src, byte color, byte /*mask*/) const
+	                byte src, byte color, byte mask) const
 	{
-		vram.cmdWrite(addr, src ^ color, time);
+		vram.cmdWrite(addr, calc(src, color, mask), time);
+	}
+	void operator()(byte* mem, unsigned addr,
+	                byte src, byte color, byte mask) const
+	{
+		mem[addr] = calc(src, color, mask);
 	}
 };
 
 struct NotOp {
+	static byte calc(byte src, byte color, byte mask) {
+		return (src & mask) | ~(color | mask);
+	}
 	void operator()(EmuTime::param time, VDPVRAM& vram, unsigned addr,
 	                byte src, byte color, byte mask) const
 	{
-		vram.cmdWrite(addr, (src & mask) | ~(color | mask), time);
+		vram.cmdWrite(addr, calc(src, color, mask), time);
+	}
+	void operator()(byte* mem, unsigned addr,
+	                byte src, byte color, byte mask) const
+	{
+		mem[addr] = calc(src, color, mask);
 	}
 };
 
@@ -709,6 +841,11 @@ struct TransparentOp : Op {
 		//      the same address inbetween the command read and write
 		if (color) Op::operator()(time, vram, addr, src, color, mask);
 	}
+	void operator()(byte* mem, unsigned addr,
+	                byte src, byte color, byte mask) const
+	{
+		if (color) Op::operator()(mem, addr, src, color, mask);
+	}
 };
 using TImpOp = TransparentOp<ImpOp>;
 using TAndOp = TransparentOp<AndOp>;
@@ -743,6 +880,123 @@ void VDPCmdEngine::calcFinishTime(unsigned nx, unsigned ny, unsigned ticksPerPix
 	setStatusChangeTime(engineTime + t);
 }
 
+bool VDPCmdEngine::calcBulkFinishTime(
+	EmuTime::param limit, span<const Delta> inner, Delta next,
+	Delta nextLine, unsigned tmpNX, unsigned tmpNY, EmuTime& finish) const
+{
+	// This does the same sequence of next() calls as the execute methods,
+	// but without accessing VRAM. Full rows that start at the same
+	// position within a display line take the same amount of time, so the
+	// timing of such rows is memoized.
+	auto calculator = getSlotCalculator(limit);
+	int ticks = 0;
+	auto step = [&](Delta delta) {
+		int before = calculator.getLinePos();
+		calculator.next(delta);
+		int diff = calculator.getLinePos() - before;
+		ticks += (diff < 0) ? (diff + TICKS) : diff;
+	};
+	// From the first VRAM access of a row till the last write in that row.
+	auto row = [&](unsigned num) {
+		for (unsigned i = 0; i < num; ++i) {
+			if (i != 0) step(next);
+			for (auto d : inner) step(d);
+		}
+	};
+
+	row(ANX); // first row can be partial
+	if (tmpNY > 1) {
+		step(nextLine);
+		std::vector<int> memo(TICKS, -1);
+		for (unsigned r = 1; r < (tmpNY - 1); ++r) {
+			if (calculator.limitReached()) return false;
+			int& m = memo[calculator.getLinePos()];
+			if (m < 0) {
+				ticks = 0;
+				row(tmpNX);
+				step(nextLine);
+				m = ticks;
+			} else {
+				calculator.skip(m);
+			}
+		}
+		row(tmpNX);
+	}
+	// Only if the last write happens before 'limit' the command finishes
+	// within this sync (all earlier accesses happen even earlier).
+	if (calculator.limitReached()) return false;
+	finish = calculator.getTime();
+	return true;
+}
+
+template<typename Mode>
+bool VDPCmdEngine::isBulkAreaAccessible(
+	unsigned y, int TY, unsigned rows, bool write) const
+{
+	for (unsigned i = 0; i < rows; ++i, y += TY) {
+		unsigned first = Mode::addressOf(0, y, false);
+		unsigned last  = Mode::addressOf(Mode::PIXELS_PER_LINE - 1, y, false);
+		if ((last - first) < 256) {
+			if (!vram.isBulkAccessible(first, last, write)) return false;
+		} else {
+			// planar mode: line is split over two blocks of 128 bytes
+			if (!vram.isBulkAccessible(first, first + 127, write) ||
+			    !vram.isBulkAccessible(last - 127, last, write)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+template<typename Kernel>
+bool VDPCmdEngine::executeBulk(
+	EmuTime::param limit, span<const Delta> inner, Delta next,
+	Delta nextLine, unsigned tmpNX, unsigned tmpNY, Kernel kernel)
+{
+	EmuTime finish = EmuTime::zero();
+	if (!calcBulkFinishTime(limit, inner, next, nextLine, tmpNX, tmpNY, finish)) {
+		return false;
+	}
+
+	BulkState state = { SY, DY, NY, ASX, ADX, ANX, tmpSrc, tmpDst };
+	if (cmdBulkSetting.getEnum() == BULK_VERIFY) {
+		// Execute on a copy of VRAM. Afterwards the regular code path
+		// executes the command and checkBulkVerify() compares both.
+		const byte* data = vram.getBulkData();
+		bulkVerify = std::make_unique<BulkVerify>(BulkVerify{
+			std::vector<byte>(data, data + vram.getSize()),
+			state, finish, CMD});
+		kernel(bulkVerify->vram.data(), bulkVerify->state);
+		return false;
+	}
+
+	kernel(vram.getBulkData(), state);
+	SY  = state.SY;  DY  = state.DY;  NY  = state.NY;
+	ASX = state.ASX; ADX = state.ADX; ANX = state.ANX;
+	tmpSrc = state.tmpSrc; tmpDst = state.tmpDst;
+	engineTime = finish;
+	commandDone(finish);
+	return true;
+}
+
+void VDPCmdEngine::checkBulkVerify()
+{
+	auto verify = std::move(bulkVerify);
+	const auto& st = verify->state;
+	bool ok = (CMD == 0) && (engineTime == verify->finish) &&
+	          (SY  == st.SY)  && (DY  == st.DY)  && (NY  == st.NY)  &&
+	          (ASX == st.ASX) && (ADX == st.ADX) && (ANX == st.ANX) &&
+	          (tmpSrc == st.tmpSrc) && (tmpDst == st.tmpDst) &&
+	          (memcmp(vram.getBulkData(), verify->vram.data(),
+	                  verify->vram.size()) == 0);
+	if (!ok) {
+		vdp.getCliComm().printWarning(
+			"VDP command engine: bulk fast path gives a different "
+			"result for command 0x", hex_string<2>(verify->cmd));
+	}
+}
+
 /** Abort
   */
 void VDPCmdEngine::startAbrt(EmuTime::param time)
@@ -970,6 +1224,27 @@ void VDPCmdEngine::executeLmmv(EmuTime::param limit)
 	byte CL = COL & Mode::COLOR_MASK;
 	bool dstExt = (ARG & MXD) != 0;
 	bool doPset = !dstExt || hasExtendedVRAM;
+
+	if ((phase == 0) && !dstExt &&
+	    (cmdBulkSetting.getEnum() != BULK_OFF) &&
+	    isBulkAreaAccessible<Mode>(DY, TY, tmpNY, true)) {
+		static constexpr Delta inner[] = { DELTA_24 };
+		if (executeBulk(limit, inner, DELTA_72, DELTA_136, tmpNX, tmpNY,
+		                [&](byte* mem, BulkState& st) {
+			for (unsigned n = tmpNY; true; /**/) {
+				unsigned a = Mode::addressOf(st.ADX, st.DY, false);
+				st.tmpDst = mem[a];
+				Mode::pset(mem, st.ADX, a, st.tmpDst, CL, LogOp());
+				st.ADX += TX;
+				if (--st.ANX == 0) {
+					st.DY += TY; --st.NY;
+					st.ADX = DX; st.ANX = tmpNX;
+					if (--n == 0) break;
+				}
+			}
+		})) return;
+	}
+
 	unsigned addr = Mode::addressOf(ADX, DY, dstExt);
 	auto calculator = getSlotCalculator(limit);
 
@@ -1096,6 +1371,29 @@ void VDPCmdEngine::executeLmmm(EmuTime::param limit)
 	bool dstExt  = (ARG & MXD) != 0;
 	bool doPoint = !srcExt || hasExtendedVRAM;
 	bool doPset  = !dstExt || hasExtendedVRAM;
+
+	if ((phase == 0) && !srcExt && !dstExt &&
+	    (cmdBulkSetting.getEnum() != BULK_OFF) &&
+	    isBulkAreaAccessible<Mode>(SY, TY, tmpNY, false) &&
+	    isBulkAreaAccessible<Mode>(DY, TY, tmpNY, true)) {
+		static constexpr Delta inner[] = { DELTA_32, DELTA_24 };
+		if (executeBulk(limit, inner, DELTA_64, DELTA_128, tmpNX, tmpNY,
+		                [&](byte* mem, BulkState& st) {
+			for (unsigned n = tmpNY; true; /**/) {
+				st.tmpSrc = Mode::point(mem, st.ASX, st.SY);
+				unsigned a = Mode::addressOf(st.ADX, st.DY, false);
+				st.tmpDst = mem[a];
+				Mode::pset(mem, st.ADX, a, st.tmpDst, st.tmpSrc, LogOp());
+				st.ASX += TX; st.ADX += TX;
+				if (--st.ANX == 0) {
+					st.SY += TY; st.DY += TY; --st.NY;
+					st.ASX = SX; st.ADX = DX; st.ANX = tmpNX;
+					if (--n == 0) break;
+				}
+			}
+		})) return;
+	}
+
 	unsigned dstAddr = Mode::addressOf(ADX, DY, dstExt);
 	auto calculator = getSlotCalculator(limit);
 
@@ -1348,6 +1646,23 @@ void VDPCmdEngine::executeHmmv(EmuTime::param limit)
 		ADX, ANX << Mode::PIXELS_PER_BYTE_SHIFT, ARG );
 	bool dstExt = (ARG & MXD) != 0;
 	bool doPset = !dstExt || hasExtendedVRAM;
+
+	if (!dstExt && (cmdBulkSetting.getEnum() != BULK_OFF) &&
+	    isBulkAreaAccessible<Mode>(DY, TY, tmpNY, true)) {
+		if (executeBulk(limit, {}, DELTA_48, DELTA_104, tmpNX, tmpNY,
+		                [&](byte* mem, BulkState& st) {
+			for (unsigned n = tmpNY; true; /**/) {
+				mem[Mode::addressOf(st.ADX, st.DY, false)] = COL;
+				st.ADX += TX;
+				if (--st.ANX == 0) {
+					st.DY += TY; --st.NY;
+					st.ADX = DX; st.ANX = tmpNX;
+					if (--n == 0) break;
+				}
+			}
+		})) return;
+	}
+
 	auto calculator = getSlotCalculator(limit);
 
 	while (!calculator.limitReached()) {
@@ -1456,6 +1771,27 @@ void VDPCmdEngine::executeHmmm(EmuTime::param limit)
 	bool dstExt  = (ARG & MXD) != 0;
 	bool doPoint = !srcExt || hasExtendedVRAM;
 	bool doPset  = !dstExt || hasExtendedVRAM;
+
+	if ((phase == 0) && !srcExt && !dstExt &&
+	    (cmdBulkSetting.getEnum() != BULK_OFF) &&
+	    isBulkAreaAccessible<Mode>(SY, TY, tmpNY, false) &&
+	    isBulkAreaAccessible<Mode>(DY, TY, tmpNY, true)) {
+		static constexpr Delta inner[] = { DELTA_24 };
+		if (executeBulk(limit, inner, DELTA_64, DELTA_128, tmpNX, tmpNY,
+		                [&](byte* mem, BulkState& st) {
+			for (unsigned n = tmpNY; true; /**/) {
+				st.tmpSrc = mem[Mode::addressOf(st.ASX, st.SY, false)];
+				mem[Mode::addressOf(st.ADX, st.DY, false)] = st.tmpSrc;
+				st.ASX += TX; st.ADX += TX;
+				if (--st.ANX == 0) {
+					st.SY += TY; st.DY += TY; --st.NY;
+					st.ASX = SX; st.ADX = DX; st.ANX = tmpNX;
+					if (--n == 0) break;
+				}
+			}
+		})) return;
+	}
+
 	auto calculator = getSlotCalculator(limit);
 
 	switch (phase) {
@@ -1590,6 +1926,27 @@ void VDPCmdEngine::executeYmmm(EmuTime::param limit)
 	//  OTOH YMMM also uses DX for both read and write
 	bool dstExt = (ARG & MXD) != 0;
 	bool doPset  = !dstExt || hasExtendedVRAM;
+
+	if ((phase == 0) && !dstExt &&
+	    (cmdBulkSetting.getEnum() != BULK_OFF) &&
+	    isBulkAreaAccessible<Mode>(SY, TY, tmpNY, false) &&
+	    isBulkAreaAccessible<Mode>(DY, TY, tmpNY, true)) {
+		static constexpr Delta inner[] = { DELTA_24 };
+		if (executeBulk(limit, inner, DELTA_40, DELTA_40, tmpNX, tmpNY,
+		                [&](byte* mem, BulkState& st) {
+			for (unsigned n = tmpNY; true; /**/) {
+				st.tmpSrc = mem[Mode::addressOf(st.ADX, st.SY, false)];
+				mem[Mode::addressOf(st.ADX, st.DY, false)] = st.tmpSrc;
+				st.ADX += TX;
+				if (--st.ANX == 0) {
+					st.SY += TY; st.DY += TY; --st.NY;
+					st.ADX = DX; st.ANX = tmpNX;
+					if (--n == 0) break;
+				}
+			}
+		})) return;
+	}
+
 	auto calculator = getSlotCalculator(limit);
 
 	switch (phase) {
@@ -1743,6 +2100,16 @@ VDPCmdEngine::VDPCmdEngine(VDP& vdp_, CommandController& commandController)
 		commandController, vdp_.getName() == "VDP" ? "vdpcmdtrace" :
 		vdp_.getName() + " vdpcmdtrace", "VDP command tracing on/off",
 		false)
+	, cmdBulkSetting(
+		commandController, vdp_.getName() == "VDP" ? "vdpcmdbulk" :
+		vdp_.getName() + " vdpcmdbulk",
+		"Execute VDP block commands at once when no intermediate state "
+		"can be observed (on), always execute them access slot by "
+		"access slot (off) or do both and compare the results (verify, "
+		"for debugging)", BULK_ON,
+		EnumSetting<BulkMode>::Map{
+			{"off", BULK_OFF}, {"on", BULK_ON}, {"verify", BULK_VERIFY}},
+		Setting::DONT_SAVE)
 	, cmdInProgressCallback(
 		commandController, vdp_.getName() == "VDP" ?
 		"vdpcmdinprogress_callback" : vdp_.getName() +
@@ -2557,6 +2924,8 @@ void VDPCmdEngine::sync2(EmuTime::param time)
 	default:
 		UNREACHABLE;
 	}
+
+	if (unlikely(bulkVerify != nullptr)) checkBulkVerify();
 }
 
 void VDPCmdEngine::reportVdpCommand() const
@@ -4,10 +4,14 @@
 #include "VDP.hh"
 #include "VDPAccessSlots.hh"
 #include "BooleanSetting.hh"
+#include "EnumSetting.hh"
 #include "Probe.hh"
 #include "TclCallback.hh"
 #include "serialize_meta.hh"
 #include "openmsx.hh"
+#include "span.hh"
+#include <memory>
+#include <vector>
 
 namespace openmsx {
 
@@ -152,6 +156,39 @@ private:
 	template<typename Mode>                 void executeYmmm(EmuTime::param limit);
 	template<typename Mode>                 void executeHmmc(EmuTime::param limit);
 
+	/** Bulk fast path for the block commands (LMMV, LMMM, HMMV, HMMM and
+	  * YMMM). When the remainder of the command finishes before 'limit'
+	  * and it doesn't write to a VRAM area that's observed by another
+	  * subsystem (renderer, sprite checker), then nobody can observe the
+	  * intermediate states. In that case the whole command is executed at
+	  * once: first the finish time is calculated (without accessing VRAM),
+	  * then the VRAM operation is done in a tight loop. The end result
+	  * (VRAM, registers and engine time) is identical to the result of the
+	  * access slot accurate code path.
+	  */
+	enum BulkMode { BULK_OFF, BULK_ON, BULK_VERIFY };
+	struct BulkState {
+		unsigned SY, DY, NY, ASX, ADX, ANX;
+		byte tmpSrc, tmpDst;
+	};
+	struct BulkVerify {
+		std::vector<byte> vram;
+		BulkState state;
+		EmuTime finish;
+		byte cmd;
+	};
+	[[nodiscard]] bool calcBulkFinishTime(
+		EmuTime::param limit, span<const VDPAccessSlots::Delta> inner,
+		VDPAccessSlots::Delta next, VDPAccessSlots::Delta nextLine,
+		unsigned tmpNX, unsigned tmpNY, EmuTime& finish) const;
+	template<typename Mode> [[nodiscard]] bool isBulkAreaAccessible(
+		unsigned y, int TY, unsigned rows, bool write) const;
+	template<typename Kernel> [[nodiscard]] bool executeBulk(
+		EmuTime::param limit, span<const VDPAccessSlots::Delta> inner,
+		VDPAccessSlots::Delta next, VDPAccessSlots::Delta nextLine,
+		unsigned tmpNX, unsigned tmpNY, Kernel kernel);
+	void checkBulkVerify();
+
 	// Advance to the next access slot at or past the given time.
 	inline void nextAccessSlot(EmuTime::param time) {
 		engineTime = vdp.getAccessSlot(time, VDPAccessSlots::DELTA_0);
@@ -183,6 +220,11 @@ private:
 	/** Only call reportVdpCommand() when this setting is turned on
 	  */
 	BooleanSetting cmdTraceSetting;
+
+	/** Enable/disable/verify the bulk fast path, see executeBulk().
+	  */
+	EnumSetting<BulkMode> cmdBulkSetting;
+	std::unique_ptr<BulkVerify> bulkVerify; // only in BULK_VERIFY mode
 	TclCallback cmdInProgressCallback;
 
 	Probe<bool> executingProbe;
@@ -297,6 +297,17 @@ public:
 		return (address & combiMask) == unsigned(baseAddr);
 	}
 
+	/** Conservative test whether some address in the range [begin, end]
+	  * could be inside this window, while this window has an observer.
+	  * Only false is a definite answer.
+	  */
+	inline bool mayIntersect(unsigned begin, unsigned end) const {
+		if (!isEnabled() || !hasObserver()) return false;
+		unsigned lo = baseAddr;
+		unsigned hi = baseAddr | ~unsigned(combiMask);
+		return (begin <= hi) && (lo <= end);
+	}
+
 	/** Notifies the observer of this window of a VRAM change,
 	  * if the changes address is inside this window.
 	  * @param address The address to test.
@@ -428,6 +439,29 @@ public:
 		writeCommon(address, value, time);
 	}
 
+	/** Used by the bulk fast path of the command engine. Can the VRAM in
+	  * address range [begin, end] be accessed directly via getBulkData()?
+	  * This requires that there's no mirroring in this range and (for
+	  * writes) that no subsystem needs to be notified about changes in
+	  * this range.
+	  */
+	inline bool isBulkAccessible(unsigned begin, unsigned end, bool write) const {
+		assert(begin <= end);
+		if (((end & sizeMask) != end) || (end >= actualSize)) return false;
+		if (!write) return true;
+		return !bitmapVisibleWindow.mayIntersect(begin, end) &&
+		       !spriteAttribTable  .mayIntersect(begin, end) &&
+		       !spritePatternTable .mayIntersect(begin, end);
+	}
+
+	/** Direct access to the VRAM content, only for address ranges for
+	  * which isBulkAccessible() returned true. Changes made via this
+	  * pointer are not seen by any subsystem.
+	  */
+	inline byte* getBulkData() {
+		return &data[0];
+	}
+
 	/** Write a byte to VRAM through the CPU interface.
 	  * @param address The address to write.
 	  * @param value The value to write.
@@ -30,8 +30,10 @@ public:
 
 	/** Create a raw (=non-postprocessed) screenshot. The 'height'
 	 * parameter should be either '240' or '480'. The current image will be
-	 * scaled to '320x240' or '640x480' and written to a png file. */
-	virtual void takeRawScreenShot(
+	 * scaled to '320x240' or '640x480' and written to a png file.
+	 * Returns true iff the file is written asynchronously (see
+	 * ScreenShotWriter). */
+	virtual bool takeRawScreenShot(
 		unsigned height, const std::string& filename) = 0;
 
 	// We used to test whether a Layer is active by looking at the
@@ -0,0 +1,32 @@
+#ifndef VIDEOWRITER_HH
+#define VIDEOWRITER_HH
+
+#include <cstdint>
+
+namespace openmsx {
+
+class FrameSource;
+
+/** Interface for the different output backends of AviRecorder.
+  */
+class VideoWriter
+{
+public:
+	virtual ~VideoWriter() = default;
+
+	/** Add a frame plus the audio that belongs to it (may be empty).
+	  * @throws MSXException when writing a previous frame failed.
+	  */
+	virtual void addFrame(FrameSource* frame, unsigned samples,
+	                      int16_t* sampleData) = 0;
+
+	/** Called when the frame rate is known (after the 2nd frame). */
+	virtual void setFps(float fps) = 0;
+
+protected:
+	VideoWriter() = default;
+};
+
+} // namespace openmsx
+
+#endif
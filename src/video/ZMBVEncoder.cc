@@ -10,6 +10,9 @@
 #include <cstdlib>
 #include <cstring>
 #include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace openmsx {
 
@@ -114,8 +117,10 @@ static void createVectorTable()
 	ranges::sort(vectorTable);
 }
 
-ZMBVEncoder::ZMBVEncoder(unsigned width_, unsigned height_, unsigned bpp)
-	: width(width_)
+ZMBVEncoder::ZMBVEncoder(unsigned width_, unsigned height_, unsigned bpp,
+                         unsigned numThreads)
+	: threadPool(numThreads)
+	, width(width_)
 	, height(height_)
 {
 	setupBuffers(bpp);
@@ -142,6 +147,11 @@ ZMBVEncoder::ZMBVEncoder(unsigned width_, unsigned height_, unsigned bpp)
 	// Level 6 seems a good compromise between size/speed for THIS test.
 }
 
+ZMBVEncoder::~ZMBVEncoder()
+{
+	deflateEnd(&zstream);
+}
+
 void ZMBVEncoder::setupBuffers(unsigned bpp)
 {
 	switch (bpp) {
@@ -163,13 +173,10 @@ void ZMBVEncoder::setupBuffers(unsigned bpp)
 	}
 
 	pitch = width + 2 * MAX_VECTOR;
-	unsigned bufsize = (height + 2 * MAX_VECTOR) * pitch * pixelSize + 2048;
+	bufSize = (height + 2 * MAX_VECTOR) * pitch * pixelSize + 2048;
 
-	oldframe.resize(bufsize);
-	newframe.resize(bufsize);
-	memset(oldframe.data(), 0, bufsize);
-	memset(newframe.data(), 0, bufsize);
-	work.resize(bufsize);
+	oldframe.pixels.resize(bufSize);
+	memset(oldframe.pixels.data(), 0, bufSize);
 	outputSize = neededSize();
 	output.resize(outputSize);
 
@@ -185,6 +192,7 @@ void ZMBVEncoder::setupBuffers(unsigned bpp)
 				(x * BLOCK_WIDTH) + MAX_VECTOR;
 		}
 	}
+	rowWorks.resize(yblocks);
 }
 
 unsigned ZMBVEncoder::neededSize() const
@@ -195,11 +203,11 @@ unsigned ZMBVEncoder::neededSize() const
 }
 
 template<class P>
-unsigned ZMBVEncoder::possibleBlock(int vx, int vy, unsigned offset)
+unsigned ZMBVEncoder::possibleBlock(const P* newFrame, int vx, int vy, unsigned offset)
 {
 	int ret = 0;
-	auto* pold = &(reinterpret_cast<P*>(oldframe.data()))[offset + (vy * pitch) + vx];
-	auto* pnew = &(reinterpret_cast<P*>(newframe.data()))[offset];
+	auto* pold = &(reinterpret_cast<const P*>(oldframe.pixels.data()))[offset + (vy * pitch) + vx];
+	auto* pnew = &newFrame[offset];
 	for (unsigned y = 0; y < BLOCK_HEIGHT; y += 4) {
 		for (unsigned x = 0; x < BLOCK_WIDTH; x += 4) {
 			if (pold[x] != pnew[x]) ++ret;
@@ -211,11 +219,9 @@ unsigned ZMBVEncoder::possibleBlock(int vx, int vy, unsigned offset)
 }
 
 template<class P>
-unsigned ZMBVEncoder::compareBlock(int vx, int vy, unsigned offset)
+unsigned ZMBVEncoder::compareBlockScalar(const P* pold, const P* pnew, unsigned pitch)
 {
-	int ret = 0;
-	auto* pold = &(reinterpret_cast<P*>(oldframe.data()))[offset + (vy * pitch) + vx];
-	auto* pnew = &(reinterpret_cast<P*>(newframe.data()))[offset];
+	unsigned ret = 0;
 	for (unsigned y = 0; y < BLOCK_HEIGHT; ++y) {
 		for (unsigned x = 0; x < BLOCK_WIDTH; ++x) {
 			if (pold[x] != pnew[x]) ++ret;
@@ -226,19 +232,92 @@ unsigned ZMBVEncoder::compareBlock(int vx, int vy, unsigned offset)
 	return ret;
 }
 
+#ifdef __SSE2__
+// Count the equal pixels: for each equal pixel the comparison produces -1 in
+// the corresponding lane, subtracting that increments the per-lane counter.
+// Per lane there are at most 16 * 16 / 4 = 64 increments, so even 16-bit
+// lanes can't overflow.
+static inline unsigned horizontalSum32(__m128i v)
+{
+	v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+	v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(v);
+}
+
+unsigned ZMBVEncoder::compareBlock(const uint32_t* pold, const uint32_t* pnew, unsigned pitch)
+{
+	static_assert(BLOCK_WIDTH == 16);
+	__m128i equal = _mm_setzero_si128();
+	for (unsigned y = 0; y < BLOCK_HEIGHT; ++y) {
+		auto* o = reinterpret_cast<const __m128i*>(pold);
+		auto* n = reinterpret_cast<const __m128i*>(pnew);
+		for (unsigned i = 0; i < 4; ++i) {
+			__m128i e = _mm_cmpeq_epi32(_mm_loadu_si128(o + i),
+			                            _mm_loadu_si128(n + i));
+			equal = _mm_sub_epi32(equal, e);
+		}
+		pold += pitch;
+		pnew += pitch;
+	}
+	return BLOCK_WIDTH * BLOCK_HEIGHT - horizontalSum32(equal);
+}
+
+unsigned ZMBVEncoder::compareBlock(const uint16_t* pold, const uint16_t* pnew, unsigned pitch)
+{
+	static_assert(BLOCK_WIDTH == 16);
+	__m128i equal = _mm_setzero_si128();
+	for (unsigned y = 0; y < BLOCK_HEIGHT; ++y) {
+		auto* o = reinterpret_cast<const __m128i*>(pold);
+		auto* n = reinterpret_cast<const __m128i*>(pnew);
+		for (unsigned i = 0; i < 2; ++i) {
+			__m128i e = _mm_cmpeq_epi16(_mm_loadu_si128(o + i),
+			                            _mm_loadu_si128(n + i));
+			equal = _mm_sub_epi16(equal, e);
+		}
+		pold += pitch;
+		pnew += pitch;
+	}
+	// widen 8x16-bit to 4x32-bit before summing
+	__m128i sum = _mm_madd_epi16(equal, _mm_set1_epi16(1));
+	return BLOCK_WIDTH * BLOCK_HEIGHT - horizontalSum32(sum);
+}
+#else
+unsigned ZMBVEncoder::compareBlock(const uint32_t* pold, const uint32_t* pnew, unsigned pitch)
+{
+	return compareBlockScalar(pold, pnew, pitch);
+}
+
+unsigned ZMBVEncoder::compareBlock(const uint16_t* pold, const uint16_t* pnew, unsigned pitch)
+{
+	return compareBlockScalar(pold, pnew, pitch);
+}
+#endif
+
+template<class P>
+unsigned ZMBVEncoder::compareBlock(const P* newFrame, int vx, int vy, unsigned offset)
+{
+	auto* pold = &(reinterpret_cast<const P*>(oldframe.pixels.data()))[offset + (vy * pitch) + vx];
+	auto* pnew = &newFrame[offset];
+	return compareBlock(pold, pnew, pitch);
+}
+
 template<class P>
 void ZMBVEncoder::addXorBlock(
-	const PixelOperations<P>& pixelOps, int vx, int vy, unsigned offset, unsigned& workUsed)
+	const PixelOperations<P>& pixelOps, const P* newFrame,
+	int vx, int vy, unsigned offset, std::vector<uint8_t>& rowWork)
 {
 	using LE_P = typename Endian::Little<P>::type;
 
-	auto* pold = &(reinterpret_cast<P*>(oldframe.data()))[offset + (vy * pitch) + vx];
-	auto* pnew = &(reinterpret_cast<P*>(newframe.data()))[offset];
+	size_t workUsed = rowWork.size();
+	rowWork.resize(workUsed + BLOCK_WIDTH * BLOCK_HEIGHT * sizeof(P));
+	auto* out = reinterpret_cast<LE_P*>(&rowWork[workUsed]);
+
+	auto* pold = &(reinterpret_cast<const P*>(oldframe.pixels.data()))[offset + (vy * pitch) + vx];
+	auto* pnew = &newFrame[offset];
 	for (unsigned y = 0; y < BLOCK_HEIGHT; ++y) {
 		for (unsigned x = 0; x < BLOCK_WIDTH; ++x) {
 			P pxor = pnew[x] ^ pold[x];
-			writePixel(pixelOps, pxor, *reinterpret_cast<LE_P*>(&work[workUsed]));
-			workUsed += sizeof(P);
+			writePixel(pixelOps, pxor, *out++);
 		}
 		pold += pitch;
 		pnew += pitch;
@@ -246,29 +325,27 @@ void ZMBVEncoder::addXorBlock(
 }
 
 template<class P>
-void ZMBVEncoder::addXorFrame(const PixelFormat& pixelFormat, unsigned& workUsed)
+void ZMBVEncoder::addXorRow(
+	const PixelOperations<P>& pixelOps, const P* newFrame,
+	unsigned row, int8_t* vectors, std::vector<uint8_t>& rowWork)
 {
-	PixelOperations<P> pixelOps(pixelFormat);
-	auto* vectors = reinterpret_cast<int8_t*>(&work[workUsed]);
+	rowWork.clear();
 
 	unsigned xblocks = width / BLOCK_WIDTH;
-	unsigned yblocks = height / BLOCK_HEIGHT;
-	unsigned blockcount = xblocks * yblocks;
-
-	// Align the following xor data on 4 byte boundary
-	workUsed = (workUsed + blockcount * 2 + 3) & ~3;
-
+	// Each row starts searching from the null vector (instead of from the
+	// best vector of the previous row). This makes the result independent
+	// of how the rows are distributed over the threads.
 	int bestvx = 0;
 	int bestvy = 0;
-	for (unsigned b = 0; b < blockcount; ++b) {
+	for (unsigned b = row * xblocks; b < (row + 1) * xblocks; ++b) {
 		unsigned offset = blockOffsets[b];
 		// first try best vector of previous block
-		unsigned bestchange = compareBlock<P>(bestvx, bestvy, offset);
+		unsigned bestchange = compareBlock<P>(newFrame, bestvx, bestvy, offset);
 		if (bestchange >= 4) {
 			int possibles = 64;
 			for (auto& v : vectorTable) {
-				if (possibleBlock<P>(v.x, v.y, offset) < 4) {
-					unsigned testchange = compareBlock<P>(v.x, v.y, offset);
+				if (possibleBlock<P>(newFrame, v.x, v.y, offset) < 4) {
+					unsigned testchange = compareBlock<P>(newFrame, v.x, v.y, offset);
 					if (testchange < bestchange) {
 						bestchange = testchange;
 						bestvx = v.x;
@@ -284,27 +361,52 @@ void ZMBVEncoder::addXorFrame(const PixelFormat& pixelFormat, unsigned& workUsed
 		vectors[b * 2 + 1] = (bestvy << 1);
 		if (bestchange) {
 			vectors[b * 2 + 0] |= 1;
-			addXorBlock<P>(pixelOps, bestvx, bestvy, offset, workUsed);
+			addXorBlock<P>(pixelOps, newFrame, bestvx, bestvy, offset, rowWork);
 		}
 	}
 }
 
 template<class P>
-void ZMBVEncoder::addFullFrame(const PixelFormat& pixelFormat, unsigned& workUsed)
+void ZMBVEncoder::addXorFrame(const Frame& frame, std::vector<uint8_t>& work)
+{
+	PixelOperations<P> pixelOps(frame.pixelFormat);
+	auto* newFrame = reinterpret_cast<const P*>(frame.pixels.data());
+
+	unsigned xblocks = width / BLOCK_WIDTH;
+	unsigned yblocks = height / BLOCK_HEIGHT;
+	unsigned blockcount = xblocks * yblocks;
+
+	// Align the following xor data on 4 byte boundary
+	work.assign((blockcount * 2 + 3) & ~3, 0);
+	auto* vectors = reinterpret_cast<int8_t*>(work.data());
+
+	threadPool.parallelFor(yblocks, [&](unsigned row) {
+		addXorRow<P>(pixelOps, newFrame, row, vectors, rowWorks[row]);
+	});
+
+	// concatenate the xor data of all rows (in order)
+	for (auto& rowWork : rowWorks) {
+		work.insert(end(work), begin(rowWork), end(rowWork));
+	}
+}
+
+template<class P>
+void ZMBVEncoder::addFullFrame(const Frame& frame, std::vector<uint8_t>& work)
 {
 	using LE_P = typename Endian::Little<P>::type;
 
-	PixelOperations<P> pixelOps(pixelFormat);
+	PixelOperations<P> pixelOps(frame.pixelFormat);
+	work.resize(width * height * sizeof(P));
+	auto* pixelsOut = reinterpret_cast<LE_P*>(work.data());
 	auto* readFrame =
-		&newframe[pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch)];
+		&frame.pixels[pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch)];
 	for (unsigned y = 0; y < height; ++y) {
-		auto* pixelsIn  = reinterpret_cast<P*>   (readFrame);
-		auto* pixelsOut = reinterpret_cast<LE_P*>(&work[workUsed]);
+		auto* pixelsIn = reinterpret_cast<const P*>(readFrame);
 		for (unsigned x = 0; x < width; ++x) {
 			writePixel(pixelOps, pixelsIn[x], pixelsOut[x]);
 		}
 		readFrame += pitch * sizeof(P);
-		workUsed += width * sizeof(P);
+		pixelsOut += width;
 	}
 }
 
@@ -344,54 +446,44 @@ const void* ZMBVEncoder::getScaledLine(FrameSource* frame, unsigned y, void* wor
 	return nullptr; // avoid warning
 }
 
-void ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame,
-                                void*& buffer, unsigned& written)
+ZMBVEncoder::Frame ZMBVEncoder::grabFrame(FrameSource* frame) const
 {
-	std::swap(newframe, oldframe); // replace oldframe with newframe
-
-	// Reset the work buffer
-	unsigned workUsed = 0;
-	unsigned writeDone = 1;
-	uint8_t* writeBuf = output.data();
-
-	output[0] = 0; // first byte contains info about this frame
-	if (keyFrame) {
-		output[0] |= FLAG_KEYFRAME;
-		auto* header = reinterpret_cast<KeyframeHeader*>(
-			writeBuf + writeDone);
-		header->high_version = DBZV_VERSION_HIGH;
-		header->low_version = DBZV_VERSION_LOW;
-		header->compression = COMPRESSION_ZLIB;
-		header->format = format;
-		header->blockwidth = BLOCK_WIDTH;
-		header->blockheight = BLOCK_HEIGHT;
-		writeDone += sizeof(KeyframeHeader);
-		deflateReset(&zstream); // restart deflate
-	}
+	Frame result;
+	result.pixels.resize(bufSize);
+	result.pixelFormat = frame->getPixelFormat();
 
 	// copy lines (to add black border)
 	unsigned linePitch = pitch * pixelSize;
 	unsigned lineWidth = width * pixelSize;
-	uint8_t* dest =
-		&newframe[pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch)];
+	unsigned borderWidth = 2 * MAX_VECTOR * pixelSize; // right + next left
+	uint8_t* begin = result.pixels.data();
+	uint8_t* dest = begin + pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch);
+	memset(begin, 0, dest - begin); // top border
 	for (unsigned i = 0; i < height; ++i) {
 		auto* scaled = getScaledLine(frame, i, dest);
 		if (scaled != dest) memcpy(dest, scaled, lineWidth);
+		memset(dest + lineWidth, 0, borderWidth);
 		dest += linePitch;
 	}
+	uint8_t* end = begin + bufSize;
+	memset(dest, 0, end - dest); // bottom border
+	return result;
+}
 
-	// Add the frame data.
+std::vector<uint8_t> ZMBVEncoder::encodeFrame(bool keyFrame, Frame frame)
+{
+	std::vector<uint8_t> work;
 	if (keyFrame) {
 		// Key frame: full frame data.
 		switch (pixelSize) {
 #if HAVE_16BPP
 		case 2:
-			addFullFrame<uint16_t>(frame->getPixelFormat(), workUsed);
+			addFullFrame<uint16_t>(frame, work);
 			break;
 #endif
 #if HAVE_32BPP
 		case 4:
-			addFullFrame<uint32_t>(frame->getPixelFormat(), workUsed);
+			addFullFrame<uint32_t>(frame, work);
 			break;
 #endif
 		default:
@@ -402,21 +494,46 @@ void ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame,
 		switch (pixelSize) {
 #if HAVE_16BPP
 		case 2:
-			addXorFrame<uint16_t>(frame->getPixelFormat(), workUsed);
+			addXorFrame<uint16_t>(frame, work);
 			break;
 #endif
 #if HAVE_32BPP
 		case 4:
-			addXorFrame<uint32_t>(frame->getPixelFormat(), workUsed);
+			addXorFrame<uint32_t>(frame, work);
 			break;
 #endif
 		default:
 			UNREACHABLE;
 		}
 	}
+	oldframe = std::move(frame); // reference for the next frame
+	return work;
+}
+
+void ZMBVEncoder::compressFrame(bool keyFrame, const std::vector<uint8_t>& work,
+                                void*& buffer, unsigned& written)
+{
+	unsigned writeDone = 1;
+	uint8_t* writeBuf = output.data();
+
+	output[0] = 0; // first byte contains info about this frame
+	if (keyFrame) {
+		output[0] |= FLAG_KEYFRAME;
+		auto* header = reinterpret_cast<KeyframeHeader*>(
+			writeBuf + writeDone);
+		header->high_version = DBZV_VERSION_HIGH;
+		header->low_version = DBZV_VERSION_LOW;
+		header->compression = COMPRESSION_ZLIB;
+		header->format = format;
+		header->blockwidth = BLOCK_WIDTH;
+		header->blockheight = BLOCK_HEIGHT;
+		writeDone += sizeof(KeyframeHeader);
+		deflateReset(&zstream); // restart deflate
+	}
+
 	// Compress the frame data with zlib.
-	zstream.next_in = work.data();
-	zstream.avail_in = workUsed;
+	zstream.next_in = const_cast<Bytef*>(work.data());
+	zstream.avail_in = unsigned(work.size());
 	zstream.total_in = 0;
 
 	zstream.next_out = static_cast<Bytef*>(writeBuf + writeDone);
@@ -429,4 +546,15 @@ void ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame,
 	written = writeDone + zstream.total_out;
 }
 
+void ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame,
+                                void*& buffer, unsigned& written)
+{
+	compressFrame(keyFrame, encodeFrame(keyFrame, grabFrame(frame)),
+	              buffer, written);
+}
+
+// Explicit instantiations (also used by the unittests).
+template unsigned ZMBVEncoder::compareBlockScalar<uint16_t>(const uint16_t*, const uint16_t*, unsigned);
+template unsigned ZMBVEncoder::compareBlockScalar<uint32_t>(const uint32_t*, const uint32_t*, unsigned);
+
 } // namespace openmsx
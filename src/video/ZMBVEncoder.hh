@@ -5,7 +5,9 @@
 
 #include "PixelFormat.hh"
 #include "MemBuffer.hh"
+#include "ThreadPool.hh"
 #include <cstdint>
+#include <vector>
 #include <zlib.h>
 
 namespace openmsx {
@@ -13,16 +15,55 @@ namespace openmsx {
 class FrameSource;
 template<class P> class PixelOperations;
 
+/** Encodes frames in the ZMBV (DOSBox capture) format.
+  *
+  * Encoding happens in three steps, which allows to pipeline the work over
+  * multiple threads:
+  *  - grabFrame(): copy the (scaled) frame. This is the only step that needs
+  *    the FrameSource, so it must run on the thread that renders the
+  *    frames. It's cheap compared to the next two steps.
+  *  - encodeFrame(): motion search and xor with the previous frame. The
+  *    motion search is split over the rows of blocks, and those are
+  *    processed in parallel.
+  *  - compressFrame(): zlib-compress the result of encodeFrame().
+  * encodeFrame() and compressFrame() must each be called in frame order,
+  * but compressFrame() for frame N can run concurrently with encodeFrame()
+  * for frame N+1.
+  */
 class ZMBVEncoder
 {
 public:
 	static constexpr const char CODEC_4CC[5] = "ZMBV"; // 4 + zero-terminator
 
-	ZMBVEncoder(unsigned width, unsigned height, unsigned bpp);
+	struct Frame {
+		MemBuffer<uint8_t, SSE2_ALIGNMENT> pixels; // including border
+		PixelFormat pixelFormat;
+	};
+
+	/** @param numThreads Number of extra threads used by the motion search.
+	  *     The output does not depend on this number. */
+	ZMBVEncoder(unsigned width, unsigned height, unsigned bpp,
+	            unsigned numThreads);
+	~ZMBVEncoder();
 
+	[[nodiscard]] Frame grabFrame(FrameSource* frame) const;
+	[[nodiscard]] std::vector<uint8_t> encodeFrame(bool keyFrame, Frame frame);
+	void compressFrame(bool keyFrame, const std::vector<uint8_t>& work,
+	                   void*& buffer, unsigned& written);
+
+	/** Execute all three steps above, on the calling thread. */
 	void compressFrame(bool keyFrame, FrameSource* frame,
 	                   void*& buffer, unsigned& written);
 
+	/** Number of pixels that differ between the given 16x16 blocks.
+	  * Exposed for testing/benchmarking of the SIMD implementation. */
+	static unsigned compareBlock(
+		const uint16_t* pold, const uint16_t* pnew, unsigned pitch);
+	static unsigned compareBlock(
+		const uint32_t* pold, const uint32_t* pnew, unsigned pitch);
+	template<class P> static unsigned compareBlockScalar(
+		const P* pold, const P* pnew, unsigned pitch);
+
 private:
 	enum Format {
 		ZMBV_FORMAT_16BPP = 6,
@@ -31,23 +72,27 @@ private:
 
 	void setupBuffers(unsigned bpp);
 	unsigned neededSize() const;
-	template<class P> void addFullFrame(const PixelFormat& pixelFormat, unsigned& workUsed);
-	template<class P> void addXorFrame (const PixelFormat& pixelFormat, unsigned& workUsed);
-	template<class P> unsigned possibleBlock(int vx, int vy, unsigned offset);
-	template<class P> unsigned compareBlock(int vx, int vy, unsigned offset);
+	template<class P> void addFullFrame(const Frame& frame, std::vector<uint8_t>& work);
+	template<class P> void addXorFrame (const Frame& frame, std::vector<uint8_t>& work);
+	template<class P> void addXorRow(
+		const PixelOperations<P>& pixelOps, const P* newFrame,
+		unsigned row, int8_t* vectors, std::vector<uint8_t>& rowWork);
+	template<class P> unsigned possibleBlock(const P* newFrame, int vx, int vy, unsigned offset);
+	template<class P> unsigned compareBlock(const P* newFrame, int vx, int vy, unsigned offset);
 	template<class P> void addXorBlock(
-		const PixelOperations<P>& pixelOps, int vx, int vy,
-		unsigned offset, unsigned& workUsed);
+		const PixelOperations<P>& pixelOps, const P* newFrame,
+		int vx, int vy, unsigned offset, std::vector<uint8_t>& rowWork);
 	const void* getScaledLine(FrameSource* frame, unsigned y, void* workBuf) const;
 
-	MemBuffer<uint8_t, SSE2_ALIGNMENT> oldframe;
-	MemBuffer<uint8_t, SSE2_ALIGNMENT> newframe;
-	MemBuffer<uint8_t, SSE2_ALIGNMENT> work;
-	MemBuffer<uint8_t> output;
+	Frame oldframe; // only accessed from encodeFrame()
+	std::vector<std::vector<uint8_t>> rowWorks; // one per row of blocks
+	MemBuffer<uint8_t> output; // only accessed from compressFrame()
 	MemBuffer<unsigned> blockOffsets;
 	unsigned outputSize;
+	unsigned bufSize;
 
 	z_stream zstream;
+	ThreadPool threadPool;
 
 	const unsigned width;
 	const unsigned height;
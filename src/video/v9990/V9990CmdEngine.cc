@@ -11,8 +11,10 @@
 #include "serialize.hh"
 #include "likely.hh"
 #include "unreachable.hh"
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <type_traits>
 
 namespace openmsx {
 
@@ -682,6 +684,48 @@ inline void V9990CmdEngine::V9990Bpp16::psetColor(
 	vram.writeVRAMDirect(addr + 0x40000, result >> 8);
 }
 
+// Bulk execution ------------------------------------------------------
+unsigned V9990CmdEngine::getNumSteps(
+	EmuDuration::param delta, EmuTime::param limit, unsigned max) const
+{
+	if (engineTime >= limit) return 0;
+	if (delta == EmuDuration::zero()) return max; // broken timing
+	uint64_t n = ((limit - engineTime).length() + delta.length() - 1) /
+	             delta.length();
+	return unsigned(std::min<uint64_t>(n, max));
+}
+
+template<typename Mode>
+bool V9990CmdEngine::getRowRange(
+	unsigned x, unsigned y, unsigned pitch, unsigned nx, int dx,
+	unsigned& addr, unsigned& num)
+{
+	if constexpr (std::is_same_v<Mode, V9990P1> ||
+	              std::is_same_v<Mode, V9990P2>) {
+		// The P1/P2 layouts interleave pixels over the two VRAM banks,
+		// P1/P2 commands always use the per-pixel path.
+		return false;
+	} else {
+		return V9990CmdKernels::getRowRange(
+			Mode::BITS_PER_PIXEL, x, y, pitch, nx, dx, addr, num);
+	}
+}
+
+void V9990CmdEngine::bulkFill(unsigned dst, unsigned num, word color,
+                              const byte* lut, V9990CmdKernels::LogOp op)
+{
+	V9990CmdKernels::fillBx(vram.getWriteBackdoor(), dst, num, color, WM,
+	                        lut, op);
+}
+
+void V9990CmdEngine::bulkCopy(unsigned src, unsigned dst, unsigned num,
+                              word mask, const byte* lut,
+                              V9990CmdKernels::LogOp op)
+{
+	V9990CmdKernels::copyBx(vram.getWriteBackdoor(), src, dst, num, mask,
+	                        lut, op);
+}
+
 // ====================================================================
 /** Constructor
   */
@@ -790,13 +834,13 @@ void V9990CmdEngine::setCmdReg(byte reg, byte value, EmuTime::param time)
 		break;
 	case 20: { // CMD
 		CMD = value;
-		if (cmdTraceSetting->getBoolean()) {
-			reportV9990Command();
-		}
 		status |= CE;
 
 		// TODO do this when mode changes instead of at the start of a command.
 		setCommandMode();
+		if (cmdTraceSetting->getBoolean()) {
+			reportV9990Command();
+		}
 
 		//currentCommand->start(time);
 		switch (cmdMode | (CMD >> 4)) {
@@ -915,6 +959,9 @@ void V9990CmdEngine::reportV9990Command() const
 		"BMXL", "BMLX", "BMLL", "LINE",
 		"SRCH", "POINT","PSET", "ADVN"
 	};
+	const char* const MODES[6] = {
+		"P1", "P2", "BPP2", "BPP4", "BPP8", "BPP16"
+	};
 	std::cerr << "V9990Cmd " << COMMANDS[CMD >> 4]
 	          << " SX="  << std::dec << SX
 	          << " SY="  << std::dec << SY
@@ -928,6 +975,8 @@ void V9990CmdEngine::reportV9990Command() const
 	          << " FC="  << std::hex << fgCol
 	          << " BC="  << std::hex << bgCol
 	          << " CMD=" << std::hex << int(CMD)
+	          << " MODE=" << MODES[cmdMode >> 4]
+	          << " WIDTH=" << std::dec << vdp.getImageWidth()
 	          << '\n';
 }
 
@@ -1028,15 +1077,35 @@ void V9990CmdEngine::startLMMV(EmuTime::param time)
 template<typename Mode>
 void V9990CmdEngine::executeLMMV(EmuTime::param limit)
 {
-	// TODO can be optimized a lot
-
 	auto delta = getTiming(*this, LMMV_TIMING);
 	unsigned pitch = Mode::getPitch(vdp.getImageWidth());
 	int dx = (ARG & DIX) ? -1 : 1;
 	int dy = (ARG & DIY) ? -1 : 1;
 	const byte* lut = Mode::getLogOpLUT(LOG);
-	while (engineTime < limit) {
-		engineTime += delta;
+	// 16bpp transparency can't be done per byte
+	bool bulk = (Mode::BITS_PER_PIXEL != 16) || !(LOG & 0x10);
+	auto op = V9990CmdKernels::classify(LOG, Mode::BITS_PER_PIXEL == 8);
+	unsigned nx = getWrappedNX();
+	unsigned steps = getNumSteps(delta, limit, ANX + (ANY - 1) * nx);
+	engineTime += delta * steps;
+	while (steps) {
+		unsigned addr, num;
+		if (bulk && (ANX == nx) && (steps >= nx) &&
+		    getRowRange<Mode>(DX, DY, pitch, nx, dx, addr, num)) {
+			// whole row at once
+			bulkFill(addr, num, fgCol, lut, op);
+			steps -= nx;
+			DX += (nx - NX) * dx;
+			DY += dy;
+			if (!--(ANY)) {
+				ANX = 0;
+				cmdReady(engineTime);
+				return;
+			}
+			continue;
+		}
+
+		--steps;
 		Mode::psetColor(vram, DX, DY, pitch, fgCol, WM, lut, LOG);
 
 		DX += dx;
@@ -1047,7 +1116,7 @@ void V9990CmdEngine::executeLMMV(EmuTime::param limit)
 				cmdReady(engineTime);
 				return;
 			} else {
-				ANX = getWrappedNX();
+				ANX = nx;
 			}
 		}
 	}
@@ -1120,18 +1189,41 @@ void V9990CmdEngine::startLMMM(EmuTime::param time)
 template<typename Mode>
 void V9990CmdEngine::executeLMMM(EmuTime::param limit)
 {
-	// TODO can be optimized a lot
-
 	auto delta = getTiming(*this, LMMM_TIMING);
 	unsigned pitch = Mode::getPitch(vdp.getImageWidth());
 	int dx = (ARG & DIX) ? -1 : 1;
 	int dy = (ARG & DIY) ? -1 : 1;
 	const byte* lut = Mode::getLogOpLUT(LOG);
-	while (engineTime < limit) {
-		engineTime += delta;
-		auto src = Mode::point(vram, SX, SY, pitch);
-		src = Mode::shift(src, SX, DX);
-		Mode::pset(vram, DX, DY, pitch, src, WM, lut, LOG);
+	bool bulk = (Mode::BITS_PER_PIXEL != 16) || !(LOG & 0x10);
+	auto op = V9990CmdKernels::classify(LOG, Mode::BITS_PER_PIXEL == 8);
+	unsigned nx = getWrappedNX();
+	unsigned steps = getNumSteps(delta, limit, ANX + (ANY - 1) * nx);
+	engineTime += delta * steps;
+	while (steps) {
+		unsigned src, dst, num;
+		if (bulk && (ANX == nx) && (steps >= nx) &&
+		    getRowRange<Mode>(SX, SY, pitch, nx, dx, src, num) &&
+		    getRowRange<Mode>(DX, DY, pitch, nx, dx, dst, num) &&
+		    V9990CmdKernels::canCopyBx(src, dst, num, dx > 0)) {
+			// whole row at once
+			bulkCopy(src, dst, num, WM, lut, op);
+			steps -= nx;
+			DX += (nx - NX) * dx;
+			SX += (nx - NX) * dx;
+			DY += dy;
+			SY += dy;
+			if (!--(ANY)) {
+				ANX = 0;
+				cmdReady(engineTime);
+				return;
+			}
+			continue;
+		}
+
+		--steps;
+		auto srcColor = Mode::point(vram, SX, SY, pitch);
+		srcColor = Mode::shift(srcColor, SX, DX);
+		Mode::pset(vram, DX, DY, pitch, srcColor, WM, lut, LOG);
 
 		DX += dx;
 		SX += dx;
@@ -1144,7 +1236,7 @@ void V9990CmdEngine::executeLMMM(EmuTime::param limit)
 				cmdReady(engineTime);
 				return;
 			} else {
-				ANX = getWrappedNX();
+				ANX = nx;
 			}
 		}
 	}
@@ -1267,13 +1359,36 @@ void V9990CmdEngine::executeBMXL<V9990CmdEngine::V9990Bpp16>(EmuTime::param limi
 	int dx = (ARG & DIX) ? -1 : 1;
 	int dy = (ARG & DIY) ? -1 : 1;
 	const byte* lut = V9990Bpp16::getLogOpLUT(LOG);
+	bool bulk = (dx > 0) && !(LOG & 0x10);
+	auto op = V9990CmdKernels::classify(LOG, false);
+	unsigned nx = getWrappedNX();
+	unsigned steps = getNumSteps(delta, limit, ANX + (ANY - 1) * nx);
+	engineTime += delta * steps;
+	while (steps) {
+		unsigned src = srcAddress & 0x7FFFF;
+		unsigned dst, num;
+		if (bulk && (ANX == nx) && (steps >= nx) &&
+		    getRowRange<V9990Bpp16>(DX, DY, pitch, nx, dx, dst, num) &&
+		    ((src + num) <= 0x80000) && V9990CmdKernels::canCopyBx(src, dst, num, true)) {
+			// whole row at once
+			bulkCopy(src, dst, num, WM, lut, op);
+			srcAddress += num;
+			steps -= nx;
+			DX += (nx - NX) * dx;
+			DY += dy;
+			if (!--(ANY)) {
+				ANX = 0;
+				cmdReady(engineTime);
+				return;
+			}
+			continue;
+		}
 
-	while (engineTime < limit) {
-		engineTime += delta;
-		word src = vram.readVRAMBx(srcAddress + 0) +
-		           vram.readVRAMBx(srcAddress + 1) * 256;
+		--steps;
+		word srcColor = vram.readVRAMBx(srcAddress + 0) +
+		                vram.readVRAMBx(srcAddress + 1) * 256;
 		srcAddress += 2;
-		V9990Bpp16::pset(vram, DX, DY, pitch, src, WM, lut, LOG);
+		V9990Bpp16::pset(vram, DX, DY, pitch, srcColor, WM, lut, LOG);
 		DX += dx;
 		if (!--(ANX)) {
 			DX -= (NX * dx);
@@ -1282,7 +1397,7 @@ void V9990CmdEngine::executeBMXL<V9990CmdEngine::V9990Bpp16>(EmuTime::param limi
 				cmdReady(engineTime);
 				return;
 			} else {
-				ANX = getWrappedNX();
+				ANX = nx;
 			}
 		}
 	}
@@ -1296,9 +1411,34 @@ void V9990CmdEngine::executeBMXL(EmuTime::param limit)
 	int dx = (ARG & DIX) ? -1 : 1;
 	int dy = (ARG & DIY) ? -1 : 1;
 	const byte* lut = Mode::getLogOpLUT(LOG);
+	auto op = V9990CmdKernels::classify(LOG, Mode::BITS_PER_PIXEL == 8);
+	unsigned nx = getWrappedNX();
+	// one byte (possibly spanning two rows) per iteration
+	unsigned steps = getNumSteps(delta, limit,
+		(ANX + (ANY - 1) * nx + Mode::PIXELS_PER_BYTE - 1) / Mode::PIXELS_PER_BYTE);
+	engineTime += delta * steps;
+	while (steps) {
+		unsigned src = srcAddress & 0x7FFFF;
+		unsigned dst, num;
+		if ((dx > 0) && (ANX == nx) &&
+		    getRowRange<Mode>(DX, DY, pitch, nx, dx, dst, num) &&
+		    (steps >= num) && ((src + num) <= 0x80000) &&
+		    V9990CmdKernels::canCopyBx(src, dst, num, true)) {
+			// whole row at once
+			bulkCopy(src, dst, num, WM, lut, op);
+			srcAddress += num;
+			steps -= num;
+			DX += (nx - NX) * dx;
+			DY += dy;
+			if (!--(ANY)) {
+				ANX = 0;
+				cmdReady(engineTime);
+				return;
+			}
+			continue;
+		}
 
-	while (engineTime < limit) {
-		engineTime += delta;
+		--steps;
 		byte d = vram.readVRAMBx(srcAddress++);
 		for (int i = 0; (ANY > 0) && (i < Mode::PIXELS_PER_BYTE); ++i) {
 			Mode::pset(vram, DX, DY, pitch, d, WM, lut, LOG);
@@ -1310,7 +1450,7 @@ void V9990CmdEngine::executeBMXL(EmuTime::param limit)
 					cmdReady(engineTime);
 					return;
 				} else {
-					ANX = getWrappedNX();
+					ANX = nx;
 				}
 			}
 		}
@@ -1334,12 +1474,33 @@ void V9990CmdEngine::executeBMLX<V9990CmdEngine::V9990Bpp16>(EmuTime::param limi
 	unsigned pitch = V9990Bpp16::getPitch(vdp.getImageWidth());
 	int dx = (ARG & DIX) ? -1 : 1;
 	int dy = (ARG & DIY) ? -1 : 1;
+	unsigned nx = getWrappedNX();
+	unsigned steps = getNumSteps(delta, limit, ANX + (ANY - 1) * nx);
+	engineTime += delta * steps;
+	while (steps) {
+		unsigned dst = dstAddress & 0x7FFFF;
+		unsigned src, num;
+		if ((dx > 0) && (ANX == nx) && (steps >= nx) &&
+		    getRowRange<V9990Bpp16>(SX, SY, pitch, nx, dx, src, num) &&
+		    ((dst + num) <= 0x80000) && V9990CmdKernels::canCopyBx(src, dst, num, true)) {
+			// whole row at once
+			bulkCopy(src, dst, num, 0xFFFF, nullptr, V9990CmdKernels::LogOp::IMP);
+			dstAddress += num;
+			steps -= nx;
+			SX += (nx - NX) * dx;
+			SY += dy;
+			if (!--(ANY)) {
+				ANX = 0;
+				cmdReady(engineTime);
+				return;
+			}
+			continue;
+		}
 
-	while (engineTime < limit) {
-		engineTime += delta;
-		auto src = V9990Bpp16::point(vram, SX, SY, pitch);
-		vram.writeVRAMBx(dstAddress++, src & 0xFF);
-		vram.writeVRAMBx(dstAddress++, src >> 8);
+		--steps;
+		auto srcColor = V9990Bpp16::point(vram, SX, SY, pitch);
+		vram.writeVRAMBx(dstAddress++, srcColor & 0xFF);
+		vram.writeVRAMBx(dstAddress++, srcColor >> 8);
 		SX += dx;
 		if (!--(ANX)) {
 			SX -= (NX * dx);
@@ -1348,7 +1509,7 @@ void V9990CmdEngine::executeBMLX<V9990CmdEngine::V9990Bpp16>(EmuTime::param limi
 				cmdReady(engineTime);
 				return;
 			} else {
-				ANX = getWrappedNX();
+				ANX = nx;
 			}
 		}
 	}
@@ -1361,13 +1522,37 @@ void V9990CmdEngine::executeBMLX(EmuTime::param limit)
 	unsigned pitch = Mode::getPitch(vdp.getImageWidth());
 	int dx = (ARG & DIX) ? -1 : 1;
 	int dy = (ARG & DIY) ? -1 : 1;
+	unsigned nx = getWrappedNX();
+	// one byte (possibly spanning two rows) per iteration
+	unsigned steps = getNumSteps(delta, limit,
+		(ANX + (ANY - 1) * nx + Mode::PIXELS_PER_BYTE - 1) / Mode::PIXELS_PER_BYTE);
+	engineTime += delta * steps;
+	while (steps) {
+		unsigned dst = dstAddress & 0x7FFFF;
+		unsigned src, num;
+		if ((dx > 0) && (ANX == nx) &&
+		    getRowRange<Mode>(SX, SY, pitch, nx, dx, src, num) &&
+		    (steps >= num) && ((dst + num) <= 0x80000) &&
+		    V9990CmdKernels::canCopyBx(src, dst, num, true)) {
+			// whole row at once
+			bulkCopy(src, dst, num, 0xFFFF, nullptr, V9990CmdKernels::LogOp::IMP);
+			dstAddress += num;
+			steps -= num;
+			SX += (nx - NX) * dx;
+			SY += dy;
+			if (!--(ANY)) {
+				ANX = 0;
+				cmdReady(engineTime);
+				return;
+			}
+			continue;
+		}
 
-	while (engineTime < limit) {
-		engineTime += delta;
+		--steps;
 		byte d = 0;
 		for (int i = 0; i < Mode::PIXELS_PER_BYTE; ++i) {
-			auto src = Mode::point(vram, SX, SY, pitch);
-			d |= Mode::shift(src, SX, i) & Mode::shiftMask(i);
+			auto src2 = Mode::point(vram, SX, SY, pitch);
+			d |= Mode::shift(src2, SX, i) & Mode::shiftMask(i);
 			SX += dx;
 			if (!--(ANX)) {
 				SX -= (NX * dx);
@@ -1377,7 +1562,7 @@ void V9990CmdEngine::executeBMLX(EmuTime::param limit)
 					cmdReady(engineTime);
 					return;
 				} else {
-					ANX = getWrappedNX();
+					ANX = nx;
 				}
 			}
 		}
@@ -1414,8 +1599,28 @@ void V9990CmdEngine::executeBMLL<V9990CmdEngine::V9990Bpp16>(EmuTime::param limi
 	auto delta = getTiming(*this, BMLL_TIMING) * 2;
 	const byte* lut = V9990Bpp16::getLogOpLUT(LOG);
 	bool transp = (LOG & 0x10) != 0;
-	while (engineTime < limit) {
-		engineTime += delta;
+	auto op = V9990CmdKernels::classify(LOG, false);
+	unsigned steps = getNumSteps(delta, limit, nbBytes);
+	engineTime += delta * steps;
+	while (steps) {
+		if (!transp) {
+			// as many words as possible without wrapping, as Bx
+			// addresses these never overlap in a harmful way
+			unsigned num = std::min({steps, 0x40000 - srcAddress,
+			                                0x40000 - dstAddress});
+			bulkCopy(2 * srcAddress, 2 * dstAddress, 2 * num, WM, lut, op);
+			srcAddress = (srcAddress + num) & 0x3FFFF;
+			dstAddress = (dstAddress + num) & 0x3FFFF;
+			steps -= num;
+			nbBytes -= num;
+			if (!nbBytes) {
+				cmdReady(engineTime);
+				return;
+			}
+			continue;
+		}
+
+		--steps;
 		// VRAM always mapped as in Bx modes
 		word srcColor = vram.readVRAMDirect(srcAddress + 0x00000) +
 		                vram.readVRAMDirect(srcAddress + 0x40000) * 256;
@@ -1440,8 +1645,27 @@ void V9990CmdEngine::executeBMLL(EmuTime::param limit)
 	// TODO DIX DIY?
 	auto delta = getTiming(*this, BMLL_TIMING);
 	const byte* lut = Mode::getLogOpLUT(LOG);
-	while (engineTime < limit) {
-		engineTime += delta;
+	auto op = V9990CmdKernels::classify(LOG, Mode::BITS_PER_PIXEL == 8);
+	unsigned steps = getNumSteps(delta, limit, nbBytes);
+	engineTime += delta * steps;
+	while (steps) {
+		// as many bytes as possible without wrapping
+		unsigned num = std::min({steps, 0x80000 - srcAddress,
+		                                0x80000 - dstAddress});
+		if (V9990CmdKernels::canCopyBx(srcAddress, dstAddress, num, true)) {
+			bulkCopy(srcAddress, dstAddress, num, WM, lut, op);
+			srcAddress = (srcAddress + num) & 0x7FFFF;
+			dstAddress = (dstAddress + num) & 0x7FFFF;
+			steps -= num;
+			nbBytes -= num;
+			if (!nbBytes) {
+				cmdReady(engineTime);
+				return;
+			}
+			continue;
+		}
+
+		--steps;
 		// VRAM always mapped as in Bx modes
 		byte srcColor = vram.readVRAMBx(srcAddress);
 		unsigned addr = V9990VRAM::transformBx(dstAddress);
@@ -1,6 +1,7 @@
 #ifndef V9990CMDENGINE_HH
 #define V9990CMDENGINE_HH
 
+#include "V9990CmdKernels.hh"
 #include "Observer.hh"
 #include "EmuDuration.hh"
 #include "EmuTime.hh"
@@ -330,6 +331,29 @@ private:
 
 	void setCommandMode();
 
+	/** Number of iterations of the 'while (engineTime < limit) {
+	  * engineTime += delta; ... }' loop of a command, but at most 'max'.
+	  * Knowing this upfront allows to execute those iterations (possibly
+	  * a whole row at once) without checking the time in between.
+	  */
+	unsigned getNumSteps(EmuDuration::param delta, EmuTime::param limit,
+	                     unsigned max) const;
+
+	/** See V9990CmdKernels::getRowRange(), this fails for P1/P2 modes.
+	  */
+	template<typename Mode>
+	static bool getRowRange(unsigned x, unsigned y, unsigned pitch,
+	                        unsigned nx, int dx, unsigned& addr, unsigned& num);
+
+	/** Execute a fill or copy of a range of Bx addresses with the bulk
+	  * kernels. For bulkCopy() the caller must check
+	  * V9990CmdKernels::canCopyBx().
+	  */
+	void bulkFill(unsigned dst, unsigned num, word color,
+	              const byte* lut, V9990CmdKernels::LogOp op);
+	void bulkCopy(unsigned src, unsigned dst, unsigned num, word mask,
+	              const byte* lut, V9990CmdKernels::LogOp op);
+
 	inline unsigned getWrappedNX() const {
 		return NX ? NX : 2048;
 	}
@@ -0,0 +1,189 @@
+#include "V9990CmdKernels.hh"
+#include "V9990VRAM.hh"
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace openmsx::V9990CmdKernels {
+
+LogOp classify(byte log, bool bpp8)
+{
+	if ((log & 0x0F) != 0x0C) return LogOp::GENERIC;
+	if (!(log & 0x10)) return LogOp::IMP;
+	return bpp8 ? LogOp::TIMP : LogOp::GENERIC;
+}
+
+static inline byte combine(byte d, byte n, byte mask)
+{
+	return d ^ ((d ^ n) & mask);
+}
+
+void fill(byte* dst, size_t num, byte color, byte mask,
+          const byte* lut, LogOp op)
+{
+	switch (op) {
+	case LogOp::TIMP:
+		if (color == 0) return; // transparent, nothing changes
+		[[fallthrough]];
+	case LogOp::IMP:
+		if (mask == 0xFF) {
+			memset(dst, color, num);
+		} else {
+			for (size_t i = 0; i < num; ++i) {
+				dst[i] = combine(dst[i], color, mask);
+			}
+		}
+		break;
+	case LogOp::GENERIC:
+		lut += color;
+		for (size_t i = 0; i < num; ++i) {
+			byte d = dst[i];
+			dst[i] = combine(d, lut[256 * d], mask);
+		}
+		break;
+	}
+}
+
+// Scalar reference, also handles any overlap between source and destination.
+static void copyScalar(byte* dst, const byte* src, size_t num, byte mask,
+                       const byte* lut, LogOp op)
+{
+	switch (op) {
+	case LogOp::IMP:
+		for (size_t i = 0; i < num; ++i) {
+			dst[i] = combine(dst[i], src[i], mask);
+		}
+		break;
+	case LogOp::TIMP:
+		for (size_t i = 0; i < num; ++i) {
+			byte s = src[i];
+			if (s) dst[i] = combine(dst[i], s, mask);
+		}
+		break;
+	case LogOp::GENERIC:
+		for (size_t i = 0; i < num; ++i) {
+			byte d = dst[i];
+			dst[i] = combine(d, lut[256 * d + src[i]], mask);
+		}
+		break;
+	}
+}
+
+#ifdef __SSE2__
+// Processes 16 bytes at a time, only valid when each block of source bytes
+// is read before (or doesn't overlap with) the destination bytes that a
+// byte-per-byte loop would already have written.
+static size_t copySSE2(byte* dst, const byte* src, size_t num, byte mask,
+                       LogOp op)
+{
+	__m128i m = _mm_set1_epi8(char(mask));
+	__m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+	for (/**/; (i + 16) <= num; i += 16) {
+		__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+		if (op == LogOp::TIMP) {
+			// only change the destination where the source is not zero
+			__m128i t = _mm_cmpeq_epi8(s, zero);
+			s = _mm_or_si128(_mm_and_si128(t, d), _mm_andnot_si128(t, s));
+		}
+		__m128i r = _mm_xor_si128(d, _mm_and_si128(_mm_xor_si128(d, s), m));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), r);
+	}
+	return i;
+}
+#endif
+
+void copy(byte* dst, const byte* src, size_t num, byte mask,
+          const byte* lut, LogOp op)
+{
+	// When the destination starts inside the source, a byte-per-byte copy
+	// reads back bytes it has written itself.
+	bool repeats = (src < dst) && (dst < (src + num));
+	if (!repeats && (op == LogOp::IMP) && (mask == 0xFF)) {
+		memmove(dst, src, num);
+		return;
+	}
+#ifdef __SSE2__
+	if ((op != LogOp::GENERIC) && (!repeats || ((dst - src) >= 16))) {
+		size_t done = copySSE2(dst, src, num, mask, op);
+		dst += done;
+		src += done;
+		num -= done;
+	}
+#endif
+	copyScalar(dst, src, num, mask, lut, op);
+}
+
+bool getRowRange(unsigned bitsPerPixel, unsigned x, unsigned y,
+                 unsigned pitch, unsigned nx, int dx,
+                 unsigned& addr, unsigned& num)
+{
+	if (dx < 0) {
+		// continue with the leftmost pixel
+		if ((x + 1) < nx) return false;
+		x -= nx - 1;
+	}
+	if (bitsPerPixel == 16) {
+		// low byte in the first, high byte in the second bank,
+		// that's the same as Bx address '2 * addressOf()'
+		unsigned col = x & (pitch - 1);
+		if ((col + nx) > pitch) return false;
+		unsigned a = (col + y * pitch) & 0x3FFFF;
+		if ((a + nx) > 0x40000) return false;
+		addr = 2 * a;
+		num  = 2 * nx;
+	} else {
+		unsigned ppb = 8 / bitsPerPixel;
+		if ((x % ppb) || (nx % ppb)) return false;
+		unsigned n = nx / ppb;
+		unsigned col = (x / ppb) & (pitch - 1);
+		if ((col + n) > pitch) return false;
+		unsigned a = (col + y * pitch) & 0x7FFFF;
+		if ((a + n) > 0x80000) return false;
+		addr = a;
+		num  = n;
+	}
+	return true;
+}
+
+// Each part is handled by a single call to a kernel. The even and odd Bx
+// addresses in the range also have a different write mask (and color for
+// fills).
+void fillBx(byte* vram, unsigned dst, unsigned num, word color, word mask,
+            const byte* lut, LogOp op)
+{
+	for (unsigned i = 0; i < 2; ++i) {
+		unsigned d = V9990VRAM::transformBx(dst + i);
+		bool high = (d & 0x40000) != 0;
+		fill(&vram[d], (num + 1 - i) / 2,
+		     high ? (color >> 8) : (color & 0xFF),
+		     high ? (mask  >> 8) : (mask  & 0xFF),
+		     lut, op);
+	}
+}
+
+void copyBx(byte* vram, unsigned src, unsigned dst, unsigned num, word mask,
+            const byte* lut, LogOp op)
+{
+	for (unsigned i = 0; i < 2; ++i) {
+		unsigned s = V9990VRAM::transformBx(src + i);
+		unsigned d = V9990VRAM::transformBx(dst + i);
+		copy(&vram[d], &vram[s], (num + 1 - i) / 2,
+		     (d & 0x40000) ? (mask >> 8) : (mask & 0xFF),
+		     lut, op);
+	}
+}
+
+bool canCopyBx(unsigned src, unsigned dst, unsigned num, bool forward)
+{
+	// Without overlap the order in which the bytes are processed doesn't
+	// matter. Otherwise, the two parts of a copyBx() must each stay
+	// within one bank (so they're independent), and the kernels only go
+	// forward.
+	bool overlap = (src < (dst + num)) && (dst < (src + num));
+	return !overlap || (forward && (((src ^ dst) & 1) == 0));
+}
+
+} // namespace openmsx::V9990CmdKernels
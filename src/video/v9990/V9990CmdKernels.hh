@@ -0,0 +1,81 @@
+#ifndef V9990CMDKERNELS_HH
+#define V9990CMDKERNELS_HH
+
+#include "openmsx.hh"
+#include <cstddef>
+
+/** Building blocks to execute (part of) a V9990 block command as a few
+  * operations on contiguous VRAM instead of pixel per pixel.
+  *
+  * All functions give exactly the same result as a loop that processes
+  * the bytes one at a time in increasing address order. Even when the
+  * source and destination overlap, e.g. a copy to a slightly higher
+  * address repeats the first bytes of the source (like the real command
+  * engine does), it does not behave like memmove().
+  *
+  * For each byte the result is
+  *    (dst & ~mask) | (op(src, dst) & mask)
+  * where 'op' is given by a logical operation lookup table (indexed as
+  * lut[256 * dst + src]). That's only correct when the logical operation
+  * works independently per byte, the caller must check that (e.g. 16bpp
+  * transparency depends on both bytes of a pixel).
+  */
+namespace openmsx::V9990CmdKernels {
+
+enum class LogOp {
+	GENERIC, // use the lookup table
+	IMP,     // dst = src
+	TIMP,    // dst = src ? src : dst
+};
+
+/** Find a faster alternative for the lookup table, if there is one.
+  * @param log The LOG command register.
+  * @param bpp8 Transparency is per byte (8bpp mode). In 2bpp and 4bpp
+  *             modes it's per pixel, in those modes TIMP is executed
+  *             with the generic lookup table.
+  */
+[[nodiscard]] LogOp classify(byte log, bool bpp8);
+
+/** Combine 'num' bytes at 'dst' with the single value 'color'. */
+void fill(byte* dst, size_t num, byte color, byte mask,
+          const byte* lut, LogOp op);
+
+/** Combine 'num' bytes at 'dst' with the bytes at 'src'. */
+void copy(byte* dst, const byte* src, size_t num, byte mask,
+          const byte* lut, LogOp op);
+
+// The functions below work on the whole 512kB VRAM and on Bx addresses
+// (see V9990VRAM::transformBx()). In VRAM, a range of Bx addresses is two
+// contiguous parts, one in each bank.
+
+/** Get the VRAM range of 'nx' pixels starting at (x, y) in direction 'dx'
+  * (2, 4, 8 or 16 bits per pixel, not P1/P2), as a range of (not yet
+  * transformed) Bx addresses. This fails when the pixels don't cover whole
+  * bytes or when the range wraps.
+  */
+[[nodiscard]] bool getRowRange(unsigned bitsPerPixel, unsigned x, unsigned y,
+                               unsigned pitch, unsigned nx, int dx,
+                               unsigned& addr, unsigned& num);
+
+/** Combine the range of 'num' Bx addresses starting at 'dst' with 'color'.
+  * The low byte of 'color' and 'mask' is used for the first bank, the high
+  * byte for the second bank.
+  */
+void fillBx(byte* vram, unsigned dst, unsigned num, word color, word mask,
+            const byte* lut, LogOp op);
+
+/** Combine the range of 'num' Bx addresses starting at 'dst' with the range
+  * at 'src'. Only allowed when canCopyBx() returns true.
+  */
+void copyBx(byte* vram, unsigned src, unsigned dst, unsigned num, word mask,
+            const byte* lut, LogOp op);
+
+/** Does copyBx() give the same result as processing the Bx addresses one
+  * by one (going forward or backward)?
+  */
+[[nodiscard]] bool canCopyBx(unsigned src, unsigned dst, unsigned num,
+                             bool forward);
+
+} // namespace openmsx::V9990CmdKernels
+
+#endif
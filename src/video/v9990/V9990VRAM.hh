@@ -78,6 +78,13 @@ public:
 		data.write(address, value);
 	}
 
+	/** Direct access for the bulk command kernels. Marks the VRAM as
+	  * modified, so don't keep the pointer for later writes.
+	  */
+	byte* getWriteBackdoor() {
+		return data.getWriteBackdoor();
+	}
+
 	byte readVRAMCPU(unsigned address, EmuTime::param time);
 	void writeVRAMCPU(unsigned address, byte val, EmuTime::param time);
 
@@ -39,7 +39,7 @@ private:
 
 	// VideoLayer
 	void paint(OutputSurface& output) override;
-	void takeRawScreenShot(unsigned height, const std::string& filename) override;
+	bool takeRawScreenShot(unsigned height, const std::string& filename) override;
 
 	// EventListener
 	int signalEvent(const std::shared_ptr<const Event>& event) override;